@@ -129,6 +129,7 @@ local flexCallIns = {
   'UnitCommand',
   'UnitCmdDone',
   'UnitDamaged',
+  'UnitDamagedBatch',
   'UnitStunned',
   'UnitEnteredRadar',
   'UnitEnteredLos',
@@ -144,6 +145,7 @@ local flexCallIns = {
   'UnitCloaked',
   'UnitDecloaked',
   'UnitMoveFailed',
+  'UnitMovedBatch',
   'UnitHarvestStorageFull',
   'RecvLuaMsg',
   'StockpileChanged',
@@ -1856,6 +1858,13 @@ function widgetHandler:UnitDamaged(unitID, unitDefID, unitTeam, damage, paralyze
   return
 end
 
+function widgetHandler:UnitDamagedBatch(unitIDs, unitDefIDs, unitTeams, damages, paralyzers, weaponDefIDs, projectileIDs)
+  for _,w in ipairs(self.UnitDamagedBatchList) do
+    w:UnitDamagedBatch(unitIDs, unitDefIDs, unitTeams, damages, paralyzers, weaponDefIDs, projectileIDs)
+  end
+  return
+end
+
 function widgetHandler:UnitStunned(unitID, unitDefID, unitTeam, stunned)
   for _,w in ipairs(self.UnitStunnedList) do
     w:UnitStunned(unitID, unitDefID, unitTeam, stunned)
@@ -1979,6 +1988,13 @@ function widgetHandler:UnitMoveFailed(unitID, unitDefID, unitTeam)
   return
 end
 
+function widgetHandler:UnitMovedBatch(unitIDs, unitDefIDs, unitTeams)
+  for _,w in ipairs(self.UnitMovedBatchList) do
+    w:UnitMovedBatch(unitIDs, unitDefIDs, unitTeams)
+  end
+  return
+end
+
 function widgetHandler:UnitHarvestStorageFull(unitID, unitDefID, unitTeam)
   for _,w in ipairs(self.UnitHarvestStorageFullList) do
     w:UnitHarvestStorageFull(unitID, unitDefID, unitTeam)
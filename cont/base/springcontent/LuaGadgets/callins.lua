@@ -71,6 +71,8 @@ CALLIN_LIST = {
 	"UnitFeatureCollision",
 	"UnitMoveFailed",
 	"UnitMoved",               -- FIXME: not exposed to Lua yet (as of 95.0)
+	"UnitMovedBatch",
+	"UnitDamagedBatch",
 	"UnitEnteredAir",
 	"UnitLeftAir",
 	"UnitEnteredWater",
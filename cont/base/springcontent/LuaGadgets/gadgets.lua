@@ -1426,6 +1426,25 @@ function gadgetHandler:UnitDamaged(
   end
 end
 
+function gadgetHandler:UnitDamagedBatch(
+  unitIDs,
+  unitDefIDs,
+  unitTeams,
+  damages,
+  paralyzers,
+  weaponDefIDs,
+  projectileIDs,
+  attackerIDs,
+  attackerDefIDs,
+  attackerTeams
+)
+  for _,g in r_ipairs(self.UnitDamagedBatchList) do
+    g:UnitDamagedBatch(unitIDs, unitDefIDs, unitTeams,
+                       damages, paralyzers, weaponDefIDs, projectileIDs,
+                       attackerIDs, attackerDefIDs, attackerTeams)
+  end
+end
+
 function gadgetHandler:UnitStunned(unitID, unitDefID, unitTeam, stunned)
   for _,g in r_ipairs(self.UnitStunnedList) do
     g:UnitStunned(unitID, unitDefID, unitTeam, stunned)
@@ -1579,6 +1598,12 @@ function gadgetHandler:UnitHarvestStorageFull(unitID, unitDefID, unitTeam)
   end
 end
 
+function gadgetHandler:UnitMovedBatch(unitIDs, unitDefIDs, unitTeams)
+  for _,g in r_ipairs(self.UnitMovedBatchList) do
+    g:UnitMovedBatch(unitIDs, unitDefIDs, unitTeams)
+  end
+end
+
 --------------------------------------------------------------------------------
 --
 --  Feature call-ins
@@ -105,6 +105,7 @@
 #include "System/Config/ConfigHandler.h"
 #include "System/EventHandler.h"
 #include "System/Exceptions.h"
+#include "System/StringUtil.h"
 #include "System/Sync/FPUCheck.h"
 #include "System/myMath.h"
 #include "Net/GameServer.h"
@@ -112,6 +113,7 @@
 #include "System/SafeUtil.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveHandler.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Watchdog.h"
@@ -196,6 +198,9 @@ CR_REG_METADATA(CGame, (
 	CR_IGNORED(curKeyChain),
 	CR_IGNORED(worldDrawer),
 	CR_IGNORED(saveFile),
+	CR_IGNORED(snapshotReplay),
+	CR_IGNORED(gameStateUpload),
+	CR_IGNORED(gameStateFrameNum),
 
 	// Post Load
 	CR_POSTLOAD(PostLoad)
@@ -241,6 +246,8 @@ CGame::CGame(const std::string& mapName, const std::string& modName, ILoadSaveHa
 	, speedControl(-1)
 
 	, saveFile(saveFile)
+	, snapshotReplay(false)
+	, gameStateFrameNum(-1)
 	, finishedLoading(false)
 	, gameOver(false)
 {
@@ -436,6 +443,7 @@ void CGame::LoadGame(const std::string& mapName)
 		if (!globalQuit && saveFile != nullptr) {
 			loadscreen->SetLoadMessage("Loading Saved Game");
 			saveFile->LoadGame();
+			snapshotReplay = saveFile->IsSnapshot();
 		}
 	} catch (const content_error& e) {
 		LOG_L(L_WARNING, "[Game::%s][6] forced quit with exception \"%s\"", __func__, e.what());
@@ -1514,6 +1522,7 @@ void CGame::SimFrame() {
 		unitHandler.Update();
 		projectileHandler.Update();
 		featureHandler.Update();
+		quadField.Update();
 		{
 			SCOPED_TIMER("Sim::Script");
 			unitScriptEngine->Tick(33);
@@ -1528,6 +1537,10 @@ void CGame::SimFrame() {
 
 		teamHandler.GameFrame(gs->frameNum);
 		playerHandler.GameFrame(gs->frameNum);
+		{
+			SCOPED_TIMER("Sim::GameFrame::EventBatches");
+			eventHandler.SendEventBatches();
+		}
 	}
 
 	lastSimFrameTime = spring_gettime();
@@ -1862,6 +1875,63 @@ void CGame::SaveGame(const std::string& filename, bool overwrite, bool usecreg)
 }
 
 
+void CGame::SendGameStateSnapshot(int requestFrameNum)
+{
+	// the request follows the last frame the server sent, so this should never happen
+	if (requestFrameNum != gs->frameNum) {
+		LOG_L(L_WARNING, "[Game::%s] snapshot requested for frame %d at frame %d", __func__, requestFrameNum, gs->frameNum);
+		return;
+	}
+
+	// the previous snapshot is still being compressed, the server asks again later
+	if (gameStateUpload.valid()) {
+		LOG_L(L_WARNING, "[Game::%s] skipped snapshot of frame %d, frame %d is still being compressed", __func__, gs->frameNum, gameStateFrameNum);
+		return;
+	}
+
+	// creg saves do not contain synced Lua state, refuse so the server stops asking
+	if (luaRules != nullptr || luaGaia != nullptr) {
+		clientNet->Send(CBaseNetProtocol::Get().SendGameState(gu->myPlayerNum, gs->frameNum, 0, 0, {}));
+		return;
+	}
+
+	std::stringstream oss;
+	CCregLoadSaveHandler ls;
+
+	ls.mapName = gameSetup->mapName;
+	ls.modName = gameSetup->modName;
+
+	// the game-state has to be serialized between two frames, but compressing
+	// it can happen while the simulation continues (see UploadGameStateSnapshot)
+	if (!ls.SaveGameState(oss))
+		return;
+
+	const std::function<std::vector<std::uint8_t>(std::string&&)> func = [](std::string&& rawData) {
+		return zlib::deflate(reinterpret_cast<const std::uint8_t*>(rawData.data()), rawData.size());
+	};
+
+	gameStateFrameNum = gs->frameNum;
+	gameStateUpload = std::async(std::launch::async, func, std::move(oss.str()));
+}
+
+void CGame::UploadGameStateSnapshot()
+{
+	if (!gameStateUpload.valid() || gameStateUpload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	const std::vector<std::uint8_t> data = gameStateUpload.get();
+
+	std::vector<std::uint8_t> part;
+
+	for (size_t offset = 0; offset < data.size(); offset += GAMESTATE_PART_SIZE) {
+		part.assign(data.begin() + offset, data.begin() + std::min(offset + GAMESTATE_PART_SIZE, data.size()));
+		clientNet->Send(CBaseNetProtocol::Get().SendGameState(gu->myPlayerNum, gameStateFrameNum, data.size(), offset, part));
+	}
+
+	LOG("[Game::%s] sent game-state snapshot of frame %d (%u bytes compressed)", __func__, gameStateFrameNum, uint32_t(data.size()));
+}
+
+
 void CGame::ReloadGame()
 {
 	if (saveFile) {
@@ -3,6 +3,7 @@
 #ifndef _GAME_H
 #define _GAME_H
 
+#include <future>
 #include <string>
 #include <vector>
 
@@ -92,6 +93,10 @@ public:
 
 	void ReloadGame();
 	void SaveGame(const std::string& filename, bool overwrite, bool usecreg);
+	/// answers NETMSG_GAMESTATE_REQUEST, the server forwards the snapshot to mid-game joiners
+	void SendGameStateSnapshot(int requestFrameNum);
+	/// sends the snapshot once it has been compressed, polled by ClientReadNet
+	void UploadGameStateSnapshot();
 
 	void ResizeEvent() override;
 
@@ -207,6 +212,17 @@ private:
 	/// for reloading the savefile
 	ILoadSaveHandler* saveFile;
 
+	/**
+	 * true while receiving the messages the server replays from before the
+	 * snapshot we joined from; their effects on teams are already part of
+	 * it, only those on players and AIs are applied (see ClientReadNet)
+	 */
+	bool snapshotReplay;
+
+	/// compressed snapshot of <gameStateFrameNum>, see SendGameStateSnapshot
+	std::future< std::vector<std::uint8_t> > gameStateUpload;
+	int gameStateFrameNum;
+
 	volatile bool finishedLoading;
 	bool gameOver;
 };
@@ -636,6 +636,43 @@ namespace {
 
 
 
+static float GetWeaponTargetScanRadius(const CWeapon* weapon)
+{
+	const float scanRadius = weapon->range + weapon->autoTargetRangeBoost;
+	const float  aimHeight = weapon->aimFromPos.y;
+
+	return (scanRadius + (aimHeight - std::max(0.0f, readMap->GetInitMinHeight())) * weapon->weaponDef->heightmod);
+}
+
+void CGameHelper::GatherWeaponTargetCandidates(const CWeapon* weapon, QueryVisitedSet& visited, std::vector<int>& scanQuads, std::vector<CUnit*>& candidates)
+{
+	const CUnit* weaponOwner = weapon->owner;
+
+	QuadFieldQuery qfQuery;
+	quadField.GetQuads(qfQuery, weaponOwner->pos, GetWeaponTargetScanRadius(weapon));
+
+	scanQuads.assign(qfQuery.quads->begin(), qfQuery.quads->end());
+	candidates.clear();
+
+	// units only ever belong to one allyteam, so the visited-set plays
+	// the same role as the tempNum stamps in GenerateWeaponTargets
+	visited.Reset();
+
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		if (teamHandler.Ally(weaponOwner->allyteam, t))
+			continue;
+
+		for (const int qi: scanQuads) {
+			for (CUnit* targetUnit: quadField.GetQuad(qi).teamUnits[t]) {
+				if (!visited.Insert(targetUnit))
+					continue;
+
+				candidates.push_back(targetUnit);
+			}
+		}
+	}
+}
+
 void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets)
 {
 	const CUnit*  weaponOwner = weapon->owner;
@@ -660,84 +697,97 @@ void CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoi
 
 	const bool paralyzer = (weaponDmg->paralyzeDamageTime != 0);
 
-	// copy on purpose since the below calls lua
-	QuadFieldQuery qfQuery;
-	quadField.GetQuads(qfQuery, ownerPos, scanRadius + (aimHeight - std::max(0.0f, readMap->GetInitMinHeight())) * heightMod);
+	const auto AddTarget = [&](CUnit* targetUnit) {
+		if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
+			return;
 
-	const int tempNum = gs->GetTempNum();
+		const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
 
-	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
-		if (teamHandler.Ally(weaponOwner->allyteam, t))
-			continue;
+		float targetPriority = tgtPriorityMults[(targetUnit == avoidUnit) * 1];
+		float3 targetPos;
 
-		for (const int qi: *qfQuery.quads) {
-			const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
+		if (targetLOSState & LOS_INLOS) {
+			targetPos = targetUnit->aimPos;
+		} else if (targetLOSState & LOS_INRADAR) {
+			targetPos = weapon->GetUnitPositionWithError(targetUnit);
+			targetPriority *= tgtPriorityMults[1];
+		} else {
+			return;
+		}
 
-			for (CUnit* targetUnit: allyTeamUnits) {
-				if (targetUnit->tempNum == tempNum)
-					continue;
+		const float modRange = scanRadius + (aimHeight - targetPos.y) * heightMod;
+		const float sqDist2D = ownerPos.SqDistance2D(targetPos);
 
-				targetUnit->tempNum = tempNum;
+		if (sqDist2D > Square(modRange))
+			return;
 
-				if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
-					continue;
+		const float dist2D = math::sqrt(sqDist2D);
+		const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
+		const float damageMul = weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple;
 
-				const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
+		targetPriority *= rangeMul;
+		targetPriority *= tgtPriorityMults[(dist2D > baseRange) * 6];
 
-				float targetPriority = tgtPriorityMults[(targetUnit == avoidUnit) * 1];
-				float3 targetPos;
+		if (targetLOSState & LOS_INLOS) {
+			targetPriority *= (secDamage + targetUnit->health);
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPos = targetUnit->aimPos;
-				} else if (targetLOSState & LOS_INRADAR) {
-					targetPos = weapon->GetUnitPositionWithError(targetUnit);
-					targetPriority *= tgtPriorityMults[1];
-				} else {
-					continue;
-				}
+			if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
+				targetPriority *= tgtPriorityMults[5];
 
-				const float modRange = scanRadius + (aimHeight - targetPos.y) * heightMod;
-				const float sqDist2D = ownerPos.SqDistance2D(targetPos);
+			if (weapon->hasTargetWeight)
+				targetPriority *= weapon->TargetWeight(targetUnit);
 
-				if (sqDist2D > Square(modRange))
-					continue;
+		} else {
+			targetPriority *= (secDamage + 10000.0f);
+		}
 
-				const float dist2D = math::sqrt(sqDist2D);
-				const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
-				const float damageMul = weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple;
+		if (targetLOSState & LOS_PREVLOS) {
+			targetPriority /= (damageMul * targetUnit->power * (0.7f + gsRNG.NextFloat() * 0.6f));
+			targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
+			targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
+			targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
+		}
 
-				targetPriority *= rangeMul;
-				targetPriority *= tgtPriorityMults[(dist2D > baseRange) * 6];
+		if (!eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority))
+			return;
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPriority *= (secDamage + targetUnit->health);
+		targets.emplace_back(targetPriority, targetUnit);
+	};
 
-					if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
-						targetPriority *= tgtPriorityMults[5];
+	// copy on purpose since the below calls lua
+	QuadFieldQuery qfQuery;
+	quadField.GetQuads(qfQuery, ownerPos, GetWeaponTargetScanRadius(weapon));
 
-					if (weapon->hasTargetWeight)
-						targetPriority *= weapon->TargetWeight(targetUnit);
+	// candidates gathered on the ThreadPool by CUnitHandler are only
+	// returned if they equal what the loop below would visit, in the
+	// same order
+	const std::vector<CUnit*>* candidates = weapon->GetTargetCandidates(*qfQuery.quads);
 
-				} else {
-					targetPriority *= (secDamage + 10000.0f);
-				}
+	if (candidates != nullptr) {
+		for (CUnit* targetUnit: *candidates) {
+			AddTarget(targetUnit);
+		}
+	} else {
+		const int tempNum = gs->GetTempNum();
 
-				if (targetLOSState & LOS_PREVLOS) {
-					targetPriority /= (damageMul * targetUnit->power * (0.7f + gsRNG.NextFloat() * 0.6f));
-					targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
-					targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
-					targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
-				}
+		for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+			if (teamHandler.Ally(weaponOwner->allyteam, t))
+				continue;
 
-				const bool allowTarget = eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority);
+			for (const int qi: *qfQuery.quads) {
+				const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
 
-				// Lua call may have changed tempNum, so needs to be set again
-				targetUnit->tempNum = tempNum;
+				for (CUnit* targetUnit: allyTeamUnits) {
+					if (targetUnit->tempNum == tempNum)
+						continue;
 
-				if (!allowTarget)
-					continue;
+					targetUnit->tempNum = tempNum;
+
+					AddTarget(targetUnit);
 
-				targets.emplace_back(targetPriority, targetUnit);
+					// Lua call may have changed tempNum, so needs to be set again
+					targetUnit->tempNum = tempNum;
+				}
 			}
 		}
 	}
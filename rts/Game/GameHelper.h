@@ -18,6 +18,7 @@ class CWeapon;
 class CSolidObject;
 class CFeature;
 class CMobileCAI;
+class QueryVisitedSet;
 struct UnitDef;
 struct MoveDef;
 struct BuildInfo;
@@ -122,6 +123,12 @@ public:
 	static float3 ClosestBuildSite(int team, const UnitDef* unitDef, float3 pos, float searchRadius, int minDist, int facing = 0);
 
 	static void GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets);
+	/**
+	 * Read-only part of GenerateWeaponTargets: collects every enemy unit linked into
+	 * the weapon's scan-quads, in the order GenerateWeaponTargets would visit them.
+	 * Safe to call from ThreadPool workers (one <visited> set per thread).
+	 */
+	static void GatherWeaponTargetCandidates(const CWeapon* weapon, QueryVisitedSet& visited, std::vector<int>& scanQuads, std::vector<CUnit*>& candidates);
 
 	void Init();
 	void Update();
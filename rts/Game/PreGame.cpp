@@ -35,6 +35,7 @@
 #include "System/Exceptions.h"
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
+#include "System/StringUtil.h"
 #include "System/TimeProfiler.h"
 #include "System/TdfParser.h"
 #include "System/Input/KeyInput.h"
@@ -44,6 +45,7 @@
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/LoadSave/DemoReader.h"
 #include "System/LoadSave/LoadSaveHandler.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
 #include "System/Log/ILog.h"
 #include "System/Net/RawPacket.h"
 #include "System/Net/UnpackPacket.h"
@@ -364,6 +366,12 @@ void CPreGame::UpdateClientNet()
 				GameDataReceived(packet);
 			} break;
 
+			case NETMSG_GAMESTATE: {
+				// sent between NETMSG_GAMEDATA and NETMSG_SETPLAYERNUM if the
+				// server has a snapshot for us to start from
+				GameStateReceived(packet);
+			} break;
+
 			case NETMSG_SETPLAYERNUM: {
 				// this is sent after NETMSG_GAMEDATA, to let us know which
 				// player number we have (server assigns them based on order
@@ -583,3 +591,43 @@ void CPreGame::GameDataReceived(std::shared_ptr<const netcode::RawPacket> packet
 	}
 }
 
+
+void CPreGame::GameStateReceived(std::shared_ptr<const netcode::RawPacket> packet)
+{
+	uint8_t playerNum;
+	int32_t frameNum;
+	uint32_t totalSize;
+	uint32_t offset;
+
+	try {
+		netcode::UnpackPacket pckt(packet, 3);
+
+		pckt >> playerNum;
+		pckt >> frameNum;
+		pckt >> totalSize;
+		pckt >> offset;
+	} catch (const netcode::UnpackPacketException& ex) {
+		throw content_error(std::string("invalid game-state snapshot received: ") + ex.what());
+	}
+
+	if (offset != gameStateData.size())
+		throw content_error("game-state snapshot parts received out of order");
+
+	gameStateData.insert(gameStateData.end(), packet->data + GAMESTATE_HEADER_SIZE, packet->data + packet->length);
+
+	if (gameStateData.size() < totalSize)
+		return;
+
+	const std::vector<std::uint8_t> rawData = zlib::inflate(gameStateData);
+
+	if (rawData.empty())
+		throw content_error("corrupt game-state snapshot received");
+
+	LOG("[PreGame::%s] received game-state snapshot of frame %d from player %d (%u bytes)", __func__, frameNum, playerNum, uint32_t(rawData.size()));
+
+	CCregLoadSaveHandler* snapshot = new CCregLoadSaveHandler();
+	snapshot->LoadGameStateInfo(std::string(rawData.begin(), rawData.end()));
+
+	savefile = snapshot;
+	gameStateData.clear();
+}
@@ -3,8 +3,10 @@
 #ifndef PREGAME_H
 #define PREGAME_H
 
+#include <cinttypes>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "GameController.h"
 #include "System/Misc/SpringTime.h"
@@ -61,6 +63,8 @@ private:
 	void UpdateClientNet();
 
 	void GameDataReceived(std::shared_ptr<const netcode::RawPacket> packet);
+	/// collects the parts of a snapshot the server sends when joining mid-game
+	void GameStateReceived(std::shared_ptr<const netcode::RawPacket> packet);
 
 	/**
 	@brief GameData we received from server
@@ -73,6 +77,9 @@ private:
 	std::string modArchive;
 	ILoadSaveHandler* savefile;
 
+	/// compressed snapshot data received so far (see GameStateReceived)
+	std::vector<std::uint8_t> gameStateData;
+
 	spring_time connectTimer;
 
 	bool wantDemo;
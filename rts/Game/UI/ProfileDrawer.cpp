@@ -375,7 +375,7 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 	const char* avgFmtStr = "[3] {Sim,Update,Draw}FrameTime={%s%2.1f, %s%2.1f, %s%2.1f (GL=%2.1f)}ms";
 	const char* spdFmtStr = "[4] {Current,Wanted}SimSpeedMul={%2.2f, %2.2f}x";
 	const char* sfxFmtStr = "[5] {Synced,Unsynced}Projectiles={%u,%u} Particles=%u Saturation=%.1f";
-	const char* pfsFmtStr = "[6] (%s)PFS-updates queued: {%i, %i}";
+	const char* pfsFmtStr = "[6] (%s)PFS-updates queued: {%i, %i} cache: {hits=%.0f%%, evictions=%u, invalidations=%u, size=%u/%u}";
 	const char* luaFmtStr = "[7] Lua-allocated memory: %.1fMB (%.1fK allocs : %.5u usecs : %.1u states)";
 	const char* gpuFmtStr = "[8] GPU-allocated memory: %.1fMB / %.1fMB";
 	const char* sopFmtStr = "[9] SOP-allocated memory: {U,F,P,W}={%.1f/%.1f, %.1f/%.1f, %.1f/%.1f, %.1f/%.1f}KB";
@@ -399,16 +399,18 @@ static void DrawInfoText(GL::RenderDataBufferC* buffer)
 
 	{
 		const int2 pfsUpdates = pm->GetNumQueuedUpdates();
+		const PathCacheStats pfsCache = pm->GetPathCacheStats(true);
+		const float pfsCacheHits = (pfsCache.numHits * 100.0f) / std::max(1u, pfsCache.numHits + pfsCache.numMisses);
 
 		switch (pm->GetPathFinderType()) {
 			case NOPFS_TYPE: {
-				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "NO", pfsUpdates.x, pfsUpdates.y);
+				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "NO", pfsUpdates.x, pfsUpdates.y, pfsCacheHits, pfsCache.numEvictions, pfsCache.numInvalidations, pfsCache.size, pfsCache.capacity);
 			} break;
 			case HAPFS_TYPE: {
-				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "HA", pfsUpdates.x, pfsUpdates.y);
+				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "HA", pfsUpdates.x, pfsUpdates.y, pfsCacheHits, pfsCache.numEvictions, pfsCache.numInvalidations, pfsCache.size, pfsCache.capacity);
 			} break;
 			case QTPFS_TYPE: {
-				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "QT", pfsUpdates.x, pfsUpdates.y);
+				font->glFormat(0.01f, 0.12f, 0.5f, DBG_FONT_FLAGS | FONT_BUFFERED, pfsFmtStr, "QT", pfsUpdates.x, pfsUpdates.y, pfsCacheHits, pfsCache.numEvictions, pfsCache.numInvalidations, pfsCache.size, pfsCache.capacity);
 			} break;
 			default: {
 			} break;
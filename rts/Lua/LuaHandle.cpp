@@ -1301,6 +1301,99 @@ void CLuaHandle::UnitMoveFailed(const CUnit* unit)
 }
 
 
+void CLuaHandle::UnitMovedBatch(const std::vector<UnitMovedBatchEvent>& events)
+{
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 6, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+	const LuaUtils::ScopedDebugTraceBack traceBack(L);
+
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	// one array per argument of UnitMoved, skipping unreadable events
+	lua_createtable(L, events.size(), 0);
+	lua_createtable(L, events.size(), 0);
+	lua_createtable(L, events.size(), 0);
+
+	int count = 0;
+
+	for (const UnitMovedBatchEvent& e: events) {
+		if (!CanReadAllyTeam(e.unitAllyTeam))
+			continue;
+
+		count++;
+
+		lua_pushnumber(L, e.unitID   ); lua_rawseti(L, -4, count);
+		lua_pushnumber(L, e.unitDefID); lua_rawseti(L, -3, count);
+		lua_pushnumber(L, e.unitTeam ); lua_rawseti(L, -2, count);
+	}
+
+	if (count == 0) {
+		lua_pop(L, 4);
+		return;
+	}
+
+	// call the routine
+	RunCallInTraceback(L, cmdStr, 3, 0, traceBack.GetErrFuncIdx(), false);
+}
+
+
+void CLuaHandle::UnitDamagedBatch(const std::vector<UnitDamagedBatchEvent>& events)
+{
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 13, __func__);
+
+	static const LuaHashString cmdStr(__func__);
+	const LuaUtils::ScopedDebugTraceBack traceBack(L);
+
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	// one array per argument of UnitDamaged; the attacker arrays have
+	// holes where UnitDamaged would not have passed an attacker, so the
+	// length of unitIDs is the number of events
+	for (int n = 0; n < 10; n++) {
+		lua_createtable(L, events.size(), 0);
+	}
+
+	const bool fullRead = GetHandleFullRead(L);
+
+	int count = 0;
+
+	for (const UnitDamagedBatchEvent& e: events) {
+		if (!CanReadAllyTeam(e.unitAllyTeam))
+			continue;
+
+		count++;
+
+		lua_pushnumber(L, e.unitID      ); lua_rawseti(L, -11, count);
+		lua_pushnumber(L, e.unitDefID   ); lua_rawseti(L, -10, count);
+		lua_pushnumber(L, e.unitTeam    ); lua_rawseti(L,  -9, count);
+		lua_pushnumber(L, e.damage      ); lua_rawseti(L,  -8, count);
+		lua_pushboolean(L, e.paralyzer  ); lua_rawseti(L,  -7, count);
+		lua_pushnumber(L, e.weaponDefID ); lua_rawseti(L,  -6, count);
+		lua_pushnumber(L, e.projectileID); lua_rawseti(L,  -5, count);
+
+		if (e.attackerID == -1 || !fullRead)
+			continue;
+
+		lua_pushnumber(L, e.attackerID   ); lua_rawseti(L, -4, count);
+		lua_pushnumber(L, e.attackerDefID); lua_rawseti(L, -3, count);
+		lua_pushnumber(L, e.attackerTeam ); lua_rawseti(L, -2, count);
+	}
+
+	if (count == 0) {
+		lua_pop(L, 11);
+		return;
+	}
+
+	// call the routine
+	RunCallInTraceback(L, cmdStr, 10, 0, traceBack.GetErrFuncIdx(), false);
+}
+
+
 void CLuaHandle::RenderUnitDestroyed(const CUnit* unit)
 {
 	LUA_CALL_IN_CHECK(L);
@@ -162,6 +162,8 @@ class CLuaHandle : public CEventClient
 		bool UnitUnitCollision(const CUnit* collider, const CUnit* collidee) override;
 		bool UnitFeatureCollision(const CUnit* collider, const CFeature* collidee) override;
 		void UnitMoveFailed(const CUnit* unit) override;
+		void UnitMovedBatch(const std::vector<UnitMovedBatchEvent>& events) override;
+		void UnitDamagedBatch(const std::vector<UnitDamagedBatchEvent>& events) override;
 
 		void RenderUnitDestroyed(const CUnit* unit) override;
 
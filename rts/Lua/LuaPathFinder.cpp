@@ -69,6 +69,7 @@ bool LuaPathFinder::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetPathNodeCosts);
 	REGISTER_LUA_CFUNC(SetPathNodeCost);
 	REGISTER_LUA_CFUNC(GetPathNodeCost);
+	REGISTER_LUA_CFUNC(GetPathCacheStats);
 
 	return true;
 }
@@ -396,6 +397,10 @@ int LuaPathFinder::SetPathNodeCost(lua_State* L)
 	if (costValIndex < overlay.Size())
 		overlay.costs[costValIndex] = luaL_checkfloat(L, 3);
 
+	// paths cached while the active overlay had the old cost are stale
+	if (costValIndex < overlay.Size() && pathManager->GetNodeExtraCosts(syncedOverlay) == &overlay.costs[0])
+		pathManager->SetNodeExtraCosts(&overlay.costs[0], overlay.sizex, overlay.sizez, syncedOverlay);
+
 	lua_pushboolean(L, (costValIndex < overlay.Size()));
 	return 1;
 }
@@ -410,5 +415,22 @@ int LuaPathFinder::GetPathNodeCost(lua_State* L)
 	return 1;
 }
 
+int LuaPathFinder::GetPathCacheStats(lua_State* L)
+{
+	// unsynced states may also look at the caches of unsynced requests
+	const bool synced = CLuaHandle::GetHandleSynced(L) || luaL_optboolean(L, 1, true);
+	const PathCacheStats stats = pathManager->GetPathCacheStats(synced);
+
+	lua_createtable(L, 0, 7);
+	LuaPushNamedNumber(L, "hits", stats.numHits);
+	LuaPushNamedNumber(L, "misses", stats.numMisses);
+	LuaPushNamedNumber(L, "sharedHits", stats.numSharedHits);
+	LuaPushNamedNumber(L, "evictions", stats.numEvictions);
+	LuaPushNamedNumber(L, "invalidations", stats.numInvalidations);
+	LuaPushNamedNumber(L, "size", stats.size);
+	LuaPushNamedNumber(L, "capacity", stats.capacity);
+	return 1;
+}
+
 /******************************************************************************/
 /******************************************************************************/
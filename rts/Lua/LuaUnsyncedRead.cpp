@@ -953,7 +953,7 @@ int LuaUnsyncedRead::GetVisibleUnits(lua_State* L)
 	static CVisUnitQuadDrawer unitQuadIter;
 
 	unitQuadIter.ResetState();
-	readMap->GridVisibility(nullptr, &unitQuadIter, 1e9, CQuadField::BASE_QUAD_SIZE / SQUARE_SIZE);
+	readMap->GridVisibility(nullptr, &unitQuadIter, 1e9, quadField.GetQuadSizeX() / SQUARE_SIZE);
 
 	// Even though we're in unsynced it's ok to use gs->tempNum since its exact value
 	// doesn't matter
@@ -1032,7 +1032,7 @@ int LuaUnsyncedRead::GetVisibleFeatures(lua_State* L)
 	static CVisFeatureQuadDrawer featureQuadIter;
 
 	featureQuadIter.ResetState();
-	readMap->GridVisibility(nullptr, &featureQuadIter, 1e9, CQuadField::BASE_QUAD_SIZE / SQUARE_SIZE);
+	readMap->GridVisibility(nullptr, &featureQuadIter, 1e9, quadField.GetQuadSizeX() / SQUARE_SIZE);
 
 	// Even though we're in unsynced it's ok to use gs->tempNum since its exact value
 	// doesn't matter
@@ -1095,7 +1095,7 @@ int LuaUnsyncedRead::GetVisibleProjectiles(lua_State* L)
 
 
 	projQuadIter.ResetState();
-	readMap->GridVisibility(nullptr, &projQuadIter, 1e9, CQuadField::BASE_QUAD_SIZE / SQUARE_SIZE);
+	readMap->GridVisibility(nullptr, &projQuadIter, 1e9, quadField.GetQuadSizeX() / SQUARE_SIZE);
 
 	// Even though we're in unsynced it's ok to use gs->tempNum since its exact value
 	// doesn't matter
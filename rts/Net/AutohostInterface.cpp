@@ -48,6 +48,16 @@ enum EVENT
 	/// Server gave out a warning (string warningmessage)
 	SERVER_WARNING = 5,
 
+	/**
+	 * @brief Memory used by the server for this game
+	 *   (uint32 numCachedPackets, uint32 numCacheSegments,
+	 *   uint64 cacheRawBytes, uint64 cacheUsedBytes, uint32 snapshotBytes)
+	 *
+	 * The packet-cache holds everything broadcast so far for clients joining
+	 * mid-game; raw is its uncompressed size, used what it actually occupies.
+	 */
+	SERVER_MEMUSAGE = 6,
+
 	/// Player has joined the game (uchar playernumber, string name)
 	PLAYER_JOINED = 10,
 
@@ -276,6 +286,28 @@ void AutohostInterface::SendPlayerDefeated(uchar playerNum)
 	Send(asio::buffer(&msg, 2 * sizeof(uchar)));
 }
 
+void AutohostInterface::SendMemoryUsage(
+	std::uint32_t numCachedPackets,
+	std::uint32_t numCacheSegments,
+	std::uint64_t cacheRawBytes,
+	std::uint64_t cacheUsedBytes,
+	std::uint32_t snapshotBytes
+) {
+	std::uint8_t msg[1 + 4 + 4 + 8 + 8 + 4];
+	unsigned int pos = 0;
+
+	msg[pos++] = SERVER_MEMUSAGE;
+
+	memcpy(&msg[pos], &numCachedPackets, sizeof(numCachedPackets)); pos += sizeof(numCachedPackets);
+	memcpy(&msg[pos], &numCacheSegments, sizeof(numCacheSegments)); pos += sizeof(numCacheSegments);
+	memcpy(&msg[pos], &cacheRawBytes, sizeof(cacheRawBytes)); pos += sizeof(cacheRawBytes);
+	memcpy(&msg[pos], &cacheUsedBytes, sizeof(cacheUsedBytes)); pos += sizeof(cacheUsedBytes);
+	memcpy(&msg[pos], &snapshotBytes, sizeof(snapshotBytes)); pos += sizeof(snapshotBytes);
+	assert(pos == sizeof(msg));
+
+	Send(asio::buffer(msg, sizeof(msg)));
+}
+
 void AutohostInterface::Message(const std::string& message)
 {
 	if (autohost.is_open()) {
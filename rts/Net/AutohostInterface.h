@@ -43,6 +43,14 @@ public:
 	void SendPlayerChat(uchar playerNum, uchar destination, const std::string& msg);
 	void SendPlayerDefeated(uchar playerNum);
 
+	void SendMemoryUsage(
+		std::uint32_t numCachedPackets,
+		std::uint32_t numCacheSegments,
+		std::uint64_t cacheRawBytes,
+		std::uint64_t cacheUsedBytes,
+		std::uint32_t snapshotBytes
+	);
+
 	void Message(const std::string& message);
 	void Warning(const std::string& message);
 
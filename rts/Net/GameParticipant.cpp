@@ -15,6 +15,9 @@ GameParticipant::GameParticipant()
 , isLocal(false)
 , isReconn(false)
 , isMidgameJoin(false)
+, streamingCache(false)
+, cacheIndex(0)
+, snapshotCacheIndex(0)
 {
 	linkData[MAX_AIS] = PlayerLinkData(false);
 }
@@ -48,6 +51,8 @@ void GameParticipant::Kill(const std::string& reason, const bool flush)
 		link.reset();
 	}
 	linkData[MAX_AIS].link.reset();
+	snapshotEndMarker.reset();
+	streamingCache = false;
 #ifdef SYNCCHECK
 	syncResponse.clear();
 #endif
@@ -45,7 +45,16 @@ public:
 	bool isLocal;
 	bool isReconn;
 	bool isMidgameJoin;
+	/// true while catching up on the packet-cache, see CGameServer::StreamPacketCache
+	bool streamingCache;
 	std::shared_ptr<netcode::CConnection> link;
+
+	/// next packet-cache entry to send
+	size_t cacheIndex;
+	/// cache entries before this one precede the snapshot the client joins from
+	size_t snapshotCacheIndex;
+	/// sent once <cacheIndex> reaches <snapshotCacheIndex>
+	std::shared_ptr<const netcode::RawPacket> snapshotEndMarker;
 	PlayerStatistics lastStats;
 
 	struct PlayerLinkData {
@@ -71,6 +71,9 @@ CONFIG(int, SpeedControl).defaultValue(1).minimumValue(1).maximumValue(2)
 	.description("Sets how server adjusts speed according to player's load (CPU), 1: use average, 2: use highest");
 CONFIG(bool, AllowSpectatorJoin).defaultValue(true).description("allow any unauthenticated clients to join as spectator with any name, name will be prefixed with ~");
 CONFIG(bool, WhiteListAdditionalPlayers).defaultValue(true);
+CONFIG(int, SpectatorJoinSnapshotInterval).defaultValue(0).minimumValue(0).description("Number of seconds between game-state snapshots which an in-sync client makes for spectators joining mid-game, so they do not have to re-simulate every frame since the start (0 disables snapshots).");
+CONFIG(int, SpectatorJoinSnapshotMaxSize).defaultValue(64).minimumValue(1).description("Maximum size in MB of a compressed game-state snapshot the server accepts from a client, snapshots are disabled once one exceeds it.");
+CONFIG(int, PacketCacheSegmentLength).defaultValue(60).minimumValue(1).description("Number of seconds of broadcast packets the server keeps uncompressed for clients joining mid-game, older ones are compressed in segments of this length.");
 CONFIG(bool, ServerRecordDemos).defaultValue(false).dedicatedValue(true);
 CONFIG(bool, ServerLogInfoMessages).defaultValue(false);
 CONFIG(bool, ServerLogDebugMessages).defaultValue(false);
@@ -111,14 +114,14 @@ static const unsigned syncResponseEchoInterval = GAME_SPEED * 2;
 
 
 //FIXME remodularize server commands, so they get registered in word completion etc.
-static const std::array<std::string, 23> SERVER_COMMANDS = {
+static const std::array<std::string, 24> SERVER_COMMANDS = {
 	"kick", "kickbynum",
 	"mute", "mutebynum",
 	"setminspeed", "setmaxspeed",
 	"nopause", "nohelp", "cheat", "godmode", "globallos",
 	"nocost", "forcestart", "nospectatorchat", "nospecdraw",
 	"skip", "reloadcob", "reloadcegs", "devlua", "editdefs",
-	"singlestep", "spec", "specbynum"
+	"singlestep", "spec", "specbynum", "snapshotsource"
 };
 
 
@@ -195,6 +198,11 @@ void CGameServer::Initialize()
 	// configs
 	curSpeedCtrl = configHandler->GetInt("SpeedControl");
 	allowSpecJoin = configHandler->GetBool("AllowSpectatorJoin");
+	snapshotInterval = configHandler->GetInt("SpectatorJoinSnapshotInterval") * GAME_SPEED;
+	snapshotMaxSize = std::min(configHandler->GetInt("SpectatorJoinSnapshotMaxSize"), 4095) * 1024u * 1024u;
+	snapshotSource = -1u;
+
+	packetCache.SetSegmentFrames(configHandler->GetInt("PacketCacheSegmentLength") * GAME_SPEED);
 	whiteListAdditionalPlayers = configHandler->GetBool("WhiteListAdditionalPlayers");
 	logInfoMessages = configHandler->GetBool("ServerLogInfoMessages");
 	logDebugMessages = configHandler->GetBool("ServerLogDebugMessages");
@@ -529,7 +537,9 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 			case NETMSG_GAMEDATA:
 			case NETMSG_SETPLAYERNUM:
 			case NETMSG_USER_SPEED:
-			case NETMSG_INTERNAL_SPEED: {
+			case NETMSG_INTERNAL_SPEED:
+			case NETMSG_GAMESTATE_REQUEST:
+			case NETMSG_GAMESTATE: {
 				// never send these from demos
 				break;
 			}
@@ -570,15 +580,219 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 
 void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 {
+	const bool cachePacket = (canReconnect || allowSpecJoin || !gameHasStarted);
+
 	for (GameParticipant& p: players) {
+		// clients still catching up get it from the cache, in order
+		if (cachePacket && p.streamingCache)
+			continue;
+
 		p.SendData(packet);
 	}
 
-	if (canReconnect || allowSpecJoin || !gameHasStarted)
+	if (cachePacket)
 		AddToPacketCache(packet);
 
 	if (demoRecorder != nullptr)
 		demoRecorder->SaveToDemo(packet->data, packet->length, GetDemoTime());
+
+	if (packet->data[0] == NETMSG_NEWFRAME || packet->data[0] == NETMSG_KEYFRAME)
+		RequestGameStateSnapshot();
+}
+
+void CGameServer::RequestGameStateSnapshot()
+{
+	if (snapshotInterval <= 0 || (serverFrameNum % snapshotInterval) != 0)
+		return;
+	if (!canReconnect && !allowSpecJoin)
+		return;
+	// do not trust any client once a desync was detected
+	if (syncErrorFrame != 0)
+		return;
+
+	// every spectator joining from it loads the snapshot as-is, so only the host
+	// or a client chosen by the autohost (see /snapshotsource) is trusted to make it
+	const unsigned int playerNum = HasLocalClient()? localClientNumber: snapshotSource;
+
+	if (playerNum >= players.size())
+		return;
+
+	const GameParticipant& p = players[playerNum];
+
+	if (p.link == nullptr || p.isFromDemo || p.myState != GameParticipant::INGAME)
+		return;
+	// a client that does not keep up would answer too late
+	if (!p.isLocal && (serverFrameNum - p.lastFrameResponse) > GAME_SPEED)
+		return;
+
+	// a snapshot still being uploaded is superseded
+	newGameState = {};
+	newGameState.cacheIndex = packetCache.GetNumPackets();
+	newGameState.frameNum = serverFrameNum;
+	newGameState.playerNum = playerNum;
+
+	// the client processes this right after the frame that was just sent,
+	// so the snapshot reflects every packet up to <cacheIndex>
+	players[playerNum].SendData(CBaseNetProtocol::Get().SendGameStateRequest(serverFrameNum));
+}
+
+void CGameServer::GameStateReceived(const unsigned playerNum, std::shared_ptr<const netcode::RawPacket> packet)
+{
+	uint8_t senderNum;
+	int32_t frameNum;
+	uint32_t totalSize;
+	uint32_t offset;
+
+	try {
+		netcode::UnpackPacket pckt(packet, 3);
+
+		pckt >> senderNum;
+		pckt >> frameNum;
+		pckt >> totalSize;
+		pckt >> offset;
+	} catch (const netcode::UnpackPacketException& ex) {
+		Message(spring::format("[GameServer::%s] exception \"%s\" from player \"%s\"", __func__, ex.what(), players[playerNum].name.c_str()));
+		return;
+	}
+
+	if (senderNum != playerNum) {
+		Message(spring::format(WrongPlayer, NETMSG_GAMESTATE, playerNum, (unsigned)senderNum));
+		return;
+	}
+
+	// stale part of a superseded request
+	if (playerNum != newGameState.playerNum || frameNum != newGameState.frameNum)
+		return;
+
+	// the client can not save synced Lua state and refused, joiners have to re-simulate
+	if (totalSize == 0) {
+		Message(spring::format("%s can not make game-state snapshots while synced Lua is running, disabling spectator-join snapshots", players[playerNum].name.c_str()));
+
+		snapshotInterval = 0;
+		curGameState = {};
+		newGameState = {};
+		return;
+	}
+
+	if (totalSize > snapshotMaxSize) {
+		Message(spring::format("Game-state snapshot from %s exceeds SpectatorJoinSnapshotMaxSize (%u > %u bytes), disabling spectator-join snapshots", players[playerNum].name.c_str(), totalSize, snapshotMaxSize));
+
+		// keep the last snapshot, later ones would not be any smaller
+		snapshotInterval = 0;
+		newGameState = {};
+		return;
+	}
+
+	if (offset == 0)
+		newGameState.totalSize = totalSize;
+
+	const uint32_t partSize = packet->length - GAMESTATE_HEADER_SIZE;
+
+	// parts arrive in order over a single connection, anything else is corrupt
+	if (offset != newGameState.numBytes || packet->length <= GAMESTATE_HEADER_SIZE || totalSize != newGameState.totalSize || partSize > (totalSize - offset)) {
+		newGameState = {};
+		return;
+	}
+
+	newGameState.packets.push_back(packet);
+	newGameState.numBytes += partSize;
+
+	if (newGameState.numBytes < totalSize)
+		return;
+
+	curGameState = std::move(newGameState);
+	newGameState = {};
+
+	Message(spring::format("Received game-state snapshot of frame %d (%u bytes) from %s", curGameState.frameNum, curGameState.numBytes, players[playerNum].name.c_str()), false);
+}
+
+/**
+ * Whether a cached packet from before a snapshot has to be sent to clients
+ * joining from it: those affecting players, AIs and game-speed, which are
+ * not part of the snapshot. Anything changing the simulation is already
+ * contained in it and must not be applied twice; the joiner applies only
+ * the player- and AI-parts of the packets kept here (see CGame::ClientReadNet)
+ * until the end-marker sent after them.
+ */
+static bool KeepBeforeSnapshot(const netcode::RawPacket* packet)
+{
+	switch (packet->data[0]) {
+		case NETMSG_STARTPLAYING:
+		case NETMSG_PLAYERNAME:
+		case NETMSG_CHAT:
+		case NETMSG_GAMEID:
+		case NETMSG_PATH_CHECKSUM:
+		case NETMSG_PAUSE:
+		case NETMSG_USER_SPEED:
+		case NETMSG_INTERNAL_SPEED:
+		case NETMSG_PLAYERSTAT:
+		case NETMSG_SYSTEMMSG:
+		case NETMSG_PLAYERINFO:
+		case NETMSG_PLAYERLEFT:
+		case NETMSG_AI_CREATED:
+		case NETMSG_AI_STATE_CHANGED:
+		case NETMSG_CREATE_NEWPLAYER: {
+			return true;
+		} break;
+
+		// the team-changes are part of the snapshot, but players might have become spectators
+		case NETMSG_TEAM: {
+			return (packet->data[2] == TEAMMSG_GIVEAWAY || packet->data[2] == TEAMMSG_RESIGN || packet->data[2] == TEAMMSG_JOIN_TEAM);
+		} break;
+
+		default: {
+		} break;
+	}
+
+	return false;
+}
+
+void CGameServer::UpdatePacketCacheStreams()
+{
+	for (GameParticipant& p: players) {
+		if (!p.streamingCache || p.link == nullptr)
+			continue;
+		// wait until the previous segment was sent and acknowledged
+		if (p.link->GetOutgoingQueueSize() > 0)
+			continue;
+
+		StreamPacketCache(p);
+	}
+}
+
+/**
+ * Sends the packets of one cache segment to a client joining mid-game, so
+ * only a single segment is inflated at any time. Returns false once the
+ * client caught up (and receives broadcasts directly again) or was dropped
+ * because the segment was corrupt.
+ */
+bool CGameServer::StreamPacketCache(GameParticipant& p)
+{
+	const size_t numPackets = packetCache.GetNumPackets();
+	const size_t endIndex = (p.cacheIndex < p.snapshotCacheIndex)? p.snapshotCacheIndex: numPackets;
+
+	std::vector<PacketCache::PacketPtr> packets;
+
+	if (!packetCache.Read(p.cacheIndex, endIndex, packets)) {
+		Message(spring::format(PlayerLeft, p.GetType(), p.name.c_str(), spring::format(" corrupt packet-cache segment at packet %u", unsigned(p.cacheIndex)).c_str()));
+		Broadcast(CBaseNetProtocol::Get().SendPlayerLeft(p.id, 0));
+		p.Kill("Corrupt packet-cache");
+		if (hostif)
+			hostif->SendPlayerLeft(p.id, 0);
+		return false;
+	}
+
+	for (const PacketCache::PacketPtr& packet: packets) {
+		if (p.cacheIndex++ >= p.snapshotCacheIndex || KeepBeforeSnapshot(packet.get()))
+			p.SendData(packet);
+	}
+
+	if (p.snapshotEndMarker != nullptr && p.cacheIndex >= p.snapshotCacheIndex) {
+		p.SendData(p.snapshotEndMarker);
+		p.snapshotEndMarker.reset();
+	}
+
+	return (p.streamingCache = (p.cacheIndex < numPackets));
 }
 
 void CGameServer::Message(const std::string& message, bool broadcast, bool internal)
@@ -853,6 +1067,8 @@ void CGameServer::Update()
 	else if (!PreSimFrame() || demoReader != nullptr)
 		CreateNewFrame(true, false);
 
+	UpdatePacketCacheStreams();
+
 	if (hostif) {
 		std::string msg = hostif->GetChatMessage();
 
@@ -1799,6 +2015,11 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 			break;
 		}
 
+		case NETMSG_GAMESTATE: {
+			GameStateReceived(a, packet);
+			break;
+		}
+
 #ifdef SYNCDEBUG
 		case NETMSG_SD_CHKRESPONSE:
 		case NETMSG_SD_BLKRESPONSE:
@@ -2082,8 +2303,14 @@ void CGameServer::StartGame(bool forced)
 	assert(!gameHasStarted);
 	gameHasStarted = true;
 	startTime = gameTime;
-	if (!canReconnect && !allowSpecJoin)
-		packetCache.clear(); // free memory
+	if (!canReconnect && !allowSpecJoin) {
+		// nobody can join later, finish sending the cache to those who already did
+		for (GameParticipant& p: players) {
+			while (p.streamingCache && StreamPacketCache(p));
+		}
+
+		packetCache.Clear(); // free memory
+	}
 
 	if (UDPNet && !canReconnect && !allowSpecJoin)
 		UDPNet->SetAcceptingConnections(false); // do not accept new connections
@@ -2258,6 +2485,26 @@ void CGameServer::PushAction(const Action& action, bool fromAutoHost)
 			}
 		}
 	}
+	else if (action.command == "snapshotsource") {
+		// without a name only the host makes snapshots
+		snapshotSource = -1u;
+
+		if (!action.extra.empty()) {
+			const std::string name = StringToLower(action.extra);
+
+			for (const GameParticipant& p: players) {
+				if (p.isFromDemo)
+					continue;
+				if (StringToLower(p.name) == name) {
+					snapshotSource = p.id;
+					break;
+				}
+			}
+
+			if (snapshotSource == -1u)
+				LOG_L(L_WARNING, "[GameServer::%s] no player named \"%s\" to make game-state snapshots", __func__, action.extra.c_str());
+		}
+	}
 	else if (action.command == "nopause") {
 		InverseOrSetBool(gamePausable, action.extra);
 	}
@@ -2810,12 +3057,30 @@ unsigned CGameServer::BindConnection(std::string name, const std::string& passwd
 
 	newPlayer.Connected(link, isLocal);
 	newPlayer.SendData(std::shared_ptr<const RawPacket>(myGameData->Pack()));
-	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
 
-	// after gamedata and playerNum, the player can start loading
-	// throw at him all stuff he missed until now
-	for (const std::shared_ptr<const netcode::RawPacket>& p: packetCache)
-		newPlayer.SendData(p);
+	if (gameHasStarted && syncErrorFrame == 0 && !curGameState.packets.empty()) {
+		// the snapshot has to arrive before playerNum, the player starts loading with it
+		for (const std::shared_ptr<const netcode::RawPacket>& p: curGameState.packets)
+			newPlayer.SendData(p);
+
+		newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
+
+		// a part without data marks the end of the messages preceding the snapshot
+		newPlayer.snapshotCacheIndex = curGameState.cacheIndex;
+		newPlayer.snapshotEndMarker = CBaseNetProtocol::Get().SendGameState(curGameState.playerNum, curGameState.frameNum, curGameState.numBytes, curGameState.numBytes, {});
+
+		Message(spring::format(" -> Joining from snapshot of frame %d", curGameState.frameNum), false);
+	} else {
+		newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
+
+		newPlayer.snapshotCacheIndex = 0;
+		newPlayer.snapshotEndMarker.reset();
+	}
+
+	// after gamedata and playerNum, the player can start loading; all stuff
+	// it missed until now follows as its connection drains (see Update)
+	newPlayer.cacheIndex = 0;
+	newPlayer.streamingCache = true;
 
 	if (demoReader == NULL || myGameSetup->demoName.empty()) {
 		// player wants to play -> join team
@@ -2888,5 +3153,17 @@ uint8_t CGameServer::ReserveSkirmishAIId()
 
 void CGameServer::AddToPacketCache(std::shared_ptr<const netcode::RawPacket> &pckt)
 {
-	packetCache.push_back(pckt);
+	// report once per sealed segment, i.e. every PacketCacheSegmentLength seconds
+	if (packetCache.Add(pckt, serverFrameNum))
+		SendMemoryUsage();
+}
+
+void CGameServer::SendMemoryUsage()
+{
+	if (hostif == nullptr)
+		return;
+
+	const PacketCache::MemoryStats stats = packetCache.GetMemoryStats();
+
+	hostif->SendMemoryUsage(stats.numPackets, stats.numSegments, stats.rawBytes, stats.usedBytes, curGameState.numBytes);
 }
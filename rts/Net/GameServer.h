@@ -8,12 +8,12 @@
 #include <memory>
 #include <string>
 #include <array>
-#include <deque>
 #include <map>
 #include <set>
 #include <vector>
 
 #include "Game/GameData.h"
+#include "Net/PacketCache.h"
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/TeamBase.h"
 #include "System/float3.h"
@@ -160,6 +160,14 @@ private:
 
 	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet);
 
+	/// sends the next segment of the packet-cache to each client catching up whose connection drained
+	void UpdatePacketCacheStreams();
+	bool StreamPacketCache(GameParticipant& p);
+
+	/// asks the host or <snapshotSource> for a snapshot every <snapshotInterval> frames
+	void RequestGameStateSnapshot();
+	void GameStateReceived(const unsigned playerNum, std::shared_ptr<const netcode::RawPacket> packet);
+
 	/**
 	 * @brief skip frames
 	 *
@@ -172,6 +180,7 @@ private:
 	void PrivateMessage(int playerNum, const std::string& message);
 
 	void AddToPacketCache(std::shared_ptr<const netcode::RawPacket>& pckt);
+	void SendMemoryUsage();
 
 	float GetDemoTime() const;
 
@@ -241,7 +250,33 @@ private:
 	bool logInfoMessages;
 	bool logDebugMessages;
 
-	std::deque< std::shared_ptr<const netcode::RawPacket> > packetCache;
+	PacketCache packetCache;
+
+	struct GameStateSnapshot {
+		/// NETMSG_GAMESTATE parts as sent by the client, forwarded unchanged
+		std::vector< std::shared_ptr<const netcode::RawPacket> > packets;
+
+		/// number of packetCache entries the snapshot already includes
+		size_t cacheIndex = 0;
+		uint32_t numBytes = 0;
+
+		/// compressed size announced by every part
+		uint32_t totalSize = 0;
+
+		int frameNum = -1;
+		unsigned int playerNum = -1u;
+	};
+
+	/// latest complete snapshot, used for spectators joining mid-game
+	GameStateSnapshot curGameState;
+	/// snapshot being uploaded by the client it was requested from
+	GameStateSnapshot newGameState;
+
+	int snapshotInterval;
+	/// largest compressed snapshot accepted, in bytes
+	uint32_t snapshotMaxSize;
+	/// client chosen by the autohost (/snapshotsource) to make snapshots if there is no host
+	unsigned int snapshotSource;
 
 	/////////////////// sync stuff ///////////////////
 #ifdef SYNCCHECK
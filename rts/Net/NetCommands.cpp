@@ -233,6 +233,7 @@ void CGame::ClientReadNet()
 	// sim & drawing)
 	UpdateNumQueuedSimFrames();
 	UpdateNetMessageProcessingTimeLeft();
+	UploadGameStateSnapshot();
 
 	const spring_time msgProcEndTime = spring_gettime() + spring_msecs(GetNetMessageProcessingTimeLimit());
 
@@ -1078,6 +1079,15 @@ void CGame::ClientReadNet()
 
 						bool giveAwayOk = false;
 
+						// units given away before our snapshot are already part of it
+						if (snapshotReplay) {
+							if (giverTeam == player->team && numPlayersInGiverTeam != 1)
+								player->StartSpectating();
+
+							CPlayer::UpdateControlledTeams();
+							break;
+						}
+
 						if ((giveAwayOk = (giverTeam == player->team))) {
 							// player is giving stuff from his own team
 							if (numPlayersInGiverTeam == 1) {
@@ -1106,8 +1116,9 @@ void CGame::ClientReadNet()
 
 						player->StartSpectating();
 
-						// update all teams of which the player is leader
-						for (size_t t = 0; t < teamHandler.ActiveTeams(); ++t) {
+						// update all teams of which the player is leader (unless
+						// replayed from before our snapshot, which has the leaders)
+						for (size_t t = 0; t < teamHandler.ActiveTeams() && !snapshotReplay; ++t) {
 							CTeam* team = teamHandler.Team(t);
 
 							if (team->GetLeader() != playerNum)
@@ -1143,6 +1154,13 @@ void CGame::ClientReadNet()
 							break;
 						}
 
+						if (snapshotReplay) {
+							// the team itself is part of our snapshot
+							player->JoinTeam(newTeamNum);
+							player->SetControlledTeams();
+							break;
+						}
+
 						teamHandler.Team(newTeamNum)->AddPlayer(playerNum);
 					} break;
 					case TEAMMSG_TEAM_DIED: {
@@ -1208,7 +1226,7 @@ void CGame::ClientReadNet()
 						wordCompletion.AddWord(aiData.name + " ", false, false, false);
 					}
 
-					if (!tai->HasLeader())
+					if (!tai->HasLeader() && !snapshotReplay)
 						tai->SetLeader(playerNum);
 
 					CPlayer::UpdateControlledTeams();
@@ -1267,7 +1285,7 @@ void CGame::ClientReadNet()
 						aiData = nullptr;
 
 						// this could be done in the above function as well, team has no controller left now
-						if ((numPlayersInAITeam + numAIsInAITeam) == 1)
+						if ((numPlayersInAITeam + numAIsInAITeam) == 1 && !snapshotReplay)
 							tai->SetLeader(-1);
 
 						CPlayer::UpdateControlledTeams();
@@ -1410,7 +1428,7 @@ void CGame::ClientReadNet()
 
 					LOG("[Game::%s] added new player %s with number %d to team %d", __func__, name.c_str(), player.playerNum, player.team);
 
-					if (!player.spectator)
+					if (!player.spectator && !snapshotReplay)
 						eventHandler.TeamChanged(player.team);
 
 					CDemoRecorder* record = clientNet->GetDemoRecorder();
@@ -1461,6 +1479,20 @@ void CGame::ClientReadNet()
 			} break;
 
 
+			case NETMSG_GAMESTATE_REQUEST: {
+				SendGameStateSnapshot(*reinterpret_cast<const int32_t*>(inbuf + 1));
+				AddTraffic(-1, packetCode, dataLength);
+			} break;
+
+			// only relevant before the load-screen was created (see PreGame),
+			// except for the part without data that ends the replay of all
+			// messages preceding the snapshot we joined from
+			case NETMSG_GAMESTATE: {
+				snapshotReplay = false;
+				AddTraffic(-1, packetCode, dataLength);
+			} break;
+
+
 			// if we received this packet here we are the local host player
 			// (for which GetNumQueuedSimFrameMessages is not called where
 			// it would normally be processed), so discard it
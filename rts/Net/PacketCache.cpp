@@ -0,0 +1,132 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cstring>
+
+#include "PacketCache.h"
+#include "System/StringUtil.h"
+
+
+bool PacketCache::Add(const PacketPtr& packet, int frameNum)
+{
+	const bool sealed = (segmentFrames > 0 && !openPackets.empty() && (frameNum - openFrameNum) >= segmentFrames && Seal());
+
+	if (openPackets.empty())
+		openFrameNum = frameNum;
+
+	openPackets.push_back(packet);
+
+	numPackets += 1;
+	rawBytes += packet->length;
+	return sealed;
+}
+
+void PacketCache::Clear()
+{
+	segments.clear();
+	segments.shrink_to_fit();
+	openPackets.clear();
+	openPackets.shrink_to_fit();
+
+	numPackets = 0;
+	rawBytes = 0;
+	sealedBytes = 0;
+}
+
+bool PacketCache::Seal()
+{
+	std::vector<std::uint8_t> buffer;
+
+	size_t rawSize = 0;
+	size_t pos = 0;
+
+	for (const PacketPtr& p: openPackets) {
+		rawSize += (sizeof(std::uint32_t) + p->length);
+	}
+
+	buffer.resize(rawSize);
+
+	for (const PacketPtr& p: openPackets) {
+		std::memcpy(&buffer[pos], &p->length, sizeof(std::uint32_t));
+		pos += sizeof(std::uint32_t);
+
+		std::memcpy(&buffer[pos], p->data, p->length);
+		pos += p->length;
+	}
+
+	Segment segment = {zlib::deflate(buffer), numPackets - openPackets.size(), openPackets.size(), rawSize};
+
+	// keep everything uncompressed rather than losing packets
+	if (segment.data.empty())
+		return false;
+
+	sealedBytes += segment.data.size();
+	segments.push_back(std::move(segment));
+
+	openPackets.clear();
+	return true;
+}
+
+bool PacketCache::Read(size_t begin, size_t end, std::vector<PacketPtr>& packets) const
+{
+	const size_t openIndex = numPackets - openPackets.size();
+
+	end = std::min(end, numPackets);
+
+	if (begin >= end)
+		return true;
+
+	if (begin >= openIndex) {
+		packets.insert(packets.end(), openPackets.begin() + (begin - openIndex), openPackets.begin() + (end - openIndex));
+		return true;
+	}
+
+	// last segment starting at or before <begin>
+	const auto pred = [](size_t index, const Segment& s) { return (index < s.firstIndex); };
+	const Segment& segment = *(std::upper_bound(segments.begin(), segments.end(), begin, pred) - 1);
+	const std::vector<std::uint8_t> buffer = zlib::inflate(segment.data);
+
+	if (buffer.size() != segment.rawSize)
+		return false;
+
+	end = std::min(end, segment.firstIndex + segment.numPackets);
+
+	for (size_t n = segment.firstIndex, pos = 0; n < end; n++) {
+		std::uint32_t length;
+
+		if ((pos + sizeof(length)) > buffer.size())
+			return false;
+
+		std::memcpy(&length, &buffer[pos], sizeof(length));
+		pos += sizeof(length);
+
+		if ((pos + length) > buffer.size())
+			return false;
+
+		if (n >= begin)
+			packets.push_back(std::make_shared<const netcode::RawPacket>(&buffer[pos], length));
+
+		pos += length;
+	}
+
+	return true;
+}
+
+
+PacketCache::MemoryStats PacketCache::GetMemoryStats() const
+{
+	MemoryStats stats;
+
+	stats.numPackets = numPackets;
+	stats.numSegments = segments.size();
+	stats.rawBytes = rawBytes;
+	stats.usedBytes = sealedBytes + segments.capacity() * sizeof(Segment) + openPackets.capacity() * sizeof(PacketPtr);
+
+	// packets of the open segment are each a separate allocation; count the
+	// RawPacket object and (roughly) the shared_ptr control block with them
+	for (const PacketPtr& p: openPackets) {
+		stats.usedBytes += (p->length + sizeof(netcode::RawPacket) + sizeof(PacketPtr) * 2);
+	}
+
+	return stats;
+}
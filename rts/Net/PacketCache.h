@@ -0,0 +1,82 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _PACKET_CACHE_H
+#define _PACKET_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "System/Net/RawPacket.h"
+
+/**
+ * @brief Packets broadcast by the server, kept for clients joining mid-game
+ *
+ * Packets of the most recent <segmentFrames> frames are held as they were
+ * broadcast, older ones are packed into contiguous zlib-compressed segments
+ * (each a sequence of uint32 length + data records) and only inflated, one
+ * segment at a time, while being streamed to a joining client (see Read).
+ */
+class PacketCache
+{
+public:
+	typedef std::shared_ptr<const netcode::RawPacket> PacketPtr;
+
+	struct MemoryStats {
+		/// number of cached packets
+		size_t numPackets = 0;
+		/// number of compressed segments
+		size_t numSegments = 0;
+		/// sum of the lengths of all cached packets
+		size_t rawBytes = 0;
+		/// bytes held by the cache, including per-packet overhead of the open segment
+		size_t usedBytes = 0;
+	};
+
+public:
+	void SetSegmentFrames(int frames) { segmentFrames = frames; }
+
+	/**
+	 * @brief append a packet broadcast in frame <frameNum>
+	 * @return true if this sealed the open segment
+	 */
+	bool Add(const PacketPtr& packet, int frameNum);
+	void Clear();
+
+	size_t GetNumPackets() const { return numPackets; }
+	MemoryStats GetMemoryStats() const;
+
+	/**
+	 * @brief appends the packets with index in [begin, end) to <packets>,
+	 *   but at most those of the segment holding <begin>
+	 * @return false if that segment is corrupt
+	 */
+	bool Read(size_t begin, size_t end, std::vector<PacketPtr>& packets) const;
+
+private:
+	struct Segment {
+		std::vector<std::uint8_t> data;
+
+		/// index of the first packet in this segment
+		size_t firstIndex;
+		size_t numPackets;
+		/// size of <data> once inflated
+		size_t rawSize;
+	};
+
+	bool Seal();
+
+private:
+	std::vector<Segment> segments;
+	std::vector<PacketPtr> openPackets;
+
+	size_t numPackets = 0;
+	size_t rawBytes = 0;
+	size_t sealedBytes = 0;
+
+	/// frame in which the first packet of the open segment was added
+	int openFrameNum = 0;
+	int segmentFrames = 0;
+};
+
+#endif // _PACKET_CACHE_H
@@ -9,8 +9,10 @@
 #include "System/Net/ProtocolDef.h"
 #include <cinttypes>
 
+using netcode::AllocPacket;
 using netcode::PackPacket;
 typedef std::shared_ptr<const netcode::RawPacket> PacketType;
+typedef std::shared_ptr<PackPacket> PackPacketPtr;
 
 CBaseNetProtocol& CBaseNetProtocol::Get()
 {
@@ -20,14 +22,14 @@ CBaseNetProtocol& CBaseNetProtocol::Get()
 
 PacketType CBaseNetProtocol::SendKeyFrame(int32_t frameNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(frameNum), NETMSG_KEYFRAME);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(frameNum), NETMSG_KEYFRAME);
 	*packet << frameNum;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendNewFrame()
 {
-	return PacketType(new PackPacket(sizeof(uint8_t), NETMSG_NEWFRAME));
+	return AllocPacket<PackPacket>(sizeof(uint8_t), NETMSG_NEWFRAME);
 }
 
 
@@ -41,21 +43,21 @@ PacketType CBaseNetProtocol::SendQuit(const std::string& reason)
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_QUIT);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_QUIT);
 	*packet << static_cast<uint16_t>(packetSize) << reason;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendStartPlaying(uint32_t countdown)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(countdown), NETMSG_STARTPLAYING);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(countdown), NETMSG_STARTPLAYING);
 	*packet << countdown;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSetPlayerNum(uint8_t playerNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum), NETMSG_SETPLAYERNUM);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum), NETMSG_SETPLAYERNUM);
 	*packet << playerNum;
 	return PacketType(packet);
 }
@@ -66,14 +68,14 @@ PacketType CBaseNetProtocol::SendPlayerName(uint8_t playerNum, const std::string
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_PLAYERNAME);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_PLAYERNAME);
 	*packet << static_cast<uint8_t>(packetSize) << playerNum << playerName;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendRandSeed(uint32_t randSeed)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(randSeed), NETMSG_RANDSEED);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(randSeed), NETMSG_RANDSEED);
 	*packet << randSeed;
 	return PacketType(packet);
 }
@@ -81,14 +83,14 @@ PacketType CBaseNetProtocol::SendRandSeed(uint32_t randSeed)
 // NETMSG_GAMEID = 9, char gameID[16];
 PacketType CBaseNetProtocol::SendGameID(const uint8_t* buf)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + 16, NETMSG_GAMEID);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + 16, NETMSG_GAMEID);
 	memcpy(packet->GetWritingPos(), buf, 16);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendPathCheckSum(uint8_t playerNum, uint32_t checksum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(uint32_t), NETMSG_PATH_CHECKSUM);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(uint32_t), NETMSG_PATH_CHECKSUM);
 	*packet << playerNum;
 	*packet << checksum;
 	return PacketType(packet);
@@ -101,7 +103,7 @@ PacketType CBaseNetProtocol::SendCommand(uint8_t playerNum, int32_t id, uint8_t
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_COMMAND);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_COMMAND);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << id << options << params;
 	return PacketType(packet);
 }
@@ -112,7 +114,7 @@ PacketType CBaseNetProtocol::SendSelect(uint8_t playerNum, const std::vector<int
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SELECT);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_SELECT);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << selectedUnitIDs;
 	return PacketType(packet);
 }
@@ -120,7 +122,7 @@ PacketType CBaseNetProtocol::SendSelect(uint8_t playerNum, const std::vector<int
 
 PacketType CBaseNetProtocol::SendPause(uint8_t playerNum, uint8_t bPaused)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bPaused), NETMSG_PAUSE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bPaused), NETMSG_PAUSE);
 	*packet << playerNum << bPaused;
 	return PacketType(packet);
 }
@@ -148,7 +150,7 @@ PacketType CBaseNetProtocol::SendAICommand(
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendAICommand] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, commandTypeID);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, commandTypeID);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << aiID << unitID << commandID << options;
 
 	if (commandTypeID == NETMSG_AICOMMAND_TRACKED)
@@ -167,7 +169,7 @@ PacketType CBaseNetProtocol::SendAIShare(uint8_t playerNum, uint8_t aiID, uint8_
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendAIShare] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_AISHARE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_AISHARE);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << aiID << sourceTeam << destTeam << metal << energy << unitIDs;
 	return PacketType(packet);
 }
@@ -175,35 +177,35 @@ PacketType CBaseNetProtocol::SendAIShare(uint8_t playerNum, uint8_t aiID, uint8_
 
 PacketType CBaseNetProtocol::SendUserSpeed(uint8_t playerNum, float userSpeed)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(userSpeed), NETMSG_USER_SPEED);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(userSpeed), NETMSG_USER_SPEED);
 	*packet << playerNum << userSpeed;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendInternalSpeed(float internalSpeed)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(internalSpeed), NETMSG_INTERNAL_SPEED);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(internalSpeed), NETMSG_INTERNAL_SPEED);
 	*packet << internalSpeed;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendCPUUsage(float cpuUsage)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(cpuUsage), NETMSG_CPU_USAGE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(cpuUsage), NETMSG_CPU_USAGE);
 	*packet << cpuUsage;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendDirectControl(uint8_t playerNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum), NETMSG_DIRECT_CONTROL);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum), NETMSG_DIRECT_CONTROL);
 	*packet << playerNum;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendDirectControlUpdate(uint8_t playerNum, uint8_t status, int16_t heading, int16_t pitch)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(status) + sizeof(heading) + sizeof(pitch), NETMSG_DC_UPDATE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(status) + sizeof(heading) + sizeof(pitch), NETMSG_DC_UPDATE);
 	*packet << playerNum << status << heading << pitch;
 	return PacketType(packet);
 }
@@ -215,7 +217,7 @@ PacketType CBaseNetProtocol::SendAttemptConnect(const std::string& name, const s
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize , NETMSG_ATTEMPTCONNECT);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize , NETMSG_ATTEMPTCONNECT);
 	*packet << static_cast<uint16_t>(packetSize) << NETWORK_VERSION << name << passwd << version << uint8_t(reconnect) << uint8_t(netloss);
 	return PacketType(packet);
 }
@@ -227,7 +229,7 @@ PacketType CBaseNetProtocol::SendRejectConnect(const std::string& reason)
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_REJECT_CONNECT);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_REJECT_CONNECT);
 	*packet << static_cast<uint16_t>(packetSize) << reason;
 	return PacketType(packet);
 }
@@ -235,14 +237,14 @@ PacketType CBaseNetProtocol::SendRejectConnect(const std::string& reason)
 
 PacketType CBaseNetProtocol::SendShare(uint8_t playerNum, uint8_t shareTeam, uint8_t bShareUnits, float shareMetal, float shareEnergy)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(shareTeam) + sizeof(bShareUnits) + (sizeof(shareMetal) * 2), NETMSG_SHARE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(shareTeam) + sizeof(bShareUnits) + (sizeof(shareMetal) * 2), NETMSG_SHARE);
 	*packet << playerNum << shareTeam << bShareUnits << shareMetal << shareEnergy;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSetShare(uint8_t playerNum, uint8_t myTeam, float metalShareFraction, float energyShareFraction)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(myTeam) + (sizeof(metalShareFraction) * 2), NETMSG_SETSHARE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(myTeam) + (sizeof(metalShareFraction) * 2), NETMSG_SETSHARE);
 	*packet << playerNum << myTeam << metalShareFraction << energyShareFraction;
 	return PacketType(packet);
 }
@@ -250,14 +252,14 @@ PacketType CBaseNetProtocol::SendSetShare(uint8_t playerNum, uint8_t myTeam, flo
 
 PacketType CBaseNetProtocol::SendPlayerStat(uint8_t playerNum, const PlayerStatistics& currentStats)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(PlayerStatistics), NETMSG_PLAYERSTAT);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(PlayerStatistics), NETMSG_PLAYERSTAT);
 	*packet << playerNum << currentStats;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendTeamStat(uint8_t teamNum, const TeamStatistics& currentStats)
 {
-	PackPacket* packet = new netcode::PackPacket(sizeof(uint8_t) + sizeof(teamNum) + sizeof(TeamStatistics), NETMSG_TEAMSTAT);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(teamNum) + sizeof(TeamStatistics), NETMSG_TEAMSTAT);
 	*packet << teamNum << currentStats;
 	return PacketType(packet);
 }
@@ -270,7 +272,7 @@ PacketType CBaseNetProtocol::SendGameOver(uint8_t playerNum, const std::vector<u
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_GAMEOVER);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_GAMEOVER);
 	*packet << static_cast<uint8_t>(packetSize) << playerNum << winningAllyTeams;
 	return PacketType(packet);
 }
@@ -284,7 +286,7 @@ PacketType CBaseNetProtocol::SendMapErase(uint8_t playerNum, int16_t x, int16_t
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_MAPDRAW);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_MAPDRAW);
 	*packet << static_cast<uint8_t>(packetSize) << playerNum << drawType << x << z;
 	return PacketType(packet);
 }
@@ -298,7 +300,7 @@ PacketType CBaseNetProtocol::SendMapDrawPoint(uint8_t playerNum, int16_t x, int1
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_MAPDRAW);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_MAPDRAW);
 	*packet <<
 		static_cast<uint8_t>(packetSize) <<
 		playerNum <<
@@ -318,7 +320,7 @@ PacketType CBaseNetProtocol::SendMapDrawLine(uint8_t playerNum, int16_t x1, int1
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_MAPDRAW);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_MAPDRAW);
 	*packet <<
 		static_cast<uint8_t>(packetSize) <<
 		playerNum <<
@@ -332,7 +334,7 @@ PacketType CBaseNetProtocol::SendMapDrawLine(uint8_t playerNum, int16_t x1, int1
 
 PacketType CBaseNetProtocol::SendSyncResponse(uint8_t playerNum, int32_t frameNum, uint32_t checksum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(frameNum) + sizeof(checksum), NETMSG_SYNCRESPONSE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(frameNum) + sizeof(checksum), NETMSG_SYNCRESPONSE);
 	*packet << playerNum << frameNum << checksum;
 	return PacketType(packet);
 }
@@ -348,28 +350,28 @@ PacketType CBaseNetProtocol::SendSystemMessage(uint8_t playerNum, std::string me
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SYSTEMMSG);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_SYSTEMMSG);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << message;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendStartPos(uint8_t playerNum, uint8_t teamNum, uint8_t readyState, float x, float y, float z)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(teamNum) + sizeof(readyState) + (3 * sizeof(x)), NETMSG_STARTPOS);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(teamNum) + sizeof(readyState) + (3 * sizeof(x)), NETMSG_STARTPOS);
 	*packet << playerNum << teamNum << readyState << x << y << z;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendPlayerInfo(uint8_t playerNum, float cpuUsage, int32_t ping)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(cpuUsage) + sizeof(ping), NETMSG_PLAYERINFO);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(cpuUsage) + sizeof(ping), NETMSG_PLAYERINFO);
 	*packet << playerNum << cpuUsage << static_cast<uint32_t>(ping);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendPlayerLeft(uint8_t playerNum, uint8_t bIntended)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bIntended), NETMSG_PLAYERLEFT);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(bIntended), NETMSG_PLAYERLEFT);
 	*packet << playerNum << bIntended;
 	return PacketType(packet);
 }
@@ -384,7 +386,7 @@ PacketType CBaseNetProtocol::SendLogMsg(uint8_t playerNum, uint8_t logMsgLvl, co
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendLogMsg] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_LOGMSG);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_LOGMSG);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << logMsgLvl << strData;
 	return PacketType(packet);
 }
@@ -398,7 +400,7 @@ PacketType CBaseNetProtocol::SendLuaMsg(uint8_t playerNum, uint16_t script, uint
 	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
 		throw netcode::PackPacketException("[BaseNetProto::SendLuaMsg] maximum packet-size exceeded");
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_LUAMSG);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_LUAMSG);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << script << mode << rawData;
 	return PacketType(packet);
 }
@@ -406,28 +408,28 @@ PacketType CBaseNetProtocol::SendLuaMsg(uint8_t playerNum, uint16_t script, uint
 
 PacketType CBaseNetProtocol::SendGiveAwayEverything(uint8_t playerNum, uint8_t giveToTeam, uint8_t takeFromTeam)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(giveToTeam) + sizeof(takeFromTeam), NETMSG_TEAM);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(giveToTeam) + sizeof(takeFromTeam), NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_GIVEAWAY) << giveToTeam << takeFromTeam;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendResign(uint8_t playerNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + 1 + 1, NETMSG_TEAM);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + 1 + 1 + 1, NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_RESIGN) << static_cast<uint8_t>(0) << static_cast<uint8_t>(0);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendJoinTeam(uint8_t playerNum, uint8_t wantedTeamNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(wantedTeamNum) + 1, NETMSG_TEAM);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(wantedTeamNum) + 1, NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_JOIN_TEAM) << wantedTeamNum << static_cast<uint8_t>(0);
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendTeamDied(uint8_t playerNum, uint8_t whichTeam)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(whichTeam) + 1, NETMSG_TEAM);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + 1 + sizeof(whichTeam) + 1, NETMSG_TEAM);
 	*packet << playerNum << static_cast<uint8_t>(TEAMMSG_TEAM_DIED) << whichTeam << static_cast<uint8_t>(0);
 	return PacketType(packet);
 }
@@ -439,7 +441,7 @@ PacketType CBaseNetProtocol::SendAICreated(uint8_t playerNum, uint8_t whichSkirm
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_AI_CREATED);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_AI_CREATED);
 	*packet
 		<< static_cast<uint8_t>(packetSize)
 		<< playerNum
@@ -452,14 +454,14 @@ PacketType CBaseNetProtocol::SendAICreated(uint8_t playerNum, uint8_t whichSkirm
 PacketType CBaseNetProtocol::SendAIStateChanged(uint8_t playerNum, uint8_t whichSkirmishAI, uint8_t newState)
 {
 	// do not hand optimize this math; the compiler will do that
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichSkirmishAI) + sizeof(newState), NETMSG_AI_STATE_CHANGED);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichSkirmishAI) + sizeof(newState), NETMSG_AI_STATE_CHANGED);
 	*packet << playerNum << whichSkirmishAI << newState;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSetAllied(uint8_t playerNum, uint8_t whichAllyTeam, uint8_t state)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichAllyTeam) + sizeof(state), NETMSG_ALLIANCE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(playerNum) + sizeof(whichAllyTeam) + sizeof(state), NETMSG_ALLIANCE);
 	*packet << playerNum << whichAllyTeam << state;
 	return PacketType(packet);
 }
@@ -471,7 +473,7 @@ PacketType CBaseNetProtocol::SendCreateNewPlayer(uint8_t playerNum, bool spectat
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_CREATE_NEWPLAYER);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_CREATE_NEWPLAYER);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << (uint8_t)spectator << teamNum << playerName;
 	return PacketType(packet);
 
@@ -479,7 +481,7 @@ PacketType CBaseNetProtocol::SendCreateNewPlayer(uint8_t playerNum, bool spectat
 
 PacketType CBaseNetProtocol::SendCurrentFrameProgress(int32_t frameNum)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(frameNum), NETMSG_GAME_FRAME_PROGRESS);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(frameNum), NETMSG_GAME_FRAME_PROGRESS);
 	*packet << frameNum;
 	return PacketType(packet);
 }
@@ -490,7 +492,7 @@ PacketType CBaseNetProtocol::SendPing(uint8_t playerNum, uint8_t pingTag, float
 	const uint32_t headerSize = sizeof(uint8_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_PING);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_PING);
 	*packet << playerNum;
 	*packet << pingTag;
 	*packet << localTime;
@@ -504,7 +506,7 @@ PacketType CBaseNetProtocol::SendClientData(uint8_t playerNum, const std::vector
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_CLIENTDATA);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_CLIENTDATA);
 	*packet << static_cast<uint16_t>(packetSize);
 	*packet << playerNum;
 	*packet << data;
@@ -513,11 +515,33 @@ PacketType CBaseNetProtocol::SendClientData(uint8_t playerNum, const std::vector
 }
 
 
+PacketType CBaseNetProtocol::SendGameStateRequest(int32_t frameNum)
+{
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(frameNum), NETMSG_GAMESTATE_REQUEST);
+	*packet << frameNum;
+	return PacketType(packet);
+}
+
+PacketType CBaseNetProtocol::SendGameState(uint8_t playerNum, int32_t frameNum, uint32_t totalSize, uint32_t offset, const std::vector<uint8_t>& data)
+{
+	const uint32_t payloadSize = sizeof(playerNum) + sizeof(frameNum) + sizeof(totalSize) + sizeof(offset) + data.size();
+	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
+	const uint32_t packetSize = headerSize + payloadSize;
+
+	if (packetSize >= (1 << (sizeof(uint16_t) * 8)))
+		throw netcode::PackPacketException("[BaseNetProto::SendGameState] maximum packet-size exceeded");
+
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_GAMESTATE);
+	*packet << static_cast<uint16_t>(packetSize) << playerNum << frameNum << totalSize << offset << data;
+	return PacketType(packet);
+}
+
+
 
 #ifdef SYNCDEBUG
 PacketType CBaseNetProtocol::SendSdCheckrequest(int32_t frameNum)
 {
-	PackPacket* packet = new PackPacket(5, NETMSG_SD_CHKREQUEST);
+	PackPacketPtr packet = AllocPacket<PackPacket>(5, NETMSG_SD_CHKREQUEST);
 	*packet << frameNum;
 	return PacketType(packet);
 }
@@ -528,20 +552,20 @@ PacketType CBaseNetProtocol::SendSdCheckresponse(uint8_t playerNum, uint64_t flo
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SD_CHKRESPONSE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_SD_CHKRESPONSE);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << flop << checksums;
 	return PacketType(packet);
 }
 
 PacketType CBaseNetProtocol::SendSdReset()
 {
-	return PacketType(new PackPacket(sizeof(uint8_t), NETMSG_SD_RESET));
+	return AllocPacket<PackPacket>(sizeof(uint8_t), NETMSG_SD_RESET);
 }
 
 
 PacketType CBaseNetProtocol::SendSdBlockrequest(uint16_t begin, uint16_t length, uint16_t requestSize)
 {
-	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(begin) + sizeof(length) + sizeof(requestSize), NETMSG_SD_BLKREQUEST);
+	PackPacketPtr packet = AllocPacket<PackPacket>(sizeof(uint8_t) + sizeof(begin) + sizeof(length) + sizeof(requestSize), NETMSG_SD_BLKREQUEST);
 	*packet << begin << length << requestSize;
 	return PacketType(packet);
 
@@ -553,7 +577,7 @@ PacketType CBaseNetProtocol::SendSdBlockresponse(uint8_t playerNum, std::vector<
 	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint16_t);
 	const uint32_t packetSize = headerSize + payloadSize;
 
-	PackPacket* packet = new PackPacket(packetSize, NETMSG_SD_BLKRESPONSE);
+	PackPacketPtr packet = AllocPacket<PackPacket>(packetSize, NETMSG_SD_BLKRESPONSE);
 	*packet << static_cast<uint16_t>(packetSize) << playerNum << checksums;
 	return PacketType(packet);
 }
@@ -620,6 +644,9 @@ CBaseNetProtocol::CBaseNetProtocol()
 	proto->AddType(NETMSG_AI_STATE_CHANGED, 4);
 	proto->AddType(NETMSG_GAME_FRAME_PROGRESS, 5);
 	proto->AddType(NETMSG_PING, 1 + (1 + 1 + 4));
+	proto->AddType(NETMSG_GAMESTATE_REQUEST, 5);
+	proto->AddType(NETMSG_GAMESTATE, -2);
+	proto->AddType(NETMSG_COMPRESSION, 2);
 
 #ifdef SYNCDEBUG
 	proto->AddType(NETMSG_SD_CHKREQUEST, 5);
@@ -26,6 +26,11 @@ struct PlayerStatistics;
 struct TeamStatistics;
 
 
+/// maximum number of snapshot bytes carried by one NETMSG_GAMESTATE
+static constexpr uint32_t GAMESTATE_PART_SIZE = 32768;
+/// size of the NETMSG_GAMESTATE fields preceding the snapshot bytes
+static constexpr uint32_t GAMESTATE_HEADER_SIZE = 1 + 2 + 1 + 4 + 4 + 4;
+
 static const uint16_t NETWORK_VERSION = atoi(SpringVersion::GetMajor().c_str());
 
 
@@ -110,6 +115,11 @@ public:
 
 	PacketType SendClientData(uint8_t playerNum, const std::vector<uint8_t>& data);
 
+	/// asks one client for a snapshot of the game-state as it is after the last frame sent
+	PacketType SendGameStateRequest(int32_t frameNum);
+	/// one part of a compressed snapshot, at most GAMESTATE_PART_SIZE bytes of <data> each
+	PacketType SendGameState(uint8_t playerNum, int32_t frameNum, uint32_t totalSize, uint32_t offset, const std::vector<uint8_t>& data);
+
 #ifdef SYNCDEBUG
 	PacketType SendSdCheckrequest(int32_t frameNum);
 	PacketType SendSdCheckresponse(uint8_t playerNum, uint64_t flop, std::vector<uint32_t> checksums);
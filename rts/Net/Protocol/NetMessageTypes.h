@@ -93,6 +93,14 @@ enum NETMSG {
 
 	NETMSG_PING = 78, // uint8_t playerNum, uint8_t pingTag, float localTime
 
+	NETMSG_GAMESTATE_REQUEST= 79, // int32_t frameNum # sent by the server to one in-sync client, which answers with NETMSG_GAMESTATE #
+	NETMSG_GAMESTATE        = 80, // uint16_t messageSize, uint8_t playerNum, int32_t frameNum, uint32_t totalSize, uint32_t offset,
+	                              // std::vector<uint8_t> data # one part of a zlib-compressed creg game-state, forwarded to spectators joining mid-game;
+	                              // a part without data follows the replayed messages preceding the snapshot, one with
+	                              // totalSize 0 refuses the request (synced Lua state can not be saved) #
+
+	NETMSG_COMPRESSION      = 81, // uint8_t mode # consumed by UDPConnection, see CompressionMode #
+
 	NETMSG_LAST //max types of netmessages, internal only
 };
 
@@ -108,6 +116,12 @@ enum TEAMMSG {
 //TODO: in-game allyteams
 };
 
+/// modes of NETMSG_COMPRESSION
+enum CompressionMode {
+	COMPRESSION_OFFER       = 0, // sender can inflate and wants the other side to compress what it sends
+	COMPRESSION_START       = 1, // always ends its chunk; all later chunks from the sender are one raw-deflate stream
+};
+
 /// sub-action-types of NETMSG_MAPDRAW
 enum MapDrawAction {
 	MAPDRAW_POINT,
@@ -381,6 +381,9 @@ void DefaultPathDrawer::Draw(const CPathEstimator* pe) const {
 
 	if (md == nullptr)
 		return;
+	// nothing to show until a path has been requested for this type
+	if (!pe->IsPathTypeLoaded(md->pathType))
+		return;
 
 	GL::RenderDataBufferC* rdbc = GL::GetRenderBufferC();
 	Shader::IProgramObject* prog = rdbc->GetShader();
@@ -397,7 +400,6 @@ void DefaultPathDrawer::Draw(const CPathEstimator* pe) const {
 	// compiling)
 	if (drawLowResPE || drawMedResPE) {
 		const int2 peNumBlocks = pe->GetNumBlocks();
-		const int vertexBaseNr = md->pathType * peNumBlocks.x * peNumBlocks.y * PATH_DIRECTION_VERTICES;
 
 		for (int z = 0; z < peNumBlocks.y; z++) {
 			for (int x = 0; x < peNumBlocks.x; x++) {
@@ -424,9 +426,9 @@ void DefaultPathDrawer::Draw(const CPathEstimator* pe) const {
 					if (obz >= peNumBlocks.y) continue;
 
 					const int obBlockNr = obz * peNumBlocks.x + obx;
-					const int vertexNr = vertexBaseNr + blockNr * PATH_DIRECTION_VERTICES + GetBlockVertexOffset(dir, peNumBlocks.x);
+					const int vertexNr = blockNr * PATH_DIRECTION_VERTICES + GetBlockVertexOffset(dir, peNumBlocks.x);
 
-					const float rawCost = pe->vertexCosts[vertexNr];
+					const float rawCost = pe->vertexCosts[md->pathType][vertexNr];
 					const float nrmCost = (rawCost * PATH_NODE_SPACING) / pe->BLOCK_SIZE;
 
 					if (rawCost >= PATHCOST_INFINITY)
@@ -470,10 +472,10 @@ void DefaultPathDrawer::Draw(const CPathEstimator* pe) const {
 					if (obz >= peNumBlocks.y) continue;
 
 					const int obBlockNr = obz * peNumBlocks.x + obx;
-					const int vertexNr = vertexBaseNr + blockNr * PATH_DIRECTION_VERTICES + GetBlockVertexOffset(dir, peNumBlocks.x);
+					const int vertexNr = blockNr * PATH_DIRECTION_VERTICES + GetBlockVertexOffset(dir, peNumBlocks.x);
 
 					// rescale so numbers remain near 1.0 (more readable)
-					const float rawCost = pe->vertexCosts[vertexNr];
+					const float rawCost = pe->vertexCosts[md->pathType][vertexNr];
 					const float nrmCost = (rawCost * PATH_NODE_SPACING) / pe->BLOCK_SIZE;
 
 					if (rawCost >= PATHCOST_INFINITY)
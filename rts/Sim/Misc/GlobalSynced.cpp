@@ -43,7 +43,9 @@ CR_REG_METADATA(CGlobalSynced, (
 	CR_MEMBER(cheatEnabled),
 	CR_MEMBER(noHelperAIs),
 	CR_MEMBER(editDefsEnabled),
-	CR_MEMBER(useLuaGaia)
+	CR_MEMBER(useLuaGaia),
+
+	CR_SERIALIZER(Serialize)
 ))
 
 
@@ -53,6 +55,16 @@ void CGlobalSynced::Kill()
 }
 
 
+#ifdef USING_CREG
+void CGlobalSynced::Serialize(creg::ISerializer* s)
+{
+	// gsRNG is not a member, but every synced random number
+	// drawn after loading depends on its state being restored
+	gsRNG.Serialize(s);
+}
+#endif
+
+
 void CGlobalSynced::ResetState() {
 	frameNum = -1; // first real frame is 0
 	tempNum  =  1;
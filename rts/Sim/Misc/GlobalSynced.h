@@ -28,6 +28,8 @@ public:
 	void ResetState();
 	void LoadFromSetup(const CGameSetup*);
 
+	void Serialize(creg::ISerializer* s);
+
 	// Lua should never see the pre-simframe value
 	int GetLuaSimFrame() { return (frameNum * (frameNum > 0)); }
 	int GetTempNum() { return tempNum++; }
@@ -41,7 +41,9 @@ CR_REG_METADATA(CLosHandler,(
 	CR_MEMBER(baseRadarErrorSize),
 	CR_MEMBER(baseRadarErrorMult),
 	CR_MEMBER(radarErrorSizes),
-	CR_IGNORED(losTypes)
+	CR_IGNORED(losTypes),
+	CR_IGNORED(mergeJobs),
+	CR_IGNORED(raycastJobs)
 ))
 
 
@@ -123,6 +125,11 @@ void ILosType::Kill()
 	losDeleted.clear();
 	losRecalc.clear();
 
+	losRemoveOffsets.clear();
+	losAddOffsets.clear();
+
+	haveUpdates = false;
+
 	// mark as invalid
 	size = {0, 0};
 }
@@ -268,25 +275,28 @@ inline void ILosType::RemoveUnit(CUnit* unit, bool delayed)
 }
 
 
-inline void ILosType::LosAdd(SLosInstance* li)
+inline void ILosType::LosAdd(SLosInstance* li, const MergeJob& job)
 {
 	assert(li);
 	assert(teamHandler.IsValidAllyTeam(li->allyteam));
+	assert(li->allyteam == job.allyTeam);
 
 	if (algoType == LOS_ALGO_RAYCAST) {
-		losMaps[li->allyteam].AddRaycast(li, 1);
+		losMaps[li->allyteam].AddRaycast(li, 1, job.minRow, job.maxRow);
 	} else {
-		losMaps[li->allyteam].AddCircle(li, 1);
+		losMaps[li->allyteam].AddCircle(li, 1, job.minRow, job.maxRow);
 	}
 }
 
 
-inline void ILosType::LosRemove(SLosInstance* li)
+inline void ILosType::LosRemove(SLosInstance* li, const MergeJob& job)
 {
+	assert(li->allyteam == job.allyTeam);
+
 	if (algoType == LOS_ALGO_RAYCAST) {
-		losMaps[li->allyteam].AddRaycast(li, -1);
+		losMaps[li->allyteam].AddRaycast(li, -1, job.minRow, job.maxRow);
 	} else {
-		losMaps[li->allyteam].AddCircle(li, -1);
+		losMaps[li->allyteam].AddCircle(li, -1, job.minRow, job.maxRow);
 	}
 }
 
@@ -474,8 +484,29 @@ inline int ILosType::GetHashNum(const int allyteam, const int2 baseLos, const fl
 }
 
 
-void ILosType::Update()
+// stable grouping by allyteam, keeps the per-square order of map updates
+static void GroupByAllyTeam(std::vector<SLosInstance*>& insts, std::vector<int>& offsets, size_t numAllyTeams)
 {
+	const auto AllyTeamLess = [](const SLosInstance* a, const SLosInstance* b) { return (a->allyteam < b->allyteam); };
+
+	std::stable_sort(insts.begin(), insts.end(), AllyTeamLess);
+
+	offsets.clear();
+	offsets.resize(numAllyTeams + 1, 0);
+
+	for (const SLosInstance* li: insts) {
+		offsets[li->allyteam + 1] += 1;
+	}
+	for (size_t n = 1; n <= numAllyTeams; n++) {
+		offsets[n] += offsets[n - 1];
+	}
+}
+
+
+void ILosType::UpdateQueues()
+{
+	haveUpdates = false;
+
 	// delayed delete
 	while (!delayedDeleteQue.empty() && delayedDeleteQue.front().timeoutTime < gs->frameNum) {
 		UnrefInstance(delayedDeleteQue.front().instance);
@@ -503,11 +534,10 @@ void ILosType::Update()
 	losAdd.reserve(losUpdate.size());
 	losDeleted.clear();
 	losDeleted.reserve(losUpdate.size());
+	losRecalc.clear();
 
-	if (algoType == LOS_ALGO_RAYCAST) {
-		losRecalc.clear();
+	if (algoType == LOS_ALGO_RAYCAST)
 		losRecalc.reserve(losUpdate.size());
-	}
 
 	// filter the updates into their subparts
 	for (SLosInstance* li: losUpdate) {
@@ -545,27 +575,75 @@ void ILosType::Update()
 		}
 	}
 
-	// remove sight
-	//FIXME multithread?
-	for (SLosInstance* li: losRemove) {
-		LosRemove(li);
+	// each allyteam's map is merged separately (and in bands), so
+	// all instances touching one map have to be contiguous
+	GroupByAllyTeam(losRemove, losRemoveOffsets, losMaps.size());
+	GroupByAllyTeam(losAdd, losAddOffsets, losMaps.size());
+
+	haveUpdates = true;
+}
+
+
+void ILosType::GetUpdateJobs(std::vector<MergeJob>& mergeJobs, std::vector<RaycastJob>& raycastJobs)
+{
+	if (!haveUpdates)
+		return;
+
+	for (SLosInstance* li: losRecalc) {
+		raycastJobs.push_back({this, li});
 	}
 
-	// raycast terrain
-	if (algoType == LOS_ALGO_RAYCAST)  {
-		for_mt(0, losRecalc.size(), [&](const int idx) {
-			auto li = losRecalc[idx];
-			assert(li->refCount > 0);
-			li->squares.clear();
-			losMaps[li->allyteam].PrepareRaycast(li);
-		});
+	for (size_t at = 0; at < losMaps.size(); at++) {
+		const int numRemoves = losRemoveOffsets[at + 1] - losRemoveOffsets[at];
+		const int numAdds = losAddOffsets[at + 1] - losAddOffsets[at];
+
+		if ((numRemoves + numAdds) == 0)
+			continue;
+
+		const CLosMap& losMap = losMaps[at];
+
+		// only split maps if there is enough work for more than one band
+		int numBands = 1;
+
+		if (losMap.AllowBandedMerge(at))
+			numBands = Clamp(std::min(size.y / MIN_MERGE_ROWS, numRemoves + numAdds), 1, ThreadPool::GetNumThreads());
+
+		for (int n = 0; n < numBands; n++) {
+			mergeJobs.push_back({this, int(at), (size.y * n) / numBands, (size.y * (n + 1)) / numBands});
+		}
 	}
+}
 
-	// add sight
-	for (SLosInstance* li: losAdd) {
-		assert(li->refCount > 0);
-		LosAdd(li);
+
+void ILosType::MergeRemoves(const MergeJob& job)
+{
+	for (int i = losRemoveOffsets[job.allyTeam], n = losRemoveOffsets[job.allyTeam + 1]; i < n; i++) {
+		LosRemove(losRemove[i], job);
 	}
+}
+
+
+void ILosType::Raycast(SLosInstance* li)
+{
+	assert(li->refCount > 0);
+	li->squares.clear();
+	losMaps[li->allyteam].PrepareRaycast(li);
+}
+
+
+void ILosType::MergeAdds(const MergeJob& job)
+{
+	for (int i = losAddOffsets[job.allyTeam], n = losAddOffsets[job.allyTeam + 1]; i < n; i++) {
+		assert(losAdd[i]->refCount > 0);
+		LosAdd(losAdd[i], job);
+	}
+}
+
+
+void ILosType::UpdateInstances()
+{
+	if (!haveUpdates)
+		return;
 
 	// delete / move to cache unused instances
 	if (algoType == LOS_ALGO_RAYCAST) {
@@ -588,6 +666,7 @@ void ILosType::Update()
 	}
 
 	losUpdate.clear();
+	haveUpdates = false;
 }
 
 
@@ -804,7 +883,35 @@ void CLosHandler::Update()
 		}
 		#endif
 
-		lt->Update();
+		lt->UpdateQueues();
+	});
+
+	// the remaining stages are flattened over all types, so that a burst of
+	// (re)casts in one type is spread over all threads instead of just one
+	mergeJobs.clear();
+	raycastJobs.clear();
+
+	for (ILosType* lt: losTypes) {
+		lt->GetUpdateJobs(mergeJobs, raycastJobs);
+	}
+
+	// remove sight; must be done before instances are recast
+	for_mt(0, mergeJobs.size(), [&](const int idx) {
+		mergeJobs[idx].type->MergeRemoves(mergeJobs[idx]);
+	});
+
+	// raycast terrain
+	for_mt(0, raycastJobs.size(), [&](const int idx) {
+		raycastJobs[idx].type->Raycast(raycastJobs[idx].instance);
+	});
+
+	// add sight
+	for_mt(0, mergeJobs.size(), [&](const int idx) {
+		mergeJobs[idx].type->MergeAdds(mergeJobs[idx]);
+	});
+
+	for_mt(0, losTypes.size(), [&](const int idx) {
+		losTypes[idx]->UpdateInstances();
 	});
 }
 
@@ -817,7 +924,7 @@ void CLosHandler::UpdateHeightMapSynced(SRectangle rect)
 }
 
 
-bool CLosHandler::InLos(const CUnit* unit, int allyTeam) const
+bool CLosHandler::InLos(const LosUnitInfo& unit, int allyTeam) const
 {
 	// NOTE: units are treated differently than world objects in two ways:
 	//   1. they can be cloaked (has to be checked BEFORE all other cases)
@@ -826,34 +933,34 @@ bool CLosHandler::InLos(const CUnit* unit, int allyTeam) const
 	//      is enabled --> underwater units can NOT BE SEEN AT ALL without
 	//      active radar!
 	if (modInfo.alwaysVisibleOverridesCloaked) {
-		if (unit->alwaysVisible)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_ALWAYS_VISIBLE))
 			return true;
-		if (unit->isCloaked && unit->allyteam != allyTeam)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_CLOAKED) && unit.allyteam != allyTeam)
 			return false;
 	} else {
-		if (unit->isCloaked && unit->allyteam != allyTeam)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_CLOAKED) && unit.allyteam != allyTeam)
 			return false;
-		if (unit->alwaysVisible)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_ALWAYS_VISIBLE))
 			return true;
 	}
 
 	// isCloaked always overrides globalLOS
 	if (globalLOS[allyTeam])
 		return true;
-	if (unit->useAirLos)
-		return (InAirLos(unit->pos, allyTeam) || InAirLos(unit->pos + unit->speed, allyTeam));
+	if (unit.HasFlag(CUnitHotState::LOS_FLAG_AIR_LOS))
+		return (InAirLos(unit.pos, allyTeam) || InAirLos(unit.pos + unit.speed, allyTeam));
 
 	if (modInfo.requireSonarUnderWater) {
-		if (unit->IsUnderWater() && !InRadar(unit, allyTeam)) {
+		if (unit.IsUnderWater() && !InRadar(unit, allyTeam)) {
 			return false;
 		}
 	}
 
-	return (InLos(unit->pos, allyTeam) || InLos(unit->pos + unit->speed, allyTeam));
+	return (InLos(unit.pos, allyTeam) || InLos(unit.pos + unit.speed, allyTeam));
 }
 
 
-bool CLosHandler::InAirLos(const CUnit* unit, int allyTeam) const
+bool CLosHandler::InAirLos(const LosUnitInfo& unit, int allyTeam) const
 {
 	// NOTE: units are treated differently than world objects in two ways:
 	//   1. they can be cloaked (has to be checked BEFORE all other cases)
@@ -862,14 +969,14 @@ bool CLosHandler::InAirLos(const CUnit* unit, int allyTeam) const
 	//      is enabled --> underwater units can NOT BE SEEN AT ALL without
 	//      active radar!
 	if (modInfo.alwaysVisibleOverridesCloaked) {
-		if (unit->alwaysVisible)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_ALWAYS_VISIBLE))
 			return true;
-		if (unit->isCloaked && unit->allyteam != allyTeam)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_CLOAKED) && unit.allyteam != allyTeam)
 			return false;
 	} else {
-		if (unit->isCloaked && unit->allyteam != allyTeam)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_CLOAKED) && unit.allyteam != allyTeam)
 			return false;
-		if (unit->alwaysVisible)
+		if (unit.HasFlag(CUnitHotState::LOS_FLAG_ALWAYS_VISIBLE))
 			return true;
 	}
 
@@ -878,11 +985,11 @@ bool CLosHandler::InAirLos(const CUnit* unit, int allyTeam) const
 		return true;
 
 	if (modInfo.requireSonarUnderWater) {
-		if (unit->IsUnderWater() && !InRadar(unit, allyTeam))
+		if (unit.IsUnderWater() && !InRadar(unit, allyTeam))
 			return false;
 	}
 
-	return airLos.InSight(unit->pos, allyTeam);
+	return airLos.InSight(unit.pos, allyTeam);
 }
 
 
@@ -897,25 +1004,25 @@ bool CLosHandler::InRadar(const float3 pos, int allyTeam) const
 }
 
 
-bool CLosHandler::InRadar(const CUnit* unit, int allyTeam) const
+bool CLosHandler::InRadar(const LosUnitInfo& unit, int allyTeam) const
 {
 	// unit is discoverable by sonar
-	if (unit->IsInWater()) {
-		if ((!unit->sonarStealth || unit->beingBuilt) &&
-		    sonar.InSight(unit->pos, allyTeam) &&
+	if (unit.IsInWater()) {
+		if ((!unit.HasFlag(CUnitHotState::LOS_FLAG_SONAR_STEALTH) || unit.HasFlag(CUnitHotState::LOS_FLAG_BEING_BUILT)) &&
+		    sonar.InSight(unit.pos, allyTeam) &&
 		    !InJammer(unit, allyTeam))
 			return true;
 	}
 
 	// unit is completely submerged, only sonar can see it
-	if (unit->IsUnderWater())
+	if (unit.IsUnderWater())
 		return false;
 
 	// radar stealth
-	if (unit->stealth && !unit->beingBuilt)
+	if (unit.HasFlag(CUnitHotState::LOS_FLAG_STEALTH) && !unit.HasFlag(CUnitHotState::LOS_FLAG_BEING_BUILT))
 		return false;
 
-	return (radar.InSight(unit->pos, allyTeam) && !InJammer(unit, allyTeam));
+	return (radar.InSight(unit.pos, allyTeam) && !InJammer(unit, allyTeam));
 }
 
 
@@ -930,17 +1037,17 @@ bool CLosHandler::InJammer(const float3 pos, int allyTeam) const
 }
 
 
-bool CLosHandler::InJammer(const CUnit* unit, int allyTeam) const
+bool CLosHandler::InJammer(const LosUnitInfo& unit, int allyTeam) const
 {
-	if (allyTeam == unit->allyteam)
+	if (allyTeam == unit.allyteam)
 		return false;
 
 	//TODO handle ingame alliances
 
-	const int jammerAlly = modInfo.separateJammers ? unit->allyteam : 0;
+	const int jammerAlly = modInfo.separateJammers ? unit.allyteam : 0;
 
-	if (unit->IsUnderWater()) {
-		return sonarJammer.InSight(unit->pos, jammerAlly);
+	if (unit.IsUnderWater()) {
+		return sonarJammer.InSight(unit.pos, jammerAlly);
 	}
-	return jammer.InSight(unit->pos, jammerAlly);
+	return jammer.InSight(unit.pos, jammerAlly);
 }
@@ -10,6 +10,7 @@
 #include "Sim/Misc/LosMap.h"
 #include "Sim/Objects/WorldObject.h"
 #include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitHotState.h"
 #include "System/type2.h"
 #include "System/Rectangle.h"
 #include "System/EventClient.h"
@@ -128,7 +129,26 @@ public:
 	void Kill();
 
 public:
-	void Update();
+	/// one band of rows on one allyteam's map; bands of a map never overlap
+	struct MergeJob {
+		ILosType* type;
+		int allyTeam;
+		int minRow;
+		int maxRow;
+	};
+	struct RaycastJob {
+		ILosType* type;
+		SLosInstance* instance;
+	};
+
+	// update stages, run in this order by CLosHandler::Update
+	void UpdateQueues();
+	void GetUpdateJobs(std::vector<MergeJob>& mergeJobs, std::vector<RaycastJob>& raycastJobs);
+	void MergeRemoves(const MergeJob& job);
+	void Raycast(SLosInstance* instance);
+	void MergeAdds(const MergeJob& job);
+	void UpdateInstances();
+
 	void UpdateHeightMapSynced(SRectangle rect);
 	void RemoveUnit(CUnit* unit, bool delayed = false);
 	void UpdateUnit(CUnit* unit, bool ignore = false);
@@ -136,8 +156,8 @@ public:
 private:
 	//void PostLoad();
 
-	void LosAdd(SLosInstance* instance);
-	void LosRemove(SLosInstance* instance);
+	void LosAdd(SLosInstance* instance, const MergeJob& job);
+	void LosRemove(SLosInstance* instance, const MergeJob& job);
 
 	void RefInstance(SLosInstance* instance);
 	void UnrefInstance(SLosInstance* instance);
@@ -192,12 +212,56 @@ private:
 	std::vector<SLosInstance*> losDeleted;
 	std::vector<SLosInstance*> losRecalc;
 
+	// losRemove and losAdd are grouped by allyteam, entries
+	// [offsets[n], offsets[n + 1]) belong to allyteam n
+	std::vector<int> losRemoveOffsets;
+	std::vector<int> losAddOffsets;
+
+	bool haveUpdates = false;
+
 	static constexpr int CACHE_SIZE = 4096;
+	// smallest band of rows handed to a single merge job
+	static constexpr int MIN_MERGE_ROWS = 32;
 };
 
 
 
 
+/**
+ * The unit fields LOS-tests depend on, read either from a unit or from
+ * its CUnitHotState mirror (by CUnitHandler's threaded LOS-status pass).
+ */
+struct LosUnitInfo
+{
+	explicit LosUnitInfo(const CUnit* unit)
+		: pos(unit->pos)
+		, speed(unit->speed)
+		, allyteam(unit->allyteam)
+		, physicalState(unit->physicalState)
+		, flags(CUnitHotState::GetLosFlags(unit))
+	{}
+	LosUnitInfo(const CUnitHotState& hotState, unsigned int unitID)
+		: pos(hotState.GetPos(unitID))
+		, speed(hotState.GetSpeed(unitID))
+		, allyteam(hotState.GetAllyTeam(unitID))
+		, physicalState(hotState.GetPhysicalState(unitID))
+		, flags(hotState.GetLosFlags(unitID))
+	{}
+
+	bool HasFlag(unsigned int flag) const { return ((flags & flag) != 0); }
+
+	bool IsInWater() const { return ((physicalState & CSolidObject::PSTATE_BIT_INWATER) != 0); }
+	bool IsUnderWater() const { return ((physicalState & CSolidObject::PSTATE_BIT_UNDERWATER) != 0); }
+
+	float3 pos;
+	float3 speed;
+
+	int allyteam;
+	unsigned int physicalState;
+	unsigned char flags;
+};
+
+
 /**
  * Handles line of sight (LOS) updates for all units and all ally-teams.
  *
@@ -216,7 +280,8 @@ public:
 	void Kill();
 
 	// the Interface
-	bool InLos(const CUnit* unit, int allyTeam) const;
+	bool InLos(const CUnit* unit, int allyTeam) const { return InLos(LosUnitInfo(unit), allyTeam); }
+	bool InLos(const LosUnitInfo& unit, int allyTeam) const;
 	bool InLos(const CWorldObject* obj, int allyTeam) const {
 		if (obj->alwaysVisible || globalLOS[allyTeam])
 			return true;
@@ -235,7 +300,8 @@ public:
 	}
 
 
-	bool InAirLos(const CUnit* unit, int allyTeam) const;
+	bool InAirLos(const CUnit* unit, int allyTeam) const { return InAirLos(LosUnitInfo(unit), allyTeam); }
+	bool InAirLos(const LosUnitInfo& unit, int allyTeam) const;
 	bool InAirLos(const CWorldObject* obj, int allyTeam) const {
 		if (obj->alwaysVisible || globalLOS[allyTeam])
 			return true;
@@ -250,13 +316,15 @@ public:
 
 
 	bool InRadar(const float3 pos, int allyTeam) const;
-	bool InRadar(const CUnit* unit, int allyTeam) const;
+	bool InRadar(const CUnit* unit, int allyTeam) const { return InRadar(LosUnitInfo(unit), allyTeam); }
+	bool InRadar(const LosUnitInfo& unit, int allyTeam) const;
 
 
 	// returns whether a square is being radar- or sonar-jammed
 	// (even when the square is not in radar- or sonar-coverage)
 	bool InJammer(const float3 pos, int allyTeam) const;
-	bool InJammer(const CUnit* unit, int allyTeam) const;
+	bool InJammer(const CUnit* unit, int allyTeam) const { return InJammer(LosUnitInfo(unit), allyTeam); }
+	bool InJammer(const LosUnitInfo& unit, int allyTeam) const;
 
 
 	bool InSeismicDistance(const CUnit* unit, int allyTeam) const {
@@ -320,6 +388,9 @@ private:
 
 	std::vector<float> radarErrorSizes;
 	std::array<ILosType*, 7> losTypes;
+
+	std::vector<ILosType::MergeJob> mergeJobs;
+	std::vector<ILosType::RaycastJob> raycastJobs;
 };
 
 
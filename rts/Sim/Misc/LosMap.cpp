@@ -5,6 +5,7 @@
 
 #include "LosMap.h"
 #include "LosHandler.h"
+#include "LosRays.h"
 #include "Map/ReadMap.h"
 #include "System/myMath.h"
 #include "System/float3.h"
@@ -15,8 +16,6 @@
 	#include "Game/GlobalUnsynced.h" // for myAllyTeam
 #endif
 
-constexpr float LOS_BONUS_HEIGHT = 5.0f;
-
 
 
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABLES;
@@ -24,6 +23,8 @@ static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABL
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_ANGLE_TABLES;
 static std::array<std::vector< char>, ThreadPool::MAX_THREADS> LOSRAY_SQUARE_TABLES; // visible squares per instance
 
+static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_QUAD_TABLES; // quad layout, see LosRays.h
+
 
 static float isqrtTableLookup(unsigned r, int threadNum)
 {
@@ -125,6 +126,10 @@ public:
 		return losTables[losSize][rayIndex][squareIdx];
 	}
 
+	const int2* GetLosTableRay(size_t losSize, size_t rayIndex) {
+		return losTables[losSize][rayIndex].data();
+	}
+
 	size_t GetLosTableRaySize(size_t losSize, size_t rayIndex) {
 		return losTables[losSize][rayIndex].size();
 	}
@@ -404,16 +409,23 @@ void CLosTableHelper::Debug(const LosTable& losRays, const std::vector<int2>& po
 //////////////////////////////////////////////////////////////////////
 /// CLosMap implementation
 
-void CLosMap::AddCircle(SLosInstance* instance, int amount)
+void CLosMap::AddCircle(SLosInstance* instance, int amount, int minRow, int maxRow)
 {
 #ifdef USE_UNSYNCED_HEIGHTMAP
 	//only AddRaycast supports UnsyncedHeightMap updates
 #endif
 
+	// circle does not overlap the band
+	if ((instance->basePos.y + instance->radius) < minRow || (instance->basePos.y - instance->radius) >= maxRow)
+		return;
+
+	const unsigned minY = std::max(minRow, 0);
+	const unsigned maxY = std::min(maxRow, size.y);
+
 	MidpointCircleAlgoPerLine(instance->radius, [&](int width, int y) {
 		const unsigned y_ = instance->basePos.y + y;
 
-		if (y_ < size.y) {
+		if (y_ >= minY && y_ < maxY) {
 			const unsigned sx = Clamp(instance->basePos.x - width,     0, size.x);
 			const unsigned ex = Clamp(instance->basePos.x + width + 1, 0, size.x);
 
@@ -425,21 +437,30 @@ void CLosMap::AddCircle(SLosInstance* instance, int amount)
 }
 
 
-void CLosMap::AddRaycast(SLosInstance* instance, int amount)
+void CLosMap::AddRaycast(SLosInstance* instance, int amount, int minRow, int maxRow)
 {
 	const auto& losSquares = instance->squares;
 
 	if (losSquares.empty() || losSquares[0].length == SLosInstance::EMPTY_RLE.length)
 		return;
 
+	// runs never cross a row and are sorted by start, so the band
+	// maps to one contiguous range of runs
+	const int minIdx = std::max(minRow, 0) * size.x;
+	const int maxIdx = std::min(maxRow, size.y) * size.x;
+
+	const auto RunStartLess = [](const SLosInstance::RLE& rle, int idx) { return (rle.start < idx); };
+	const auto begIt = std::lower_bound(losSquares.begin(), losSquares.end(), minIdx, RunStartLess);
+	const auto endIt = std::lower_bound(begIt, losSquares.end(), maxIdx, RunStartLess);
+
 #ifdef USE_UNSYNCED_HEIGHTMAP
 	// inform ReadMap when squares enter LoS
 	const bool visibleInstanceSquares = (instance->allyteam >= 0 && (instance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
 	const bool updateUnsyncedHeightMap = sendReadmapEvents && visibleInstanceSquares;
 
 	if ((amount > 0) && updateUnsyncedHeightMap) {
-		for (const SLosInstance::RLE rle: losSquares) {
-			for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
+		for (auto it = begIt; it != endIt; ++it) {
+			for (int idx = it->start, len = it->length; len > 0; --len, ++idx) {
 				losmap[idx] += amount;
 
 				// skip if this los-square did not *enter* LOS
@@ -459,14 +480,25 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 	}
 #endif
 
-	for (const SLosInstance::RLE rle: losSquares) {
-		for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
+	for (auto it = begIt; it != endIt; ++it) {
+		for (int idx = it->start, len = it->length; len > 0; --len, ++idx) {
 			losmap[idx] += amount;
 		}
 	}
 }
 
 
+bool CLosMap::AllowBandedMerge(int allyTeam) const
+{
+#ifdef USE_UNSYNCED_HEIGHTMAP
+	// UpdateLOS is a no-op for full-view spectators
+	return (!sendReadmapEvents || allyTeam != gu->myAllyTeam || gu->spectatingFullView);
+#else
+	return true;
+#endif
+}
+
+
 void CLosMap::PrepareRaycast(SLosInstance* instance) const
 {
 	if (!instance->squares.empty())
@@ -512,44 +544,6 @@ void CLosMap::LosAdd(SLosInstance* li) const
 }
 
 
-inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
-{
-	// [-radius, +radius]^2 -> [0, +2*radius]^2 -> idx
-	return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
-}
-
-
-inline void CastLos(
-	float* prvAngle,
-	float* maxAngle,
-	const int2& off,
-	std::vector<char>& losRaySquares,
-	std::vector<float>& raycastAngles,
-	int losRadius,
-	int threadNum
-) {
-	const size_t oidx = ToAngleMapIdx(off, losRadius);
-
-	// angle to square is smaller than current max-angle, so not visible
-	if (raycastAngles[oidx] < *maxAngle) {
-		losRaySquares[oidx] = false;
-		return;
-	}
-
-	if (raycastAngles[oidx] < *prvAngle) {
-		const float invR = isqrtTableLookup(off.x * off.x + off.y * off.y, threadNum);
-		const float angle = *prvAngle - LOS_BONUS_HEIGHT * invR;
-
-		if (raycastAngles[oidx] < (*maxAngle = angle)) {
-			losRaySquares[oidx] = false;
-			return;
-		}
-	}
-
-	*prvAngle = raycastAngles[oidx];
-}
-
-
 void CLosMap::AddSquaresToInstance(SLosInstance* li, const std::vector<char>& losRaySquares) const
 {
 	const int2 pos   = li->basePos;
@@ -603,14 +597,14 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	CLosTableHelper& helper = losTableHelpers[threadNum];
 
 	std::vector<char>& losRaySquares = LOSRAY_SQUARE_TABLES[threadNum];
-	std::vector<float>& raycastAngles = RAYCAST_ANGLE_TABLES[threadNum];
+	std::vector<float>& quadAngles = RAYCAST_QUAD_TABLES[threadNum];
 
 	helper.GenerateForLosSize(radius);
 
 	losRaySquares.clear();
 	losRaySquares.resize(Square((2 * radius) + 1), false);
-	raycastAngles.clear();
-	raycastAngles.resize(Square((2 * radius) + 1), -1e8);
+	quadAngles.clear();
+	quadAngles.resize(Square(radius + 1) * LOS_QUAD_LANES, -1e8);
 
 
 	isqrtTableExpand((radius + 1) * (radius + 1), threadNum);
@@ -620,33 +614,42 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	// 2. The heightmap is much bigger than the circle, and won't fit into the L2/L3. So
 	//    when we buffer the precalc in a vector just large enough for the processed data,
 	//    we reduce the amount of cache misses.
+	// 3. Angles are stored in quad layout (see LosRays.h), each lane covers one closed
+	//    quadrant of the circle. The center is skipped, squares on the axes are stored
+	//    in two quads.
 	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
-		const unsigned y_ = pos.y + y;
-		const unsigned sx = pos.x - width;
-		const unsigned ex = pos.x + width + 1;
+		const float* heights = &mipHeightMap[MAP_SQUARE(pos + int2(0, y))];
+		char* losRaySquaresPtr = &losRaySquares[ToAngleMapIdx(int2(0, y), radius)];
 
-		const size_t oidx = ToAngleMapIdx(int2(sx - pos.x, y), radius);
+		const auto GetAngle = [&](int x) {
+			const float invR = isqrtTableLookup(x*x + y*y, threadNum);
+			const float dh = std::max(0.0f, heights[x]) - losHeight;
 
-		float* raycastAnglesPtr = &raycastAngles[oidx];
-		char* losRaySquaresPtr = &losRaySquares[oidx];
+			return ((dh + LOS_BONUS_HEIGHT) * invR);
+		};
 
-		int idx = MAP_SQUARE(int2(sx, y_));
+		const int minX = -width;
+		const int maxX =  width;
 
-		for (unsigned x_ = sx; x_ < ex; ++x_) {
-			const int2 off(x_ - pos.x, y);
+		for (int x = minX; x <= maxX; ++x) {
+			losRaySquaresPtr[x] = true;
+		}
 
-			if (off == int2(0, 0)) {
-				++idx;
-				++raycastAnglesPtr;
-				++losRaySquaresPtr;
-				continue;
+		if (y >= 0) {
+			for (int x = (y == 0); x <= maxX; ++x) {
+				quadAngles[ToQuadMapIdx(int2(x, y), radius) * LOS_QUAD_LANES + 0] = GetAngle(x);
+			}
+			for (int x = minX; x <= -(y == 0); ++x) {
+				quadAngles[ToQuadMapIdx(int2(y, -x), radius) * LOS_QUAD_LANES + 3] = GetAngle(x);
+			}
+		}
+		if (y <= 0) {
+			for (int x = minX; x <= -(y == 0); ++x) {
+				quadAngles[ToQuadMapIdx(int2(-x, -y), radius) * LOS_QUAD_LANES + 1] = GetAngle(x);
+			}
+			for (int x = (y == 0); x <= maxX; ++x) {
+				quadAngles[ToQuadMapIdx(int2(-y, x), radius) * LOS_QUAD_LANES + 2] = GetAngle(x);
 			}
-
-			const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
-			const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
-
-			*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
-			*(losRaySquaresPtr++) = true;
 		}
 	});
 
@@ -654,21 +657,11 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
 
 	const size_t numRays = helper.GetLosTableSize(radius);
+	const float* isqrtTable = &RADIUS_ISQRT_TABLES[threadNum][0];
 
+	// no map-bounds checks needed here, so all four mirrored rays can be cast at once
 	for (size_t i = 0; i < numRays; ++i) {
-		float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-		float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-
-		const size_t numSquares = helper.GetLosTableRaySize(radius, i);
-
-		for (size_t n = 0; n < numSquares; n++) {
-			const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-			CastLos(&prvAngles[0], &maxAngles[0],       square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[1], &maxAngles[1],      -square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[2], &maxAngles[2], int2( square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y,  square.x), losRaySquares, raycastAngles, radius, threadNum);
-		}
+		CastLosQuadRays(helper.GetLosTableRay(radius, i), helper.GetLosTableRaySize(radius, i), &losRaySquares[0], &quadAngles[0], isqrtTable, radius);
 	}
 
 	// translate visible square indices to map square idx + RLE
@@ -740,6 +733,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 
 	// Cast the Rays
 	const size_t numRays = helper.GetLosTableSize(radius);
+	const float* isqrtTable = &RADIUS_ISQRT_TABLES[threadNum][0];
 
 	if (safeRect.Inside(pos)) {
 		losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
@@ -756,7 +750,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos + square))
 					break;
 
-				CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum);
+				CastLos(&prvAngles[0], &maxAngles[0],  square,                   &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 			}
 			for (size_t n = 0; n < numSquares; n++) {
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
@@ -764,7 +758,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos - square))
 					break;
 
-				CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum);
+				CastLos(&prvAngles[1], &maxAngles[1], -square,                   &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 			}
 			for (size_t n = 0; n < numSquares; n++) {
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
@@ -772,7 +766,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos + int2(square.y, -square.x)))
 					break;
 
-				CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
+				CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 			}
 			for (size_t n = 0; n < numSquares; n++) {
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
@@ -780,7 +774,7 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				if (!safeRect.Inside(pos + int2(-square.y, square.x)))
 					break;
 
-				CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum);
+				CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 			}
 		}
 	} else {
@@ -795,16 +789,16 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				const int2 square = helper.GetLosTableRaySquare(radius, i, n);
 
 				if (safeRect.Inside(pos + square))
-					CastLos(&prvAngles[0], &maxAngles[0],  square,                   losRaySquares, raycastAngles, radius, threadNum);
+					CastLos(&prvAngles[0], &maxAngles[0],  square,                   &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 
 				if (safeRect.Inside(pos - square))
-					CastLos(&prvAngles[1], &maxAngles[1], -square,                   losRaySquares, raycastAngles, radius, threadNum);
+					CastLos(&prvAngles[1], &maxAngles[1], -square,                   &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 
 				if (safeRect.Inside(pos + int2(square.y, -square.x)))
-					CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
+					CastLos(&prvAngles[2], &maxAngles[2], int2(square.y, -square.x), &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 
 				if (safeRect.Inside(pos + int2(-square.y, square.x)))
-					CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), losRaySquares, raycastAngles, radius, threadNum);
+					CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y, square.x), &losRaySquares[0], &raycastAngles[0], isqrtTable, radius);
 			}
 		}
 	}
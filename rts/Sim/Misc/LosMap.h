@@ -35,15 +35,25 @@ public:
 
 public:
 	/// circular area, for airLosMap, circular radar maps, jammer maps, ...
-	void AddCircle(SLosInstance* instance, int amount);
+	void AddCircle(SLosInstance* instance, int amount) { AddCircle(instance, amount, 0, size.y); }
+	/// as above, but only touches the rows in [minRow, maxRow)
+	void AddCircle(SLosInstance* instance, int amount, int minRow, int maxRow);
 
 	/// arbitrary area, for losMap, non-circular radar maps, ...
-	void AddRaycast(SLosInstance* instance, int amount);
+	void AddRaycast(SLosInstance* instance, int amount) { AddRaycast(instance, amount, 0, size.y); }
+	/// as above, but only touches the rows in [minRow, maxRow)
+	void AddRaycast(SLosInstance* instance, int amount, int minRow, int maxRow);
 
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void PrepareRaycast(SLosInstance* instance) const;
 
+	/// false if AddRaycast may send ReadMap events for <allyTeam>, which
+	/// are not thread-safe; merges into this map must then use one band
+	bool AllowBandedMerge(int allyTeam) const;
+
 public:
+	int2 GetSize() const { return size; }
+
 	int At(int2 p) const {
 		p.x = Clamp(p.x, 0, size.x - 1);
 		p.y = Clamp(p.y, 0, size.y - 1);
@@ -55,11 +65,14 @@ public:
 
 private:
 	void LosAdd(SLosInstance* instance) const;
-	void UnsafeLosAdd(SLosInstance* instance) const;
-	void SafeLosAdd(SLosInstance* instance) const;
 
 	void AddSquaresToInstance(SLosInstance* li, const std::vector<char>& losRaySquares) const;
 
+protected:
+	/// both produce the same squares for instances that do not touch the map borders (see LosRays test)
+	void UnsafeLosAdd(SLosInstance* instance) const;
+	void SafeLosAdd(SLosInstance* instance) const;
+
 protected:
 	int2 size;
 	int2 LOS2HEIGHT;
@@ -0,0 +1,160 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOS_RAYS_H
+#define LOS_RAYS_H
+
+#include <cstddef>
+
+#ifndef DEDICATED_NOSSE
+#include <xmmintrin.h>
+#endif
+
+#include "System/type2.h"
+
+/**
+ * Ray-casting kernels used by CLosMap (see CLosTableHelper for the rays).
+ *
+ * Every precalculated ray covers the upper-right quadrant and is cast together
+ * with its three mirror images, which are rotated by 180, -90 and +90 degrees
+ * and have the same distance to the center at each step.
+ *
+ * CastLos works on (2 * radius + 1)^2 tables centered on the instance. The
+ * quad layout used by CastLosQuadRays instead keeps the four mirrored squares
+ * of each offset (x, y) in [0, radius]^2 next to each other (lanes in the order
+ * above), so one step of all four rays is a single 4-wide load.
+ */
+
+static constexpr float LOS_BONUS_HEIGHT = 5.0f;
+static constexpr int LOS_QUAD_LANES = 4;
+
+
+inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
+{
+	// [-radius, +radius]^2 -> [0, +2*radius]^2 -> idx
+	return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
+}
+
+inline static constexpr size_t ToQuadMapIdx(const int2 p, const int radius)
+{
+	// [0, +radius]^2 -> idx
+	return p.y * (radius + 1) + p.x;
+}
+
+/// offset of <square> (in the upper-right quadrant) as seen by quad lane <lane>
+inline static int2 ToQuadLaneOffset(const int2 square, const int lane)
+{
+	switch (lane) {
+		case  0: return (      square              );
+		case  1: return (     -square              );
+		case  2: return (int2( square.y, -square.x));
+		default: return (int2(-square.y,  square.x));
+	}
+}
+
+
+inline void CastLos(
+	float* prvAngle,
+	float* maxAngle,
+	const int2& off,
+	char* losRaySquares,
+	const float* raycastAngles,
+	const float* isqrtTable,
+	int losRadius
+) {
+	const size_t oidx = ToAngleMapIdx(off, losRadius);
+
+	// angle to square is smaller than current max-angle, so not visible
+	if (raycastAngles[oidx] < *maxAngle) {
+		losRaySquares[oidx] = false;
+		return;
+	}
+
+	if (raycastAngles[oidx] < *prvAngle) {
+		const float invR = isqrtTable[off.x * off.x + off.y * off.y];
+		const float angle = *prvAngle - LOS_BONUS_HEIGHT * invR;
+
+		if (raycastAngles[oidx] < (*maxAngle = angle)) {
+			losRaySquares[oidx] = false;
+			return;
+		}
+	}
+
+	*prvAngle = raycastAngles[oidx];
+}
+
+
+/**
+ * Casts one ray and its mirror images over a quad-layout angle table and
+ * clears the squares they cannot see in <losRaySquares> (normal layout).
+ *
+ * Each lane performs exactly the same IEEE operations as CastLos, so the
+ * result is bit-identical. Only SSE1 is used since the engine is built with
+ * nothing newer (see SSE_FLAGS), and loads are unaligned since std::vector
+ * storage need not be 16-byte aligned.
+ */
+inline void CastLosQuadRays(
+	const int2* raySquares,
+	size_t numSquares,
+	char* losRaySquares,
+	const float* quadAngles,
+	const float* isqrtTable,
+	int losRadius
+) {
+#ifndef DEDICATED_NOSSE
+	const __m128 bonusHeight = _mm_set1_ps(LOS_BONUS_HEIGHT);
+
+	__m128 maxAngles = _mm_set1_ps(-1e7f);
+	__m128 prvAngles = _mm_set1_ps(-1e7f);
+
+	for (size_t n = 0; n < numSquares; n++) {
+		const int2 square = raySquares[n];
+
+		const __m128 angles = _mm_loadu_ps(&quadAngles[ToQuadMapIdx(square, losRadius) * LOS_QUAD_LANES]);
+		const __m128 invR = _mm_set1_ps(isqrtTable[square.x * square.x + square.y * square.y]);
+
+		// square is below the current max-angle
+		const __m128 belowMax = _mm_cmplt_ps(angles, maxAngles);
+		// descending after a hilltop, max-angle moves up to the hilltop's
+		const __m128 pastTop = _mm_andnot_ps(belowMax, _mm_cmplt_ps(angles, prvAngles));
+		const __m128 topAngles = _mm_sub_ps(prvAngles, _mm_mul_ps(bonusHeight, invR));
+		const __m128 belowTop = _mm_and_ps(pastTop, _mm_cmplt_ps(angles, topAngles));
+		const __m128 hidden = _mm_or_ps(belowMax, belowTop);
+
+		maxAngles = _mm_or_ps(_mm_and_ps(pastTop, topAngles), _mm_andnot_ps(pastTop, maxAngles));
+		prvAngles = _mm_or_ps(_mm_and_ps(hidden, prvAngles), _mm_andnot_ps(hidden, angles));
+
+		const int hiddenMask = _mm_movemask_ps(hidden);
+
+		if (hiddenMask == 0)
+			continue;
+
+		for (int k = 0; k < LOS_QUAD_LANES; k++) {
+			if ((hiddenMask & (1 << k)) != 0)
+				losRaySquares[ToAngleMapIdx(ToQuadLaneOffset(square, k), losRadius)] = false;
+		}
+	}
+#else
+	float maxAngles[LOS_QUAD_LANES] = {-1e7, -1e7, -1e7, -1e7};
+	float prvAngles[LOS_QUAD_LANES] = {-1e7, -1e7, -1e7, -1e7};
+
+	for (size_t n = 0; n < numSquares; n++) {
+		const int2 square = raySquares[n];
+		const size_t qidx = ToQuadMapIdx(square, losRadius);
+
+		const float invR = isqrtTable[square.x * square.x + square.y * square.y];
+
+		for (int k = 0; k < LOS_QUAD_LANES; k++) {
+			const float angle = quadAngles[qidx * LOS_QUAD_LANES + k];
+
+			if (angle < maxAngles[k] || (angle < prvAngles[k] && angle < (maxAngles[k] = prvAngles[k] - LOS_BONUS_HEIGHT * invR))) {
+				losRaySquares[ToAngleMapIdx(ToQuadLaneOffset(square, k), losRadius)] = false;
+				continue;
+			}
+
+			prvAngles[k] = angle;
+		}
+	}
+#endif
+}
+
+#endif // LOS_RAYS_H
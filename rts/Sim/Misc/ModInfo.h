@@ -153,6 +153,27 @@ public:
 	float pfRawDistMult;
 	float pfUpdateRate;
 
+	/// if true, CUnitHandler runs AMoveType::PreUpdate for all units on the ThreadPool before the serial Update pass
+	bool parallelMoveTypeUpdates;
+	/// if true, CUnitHandler calculates all units' LOS-status on the ThreadPool before (serially) applying it
+	bool parallelLosStatusUpdates;
+	/// if true, CProjectileHandler finds projectile collision candidates by sweep-and-prune instead of QuadField queries
+	bool projectileSweepAndPrune;
+	/// if positive, CQuadField shrinks its quads when the average number of objects per occupied quad exceeds this
+	float quadFieldMaxLoadFactor;
+	/// if true, CUnitHandler gathers auto-target candidates for the SlowUpdate'd units' weapons on the ThreadPool
+	bool parallelWeaponTargeting;
+	/// if true, the default pathfinder queues units' path-requests and resolves them on the ThreadPool once per frame
+	bool parallelPathRequests;
+	/// if true, the default pathfinder lets same-frame path-requests between the same PE blocks share one search
+	bool sharedPathRequests;
+	/// if true, the default pathfinder's estimators only recalculate the vertices a terrain change can affect, blocks on synced paths first
+	bool prioritizedPathUpdates;
+	/// if true, the default pathfinder's max-res unit searches jump over uniform terrain instead of expanding every square
+	bool jumpPointPathSearch;
+	/// if positive, groups of at least this many same-frame unit path-requests toward the same goal follow one flow-field (default pathfinder)
+	int flowFieldGroupSize;
+
 	bool allowTake;
 };
 
@@ -9,9 +9,12 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "System/ContainerUtil.h"
+#include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
 
 #ifndef UNIT_TEST
 	#include "Sim/Features/Feature.h"
+	#include "Sim/Misc/ModInfo.h"
 	#include "Sim/Projectiles/Projectile.h"
 	#include "Sim/Units/Unit.h"
 	#include "Sim/Weapons/PlasmaRepulser.h"
@@ -25,11 +28,10 @@ CR_REG_METADATA(CQuadField, (
 	CR_MEMBER(quadSizeX),
 	CR_MEMBER(quadSizeZ),
 
-	CR_IGNORED(tempUnits),
-	CR_IGNORED(tempFeatures),
-	CR_IGNORED(tempProjectiles),
-	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(loadStats),
+	CR_IGNORED(unitLinksVersion),
+
+	CR_IGNORED(queryArenas)
 ))
 
 CR_BIND(CQuadField::Quad, )
@@ -47,52 +49,133 @@ CR_REG_METADATA_SUB(CQuadField, Quad, (
 CQuadField quadField;
 
 
+CQuadField::CQuadField()
+{
+	queryArenas.resize(ThreadPool::MAX_THREADS);
+}
+
+
+int CQuadField::CalcQuadSize(int curQuadSize, float loadFactor, float maxLoadFactor)
+{
+	if (maxLoadFactor <= 0.0f)
+		return curQuadSize;
+
+	// halving the quad size divides the load factor by (at most) four; only
+	// grow back once it is well below the threshold so we do not oscillate
+	if (loadFactor > maxLoadFactor && curQuadSize > int(MIN_QUAD_SIZE))
+		return (curQuadSize >> 1);
+	if (loadFactor < (maxLoadFactor * 0.125f) && curQuadSize < int(BASE_QUAD_SIZE))
+		return (curQuadSize << 1);
+
+	return curQuadSize;
+}
+
+
 #ifndef UNIT_TEST
-/*
-void CQuadField::Resize(int quad_size)
+void CQuadField::Update()
 {
-	CQuadField* oldQuadField = &quadField;
-	CQuadField newQuadField;
-
-	newQuadField.Init(int2(mapDims.mapx, mapDims.mapy), quad_size);
-
-	for (int zq = 0; zq < oldQuadField->GetNumQuadsZ(); zq++) {
-		for (int xq = 0; xq < oldQuadField->GetNumQuadsX(); xq++) {
-			const CQuadField::Quad& quad = oldQuadField->GetQuadAt(xq, zq);
-
-			// COPY the object lists because the Remove* functions modify them
-			// NOTE:
-			//   teamUnits is updated internally by RemoveUnit and MovedUnit
-			//
-			//   if a unit exists in multiple quads in the old field, it will
-			//   be removed from all of them and there is no danger of double
-			//   re-insertion (important if new grid has higher resolution)
-			const std::vector<CUnit*      > units       = quad.units;
-			const std::vector<CFeature*   > features    = quad.features;
-			const std::vector<CProjectile*> projectiles = quad.projectiles;
-
-			for (auto it = units.cbegin(); it != units.cend(); ++it) {
-				oldQuadField->RemoveUnit(*it);
-				newQuadField->MovedUnit(*it); // handles addition
-			}
+	if (modInfo.quadFieldMaxLoadFactor <= 0.0f)
+		return;
+	if ((gs->frameNum % (GAME_SPEED * 5)) != 0)
+		return;
 
-			for (auto it = features.cbegin(); it != features.cend(); ++it) {
-				oldQuadField->RemoveFeature(*it);
-				newQuadField->AddFeature(*it);
-			}
+	UpdateLoadStats();
+	Resize(CalcQuadSize(quadSizeX, loadStats.GetLoadFactor(), modInfo.quadFieldMaxLoadFactor));
+}
 
-			for (auto it = projectiles.cbegin(); it != projectiles.cend(); ++it) {
-				oldQuadField->RemoveProjectile(*it);
-				newQuadField->AddProjectile(*it);
-			}
+void CQuadField::Resize(int quadSize)
+{
+	if (quadSize == quadSizeX)
+		return;
+
+	const int2 mapDims = {(numQuadsX * quadSizeX) / SQUARE_SIZE, (numQuadsZ * quadSizeZ) / SQUARE_SIZE};
+	const int tempNum = gs->GetTempNum();
+
+	std::vector<CUnit*> units;
+	std::vector<CFeature*> features;
+	std::vector<CProjectile*> projectiles;
+	std::vector<CPlasmaRepulser*> repulsers;
+
+	// gather each object once, in quad order such that
+	// all clients relink them in exactly the same order
+	for (const Quad& quad: baseQuads) {
+		for (CUnit* u: quad.units) {
+			if (u->tempNum == tempNum)
+				continue;
+
+			u->tempNum = tempNum;
+			units.push_back(u);
 		}
+		for (CFeature* f: quad.features) {
+			if (f->tempNum == tempNum)
+				continue;
+
+			f->tempNum = tempNum;
+			features.push_back(f);
+		}
+		for (CProjectile* p: quad.projectiles) {
+			if (p->tempNum == tempNum)
+				continue;
+
+			p->tempNum = tempNum;
+			projectiles.push_back(p);
+		}
+		for (CPlasmaRepulser* r: quad.repulsers) {
+			if (r->tempNum == tempNum)
+				continue;
+
+			r->tempNum = tempNum;
+			repulsers.push_back(r);
+		}
+	}
+
+	for (Quad& quad: baseQuads) {
+		quad.Clear();
+	}
+
+	// the quad indices stored by objects are meaningless in the new grid
+	for (CUnit* u: units) {
+		u->quads.clear();
 	}
+	for (CProjectile* p: projectiles) {
+		p->quads.clear();
+	}
+	for (CPlasmaRepulser* r: repulsers) {
+		r->ClearQuads();
+	}
+
+	Init(mapDims, quadSize);
 
-	quadField = std::move(newQuadField);
+	for (CUnit* u: units) {
+		MovedUnit(u);
+	}
+	for (CFeature* f: features) {
+		AddFeature(f);
+	}
+	for (CProjectile* p: projectiles) {
+		AddProjectile(p);
+	}
+	for (CPlasmaRepulser* r: repulsers) {
+		MovedRepulser(r);
+	}
+
+	LOG("[QuadField::%s] quad-size changed to %d (load-factor %.2f, %d quads)", __func__, quadSize, loadStats.GetLoadFactor(), numQuadsX * numQuadsZ);
 }
-*/
 #endif
 
+void CQuadField::UpdateLoadStats()
+{
+	loadStats = LoadStats();
+
+	for (const Quad& quad: baseQuads) {
+		const int numQuadObjects = quad.units.size() + quad.features.size();
+
+		loadStats.numObjectLinks += numQuadObjects;
+		loadStats.numOccupiedQuads += (numQuadObjects > 0);
+		loadStats.maxQuadObjects = std::max(loadStats.maxQuadObjects, numQuadObjects);
+	}
+}
+
 
 void CQuadField::Quad::PostLoad()
 {
@@ -118,6 +201,7 @@ void CQuadField::Init(int2 mapDims, int quadSize)
 	assert((mapDims.y * SQUARE_SIZE) % quadSize == 0);
 
 	baseQuads.resize(numQuadsX * numQuadsZ);
+	unitLinksVersion += 1;
 
 #ifndef UNIT_TEST
 	for (Quad& quad: baseQuads) {
@@ -134,11 +218,26 @@ void CQuadField::Kill()
 		quad.Clear();
 	}
 
-	tempUnits.ReleaseAll();
-	tempFeatures.ReleaseAll();
-	tempProjectiles.ReleaseAll();
-	tempSolids.ReleaseAll();
-	tempQuads.ReleaseAll();
+	for (QueryArena& arena: queryArenas) {
+		arena.ReleaseAll();
+	}
+}
+
+
+CQuadField::QueryArena& CQuadField::GetQueryArena(QuadFieldQuery& qfq)
+{
+	// a query's vectors are always released to the arena they came from
+	if (qfq.threadNum < 0)
+		qfq.threadNum = ThreadPool::GetThreadNum();
+
+	assert(qfq.threadNum < queryArenas.size());
+	return queryArenas[qfq.threadNum];
+}
+
+CQuadField::QueryArena& CQuadField::GetQueryArena()
+{
+	assert(ThreadPool::GetThreadNum() < queryArenas.size());
+	return queryArenas[ThreadPool::GetThreadNum()];
 }
 
 
@@ -157,12 +256,11 @@ int CQuadField::WorldPosToQuadFieldIdx(const float3 p) const
 }
 
 
-#ifndef UNIT_TEST
 void CQuadField::GetQuads(QuadFieldQuery& qfq, float3 pos, float radius)
 {
 	pos.AssertNaNs();
 	pos.ClampInBounds();
-	qfq.quads = tempQuads.GetVector();
+	qfq.quads = GetQueryArena(qfq).tempQuads.GetVector();
 
 	const int2 min = WorldPosToQuadField(pos - radius);
 	const int2 max = WorldPosToQuadField(pos + radius);
@@ -192,7 +290,7 @@ void CQuadField::GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, cons
 {
 	mins.AssertNaNs();
 	maxs.AssertNaNs();
-	qfq.quads = tempQuads.GetVector();
+	qfq.quads = GetQueryArena(qfq).tempQuads.GetVector();
 
 	const int2 min = WorldPosToQuadField(mins);
 	const int2 max = WorldPosToQuadField(maxs);
@@ -210,7 +308,6 @@ void CQuadField::GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, cons
 
 	return;
 }
-#endif // UNIT_TEST
 
 
 /// note: this function got an UnitTest, check the tests/ folder!
@@ -218,7 +315,7 @@ void CQuadField::GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const f
 {
 	dir.AssertNaNs();
 	start.AssertNaNs();
-	qfq.quads = tempQuads.GetVector();
+	qfq.quads = GetQueryArena(qfq).tempQuads.GetVector();
 
 	const float3 to = start + (dir * length);
 	const float3 invQuadSize = float3(1.0f / quadSizeX, 1.0f, 1.0f / quadSizeZ);
@@ -313,6 +410,7 @@ void CQuadField::MovedUnit(CUnit* unit)
 	}
 
 	unit->quads = std::move(*qfQuery.quads);
+	unitLinksVersion += 1;
 }
 
 void CQuadField::RemoveUnit(CUnit* unit)
@@ -323,6 +421,7 @@ void CQuadField::RemoveUnit(CUnit* unit)
 	}
 
 	unit->quads.clear();
+	unitLinksVersion += 1;
 
 	#ifdef DEBUG_QUADFIELD
 	for (const Quad& q: baseQuads) {
@@ -464,15 +563,16 @@ void CQuadField::GetUnits(QuadFieldQuery& qfq, const float3& pos, float radius)
 {
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
-	const int tempNum = gs->GetTempNum();
-	qfq.units = tempUnits.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.units = arena.tempUnits.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CUnit* u: baseQuads[qi].units) {
-			if (u->tempNum == tempNum)
+			if (!visited.Insert(u))
 				continue;
 
-			u->tempNum = tempNum;
 			qfq.units->push_back(u);
 		}
 	}
@@ -484,16 +584,16 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 {
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
-	const int tempNum = gs->GetTempNum();
-	qfq.units = tempUnits.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.units = arena.tempUnits.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CUnit* u: baseQuads[qi].units) {
-			if (u->tempNum == tempNum)
+			if (!visited.Insert(u))
 				continue;
 
-			u->tempNum = tempNum;
-
 			const float totRad       = radius + u->radius;
 			const float totRadSq     = totRad * totRad;
 			const float posUnitDstSq = spherical?
@@ -514,17 +614,17 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const fl
 {
 	QuadFieldQuery qfQuery;
 	GetQuadsRectangle(qfQuery, mins, maxs);
-	const int tempNum = gs->GetTempNum();
-	qfq.units = tempUnits.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.units = arena.tempUnits.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CUnit* unit: baseQuads[qi].units) {
 
-			if (unit->tempNum == tempNum)
+			if (!visited.Insert(unit))
 				continue;
 
-			unit->tempNum = tempNum;
-
 			const float3& pos = unit->pos;
 			if (pos.x < mins.x || pos.x > maxs.x)
 				continue;
@@ -543,16 +643,16 @@ void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& pos, float
 {
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
-	const int tempNum = gs->GetTempNum();
-	qfq.features = tempFeatures.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.features = arena.tempFeatures.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CFeature* f: baseQuads[qi].features) {
-			if (f->tempNum == tempNum)
+			if (!visited.Insert(f))
 				continue;
 
-			f->tempNum = tempNum;
-
 			const float totRad       = radius + f->radius;
 			const float totRadSq     = totRad * totRad;
 			const float posDstSq = spherical?
@@ -573,16 +673,16 @@ void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& mins, const
 {
 	QuadFieldQuery qfQuery;
 	GetQuadsRectangle(qfQuery, mins, maxs);
-	const int tempNum = gs->GetTempNum();
-	qfq.features = tempFeatures.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.features = arena.tempFeatures.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CFeature* feature: baseQuads[qi].features) {
-			if (feature->tempNum == tempNum)
+			if (!visited.Insert(feature))
 				continue;
 
-			feature->tempNum = tempNum;
-
 			const float3& pos = feature->pos;
 			if (pos.x < mins.x || pos.x > maxs.x)
 				continue;
@@ -602,16 +702,16 @@ void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& pos, flo
 {
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
-	const int tempNum = gs->GetTempNum();
-	qfq.projectiles = tempProjectiles.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.projectiles = arena.tempProjectiles.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CProjectile* p: baseQuads[qi].projectiles) {
-			if (p->tempNum == tempNum)
+			if (!visited.Insert(p))
 				continue;
 
-			p->tempNum = tempNum;
-
 			if (pos.SqDistance(p->pos) >= Square(radius + p->radius))
 				continue;
 
@@ -626,16 +726,16 @@ void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& mins, co
 {
 	QuadFieldQuery qfQuery;
 	GetQuadsRectangle(qfQuery, mins, maxs);
-	const int tempNum = gs->GetTempNum();
-	qfq.projectiles = tempProjectiles.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.projectiles = arena.tempProjectiles.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CProjectile* p: baseQuads[qi].projectiles) {
-			if (p->tempNum == tempNum)
+			if (!visited.Insert(p))
 				continue;
 
-			p->tempNum = tempNum;
-
 			const float3& pos = p->pos;
 			if (pos.x < mins.x || pos.x > maxs.x)
 				continue;
@@ -660,16 +760,16 @@ void CQuadField::GetSolidsExact(
 ) {
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
-	const int tempNum = gs->GetTempNum();
-	qfq.solids = tempSolids.GetVector();
+	QueryArena& arena = GetQueryArena(qfq);
+	QueryVisitedSet& visited = arena.visited;
+	qfq.solids = arena.tempSolids.GetVector();
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CUnit* u: baseQuads[qi].units) {
-			if (u->tempNum == tempNum)
+			if (!visited.Insert(u))
 				continue;
 
-			u->tempNum = tempNum;
-
 			if (!u->HasPhysicalStateBit(physicalStateBits))
 				continue;
 			if (!u->HasCollidableStateBit(collisionStateBits))
@@ -681,11 +781,9 @@ void CQuadField::GetSolidsExact(
 		}
 
 		for (CFeature* f: baseQuads[qi].features) {
-			if (f->tempNum == tempNum)
+			if (!visited.Insert(f))
 				continue;
 
-			f->tempNum = tempNum;
-
 			if (!f->HasPhysicalStateBit(physicalStateBits))
 				continue;
 			if (!f->HasCollidableStateBit(collisionStateBits))
@@ -709,15 +807,14 @@ bool CQuadField::NoSolidsExact(
 ) {
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
-	const int tempNum = gs->GetTempNum();
+	QueryVisitedSet& visited = GetQueryArena().visited;
+	visited.Reset();
 
 	for (const int qi: *qfQuery.quads) {
 		for (CUnit* u: baseQuads[qi].units) {
-			if (u->tempNum == tempNum)
+			if (!visited.Insert(u))
 				continue;
 
-			u->tempNum = tempNum;
-
 			if (!u->HasPhysicalStateBit(physicalStateBits))
 				continue;
 			if (!u->HasCollidableStateBit(collisionStateBits))
@@ -729,11 +826,9 @@ bool CQuadField::NoSolidsExact(
 		}
 
 		for (CFeature* f: baseQuads[qi].features) {
-			if (f->tempNum == tempNum)
+			if (!visited.Insert(f))
 				continue;
 
-			f->tempNum = tempNum;
-
 			if (!f->HasPhysicalStateBit(physicalStateBits))
 				continue;
 			if (!f->HasCollidableStateBit(collisionStateBits))
@@ -757,7 +852,8 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 	std::vector<CFeature*>& features,
 	std::vector<CPlasmaRepulser*>* repulsers
 ) {
-	const int tempNum = gs->GetTempNum();
+	QueryVisitedSet& visited = GetQueryArena().visited;
+	visited.Reset();
 
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
@@ -768,11 +864,9 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 
 		for (CUnit* u: quad.units) {
 			// prevent double adding
-			if (u->tempNum == tempNum)
+			if (!visited.Insert(u))
 				continue;
 
-			u->tempNum = tempNum;
-
 			const auto* colvol = &u->collisionVolume;
 			const float totRad = radius + colvol->GetBoundingRadius();
 
@@ -784,11 +878,9 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 
 		for (CFeature* f: quad.features) {
 			// prevent double adding
-			if (f->tempNum == tempNum)
+			if (!visited.Insert(f))
 				continue;
 
-			f->tempNum = tempNum;
-
 			const auto* colvol = &f->collisionVolume;
 			const float totRad = radius + colvol->GetBoundingRadius();
 
@@ -800,11 +892,9 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 		if (repulsers != nullptr) {
 			for (CPlasmaRepulser* r: quad.repulsers) {
 				// prevent double adding
-				if (r->tempNum == tempNum)
+				if (!visited.Insert(r))
 					continue;
 
-				r->tempNum = tempNum;
-
 				const auto* colvol = &r->collisionVolume;
 				const float totRad = radius + colvol->GetBoundingRadius();
 
@@ -23,8 +23,8 @@ template<typename T>
 class ExclusiveVectors {
 public:
 	// There should at most be 2 concurrent users of each vector type
-	// using 3 to be safe, increase this number if the assertions below
-	// fail
+	// (per thread) using 3 to be safe, increase this number if the
+	// assertions below fail
 	static constexpr int MAX_CONCURRENT_VECTORS = 3;
 
 	ExclusiveVectors() {
@@ -72,6 +72,81 @@ public:
 };
 
 
+// set of objects visited by a single query; replaces stamping objects
+// with gs->GetTempNum() (which is not thread-safe) for de-duplication
+// Reset is O(1) and Insert only allocates when the table has to grow
+class QueryVisitedSet {
+public:
+	void Reset() {
+		numItems = 0;
+
+		if ((++curStamp) != 0)
+			return;
+
+		// wrapped around, invalidate everything
+		for (Slot& s: slots) {
+			s.stamp = 0;
+		}
+
+		curStamp = 1;
+	}
+
+	bool Insert(const void* p) {
+		if (((numItems + 1) * 2) > slots.size())
+			Grow();
+
+		const size_t mask = slots.size() - 1;
+
+		for (size_t i = Hash(p) & mask; ; i = (i + 1) & mask) {
+			Slot& s = slots[i];
+
+			if (s.stamp != curStamp) {
+				s.ptr = p;
+				s.stamp = curStamp;
+				numItems += 1;
+				return true;
+			}
+
+			if (s.ptr == p)
+				return false;
+		}
+
+		return false;
+	}
+
+private:
+	struct Slot {
+		const void* ptr;
+		unsigned int stamp;
+	};
+
+	static size_t Hash(const void* p) {
+		const size_t h = reinterpret_cast<size_t>(p) >> 3;
+		return (h ^ (h >> 11) ^ (h >> 21)) * 2654435761u;
+	}
+
+	void Grow() {
+		std::vector<Slot> oldSlots(std::max(size_t(256), slots.size() * 2), Slot{nullptr, 0});
+
+		oldSlots.swap(slots);
+		numItems = 0;
+
+		for (const Slot& s: oldSlots) {
+			if (s.stamp != curStamp)
+				continue;
+
+			Insert(s.ptr);
+		}
+	}
+
+private:
+	std::vector<Slot> slots;
+
+	size_t numItems = 0;
+	unsigned int curStamp = 1;
+};
+
+
 
 class CQuadField : spring::noncopyable
 {
@@ -79,19 +154,41 @@ class CQuadField : spring::noncopyable
 	CR_DECLARE_SUB(Quad)
 
 public:
+	CQuadField();
 
-	/*
-	needed to support dynamic resizing (not used yet)
-	in large games the average loading factor (number of objects per quad)
-	can grow too large to maintain amortized constant performance so more
-	quads are needed
+	struct LoadStats {
+		/// number of (object, quad) links for units and features
+		int numObjectLinks = 0;
+		/// number of quads containing at least one unit or feature
+		int numOccupiedQuads = 0;
+		int maxQuadObjects = 0;
 
-	static void Resize(int quadSize);
-	*/
+		/// average number of objects per occupied quad
+		float GetLoadFactor() const { return (numObjectLinks / std::max(1.0f, numOccupiedQuads * 1.0f)); }
+	};
 
 	void Init(int2 mapDims, int quadSize);
 	void Kill();
 
+	/**
+	 * Periodically recalculates the load statistics and, if the load factor
+	 * crossed modInfo.quadFieldMaxLoadFactor, rebuilds the field at a smaller
+	 * (or larger) quad size. Must be called from synced code.
+	 */
+	void Update();
+
+	/**
+	 * In large games the average loading factor (number of objects per quad)
+	 * can grow too large to maintain amortized constant performance so more
+	 * quads are needed; this relinks every unit, feature, projectile and
+	 * repulser into a grid of quads of size <quadSize>.
+	 */
+	void Resize(int quadSize);
+	void UpdateLoadStats();
+
+	/// returns the quad size a field with load factor <loadFactor> should have (<curQuadSize> if unchanged)
+	static int CalcQuadSize(int curQuadSize, float loadFactor, float maxLoadFactor);
+
 	void GetQuads(QuadFieldQuery& qfq, float3 pos, float radius);
 	void GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, const float3& maxs);
 	void GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const float3& dir, float length);
@@ -163,11 +260,11 @@ public:
 	void MovedRepulser(CPlasmaRepulser* repulser);
 	void RemoveRepulser(CPlasmaRepulser* repulser);
 
-	void ReleaseVector(std::vector<CUnit*>* v       ) { tempUnits.ReleaseVector(v); }
-	void ReleaseVector(std::vector<CFeature*>* v    ) { tempFeatures.ReleaseVector(v); }
-	void ReleaseVector(std::vector<CProjectile*>* v ) { tempProjectiles.ReleaseVector(v); }
-	void ReleaseVector(std::vector<CSolidObject*>* v) { tempSolids.ReleaseVector(v); }
-	void ReleaseVector(std::vector<int>* v          ) { tempQuads.ReleaseVector(v); }
+	void ReleaseVector(std::vector<CUnit*>* v       , int threadNum) { queryArenas[threadNum].tempUnits.ReleaseVector(v); }
+	void ReleaseVector(std::vector<CFeature*>* v    , int threadNum) { queryArenas[threadNum].tempFeatures.ReleaseVector(v); }
+	void ReleaseVector(std::vector<CProjectile*>* v , int threadNum) { queryArenas[threadNum].tempProjectiles.ReleaseVector(v); }
+	void ReleaseVector(std::vector<CSolidObject*>* v, int threadNum) { queryArenas[threadNum].tempSolids.ReleaseVector(v); }
+	void ReleaseVector(std::vector<int>* v          , int threadNum) { queryArenas[threadNum].tempQuads.ReleaseVector(v); }
 
 	struct Quad {
 	public:
@@ -225,7 +322,14 @@ public:
 	int GetQuadSizeX() const { return quadSizeX; }
 	int GetQuadSizeZ() const { return quadSizeZ; }
 
+	const LoadStats& GetLoadStats() const { return loadStats; }
+
+	/// changes whenever any unit is (un)linked from a quad, i.e. whenever teamUnits might differ
+	unsigned int GetUnitLinksVersion() const { return unitLinksVersion; }
+
 	constexpr static unsigned int BASE_QUAD_SIZE = 128;
+	// must divide BASE_QUAD_SIZE (and hence the map size) evenly
+	constexpr static unsigned int MIN_QUAD_SIZE = BASE_QUAD_SIZE / 4;
 
 private:
 	// optimized functions, somewhat less userfriendly
@@ -239,15 +343,39 @@ private:
 	int2 WorldPosToQuadField(const float3 p) const;
 	int WorldPosToQuadFieldIdx(const float3 p) const;
 
+	// per-thread scratch state, such that any ThreadPool worker
+	// can run queries concurrently (as long as no objects are
+	// being moved at the same time)
+	struct QueryArena {
+		void ReleaseAll() {
+			tempUnits.ReleaseAll();
+			tempFeatures.ReleaseAll();
+			tempProjectiles.ReleaseAll();
+			tempSolids.ReleaseAll();
+			tempQuads.ReleaseAll();
+		}
+
+		// preallocated vectors for Get*Exact functions
+		ExclusiveVectors<CUnit*> tempUnits;
+		ExclusiveVectors<CFeature*> tempFeatures;
+		ExclusiveVectors<CProjectile*> tempProjectiles;
+		ExclusiveVectors<CSolidObject*> tempSolids;
+		ExclusiveVectors<int> tempQuads;
+
+		QueryVisitedSet visited;
+	};
+
+	QueryArena& GetQueryArena(QuadFieldQuery& qfq);
+	QueryArena& GetQueryArena();
+
 private:
 	std::vector<Quad> baseQuads;
+	// indexed by ThreadPool::GetThreadNum()
+	std::vector<QueryArena> queryArenas;
+
+	LoadStats loadStats;
 
-	// preallocated vectors for Get*Exact functions
-	ExclusiveVectors<CUnit*> tempUnits;
-	ExclusiveVectors<CFeature*> tempFeatures;
-	ExclusiveVectors<CProjectile*> tempProjectiles;
-	ExclusiveVectors<CSolidObject*> tempSolids;
-	ExclusiveVectors<int> tempQuads;
+	unsigned int unitLinksVersion = 0;
 
 	int numQuadsX;
 	int numQuadsZ;
@@ -261,11 +389,15 @@ extern CQuadField quadField;
 
 struct QuadFieldQuery {
 	~QuadFieldQuery() {
-		quadField.ReleaseVector(units);
-		quadField.ReleaseVector(features);
-		quadField.ReleaseVector(projectiles);
-		quadField.ReleaseVector(solids);
-		quadField.ReleaseVector(quads);
+		// nothing acquired
+		if (threadNum < 0)
+			return;
+
+		quadField.ReleaseVector(units, threadNum);
+		quadField.ReleaseVector(features, threadNum);
+		quadField.ReleaseVector(projectiles, threadNum);
+		quadField.ReleaseVector(solids, threadNum);
+		quadField.ReleaseVector(quads, threadNum);
 	}
 
 	std::vector<CUnit*>* units = nullptr;
@@ -273,6 +405,9 @@ struct QuadFieldQuery {
 	std::vector<CProjectile*>* projectiles = nullptr;
 	std::vector<CSolidObject*>* solids = nullptr;
 	std::vector<int>* quads = nullptr;
+
+	// arena the vectors were taken from, set by the first CQuadField::Get* call
+	int threadNum = -1;
 };
 
 
@@ -34,7 +34,11 @@ CR_REG_METADATA(AAirMoveType, (
 
 	CR_MEMBER(lastColWarning),
 
-	CR_MEMBER(lastColWarningType)
+	CR_MEMBER(lastColWarningType),
+
+	CR_IGNORED(preUpdatePos),
+	CR_IGNORED(preUpdateHeight),
+	CR_IGNORED(preUpdateFrame)
 ))
 
 AAirMoveType::AAirMoveType(CUnit* unit):
@@ -57,7 +61,11 @@ AAirMoveType::AAirMoveType(CUnit* unit):
 
 	lastColWarning(nullptr),
 
-	lastColWarningType(0)
+	lastColWarningType(0),
+
+	preUpdatePos(ZeroVector),
+	preUpdateHeight(0.0f),
+	preUpdateFrame(-1)
 {
 	// creg
 	if (unit == nullptr)
@@ -98,6 +106,24 @@ void AAirMoveType::DependentDied(CObject* o) {
 	}
 }
 
+float AAirMoveType::GetGroundHeight(const float3& pos) const {
+	if (preUpdateFrame == gs->frameNum && preUpdatePos.same(pos))
+		return preUpdateHeight;
+
+	return (owner->unitDef->canSubmerge?
+		CGround::GetHeightReal(pos.x, pos.z):
+		CGround::GetHeightAboveWater(pos.x, pos.z));
+}
+
+void AAirMoveType::PreUpdate() {
+	// NOTE: may run on any ThreadPool worker
+	preUpdatePos = owner->pos;
+	preUpdateHeight = owner->unitDef->canSubmerge?
+		CGround::GetHeightReal(preUpdatePos.x, preUpdatePos.z):
+		CGround::GetHeightAboveWater(preUpdatePos.x, preUpdatePos.z);
+	preUpdateFrame = gs->frameNum;
+}
+
 bool AAirMoveType::Update() {
 	// NOTE: useHeading is never true by default for aircraft (AAirMoveType
 	// forces it to false, TransportUnit::{Attach,Detach}Unit manipulate it
@@ -121,9 +147,7 @@ void AAirMoveType::UpdateLanded()
 	// lowered) later and we do not want to end up hovering
 	// in mid-air or sink below it
 	// let gravity do the job instead of teleporting
-	const float minHeight = owner->unitDef->canSubmerge?
-		CGround::GetHeightReal(owner->pos.x, owner->pos.z):
-		CGround::GetHeightAboveWater(owner->pos.x, owner->pos.z);
+	const float minHeight = GetGroundHeight(owner->pos);
 	const float curHeight = owner->pos.y;
 
 	if (curHeight > minHeight) {
@@ -180,9 +204,7 @@ void AAirMoveType::UpdateLanding()
 	const float distSq = reservedLandingPos.SqDistance(pos);
 
 
-	const float localAltitude = pos.y - (owner->unitDef->canSubmerge ?
-		CGround::GetHeightReal(owner->pos.x, owner->pos.z):
-		CGround::GetHeightAboveWater(owner->pos.x, owner->pos.z));
+	const float localAltitude = pos.y - GetGroundHeight(owner->pos);
 
 	if (distSq <= radiusSq || (distSq < landRadiusSq && localAltitude < wantedHeight + radius)) {
 		SetState(AIRCRAFT_LANDED);
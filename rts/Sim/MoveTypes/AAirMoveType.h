@@ -28,6 +28,7 @@ public:
 	AAirMoveType(CUnit* unit);
 	virtual ~AAirMoveType() {}
 
+	void PreUpdate() override;
 	virtual bool Update();
 	virtual void UpdateLanded();
 	virtual void Takeoff() {}
@@ -48,6 +49,9 @@ public:
 	bool CanApplyImpulse(const float3&) { return true; }
 	bool UseSmoothMesh() const;
 
+	/// real ground height at <pos> if owner can submerge, otherwise height above water
+	float GetGroundHeight(const float3& pos) const;
+
 	void DependentDied(CObject* o);
 
 public:
@@ -73,6 +77,11 @@ public:
 protected:
 	void CheckForCollision();
 
+	/// ground height below owner->pos as sampled by PreUpdate
+	float3 preUpdatePos;
+	float preUpdateHeight;
+	int preUpdateFrame;
+
 	/// unit found to be dangerously close to our path
 	CUnit* lastColWarning;
 
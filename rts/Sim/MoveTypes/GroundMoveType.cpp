@@ -82,6 +82,7 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_GMT)
 CR_BIND_DERIVED(CGroundMoveType, AMoveType, (nullptr))
 CR_REG_METADATA(CGroundMoveType, (
 	CR_IGNORED(pathController),
+	CR_IGNORED(preUpdateData),
 
 	CR_MEMBER(currWayPoint),
 	CR_MEMBER(nextWayPoint),
@@ -169,6 +170,7 @@ static CGroundMoveType::MemberData gmtMemberData = {
 CGroundMoveType::CGroundMoveType(CUnit* owner):
 	AMoveType(owner),
 	pathController(owner),
+	preUpdateData{ZeroVector, ZeroVector, {0.0f, 0.0f}, -1, false},
 
 	currWayPoint(ZeroVector),
 	nextWayPoint(ZeroVector),
@@ -313,6 +315,29 @@ bool CGroundMoveType::OwnerMoved(const short oldHeading, const float3& posDif, c
 	return true;
 }
 
+void CGroundMoveType::PreUpdate()
+{
+	// NOTE: may run on any ThreadPool worker, only touch preUpdateData
+	if (owner->GetTransporter() != nullptr)
+		return;
+
+	const MoveDef* md = owner->moveDef;
+
+	preUpdateData.pos = owner->pos;
+	preUpdateData.dir = flatFrontDir;
+
+	preUpdateData.onSlope = OnSlope(1.0f);
+
+	// both samples are taken unconditionally, ChangeSpeed only uses the second if the first is zero
+	preUpdateData.groundSpeedMods[0] = CMoveMath::GetPosSpeedMod(*md, preUpdateData.pos                                    , preUpdateData.dir);
+	preUpdateData.groundSpeedMods[1] = CMoveMath::GetPosSpeedMod(*md, preUpdateData.pos + preUpdateData.dir * SQUARE_SIZE, preUpdateData.dir);
+
+	preUpdateData.frame = gs->frameNum;
+}
+
+bool CGroundMoveType::HavePreUpdatePos() const { return (preUpdateData.frame == gs->frameNum && preUpdateData.pos.same(owner->pos)); }
+bool CGroundMoveType::HavePreUpdateDir() const { return (HavePreUpdatePos() && preUpdateData.dir.same(flatFrontDir)); }
+
 bool CGroundMoveType::Update()
 {
 	ASSERT_SYNCED(owner->pos);
@@ -321,7 +346,7 @@ bool CGroundMoveType::Update()
 	if (owner->GetTransporter() != nullptr)
 		return false;
 
-	owner->UpdatePhysicalStateBit(CSolidObject::PSTATE_BIT_SKIDDING, owner->IsSkidding() || OnSlope(1.0f));
+	owner->UpdatePhysicalStateBit(CSolidObject::PSTATE_BIT_SKIDDING, owner->IsSkidding() || (HavePreUpdatePos()? preUpdateData.onSlope: OnSlope(1.0f)));
 
 	if (owner->IsSkidding()) {
 		UpdateSkid();
@@ -566,6 +591,20 @@ bool CGroundMoveType::FollowPath()
 		if (currWayPoint != owner->pos)
 			waypointDir = ((currWayPoint - owner->pos) * XZVector).SafeNormalize();
 
+		if (!atEndOfPath && !useRawMovement) {
+			// paths shared by a group through a flow-field are steered along
+			// it while the next unit-diameter ahead is clear, waypoints lead
+			// around the rest (ZeroVector for all other kinds of paths)
+			const float3 flowDir = pathManager->GetFlowDir(pathID, owner->pos);
+
+			if (flowDir != ZeroVector && flowDir.dot(waypointDir) > 0.0f) {
+				const float3 flowPos = owner->pos + flowDir * (owner->radius * 2.0f);
+
+				if (owner->moveDef->TestMoveSquareRange(owner, float3::min(owner->pos, flowPos), float3::max(owner->pos, flowPos), flowDir, true, true, true))
+					waypointDir = flowDir;
+			}
+		}
+
 		ASSERT_SYNCED(waypointDir);
 
 		wantReverse = WantReverse(waypointDir, flatFrontDir);
@@ -614,13 +653,21 @@ void CGroundMoveType::ChangeSpeed(float newWantedSpeed, bool wantReverse, bool f
 			// the pathfinders do NOT check the entire footprint to determine
 			// passability wrt. terrain (only wrt. structures), so we look at
 			// the center square ONLY for our current speedmod
-			float groundSpeedMod = CMoveMath::GetPosSpeedMod(*md, owner->pos, flatFrontDir);
+			// (PreUpdate samples are reusable as long as we have not turned or been moved since)
+			const bool havePreUpdateDir = HavePreUpdateDir();
+
+			float groundSpeedMod = havePreUpdateDir?
+				preUpdateData.groundSpeedMods[0]:
+				CMoveMath::GetPosSpeedMod(*md, owner->pos, flatFrontDir);
 
 			// the pathfinders don't check the speedmod of the square our unit is currently on
 			// so if we got stuck on a nonpassable square and can't move try to see if we're
 			// trying to release ourselves towards a passable square
-			if (groundSpeedMod == 0.0f)
-				groundSpeedMod = CMoveMath::GetPosSpeedMod(*md, owner->pos + flatFrontDir * SQUARE_SIZE, flatFrontDir);
+			if (groundSpeedMod == 0.0f) {
+				groundSpeedMod = havePreUpdateDir?
+					preUpdateData.groundSpeedMods[1]:
+					CMoveMath::GetPosSpeedMod(*md, owner->pos + flatFrontDir * SQUARE_SIZE, flatFrontDir);
+			}
 
 			const float curGoalDistSq = (owner->pos - goalPos).SqLength2D();
 			const float minGoalDistSq = Square(BrakingDistance(currentSpeed, decRate));
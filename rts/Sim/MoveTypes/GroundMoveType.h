@@ -29,6 +29,7 @@ public:
 
 	void PostLoad();
 
+	void PreUpdate() override;
 	bool Update() override;
 	void SlowUpdate() override;
 
@@ -89,6 +90,21 @@ public:
 	const SyncedFloat3& GetNextWayPoint() const { return nextWayPoint; }
 
 private:
+	// terrain samples taken by PreUpdate, only valid during the same frame
+	// and while owner->pos (and flatFrontDir for the speed-mods) is unchanged
+	struct PreUpdateData {
+		float3 pos;
+		float3 dir;
+
+		float groundSpeedMods[2];
+
+		int frame;
+		bool onSlope;
+	};
+
+	bool HavePreUpdatePos() const;
+	bool HavePreUpdateDir() const;
+
 	float3 GetObstacleAvoidanceDir(const float3& desiredDir);
 	float3 GetNewSpeedVector(const float hAcc, const float vAcc) const;
 
@@ -165,6 +181,7 @@ private:
 
 private:
 	GMTDefaultPathController pathController;
+	PreUpdateData preUpdateData;
 
 	SyncedFloat3 currWayPoint;
 	SyncedFloat3 nextWayPoint;
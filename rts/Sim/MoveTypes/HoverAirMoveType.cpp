@@ -367,9 +367,7 @@ void CHoverAirMoveType::UpdateTakeoff()
 
 	UpdateAirPhysics();
 
-	const float altitude = owner->unitDef->canSubmerge?
-		(pos.y - CGround::GetHeightReal(pos.x, pos.z)):
-		(pos.y - CGround::GetHeightAboveWater(pos.x, pos.z));
+	const float altitude = pos.y - GetGroundHeight(pos);
 
 	if (altitude > orgWantedHeight * 0.8f) {
 		SetState(AIRCRAFT_FLYING);
@@ -836,9 +834,7 @@ void CHoverAirMoveType::UpdateAirPhysics()
 	// if this aircraft uses the smoothmesh, these values are
 	// calculated with respect to that (for changing vertical
 	// speed, but not for ground collision)
-	float curAbsHeight = owner->unitDef->canSubmerge?
-		CGround::GetHeightReal(pos.x, pos.z):
-		CGround::GetHeightAboveWater(pos.x, pos.z);
+	float curAbsHeight = GetGroundHeight(pos);
 
 	// always stay above the actual terrain (therefore either the value of
 	// <midPos.y - radius> or pos.y must never become smaller than the real
@@ -1,7 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "MoveDefHandler.h"
-#include "Lua/LuaParser.h"
 #include "Map/MapInfo.h"
 #include "MoveMath/MoveMath.h"
 #include "Sim/Misc/GlobalConstants.h"
@@ -11,6 +10,10 @@
 #include "System/myMath.h"
 #include "System/StringUtil.h"
 
+#ifndef UNIT_TEST
+	#include "Lua/LuaParser.h"
+#endif
+
 CR_BIND(MoveDef, ())
 CR_BIND(MoveDefHandler, )
 
@@ -56,6 +59,7 @@ CR_REG_METADATA(MoveDefHandler, (
 
 MoveDefHandler moveDefHandler;
 
+#ifndef UNIT_TEST
 // FIXME: do something with these magic numbers
 static constexpr float MAX_ALLOWED_WATER_DAMAGE_GMM = 1e3f;
 static constexpr float MAX_ALLOWED_WATER_DAMAGE_HMM = 1e4f;
@@ -148,6 +152,7 @@ MoveDef* MoveDefHandler::GetMoveDefByName(const std::string& name)
 
 	return &moveDefs[it->second];
 }
+#endif
 
 
 
@@ -198,6 +203,7 @@ MoveDef::MoveDef()
 	speedModMults[SPEEDMOD_MOBILE_NUM_MULTS] = 0.0f;
 }
 
+#ifndef UNIT_TEST
 MoveDef::MoveDef(const LuaTable& moveDefTable, int moveDefID) {
 	*this = MoveDef();
 
@@ -366,6 +372,7 @@ bool MoveDef::TestMoveSquareRange(
 	if (maxBlockBitPtr != nullptr) *maxBlockBitPtr = maxBlockBit;
 	return retTestMove;
 }
+#endif
 
 
 float MoveDef::CalcFootPrintRadius(float scale) const { return ((math::sqrt((xsize * xsize + zsize * zsize)) * 0.5f * SQUARE_SIZE) * scale); }
@@ -397,6 +404,26 @@ float MoveDef::GetDepthMod(float height) const {
 	return (1.0f / scale);
 }
 
+float MoveDef::GetMaxDepthMod() const {
+	const float minDepth = depthModParams[DEPTHMOD_MIN_HEIGHT];
+	const float maxDepth = depthModParams[DEPTHMOD_MAX_HEIGHT];
+
+	const float a = depthModParams[DEPTHMOD_QUA_COEFF];
+	const float b = depthModParams[DEPTHMOD_LIN_COEFF];
+	const float c = depthModParams[DEPTHMOD_CON_COEFF];
+
+	const auto CalcScale = [&](float depth) { return (a * depth * depth + b * depth + c); };
+
+	// smallest unclamped scale over [minDepth, maxDepth], at either end or the vertex
+	float scale = std::min(CalcScale(minDepth), CalcScale(maxDepth));
+
+	if (a > 0.0f && (-b / (2.0f * a)) > minDepth && (-b / (2.0f * a)) < maxDepth)
+		scale = std::min(scale, CalcScale(-b / (2.0f * a)));
+
+	// above <minDepth> the mod is 1
+	return std::max(1.0f, 1.0f / Clamp(scale, 0.01f, depthModParams[DEPTHMOD_MAX_SCALE]));
+}
+
 unsigned int MoveDef::GetCheckSum() const {
 	unsigned int sum = 0;
 
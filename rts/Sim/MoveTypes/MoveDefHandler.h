@@ -50,6 +50,8 @@ struct MoveDef {
 
 	float CalcFootPrintRadius(float scale) const;
 	float GetDepthMod(float height) const;
+	/// upper bound of GetDepthMod over all heights
+	float GetMaxDepthMod() const;
 
 	unsigned int GetCheckSum() const;
 
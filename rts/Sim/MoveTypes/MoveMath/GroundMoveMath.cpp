@@ -1,9 +1,10 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "MoveMath.h"
-#include "Sim/Misc/ModInfo.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 
+#include "Sim/Misc/ModInfo.h"
+
 /*
 Calculate speed-multiplier for given height and slope data.
 */
@@ -50,4 +51,3 @@ float CMoveMath::GroundSpeedMod(const MoveDef& moveDef, float height, float slop
 
 	return speedMod;
 }
-
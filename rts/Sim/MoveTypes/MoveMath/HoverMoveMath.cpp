@@ -1,9 +1,10 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "MoveMath.h"
-#include "Sim/Misc/ModInfo.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 
+#include "Sim/Misc/ModInfo.h"
+
 /*
 Calculate speed-multiplier for given height and slope data.
 */
@@ -36,4 +37,3 @@ float CMoveMath::HoverSpeedMod(const MoveDef& moveDef, float height, float slope
 
 	return (1.0f / (1.0f + std::max(0.0f, slope * dirSlopeMod) * moveDef.slopeMod));
 }
-
@@ -1,16 +1,20 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "MoveMath.h"
+#include "SpeedModRows.h"
 
-#include "Map/Ground.h"
 #include "Map/MapInfo.h"
-#include "Sim/Misc/GlobalSynced.h"
-#include "Sim/Misc/GroundBlockingObjectMap.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
-#include "Sim/MoveTypes/MoveType.h"
-#include "Sim/Objects/SolidObject.h"
-#include "Sim/Units/Unit.h"
-#include "System/Platform/Threading.h"
+
+#ifndef UNIT_TEST
+	#include "Map/Ground.h"
+	#include "Sim/Misc/GlobalSynced.h"
+	#include "Sim/Misc/GroundBlockingObjectMap.h"
+	#include "Sim/MoveTypes/MoveType.h"
+	#include "Sim/Objects/SolidObject.h"
+	#include "Sim/Units/Unit.h"
+	#include "System/Platform/Threading.h"
+#endif
 
 bool CMoveMath::noHoverWaterMove = false;
 float CMoveMath::waterDamageCost = 0.0f;
@@ -19,6 +23,7 @@ static constexpr int FOOTPRINT_XSTEP = 2;
 static constexpr int FOOTPRINT_ZSTEP = 2;
 
 
+#ifndef UNIT_TEST
 float CMoveMath::yLevel(const MoveDef& moveDef, int xSqr, int zSqr)
 {
 	switch (moveDef.speedModClass) {
@@ -42,6 +47,7 @@ float CMoveMath::yLevel(const MoveDef& moveDef, const float3& pos)
 
 	return 0.0f;
 }
+#endif
 
 
 
@@ -70,6 +76,87 @@ float CMoveMath::GetPosSpeedMod(const MoveDef& moveDef, unsigned xSquare, unsign
 	return 0.0f;
 }
 
+void CMoveMath::GetPosSpeedModRow(const MoveDef& moveDef, unsigned hxSquare, unsigned hzSquare, unsigned numSquares, float* speedMods)
+{
+	// squares outside the map have no speed, as for GetPosSpeedMod
+	const unsigned numInside = (hzSquare < mapDims.hmapy)? std::min(numSquares, unsigned(std::max(0, mapDims.hmapx - int(hxSquare)))): 0;
+
+	std::fill(speedMods + numInside, speedMods + numSquares, 0.0f);
+
+	if (numInside == 0)
+		return;
+
+	SpeedModRows::Params params;
+	params.speedModClass = moveDef.speedModClass;
+	params.maxSlope = moveDef.maxSlope;
+	params.slopeMod = moveDef.slopeMod;
+	params.depth = moveDef.depth;
+	params.waterDamageCost = waterDamageCost;
+	params.hoverWaterSpeedMod = 1.0f * !noHoverWaterMove;
+	params.depthModMinHeight = moveDef.depthModParams[MoveDef::DEPTHMOD_MIN_HEIGHT];
+	params.depthModMaxHeight = moveDef.depthModParams[MoveDef::DEPTHMOD_MAX_HEIGHT];
+	params.depthModMaxScale = moveDef.depthModParams[MoveDef::DEPTHMOD_MAX_SCALE];
+	params.depthModQuaCoeff = moveDef.depthModParams[MoveDef::DEPTHMOD_QUA_COEFF];
+	params.depthModLinCoeff = moveDef.depthModParams[MoveDef::DEPTHMOD_LIN_COEFF];
+	params.depthModConCoeff = moveDef.depthModParams[MoveDef::DEPTHMOD_CON_COEFF];
+
+	float CMapInfo::TerrainType::* typeSpeed = nullptr;
+
+	switch (moveDef.speedModClass) {
+		case MoveDef::Tank:  { typeSpeed = &CMapInfo::TerrainType::tankSpeed ; } break;
+		case MoveDef::KBot:  { typeSpeed = &CMapInfo::TerrainType::kbotSpeed ; } break;
+		case MoveDef::Hover: { typeSpeed = &CMapInfo::TerrainType::hoverSpeed; } break;
+		case MoveDef::Ship:  { typeSpeed = &CMapInfo::TerrainType::shipSpeed ; } break;
+		default: {
+			std::fill(speedMods, speedMods + numInside, 0.0f);
+			return;
+		} break;
+	}
+
+	const int square = hxSquare + (hzSquare * mapDims.hmapx);
+
+	const uint8_t* typeMap = readMap->GetTypeMapSynced() + square;
+	const float* heightMap = readMap->GetMIPHeightMapSynced(1) + square;
+	const float* slopeMap = readMap->GetSlopeMapSynced() + square;
+
+	// terrain-type speeds are gathered per chunk, SSE has no gather-loads
+	float typeSpeeds[64];
+
+	for (unsigned n = 0; n < numInside; n += 64) {
+		const unsigned numChunkSquares = std::min(numInside - n, 64u);
+
+		for (unsigned k = 0; k < numChunkSquares; k++) {
+			typeSpeeds[k] = mapInfo->terrainTypes[typeMap[n + k]].*typeSpeed;
+		}
+
+		SpeedModRows::GetSpeedModRow(params, heightMap + n, slopeMap + n, typeSpeeds, numChunkSquares, speedMods + n);
+	}
+}
+
+float CMoveMath::GetMaxSpeedMod(const MoveDef& moveDef)
+{
+	// slope-mods are at most 1, only terrain-types and water can speed units up
+	float maxTypeSpeed = 0.0f;
+
+	for (const CMapInfo::TerrainType& tt: mapInfo->terrainTypes) {
+		switch (moveDef.speedModClass) {
+			case MoveDef::Tank:  { maxTypeSpeed = std::max(maxTypeSpeed, tt.tankSpeed ); } break;
+			case MoveDef::KBot:  { maxTypeSpeed = std::max(maxTypeSpeed, tt.kbotSpeed ); } break;
+			case MoveDef::Hover: { maxTypeSpeed = std::max(maxTypeSpeed, tt.hoverSpeed); } break;
+			case MoveDef::Ship:  { maxTypeSpeed = std::max(maxTypeSpeed, tt.shipSpeed ); } break;
+			default: {} break;
+		}
+	}
+
+	switch (moveDef.speedModClass) {
+		case MoveDef::Tank: // fall-through
+		case MoveDef::KBot: { return (maxTypeSpeed * std::max(1.0f, waterDamageCost * moveDef.GetMaxDepthMod())); } break;
+		default: {} break;
+	}
+
+	return maxTypeSpeed;
+}
+
 float CMoveMath::GetPosSpeedMod(const MoveDef& moveDef, unsigned xSquare, unsigned zSquare, float3 moveDir)
 {
 	if (xSquare >= mapDims.mapx || zSquare >= mapDims.mapy)
@@ -105,6 +192,7 @@ float CMoveMath::GetPosSpeedMod(const MoveDef& moveDef, unsigned xSquare, unsign
 	return 0.0f;
 }
 
+#ifndef UNIT_TEST
 /* Check if a given square-position is accessable by the MoveDef footprint. */
 CMoveMath::BlockType CMoveMath::IsBlockedNoSpeedModCheck(const MoveDef& moveDef, int xSquare, int zSquare, const CSolidObject* collider)
 {
@@ -299,4 +387,4 @@ CMoveMath::BlockType CMoveMath::RangeIsBlocked(const MoveDef& moveDef, int xmin,
 
 	return ret;
 }
-
+#endif
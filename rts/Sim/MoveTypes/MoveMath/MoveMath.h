@@ -48,6 +48,10 @@ public:
 	{
 		return (GetPosSpeedMod(moveDef, pos.x / SQUARE_SIZE, pos.z / SQUARE_SIZE, moveDir));
 	}
+	// same as GetPosSpeedMod(moveDef, (hxSquare + n) * 2, hzSquare * 2) for n in [0, numSquares)
+	static void GetPosSpeedModRow(const MoveDef& moveDef, unsigned hxSquare, unsigned hzSquare, unsigned numSquares, float* speedMods);
+	// upper bound of the (positional and directional) speed-multipliers above on any map square
+	static float GetMaxSpeedMod(const MoveDef& moveDef);
 
 	// tells whether a position is blocked (inaccessable for a given object's MoveDef)
 	static inline BlockType IsBlocked(const MoveDef& moveDef, const float3& pos, const CSolidObject* collider);
@@ -0,0 +1,183 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SPEEDMOD_ROWS_H
+#define SPEEDMOD_ROWS_H
+
+#include <algorithm>
+
+#ifndef DEDICATED_NOSSE
+#include <xmmintrin.h>
+#endif
+
+/**
+ * Row kernels for CMoveMath::GetPosSpeedModRow.
+ *
+ * These evaluate the positional (direction-independent) speedmods of a run of
+ * half-resolution squares, four at a time, from the square heights and slopes
+ * and the terrain-type speeds for the MoveDef's class. All branches of
+ * {Ground,Hover,Ship}SpeedMod and MoveDef::GetDepthMod are computed and then
+ * selected per lane; every lane performs the same operations in the same order
+ * as the scalar code, so results are bit-wise identical to GetPosSpeedMod.
+ */
+
+namespace SpeedModRows {
+	/// what the positional speedmod of a MoveDef depends on besides the terrain
+	struct Params {
+		int speedModClass = 0; // MoveDef::SpeedModClass
+
+		float maxSlope = 0.0f;
+		float slopeMod = 0.0f;
+		float depth = 0.0f;
+
+		float waterDamageCost = 1.0f;
+		float hoverWaterSpeedMod = 1.0f; // (1.0f * !noHoverWaterMove)
+
+		// MoveDef::depthModParams
+		float depthModMinHeight = 0.0f;
+		float depthModMaxHeight = 0.0f;
+		float depthModMaxScale = 0.0f;
+		float depthModQuaCoeff = 0.0f;
+		float depthModLinCoeff = 0.0f;
+		float depthModConCoeff = 0.0f;
+	};
+
+	enum {
+		CLASS_TANK  = 0,
+		CLASS_KBOT  = 1,
+		CLASS_HOVER = 2,
+		CLASS_SHIP  = 3,
+	};
+
+
+	inline float GetDepthMod(const Params& p, const float height) {
+		if (height > -p.depthModMinHeight)
+			return 1.0f;
+		if (height < -p.depthModMaxHeight)
+			return 0.0f;
+
+		const float depth = -height;
+		const float scale = std::min(p.depthModMaxScale, std::max(0.01f, (p.depthModQuaCoeff * depth * depth + p.depthModLinCoeff * depth + p.depthModConCoeff)));
+
+		return (1.0f / scale);
+	}
+
+	/// scalar version, used for the tails of rows
+	inline float GetSpeedMod(const Params& p, const float height, const float slope, const float typeSpeed) {
+		float speedMod = 0.0f;
+
+		switch (p.speedModClass) {
+			case CLASS_TANK:
+			case CLASS_KBOT: {
+				if (slope > p.maxSlope || -height > p.depth)
+					break;
+
+				speedMod = 1.0f / (1.0f + slope * p.slopeMod);
+				speedMod *= ((height < 0.0f)? p.waterDamageCost: 1.0f);
+				speedMod *= GetDepthMod(p, height);
+			} break;
+			case CLASS_HOVER: {
+				if (height < 0.0f) {
+					speedMod = p.hoverWaterSpeedMod;
+					break;
+				}
+				if (slope > p.maxSlope)
+					break;
+
+				speedMod = 1.0f / (1.0f + slope * p.slopeMod);
+			} break;
+			case CLASS_SHIP: {
+				speedMod = (-height < p.depth)? 0.0f: 1.0f;
+			} break;
+			default: {
+				return 0.0f;
+			} break;
+		}
+
+		return (speedMod * typeSpeed);
+	}
+
+
+	#ifndef DEDICATED_NOSSE
+	inline __m128 SelectPS(const __m128 mask, const __m128 a, const __m128 b) {
+		// (mask? a: b) per lane
+		return (_mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)));
+	}
+
+	inline __m128 GetDepthMods(const Params& p, const __m128 heights) {
+		const __m128 depths = _mm_xor_ps(heights, _mm_set1_ps(-0.0f));
+
+		__m128 scales;
+		scales = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(p.depthModQuaCoeff), depths), depths);
+		scales = _mm_add_ps(scales, _mm_mul_ps(_mm_set1_ps(p.depthModLinCoeff), depths));
+		scales = _mm_add_ps(scales, _mm_set1_ps(p.depthModConCoeff));
+		// operand order matches Clamp's std::{min,max} for unordered lanes
+		scales = _mm_min_ps(_mm_max_ps(scales, _mm_set1_ps(0.01f)), _mm_set1_ps(p.depthModMaxScale));
+
+		__m128 depthMods = _mm_div_ps(_mm_set1_ps(1.0f), scales);
+		depthMods = SelectPS(_mm_cmplt_ps(heights, _mm_set1_ps(-p.depthModMaxHeight)), _mm_setzero_ps(), depthMods);
+		depthMods = SelectPS(_mm_cmpgt_ps(heights, _mm_set1_ps(-p.depthModMinHeight)), _mm_set1_ps(1.0f), depthMods);
+		return depthMods;
+	}
+
+	inline __m128 GetSpeedMods(const Params& p, const __m128 heights, const __m128 slopes, const __m128 typeSpeeds) {
+		const __m128 zeros = _mm_setzero_ps();
+		const __m128 ones = _mm_set1_ps(1.0f);
+		const __m128 depths = _mm_xor_ps(heights, _mm_set1_ps(-0.0f));
+
+		const __m128 tooSteep = _mm_cmpgt_ps(slopes, _mm_set1_ps(p.maxSlope));
+		const __m128 inWater = _mm_cmplt_ps(heights, zeros);
+
+		__m128 speedMods = zeros;
+
+		switch (p.speedModClass) {
+			case CLASS_TANK:
+			case CLASS_KBOT: {
+				const __m128 tooDeep = _mm_cmpgt_ps(depths, _mm_set1_ps(p.depth));
+
+				speedMods = _mm_div_ps(ones, _mm_add_ps(ones, _mm_mul_ps(slopes, _mm_set1_ps(p.slopeMod))));
+				speedMods = _mm_mul_ps(speedMods, SelectPS(inWater, _mm_set1_ps(p.waterDamageCost), ones));
+				speedMods = _mm_mul_ps(speedMods, GetDepthMods(p, heights));
+				speedMods = _mm_andnot_ps(_mm_or_ps(tooSteep, tooDeep), speedMods);
+			} break;
+			case CLASS_HOVER: {
+				speedMods = _mm_div_ps(ones, _mm_add_ps(ones, _mm_mul_ps(slopes, _mm_set1_ps(p.slopeMod))));
+				speedMods = _mm_andnot_ps(tooSteep, speedMods);
+				speedMods = SelectPS(inWater, _mm_set1_ps(p.hoverWaterSpeedMod), speedMods);
+			} break;
+			case CLASS_SHIP: {
+				speedMods = _mm_andnot_ps(_mm_cmplt_ps(depths, _mm_set1_ps(p.depth)), ones);
+			} break;
+			default: {
+				return zeros;
+			} break;
+		}
+
+		return (_mm_mul_ps(speedMods, typeSpeeds));
+	}
+	#endif
+
+
+	/// writes the speedmods of <numSquares> squares to <speedMods>
+	inline void GetSpeedModRow(
+		const Params& p,
+		const float* heights,
+		const float* slopes,
+		const float* typeSpeeds,
+		const unsigned int numSquares,
+		float* speedMods
+	) {
+		unsigned int n = 0;
+
+		#ifndef DEDICATED_NOSSE
+		for (; (n + 4) <= numSquares; n += 4) {
+			_mm_storeu_ps(&speedMods[n], GetSpeedMods(p, _mm_loadu_ps(&heights[n]), _mm_loadu_ps(&slopes[n]), _mm_loadu_ps(&typeSpeeds[n])));
+		}
+		#endif
+
+		for (; n < numSquares; n++) {
+			speedMods[n] = GetSpeedMod(p, heights[n], slopes[n], typeSpeeds[n]);
+		}
+	}
+}
+
+#endif // SPEEDMOD_ROWS_H
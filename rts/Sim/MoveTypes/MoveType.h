@@ -49,6 +49,14 @@ public:
 	virtual void SetManeuverLeash(float leashLength) { maneuverLeash = leashLength; }
 	virtual void SetWaterline(float depth) { waterline = depth; }
 
+	/**
+	 * Optional first phase of Update, called for every active unit before
+	 * any of them is updated (in parallel if modInfo.parallelMoveTypeUpdates
+	 * is set). Implementations may only read synced state and write to their
+	 * own pre-update cache; since other units can still move the owner before
+	 * its Update runs, cached values must be revalidated before use.
+	 */
+	virtual void PreUpdate() {}
 	virtual bool Update() = 0;
 	virtual void SlowUpdate();
 
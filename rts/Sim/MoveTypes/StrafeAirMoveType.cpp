@@ -919,9 +919,7 @@ void CStrafeAirMoveType::UpdateTakeOff()
 	SyncedFloat3& frontdir = owner->frontdir;
 	SyncedFloat3& updir    = owner->updir;
 
-	const float currentHeight = pos.y - (owner->unitDef->canSubmerge?
-		CGround::GetHeightReal(pos.x, pos.z):
-		CGround::GetHeightAboveWater(pos.x, pos.z));
+	const float currentHeight = pos.y - GetGroundHeight(pos);
 	const float yawSign = Sign((goalPos - pos).dot(rightdir));
 
 	frontdir += (rightdir * yawSign * (maxRudder * spd.y));
@@ -1027,9 +1025,7 @@ void CStrafeAirMoveType::UpdateLanding()
 		if (landPosDistXZ > curSpeedXZ && curSpeedXZ > 0.1f) {
 			owner->SetVelocity(spd + UpVector * std::max(-altitudeRate, landPosDistY * curSpeedXZ / landPosDistXZ));
 		} else {
-			const float localAltitude = pos.y - (owner->unitDef->canSubmerge ?
-				CGround::GetHeightReal(owner->pos.x, owner->pos.z):
-				CGround::GetHeightAboveWater(owner->pos.x, owner->pos.z));
+			const float localAltitude = pos.y - GetGroundHeight(owner->pos);
 			if (localAltitude > wantedHeight) {
 				owner->SetVelocity(spd + UpVector * std::max(-altitudeRate, wantedHeight - localAltitude));
 			}
@@ -33,6 +33,7 @@ void IPathFinder::Init(unsigned int _BLOCK_SIZE)
 		testedBlocks = 0;
 
 		instanceIndex = pathFinderInstances.size();
+		masterInstance = this;
 	}
 	{
 		openBlockBuffer.Clear();
@@ -158,7 +159,7 @@ IPath::SearchResult IPathFinder::InitSearch(const MoveDef& moveDef, const CPathF
 	int2 square = mStartBlock;
 
 	if (BLOCK_SIZE != 1)
-		square = blockStates.peNodeOffsets[moveDef.pathType][mStartBlockIdx];
+		square = masterInstance->blockStates.peNodeOffsets[moveDef.pathType][mStartBlockIdx];
 
 	const bool isStartGoal = pfDef.IsGoal(square.x, square.y);
 	const bool startInGoal = pfDef.startInGoalRadius;
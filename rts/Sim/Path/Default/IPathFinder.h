@@ -141,6 +141,10 @@ public:
 
 	unsigned int instanceIndex = 0;
 
+	// instance whose node-offsets and extra-costs are read during searches;
+	// only differs from <this> for the search-workers owned by CPathManager
+	const IPathFinder* masterInstance = this;
+
 	PathNodeBuffer openBlockBuffer;
 	PathNodeStateBuffer blockStates;
 	PathPriorityQueue openBlocks;
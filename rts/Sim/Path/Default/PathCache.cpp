@@ -4,39 +4,60 @@
 
 #include "PathCache.h"
 #include "Sim/Misc/GlobalConstants.h"
-#include "Sim/Misc/GlobalSynced.h"
 #include "System/Log/ILog.h"
 
-#define MAX_CACHE_QUEUE_SIZE   200
-#define MAX_PATH_LIFETIME_SECS   6
+#ifndef UNIT_TEST
+	#include "Sim/Misc/GlobalSynced.h"
+#endif
+
+#define MAX_CACHE_SIZE        1024
 #define USE_NONCOLLIDABLE_HASH   1
 
-CPathCache::CPathCache(int blocksX, int blocksZ)
-	: numBlocksX(blocksX)
+CPathCache::CPathCache(int blocksX, int blocksZ, int blockSize)
+	: cacheItems(MAX_CACHE_SIZE)
+	, cacheHashes(MAX_CACHE_SIZE, 0)
+	, refBits(MAX_CACHE_SIZE)
+
+	, numBlocksX(blocksX)
 	, numBlocksZ(blocksZ)
 	, numBlocks(numBlocksX * numBlocksZ)
 
+	, blockPixelSize(blockSize * SQUARE_SIZE)
+	, clockHand(0)
+
 	, maxCacheSize(0)
 	, numCacheHits(0)
 	, numCacheMisses(0)
+	, numSharedHits(0)
 	, numHashCollisions(0)
+	, numEvictions(0)
+	, numInvalidations(0)
 {
 	// {result, path, strtBlock, goalBlock, goalRadius, pathType}
 	dummyCacheItem = {IPath::Error, {}, {-1, -1}, {-1, -1}, -1.0f, -1};
 
-	cachedPaths.reserve(4096);
+	std::fill(cacheItems.begin(), cacheItems.end(), dummyCacheItem);
+
+	freeSlots.reserve(MAX_CACHE_SIZE);
+	cachedPaths.reserve(MAX_CACHE_SIZE);
+
+	// hand out free slots in ascending order
+	for (std::uint32_t slot = MAX_CACHE_SIZE; slot > 0; slot--) {
+		freeSlots.push_back(slot - 1);
+		refBits[slot - 1].store(0, std::memory_order_relaxed);
+	}
 }
 
 CPathCache::~CPathCache()
 {
 	const char* fmt =
 #ifdef _WIN32
-		"[%s(%ux%u)] cacheHits=%u hitPercentage=%.0f%% numHashColls=%u maxCacheSize=%I64u";
+		"[%s(%ux%u)] cacheHits=%u (shared=%u) hitPercentage=%.0f%% numEvictions=%u numInvalidations=%u numHashColls=%u maxCacheSize=%I64u";
 #else
-		"[%s(%ux%u)] cacheHits=%u hitPercentage=%.0f%% numHashColls=%u maxCacheSize=%lu";
+		"[%s(%ux%u)] cacheHits=%u (shared=%u) hitPercentage=%.0f%% numEvictions=%u numInvalidations=%u numHashColls=%u maxCacheSize=%lu";
 #endif
 
-	LOG(fmt, __FUNCTION__, numBlocksX, numBlocksZ, numCacheHits, GetCacheHitPercentage(), numHashCollisions, maxCacheSize);
+	LOG(fmt, __FUNCTION__, numBlocksX, numBlocksZ, numCacheHits, numSharedHits, GetCacheHitPercentage(), numEvictions, numInvalidations, numHashCollisions, maxCacheSize);
 }
 
 bool CPathCache::AddPath(
@@ -47,23 +68,24 @@ bool CPathCache::AddPath(
 	float goalRadius,
 	int pathType
 ) {
-	if (cacheQue.size() > MAX_CACHE_QUEUE_SIZE)
-		RemoveFrontQueItem();
-
 	const std::uint64_t hash = GetHash(strtBlock, goalBlock, goalRadius, pathType);
 	const std::uint32_t cols = numHashCollisions;
 	const auto iter = cachedPaths.find(hash);
 
 	// register any hash collisions
 	if (iter != cachedPaths.end())
-		return ((numHashCollisions += HashCollision(iter->second, strtBlock, goalBlock, goalRadius, pathType)) != cols);
+		return ((numHashCollisions += HashCollision(cacheItems[iter->second], strtBlock, goalBlock, goalRadius, pathType)) != cols);
+
+	const std::uint32_t slot = GetFreeSlot();
 
-	cachedPaths[hash] = CacheItem{result, *path, strtBlock, goalBlock, goalRadius, pathType};
+	cacheItems[slot] = CacheItem{result, *path, strtBlock, goalBlock, goalRadius, pathType};
+	cacheHashes[slot] = hash;
+	cachedPaths[hash] = slot;
 
-	const int lifeTime = (result == IPath::Ok) ? GAME_SPEED * MAX_PATH_LIFETIME_SECS : GAME_SPEED * (MAX_PATH_LIFETIME_SECS / 2);
+	// new entries survive one full sweep of the hand
+	refBits[slot].store(1, std::memory_order_relaxed);
 
-	cacheQue.push_back({gs->frameNum + lifeTime, hash});
-	maxCacheSize = std::max<std::uint64_t>(maxCacheSize, cacheQue.size());
+	maxCacheSize = std::max<std::uint64_t>(maxCacheSize, cachedPaths.size());
 	return false;
 }
 
@@ -73,39 +95,128 @@ const CPathCache::CacheItem& CPathCache::GetCachedPath(
 	float goalRadius,
 	int pathType
 ) {
+	const CacheItem& ci = FindCachedPath(strtBlock, goalBlock, goalRadius, pathType);
+
+	numCacheHits += (ci.pathType != -1);
+	numCacheMisses += (ci.pathType == -1);
+	return ci;
+}
+
+const CPathCache::CacheItem& CPathCache::FindCachedPath(
+	const int2 strtBlock,
+	const int2 goalBlock,
+	float goalRadius,
+	int pathType
+) const {
 	const std::uint64_t hash = GetHash(strtBlock, goalBlock, goalRadius, pathType);
 	const auto iter = cachedPaths.find(hash);
 
-	if (iter == cachedPaths.end()) {
-		++numCacheMisses; return dummyCacheItem;
-	}
-	if ((iter->second).strtBlock != strtBlock) {
-		++numCacheMisses; return dummyCacheItem;
+	if (iter == cachedPaths.end())
+		return dummyCacheItem;
+
+	const CacheItem& ci = cacheItems[iter->second];
+
+	if (ci.strtBlock != strtBlock)
+		return dummyCacheItem;
+	if (ci.goalBlock != goalBlock)
+		return dummyCacheItem;
+	if (ci.pathType != pathType)
+		return dummyCacheItem;
+
+	// every reader stores the same value, so the outcome is order-independent
+	refBits[iter->second].store(1, std::memory_order_relaxed);
+	return ci;
+}
+
+
+void CPathCache::InvalidateBlocks(const std::vector<std::uint8_t>& blockMask)
+{
+	assert(blockMask.size() == numBlocks);
+
+	for (std::uint32_t slot = 0; slot < cacheItems.size(); slot++) {
+		const CacheItem& ci = cacheItems[slot];
+
+		if (ci.pathType == -1)
+			continue;
+		if (ci.result == IPath::Ok && !PathCrossesBlocks(ci, blockMask))
+			continue;
+
+		RemoveSlot(slot);
+		numInvalidations += 1;
 	}
-	if ((iter->second).goalBlock != goalBlock) {
-		++numCacheMisses; return dummyCacheItem;
+}
+
+void CPathCache::Invalidate()
+{
+	for (std::uint32_t slot = 0; slot < cacheItems.size(); slot++) {
+		if (cacheItems[slot].pathType == -1)
+			continue;
+
+		RemoveSlot(slot);
+		numInvalidations += 1;
 	}
-	if ((iter->second).pathType != pathType) {
-		++numCacheMisses; return dummyCacheItem;
+}
+
+bool CPathCache::PathCrossesBlocks(const CacheItem& ci, const std::vector<std::uint8_t>& blockMask) const
+{
+	if (blockMask[ci.strtBlock.y * numBlocksX + ci.strtBlock.x] != 0)
+		return true;
+	if (blockMask[ci.goalBlock.y * numBlocksX + ci.goalBlock.x] != 0)
+		return true;
+
+	// consecutive waypoints lie in neighboring blocks, so the blocks holding
+	// them are all the blocks whose vertices the path used
+	for (const float3& wp: ci.path.path) {
+		const std::uint32_t bx = std::min(std::uint32_t(std::max(0.0f, wp.x) / blockPixelSize), numBlocksX - 1);
+		const std::uint32_t bz = std::min(std::uint32_t(std::max(0.0f, wp.z) / blockPixelSize), numBlocksZ - 1);
+
+		if (blockMask[bz * numBlocksX + bx] != 0)
+			return true;
 	}
 
-	++numCacheHits;
-	return (iter->second);
+	return false;
 }
 
-void CPathCache::Update()
+
+std::uint32_t CPathCache::GetFreeSlot()
 {
-	while (!cacheQue.empty() && (cacheQue.front().timeout) < gs->frameNum)
-		RemoveFrontQueItem();
+	if (!freeSlots.empty()) {
+		const std::uint32_t slot = freeSlots.back();
+		freeSlots.pop_back();
+		return slot;
+	}
+
+	// all slots are taken; give referenced entries a second chance
+	while (refBits[clockHand].load(std::memory_order_relaxed) != 0) {
+		refBits[clockHand].store(0, std::memory_order_relaxed);
+		clockHand = (clockHand + 1) % cacheItems.size();
+	}
+
+	const std::uint32_t slot = clockHand;
+
+	clockHand = (clockHand + 1) % cacheItems.size();
+	numEvictions += 1;
+
+	RemoveSlot(slot);
+	// RemoveSlot returned it to the free list
+	freeSlots.pop_back();
+	return slot;
 }
 
-void CPathCache::RemoveFrontQueItem()
+void CPathCache::RemoveSlot(std::uint32_t slot)
 {
-	const auto it = cachedPaths.find((cacheQue.front()).hash);
+	const auto it = cachedPaths.find(cacheHashes[slot]);
 
 	assert(it != cachedPaths.end());
+	assert(it->second == slot);
 	cachedPaths.erase(it);
-	cacheQue.pop_front();
+
+	// release the waypoint memory, not just the contents
+	cacheItems[slot] = CacheItem(dummyCacheItem);
+	cacheHashes[slot] = 0;
+	refBits[slot].store(0, std::memory_order_relaxed);
+
+	freeSlots.push_back(slot);
 }
 
 std::uint64_t CPathCache::GetHash(
@@ -158,6 +269,7 @@ bool CPathCache::HashCollision(
 	hashColl |= (ci.strtBlock != strtBlk || ci.goalBlock != goalBlk);
 	hashColl |= (ci.pathType != pathType || ci.goalRadius != goalRadius);
 
+	#ifndef UNIT_TEST
 	const char* fmt =
 #ifdef _WIN32
 		"[%s][f=%d][hash=%I64u] Hash(sb=<%d,%d> gb=<%d,%d> gr=%.2f pt=%d)==Hash(sb=<%d,%d> gb=<%d,%d> gr=%.2f pt=%d)";
@@ -177,6 +289,7 @@ bool CPathCache::HashCollision(
 			goalRadius, pathType
 		);
 	}
+	#endif
 
 	return hashColl;
 }
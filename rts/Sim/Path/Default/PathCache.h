@@ -3,16 +3,28 @@
 #ifndef PATHCACHE_H
 #define PATHCACHE_H
 
-#include <deque>
+#include <atomic>
+#include <vector>
 
 #include "IPath.h"
 #include "System/type2.h"
 #include "System/UnorderedMap.hpp"
 
+/**
+ * Size-bounded cache of PE block-paths, keyed by (start-block, goal-block,
+ * goal-radius, path-type).
+ *
+ * Entries do not expire with time; when the cache is full a CLOCK sweep
+ * evicts the first entry that was not looked up since the hand last passed
+ * it, and entries are invalidated when their path crosses a block whose
+ * vertex costs were recalculated (see InvalidateBlocks). Lookups made by
+ * concurrent readers (FindCachedPath) only set reference bits, which does
+ * not depend on the order in which they happen.
+ */
 class CPathCache
 {
 public:
-	CPathCache(int blocksX, int blocksZ);
+	CPathCache(int blocksX, int blocksZ, int blockSize);
 	~CPathCache();
 
 	struct CacheItem {
@@ -24,7 +36,6 @@ public:
 		int pathType;
 	};
 
-	void Update();
 	bool AddPath(
 		const IPath::Path* path,
 		const IPath::SearchResult result,
@@ -40,9 +51,43 @@ public:
 		float goalRadius,
 		int pathType
 	);
+	/// same as GetCachedPath but without hit-counting, safe for concurrent readers
+	const CacheItem& FindCachedPath(
+		const int2 strtBlock,
+		const int2 goalBlock,
+		float goalRadius,
+		int pathType
+	) const;
+
+	/**
+	 * Removes every entry whose path (or start- or goal-block) lies in a block
+	 * marked in <blockMask> (one byte per block, row-major), and every failed
+	 * search since any change may have opened a way to its goal.
+	 */
+	void InvalidateBlocks(const std::vector<std::uint8_t>& blockMask);
+	/// removes all entries, e.g. when the extra costs searches used have changed
+	void Invalidate();
+
+	/// counts <n> requests that reused another request's search in the same frame as hits
+	void AddSharedHits(std::uint32_t n) {
+		numCacheHits += n;
+		numSharedHits += n;
+	}
+
+	std::uint32_t GetNumCacheHits() const { return numCacheHits; }
+	std::uint32_t GetNumCacheMisses() const { return numCacheMisses; }
+	std::uint32_t GetNumSharedHits() const { return numSharedHits; }
+	std::uint32_t GetNumEvictions() const { return numEvictions; }
+	std::uint32_t GetNumInvalidations() const { return numInvalidations; }
+
+	std::uint32_t GetSize() const { return (cachedPaths.size()); }
+	std::uint32_t GetCapacity() const { return (cacheItems.size()); }
 
 private:
-	void RemoveFrontQueItem();
+	bool PathCrossesBlocks(const CacheItem& ci, const std::vector<std::uint8_t>& blockMask) const;
+
+	std::uint32_t GetFreeSlot();
+	void RemoveSlot(std::uint32_t slot);
 
 	std::uint64_t GetHash(
 		const int2 strtBlk,
@@ -67,25 +112,33 @@ private:
 	}
 
 private:
-	struct CacheQueItem {
-		std::int32_t timeout;
-		std::uint64_t hash;
-	};
-
 	// returned on any cache-miss
 	CacheItem dummyCacheItem;
 
-	std::deque<CacheQueItem> cacheQue;
-	spring::unordered_map<std::uint64_t, CacheItem> cachedPaths; // ints are sync-safe keys
+	// fixed-size slot array swept by the CLOCK hand; pathType is -1 for free slots
+	std::vector<CacheItem> cacheItems;
+	std::vector<std::uint64_t> cacheHashes;
+	std::vector<std::uint32_t> freeSlots;
+
+	// set by lookups (including those of PE workers), cleared by the hand
+	mutable std::vector< std::atomic<std::uint8_t> > refBits;
+
+	spring::unordered_map<std::uint64_t, std::uint32_t> cachedPaths; // ints are sync-safe keys
 
 	std::uint32_t numBlocksX;
 	std::uint32_t numBlocksZ;
 	std::uint64_t numBlocks;
 
+	std::uint32_t blockPixelSize;
+	std::uint32_t clockHand;
+
 	std::uint64_t maxCacheSize;
 	std::uint32_t numCacheHits;
 	std::uint32_t numCacheMisses;
+	std::uint32_t numSharedHits;
 	std::uint32_t numHashCollisions;
+	std::uint32_t numEvictions;
+	std::uint32_t numInvalidations;
 };
 
 #endif
@@ -168,8 +168,9 @@ struct PathNodeStateBuffer {
 	unsigned int GetMemFootPrint() const {
 		unsigned int memFootPrint = 0;
 
-		if (!peNodeOffsets.empty())
-			memFootPrint += (peNodeOffsets.size() * (sizeof(std::vector<short2>) + peNodeOffsets[0].size() * sizeof(short2)));
+		for (const std::vector<short2>& pathTypeOffsets: peNodeOffsets) {
+			memFootPrint += (sizeof(std::vector<short2>) + pathTypeOffsets.size() * sizeof(short2));
+		}
 
 		memFootPrint += (nodeMask.size() * sizeof(std::uint8_t));
 		memFootPrint += ((fCost.size() + gCost.size()) * sizeof(float));
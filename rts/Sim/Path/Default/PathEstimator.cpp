@@ -2,53 +2,107 @@
 
 #include "System/Platform/Win/win32.h"
 
-#include "minizip/zip.h"
-
 #include "PathEstimator.h"
 #include "PathFinder.h"
 #include "PathFinderDef.h"
+#include "PathFlowField.h"
 // #include "PathFlowMap.hpp"
 #include "PathLog.h"
 #include "PathMemPool.h"
-#include "Game/GlobalUnsynced.h"
-#include "Game/LoadScreen.h"
-#include "Sim/Misc/GroundBlockingObjectMap.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
-#include "Net/Protocol/NetProtocol.h"
 #include "System/Threading/ThreadPool.h" // for_mt
 #include "System/TimeProfiler.h"
-#include "System/Config/ConfigHandler.h"
-#include "System/FileSystem/Archives/IArchive.h"
-#include "System/FileSystem/ArchiveLoader.h"
-#include "System/FileSystem/DataDirsAccess.h"
-#include "System/FileSystem/FileSystem.h"
-#include "System/FileSystem/FileQueryFlags.h"
 #include "System/Platform/Threading.h"
 #include "System/SafeUtil.h"
 #include "System/StringUtil.h"
 #include "System/Sync/HsiehHash.h"
 #include "System/Sync/SHA512.hpp"
 
-#define ENABLE_NETLOG_CHECKSUM 1
+#ifndef UNIT_TEST
+	#include "Game/GlobalUnsynced.h"
+	#include "Game/LoadScreen.h"
+	#include "Sim/Misc/GroundBlockingObjectMap.h"
+	#include "Net/Protocol/NetProtocol.h"
+	#include "System/Config/ConfigHandler.h"
+	#include "System/FileSystem/Archives/IArchive.h"
+	#include "System/FileSystem/ArchiveLoader.h"
+	#include "System/FileSystem/DataDirsAccess.h"
+	#include "System/FileSystem/FileSystem.h"
+	#include "System/FileSystem/FileQueryFlags.h"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
+#define ENABLE_NETLOG_CHECKSUM 1
 
-CONFIG(int, MaxPathCostsMemoryFootPrint).defaultValue(512).minimumValue(64).description("Maximum memusage (in MByte) of multithreaded pathcache generator at loading time.");
 
 PCMemPool pcMemPool;
 PEMemPool peMemPool;
 
 
+#ifndef UNIT_TEST
+CONFIG(int, MaxPathCostsMemoryFootPrint).defaultValue(512).minimumValue(64).description("Maximum memusage (in MByte) of multithreaded pathcache generator at loading time.");
+
+
 static const std::string GetPathCacheDir() {
 	return (FileSystem::GetCacheDir() + "/paths/");
 }
 
+
+// uncompressed cache-file layout: the header, one section-entry per path-type,
+// then per path-type its block offsets directly followed by its vertex costs
+// (each such section starts on a page boundary so it can be faulted in alone)
+static constexpr char PECACHE_FILE_MAGIC[8] = {'S', 'P', 'R', 'G', 'P', 'E', 'C', 'F'};
+static constexpr std::uint32_t PECACHE_FILE_VERSION = 2;
+
+struct PECacheFileHeader {
+	char magic[8];
+
+	std::uint32_t version;
+	std::uint32_t hashCode; // CPathEstimator::fileHashCode
+	std::uint32_t blockSize;
+	std::uint32_t numBlocks;
+	std::uint32_t numPathTypes;
+
+	// CalcChecksum's results over all data
+	std::uint32_t pathChecksum;
+	std::uint8_t pathDigest[sha512::SHA_LEN];
+
+	// over this header (with tableHash zeroed) and all section-entries
+	std::uint32_t tableHash;
+};
+
+struct PECacheFileSection {
+	std::uint64_t dataPos;
+	std::uint32_t dataHash; // offsets, then costs
+	std::uint32_t padding;
+};
+
+
+static std::uint32_t CalcTableHash(const PECacheFileHeader& header, const PECacheFileSection* sections)
+{
+	PECacheFileHeader tableHeader = header;
+
+	std::memcpy(tableHeader.magic, PECACHE_FILE_MAGIC, sizeof(tableHeader.magic));
+	tableHeader.tableHash = 0;
+
+	return (HsiehHash(sections, header.numPathTypes * sizeof(PECacheFileSection), HsiehHash(&tableHeader, sizeof(tableHeader), 0)));
+}
+
+
 static size_t GetNumThreads() {
 	const size_t numThreads = std::max(0, configHandler->GetInt("PathingThreadCount"));
 	const size_t numCores = Threading::GetLogicalCpuCores();
 	return ((numThreads == 0)? numCores: numThreads);
 }
+#else
+// tests calculate all data on their own thread, there is no cache-file
+static size_t GetNumThreads() { return 1; }
+#endif
 
 
 
@@ -64,7 +118,9 @@ void CPathEstimator::Init(IPathFinder* pf, unsigned int BLOCK_SIZE, const std::s
 		nextCostMessageIdx = 0;
 
 		pathChecksum = 0;
+		#ifndef UNIT_TEST
 		fileHashCode = CalcHash(__func__);
+		#endif
 
 		offsetBlockNum = {nbrOfBlocks.x * nbrOfBlocks.y};
 		costBlockNum = {nbrOfBlocks.x * nbrOfBlocks.y};
@@ -74,13 +130,37 @@ void CPathEstimator::Init(IPathFinder* pf, unsigned int BLOCK_SIZE, const std::s
 	}
 	{
 		vertexCosts.clear();
-		vertexCosts.resize(moveDefHandler.GetNumMoveDefs() * blockStates.GetSize() * PATH_DIRECTION_VERTICES, PATHCOST_INFINITY);
+		vertexCosts.resize(moveDefHandler.GetNumMoveDefs());
 		maxSpeedMods.clear();
 		maxSpeedMods.resize(moveDefHandler.GetNumMoveDefs(), 0.001f);
 
 		updatedBlocks.clear();
 		consumedBlocks.clear();
 		offsetBlocksSortedByCost.clear();
+
+		blockUpdateMasks.clear();
+		blockUpdateMasks.resize(nbrOfBlocks.x * nbrOfBlocks.y, 0);
+		demandedBlocks.clear();
+		demandedBlocks.resize(nbrOfBlocks.x * nbrOfBlocks.y, 0);
+		recalcedBlocks.clear();
+		recalcedBlocks.resize(nbrOfBlocks.x * nbrOfBlocks.y, 0);
+		changedBlocks.clear();
+		changedBlocks.resize(nbrOfBlocks.x * nbrOfBlocks.y, 0);
+
+		loadedPathTypes.clear();
+		loadedPathTypes.resize(moveDefHandler.GetNumMoveDefs(), 1);
+		syncedPathTypes.clear();
+		syncedPathTypes.resize(moveDefHandler.GetNumMoveDefs(), 0);
+
+		numDemandedBlocks = 0;
+		changedSquaresMargin = 1;
+
+		// IsBlocked tests a MoveDef's entire footprint, slopes also depend on adjacent squares
+		for (unsigned int i = 0; i < moveDefHandler.GetNumMoveDefs(); i++) {
+			const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
+
+			changedSquaresMargin = std::max(changedSquaresMargin, std::max(md->xsizeh, md->zsizeh) + 1);
+		}
 	}
 
 	CPathEstimator*  childPE = this;
@@ -110,12 +190,17 @@ void CPathEstimator::Init(IPathFinder* pf, unsigned int BLOCK_SIZE, const std::s
 		assert(parentPE != nullptr);
 
 		// calculate map-wide maximum positional speedmod for each MoveDef
+		// (speedmods are constant over each half-resolution square)
 		for_mt(0, moveDefHandler.GetNumMoveDefs(), [&](unsigned int i) {
 			const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
 
-			for (int y = 0; y < mapDims.mapy; y++) {
-				for (int x = 0; x < mapDims.mapx; x++) {
-					childPE->maxSpeedMods[i] = std::max(childPE->maxSpeedMods[i], CMoveMath::GetPosSpeedMod(*md, x, y));
+			std::vector<float> speedMods(mapDims.hmapx);
+
+			for (int y = 0; y < mapDims.hmapy; y++) {
+				CMoveMath::GetPosSpeedModRow(*md, 0, y, mapDims.hmapx, speedMods.data());
+
+				for (int x = 0; x < mapDims.hmapx; x++) {
+					childPE->maxSpeedMods[i] = std::max(childPE->maxSpeedMods[i], speedMods[x]);
 				}
 			}
 		});
@@ -132,10 +217,37 @@ void CPathEstimator::Init(IPathFinder* pf, unsigned int BLOCK_SIZE, const std::s
 }
 
 
+void CPathEstimator::InitWorker(const CPathEstimator* master, IPathFinder* pf)
+{
+	IPathFinder::Init(master->BLOCK_SIZE);
+
+	{
+		// workers never Update, only search
+		pathChecksum = master->pathChecksum;
+
+		masterInstance = master;
+		parentPathFinder = pf;
+		nextPathEstimator = nullptr;
+	}
+	{
+		pathCache[0] = master->pathCache[0];
+		pathCache[1] = master->pathCache[1];
+
+		pendingCacheItems[0].clear();
+		pendingCacheItems[1].clear();
+	}
+}
+
 void CPathEstimator::Kill()
 {
+	// caches belong to the master
+	if (IsWorker())
+		return;
+
 	pcMemPool.free(pathCache[0]);
 	pcMemPool.free(pathCache[1]);
+
+	cacheFile.Close();
 }
 
 
@@ -157,6 +269,7 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 	// Not much point in multithreading these...
 	InitBlocks();
 
+	#ifndef UNIT_TEST
 	if (!ReadFile(cacheFileName, mapName)) {
 		// start extra threads if applicable, but always keep the total
 		// memory-footprint made by CPathFinder instances within bounds
@@ -196,6 +309,9 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 		}
 
 
+		// Calculate PreCached PathData Checksum (also stored in the cache-file)
+		pathChecksum = CalcChecksum();
+
 		sprintf(calcMsg, fmtStrs[2], __func__, BLOCK_SIZE, cacheFileName.c_str());
 		loadscreen->SetLoadMessage(calcMsg, true);
 
@@ -203,17 +319,27 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 
 		sprintf(calcMsg, fmtStrs[3], __func__, BLOCK_SIZE, cacheFileName.c_str());
 		loadscreen->SetLoadMessage(calcMsg, true);
+
+		// continue from the file like any later run would, which
+		// drops the data of path-types no unit has used so far
+		ReadMappedFile(cacheFileName, mapName);
 	}
+	#else
+	{
+		spring::barrier pathBarrier(1);
+		CalcOffsetsAndPathCosts(0, &pathBarrier);
 
-	// Calculate PreCached PathData Checksum
-	pathChecksum = CalcChecksum();
+		// nothing is loaded later, so Update keeps all path-types current
+		std::fill(syncedPathTypes.begin(), syncedPathTypes.end(), 1);
+	}
+	#endif
 
 	// switch to runtime wanted IPathFinder (maybe PF or PE)
 	pfMemPool.free(pathFinders[0]);
 	pathFinders[0] = parentPathFinder;
 
-	pathCache[0] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
-	pathCache[1] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y);
+	pathCache[0] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y, BLOCK_SIZE);
+	pathCache[1] = pcMemPool.alloc<CPathCache>(nbrOfBlocks.x, nbrOfBlocks.y, BLOCK_SIZE);
 }
 
 
@@ -222,6 +348,7 @@ void CPathEstimator::InitBlocks()
 	blockStates.peNodeOffsets.resize(moveDefHandler.GetNumMoveDefs());
 	for (unsigned int idx = 0; idx < moveDefHandler.GetNumMoveDefs(); idx++) {
 		blockStates.peNodeOffsets[idx].resize(nbrOfBlocks.x * nbrOfBlocks.y);
+		vertexCosts[idx].resize(nbrOfBlocks.x * nbrOfBlocks.y * PATH_DIRECTION_VERTICES, PATHCOST_INFINITY);
 	}
 }
 
@@ -258,10 +385,12 @@ void CPathEstimator::CalculateBlockOffsets(unsigned int blockIdx, unsigned int t
 {
 	const int2 blockPos = BlockIdxToPos(blockIdx);
 
+	#ifndef UNIT_TEST
 	if (threadNum == 0 && blockIdx >= nextOffsetMessageIdx) {
 		nextOffsetMessageIdx = blockIdx + blockStates.GetSize() / 16;
 		clientNet->Send(CBaseNetProtocol::Get().SendCPUUsage(BLOCK_SIZE | (blockIdx << 8)));
 	}
+	#endif
 
 	for (unsigned int i = 0; i < moveDefHandler.GetNumMoveDefs(); i++) {
 		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
@@ -275,6 +404,7 @@ void CPathEstimator::EstimatePathCosts(unsigned int blockIdx, unsigned int threa
 {
 	const int2 blockPos = BlockIdxToPos(blockIdx);
 
+	#ifndef UNIT_TEST
 	if (threadNum == 0 && blockIdx >= nextCostMessageIdx) {
 		nextCostMessageIdx = blockIdx + blockStates.GetSize() / 16;
 
@@ -284,6 +414,7 @@ void CPathEstimator::EstimatePathCosts(unsigned int blockIdx, unsigned int threa
 		clientNet->Send(CBaseNetProtocol::Get().SendCPUUsage(0x1 | BLOCK_SIZE | (blockIdx << 8)));
 		loadscreen->SetLoadMessage(calcMsg, (blockIdx != 0));
 	}
+	#endif
 
 	for (unsigned int i = 0; i < moveDefHandler.GetNumMoveDefs(); i++) {
 		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
@@ -306,6 +437,15 @@ int2 CPathEstimator::FindBlockPosOffset(const MoveDef& moveDef, unsigned int blo
 	int2 bestPos(lowerX + (BLOCK_SIZE >> 1), lowerZ + (BLOCK_SIZE >> 1));
 	float bestCost = std::numeric_limits<float>::max();
 
+	// speedmods of the block's half-resolution squares, a row at a time
+	float speedMods[(LOWRES_PE_BLOCKSIZE >> 1) * (LOWRES_PE_BLOCKSIZE >> 1)];
+
+	assert(BLOCK_SIZE <= LOWRES_PE_BLOCKSIZE);
+
+	for (unsigned int z = 0; z < (BLOCK_SIZE >> 1); z++) {
+		CMoveMath::GetPosSpeedModRow(moveDef, lowerX >> 1, (lowerZ >> 1) + z, BLOCK_SIZE >> 1, &speedMods[z * (BLOCK_SIZE >> 1)]);
+	}
+
 	// search for an accessible position within this block
 	/*for (unsigned int z = 0; z < BLOCK_SIZE; ++z) {
 		for (unsigned int x = 0; x < BLOCK_SIZE; ++x) {
@@ -334,7 +474,7 @@ int2 CPathEstimator::FindBlockPosOffset(const MoveDef& moveDef, unsigned int blo
 			break;
 
 		const int2 blockPos(lowerX + ob.offset.x, lowerZ + ob.offset.y);
-		const float speedMod = CMoveMath::GetPosSpeedMod(moveDef, blockPos.x, blockPos.y);
+		const float speedMod = speedMods[(ob.offset.y >> 1) * (BLOCK_SIZE >> 1) + (ob.offset.x >> 1)];
 
 		//assert((blockArea / (0.001f + speedMod) >= 0.0f);
 		const float cost = ob.cost + (blockArea / (0.001f + speedMod));
@@ -353,11 +493,30 @@ int2 CPathEstimator::FindBlockPosOffset(const MoveDef& moveDef, unsigned int blo
 }
 
 
+/**
+ * Half-resolution squares whose speedmods the vertex searches from <block>
+ * can look at: those of the block, of its children along PATHDIR_LEFT, _UP
+ * and the diagonals in between, and one square beyond (neighbors are tested
+ * before the search constraint)
+ */
+static SRectangle GetVertexSearchWindow(const int2 block, const unsigned int blockSize)
+{
+	const int hbs = blockSize >> 1;
+	return (SRectangle((block.x - 1) * hbs - 1, block.y * hbs - 1, (block.x + 2) * hbs + 1, (block.y + 2) * hbs + 1));
+}
+
 /**
  * Calculate costs of paths to all vertices connected from the given block
  */
 void CPathEstimator::CalcVertexPathCosts(const MoveDef& moveDef, int2 block, unsigned int threadNum)
 {
+	// PE's own helpers are max-res PF's, but a low-res PE calculates
+	// its costs with the med-res PE at runtime
+	CPathFinder* pf = dynamic_cast<CPathFinder*>(pathFinders[threadNum]);
+
+	if (pf != nullptr)
+		pf->SetSpeedModWindow(moveDef, GetVertexSearchWindow(block, BLOCK_SIZE));
+
 	// see GetBlockVertexOffset(); costs are bi-directional and only
 	// calculated for *half* the outgoing edges (while costs for the
 	// other four directions are stored at the adjacent vertices)
@@ -365,6 +524,9 @@ void CPathEstimator::CalcVertexPathCosts(const MoveDef& moveDef, int2 block, uns
 	CalcVertexPathCost(moveDef, block, PATHDIR_LEFT_UP,  threadNum);
 	CalcVertexPathCost(moveDef, block, PATHDIR_UP,       threadNum);
 	CalcVertexPathCost(moveDef, block, PATHDIR_RIGHT_UP, threadNum);
+
+	if (pf != nullptr)
+		pf->ClearSpeedModWindow();
 }
 
 void CPathEstimator::CalcVertexPathCost(
@@ -377,14 +539,13 @@ void CPathEstimator::CalcVertexPathCost(
 
 	const unsigned int parentBlockIdx = BlockPosToIdx(parentBlockPos);
 	const unsigned int  childBlockIdx = BlockPosToIdx( childBlockPos);
-	const unsigned int  vertexCostIdx =
-		moveDef.pathType * blockStates.GetSize() * PATH_DIRECTION_VERTICES +
-		parentBlockIdx * PATH_DIRECTION_VERTICES +
-		pathDir;
+	const unsigned int  vertexCostIdx = parentBlockIdx * PATH_DIRECTION_VERTICES + pathDir;
+
+	std::vector<float>& pathTypeCosts = vertexCosts[moveDef.pathType];
 
 	// outside map?
 	if ((unsigned)childBlockPos.x >= nbrOfBlocks.x || (unsigned)childBlockPos.y >= nbrOfBlocks.y) {
-		vertexCosts[vertexCostIdx] = PATHCOST_INFINITY;
+		pathTypeCosts[vertexCostIdx] = PATHCOST_INFINITY;
 		return;
 	}
 
@@ -409,7 +570,7 @@ void CPathEstimator::CalcVertexPathCost(
 	const bool goalBlocked = pfDef.IsGoalBlocked(moveDef, CMoveMath::BLOCK_STRUCTURE, nullptr);
 
 	if (strtBlocked || goalBlocked) {
-		vertexCosts[vertexCostIdx] = PATHCOST_INFINITY;
+		pathTypeCosts[vertexCostIdx] = PATHCOST_INFINITY;
 		return;
 	}
 
@@ -430,9 +591,28 @@ void CPathEstimator::CalcVertexPathCost(
 
 	// store the result
 	if (result == IPath::Ok) {
-		vertexCosts[vertexCostIdx] = path.pathCost;
+		pathTypeCosts[vertexCostIdx] = path.pathCost;
 	} else {
-		vertexCosts[vertexCostIdx] = PATHCOST_INFINITY;
+		pathTypeCosts[vertexCostIdx] = PATHCOST_INFINITY;
+	}
+}
+
+
+// calls f(vertexBlockPos, pathDir) for each vertex QueueBlockVertexUpdates flags
+template<typename F>
+static void ForEachVertexAround(const int2 blockPos, const int2 numBlocks, F f)
+{
+	for (unsigned int pathDir = 0; pathDir < PATH_DIRECTION_VERTICES; pathDir++) {
+		const int2 dirVec = PE_DIRECTION_VECTORS[pathDir];
+
+		for (int z = blockPos.y - std::max(dirVec.y, 0); z <= blockPos.y - std::min(dirVec.y, 0); z++) {
+			for (int x = blockPos.x - std::max(dirVec.x, 0); x <= blockPos.x - std::min(dirVec.x, 0); x++) {
+				if ((unsigned)x >= numBlocks.x || (unsigned)z >= numBlocks.y)
+					continue;
+
+				f(int2(x, z), pathDir);
+			}
+		}
 	}
 }
 
@@ -445,49 +625,134 @@ void CPathEstimator::MapChanged(unsigned int x1, unsigned int z1, unsigned int x
 	assert(x2 >= x1);
 	assert(z2 >= z1);
 
-	// find the upper and lower corner of the rectangular area
-	const int lowerX = Clamp(int(x1 / BLOCK_SIZE) - 1, 0, int(nbrOfBlocks.x - 1));
-	const int upperX = Clamp(int(x2 / BLOCK_SIZE) + 1, 0, int(nbrOfBlocks.x - 1));
-	const int lowerZ = Clamp(int(z1 / BLOCK_SIZE) - 1, 0, int(nbrOfBlocks.y - 1));
-	const int upperZ = Clamp(int(z2 / BLOCK_SIZE) + 1, 0, int(nbrOfBlocks.y - 1));
+	if (!modInfo.prioritizedPathUpdates) {
+		// find the upper and lower corner of the rectangular area
+		const int lowerX = Clamp(int(x1 / BLOCK_SIZE) - 1, 0, int(nbrOfBlocks.x - 1));
+		const int upperX = Clamp(int(x2 / BLOCK_SIZE) + 1, 0, int(nbrOfBlocks.x - 1));
+		const int lowerZ = Clamp(int(z1 / BLOCK_SIZE) - 1, 0, int(nbrOfBlocks.y - 1));
+		const int upperZ = Clamp(int(z2 / BLOCK_SIZE) + 1, 0, int(nbrOfBlocks.y - 1));
+
+		// mark the blocks inside the rectangle, enqueue them
+		// from upper to lower because of the placement of the
+		// bi-directional vertices
+		for (int z = upperZ; z >= lowerZ; z--) {
+			for (int x = upperX; x >= lowerX; x--) {
+				QueueBlockUpdate(int2(x, z), BLOCK_UPDATE_ALL);
+			}
+		}
 
-	// mark the blocks inside the rectangle, enqueue them
-	// from upper to lower because of the placement of the
-	// bi-directional vertices
-	for (int z = upperZ; z >= lowerZ; z--) {
-		for (int x = upperX; x >= lowerX; x--) {
-			const int idx = BlockPosToIdx(int2(x, z));
+		return;
+	}
 
-			if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) != 0)
-				continue;
+	// only blocks containing squares the change can affect need new offsets
+	const int lowerX = Clamp((int(x1) - changedSquaresMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.x - 1));
+	const int upperX = Clamp((int(x2) + changedSquaresMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.x - 1));
+	const int lowerZ = Clamp((int(z1) - changedSquaresMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.y - 1));
+	const int upperZ = Clamp((int(z2) + changedSquaresMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.y - 1));
 
-			updatedBlocks.emplace_back(x, z);
-			blockStates.nodeMask[idx] |= PATHOPT_OBSOLETE;
+	for (int z = upperZ; z >= lowerZ; z--) {
+		for (int x = upperX; x >= lowerX; x--) {
+			QueueBlockUpdate(int2(x, z), BLOCK_UPDATE_OFFSET);
+			QueueBlockVertexUpdates(int2(x, z));
 		}
 	}
 }
 
 
+void CPathEstimator::QueueBlockUpdate(int2 blockPos, std::uint8_t updateMask)
+{
+	const int idx = BlockPosToIdx(blockPos);
+
+	blockUpdateMasks[idx] |= updateMask;
+
+	if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) != 0)
+		return;
+
+	updatedBlocks.push_back(blockPos);
+	blockStates.nodeMask[idx] |= PATHOPT_OBSOLETE;
+}
+
 /**
- * Update some obsolete blocks using the FIFO-principle
+ * Flag every vertex whose search-area (the two blocks it connects
+ * plus, for diagonals, their two common neighbors) contains blockPos
  */
-void CPathEstimator::Update()
+void CPathEstimator::QueueBlockVertexUpdates(int2 blockPos)
 {
-	pathCache[0]->Update();
-	pathCache[1]->Update();
+	ForEachVertexAround(blockPos, nbrOfBlocks, [&](const int2 vertexBlockPos, unsigned int pathDir) {
+		QueueBlockUpdate(vertexBlockPos, 1 << pathDir);
+	});
+}
 
-	const unsigned int numMoveDefs = moveDefHandler.GetNumMoveDefs();
+void CPathEstimator::ConsumeBlockUpdate(int2 blockPos)
+{
+	const int idx = BlockPosToIdx(blockPos);
+	const std::uint8_t updateMask = blockUpdateMasks[idx];
+
+	// issue repathing for all active movedefs; the others
+	// recalculate this block once they become active
+	for (unsigned int i = 0; i < syncedPathTypes.size(); i++) {
+		if (syncedPathTypes[i] == 0)
+			continue;
 
-	if (numMoveDefs == 0)
+		consumedBlocks.emplace_back(blockPos, moveDefHandler.GetMoveDefByPathType(i), updateMask);
+	}
+
+	changedBlocks[idx] = 1;
+
+	// inform dependent estimator that costs were updated and it should do the same
+	// (blocks that were only queued for their vertices lie outside the changed area)
+	// FIXME?
+	//   adjacent med-res PE blocks will cause a low-res block to be updated twice
+	//   (in addition to the overlap that already exists because MapChanged() adds
+	//   boundary blocks)
+	if ((updateMask & BLOCK_UPDATE_OFFSET) != 0 && nextPathEstimator != nullptr) {
+		const unsigned int x1 = blockPos.x * BLOCK_SIZE;
+		const unsigned int z1 = blockPos.y * BLOCK_SIZE;
+
+		nextPathEstimator->MapChanged(x1, z1, x1 + BLOCK_SIZE - 1, z1 + BLOCK_SIZE - 1);
+	}
+
+	blockUpdateMasks[idx] = 0;
+	blockStates.nodeMask[idx] &= ~PATHOPT_OBSOLETE;
+}
+
+
+void CPathEstimator::MarkDemandedBlock(const float3& pos)
+{
+	const int2 blockPos = {
+		Clamp(int(pos.x / BLOCK_PIXEL_SIZE), 0, int(nbrOfBlocks.x - 1)),
+		Clamp(int(pos.z / BLOCK_PIXEL_SIZE), 0, int(nbrOfBlocks.y - 1)),
+	};
+
+	std::uint8_t& demanded = demandedBlocks[BlockPosToIdx(blockPos)];
+
+	numDemandedBlocks += (demanded == 0);
+	demanded = 1;
+}
+
+
+/**
+ * Update some obsolete blocks, those on active paths first and
+ * the rest using the FIFO-principle
+ */
+void CPathEstimator::Update(float budgetScale)
+{
+	// only this call's blocks are reported by FlowFieldChanged
+	consumedBlocks.clear();
+
+	if (moveDefHandler.GetNumMoveDefs() == 0)
 		return;
 
+	// only synced path-types are recalculated, blocks are consumed regardless
+	const unsigned int numMoveDefs = std::max<unsigned int>(1, std::count(syncedPathTypes.begin(), syncedPathTypes.end(), 1));
+
 	// determine how many blocks we should update
 	int blocksToUpdate = 0;
 	int consumeBlocks = 0;
 	{
 		const int progressiveUpdates = updatedBlocks.size() * numMoveDefs * modInfo.pfUpdateRate;
 		const int MIN_BLOCKS_TO_UPDATE = std::max<int>(BLOCKS_TO_UPDATE >> 1, 4U);
-		const int MAX_BLOCKS_TO_UPDATE = std::max<int>(BLOCKS_TO_UPDATE << 1, MIN_BLOCKS_TO_UPDATE);
+		const int MAX_BLOCKS_TO_UPDATE = std::max<int>((BLOCKS_TO_UPDATE << 1) * budgetScale, MIN_BLOCKS_TO_UPDATE);
 
 		blocksToUpdate = Clamp(progressiveUpdates, MIN_BLOCKS_TO_UPDATE, MAX_BLOCKS_TO_UPDATE);
 		blockUpdatePenalty = std::max(0, blockUpdatePenalty - blocksToUpdate);
@@ -506,12 +771,32 @@ void CPathEstimator::Update()
 	if (updatedBlocks.empty())
 		return;
 
-	consumedBlocks.clear();
 	consumedBlocks.reserve(consumeBlocks);
 
+	// get blocks on active paths (in queue order); they stay in
+	// the queue but are skipped once PATHOPT_OBSOLETE is cleared
+	if (numDemandedBlocks > 0) {
+		for (const int2& pos: updatedBlocks) {
+			if (consumedBlocks.size() >= blocksToUpdate)
+				break;
+
+			const int idx = BlockPosToIdx(pos);
+
+			if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) == 0)
+				continue;
+			if (demandedBlocks[idx] == 0)
+				continue;
+
+			ConsumeBlockUpdate(pos);
+		}
+
+		std::fill(demandedBlocks.begin(), demandedBlocks.end(), 0);
+		numDemandedBlocks = 0;
+	}
+
 	// get blocks to update
 	while (!updatedBlocks.empty()) {
-		const int2& pos = updatedBlocks.front();
+		const int2 pos = updatedBlocks.front();
 		const int idx = BlockPosToIdx(pos);
 
 		if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) == 0) {
@@ -522,42 +807,84 @@ void CPathEstimator::Update()
 		if (consumedBlocks.size() >= blocksToUpdate)
 			break;
 
-		// issue repathing for all active movedefs
-		for (unsigned int i = 0; i < numMoveDefs; i++) {
-			const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
-
-			consumedBlocks.emplace_back(pos, md);
-		}
-
-		// inform dependent estimator that costs were updated and it should do the same
-		// FIXME?
-		//   adjacent med-res PE blocks will cause a low-res block to be updated twice
-		//   (in addition to the overlap that already exists because MapChanged() adds
-		//   boundary blocks)
-		if (true && nextPathEstimator != nullptr)
-			nextPathEstimator->MapChanged(pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE, pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE);
-
-		updatedBlocks.pop_front(); // must happen _after_ last usage of the `pos` reference!
-		blockStates.nodeMask[idx] &= ~PATHOPT_OBSOLETE;
+		updatedBlocks.pop_front();
+		ConsumeBlockUpdate(pos);
 	}
 
 	// FindOffset (threadsafe)
 	{
 		SCOPED_TIMER("Sim::Path::Estimator::FindOffset");
 		for_mt(0, consumedBlocks.size(), [&](const int n) {
-			// copy the next block in line
-			const SingleBlock sb = consumedBlocks[n];
+			SingleBlock& sb = consumedBlocks[n];
+
+			if ((sb.updateMask & BLOCK_UPDATE_OFFSET) == 0)
+				return;
+
 			const int blockN = BlockPosToIdx(sb.blockPos);
 			const MoveDef* currBlockMD = sb.moveDef;
-			blockStates.peNodeOffsets[currBlockMD->pathType][blockN] = FindBlockPosOffset(*currBlockMD, sb.blockPos.x, sb.blockPos.y);
+			const int2 blockOffset = FindBlockPosOffset(*currBlockMD, sb.blockPos.x, sb.blockPos.y);
+
+			sb.offsetChanged = (blockOffset != blockStates.peNodeOffsets[currBlockMD->pathType][blockN]);
+			blockStates.peNodeOffsets[currBlockMD->pathType][blockN] = blockOffset;
 		});
 	}
 
+	// a moved offset invalidates all vertices touching its block; recalculate
+	// those of blocks consumed above right away and queue the others
+	if (modInfo.prioritizedPathUpdates) {
+		for (const SingleBlock& sb: consumedBlocks) {
+			if (sb.offsetChanged)
+				QueueBlockVertexUpdates(sb.blockPos);
+		}
+		for (SingleBlock& sb: consumedBlocks) {
+			sb.updateMask |= blockUpdateMasks[BlockPosToIdx(sb.blockPos)];
+		}
+		for (const SingleBlock& sb: consumedBlocks) {
+			const int idx = BlockPosToIdx(sb.blockPos);
+
+			blockUpdateMasks[idx] = 0;
+			blockStates.nodeMask[idx] &= ~PATHOPT_OBSOLETE;
+		}
+	}
+
 	// CalcVertexPathCosts (not threadsafe)
 	{
 		SCOPED_TIMER("Sim::Path::Estimator::CalcVertexPathCosts");
+
+		CPathFinder* pf = dynamic_cast<CPathFinder*>(pathFinders[0]);
+
 		for (unsigned int n = 0; n < consumedBlocks.size(); ++n) {
-			CalcVertexPathCosts(*consumedBlocks[n].moveDef, consumedBlocks[n].blockPos);
+			const SingleBlock& sb = consumedBlocks[n];
+
+			if ((sb.updateMask & ((1 << PATH_DIRECTION_VERTICES) - 1)) == 0)
+				continue;
+
+			if (pf != nullptr)
+				pf->SetSpeedModWindow(*sb.moveDef, GetVertexSearchWindow(sb.blockPos, BLOCK_SIZE));
+
+			for (unsigned int pathDir = 0; pathDir < PATH_DIRECTION_VERTICES; pathDir++) {
+				if ((sb.updateMask & (1 << pathDir)) != 0)
+					CalcVertexPathCost(*sb.moveDef, sb.blockPos, pathDir);
+			}
+		}
+
+		if (pf != nullptr)
+			pf->ClearSpeedModWindow();
+	}
+
+	// cached paths stay valid across frames until one of their blocks changes
+	if (!consumedBlocks.empty()) {
+		SCOPED_TIMER("Sim::Path::Estimator::InvalidateCache");
+
+		for (const SingleBlock& sb: consumedBlocks) {
+			recalcedBlocks[BlockPosToIdx(sb.blockPos)] = 1;
+		}
+
+		pathCache[0]->InvalidateBlocks(recalcedBlocks);
+		pathCache[1]->InvalidateBlocks(recalcedBlocks);
+
+		for (const SingleBlock& sb: consumedBlocks) {
+			recalcedBlocks[BlockPosToIdx(sb.blockPos)] = 0;
 		}
 	}
 }
@@ -565,12 +892,51 @@ void CPathEstimator::Update()
 
 const CPathCache::CacheItem& CPathEstimator::GetCache(const int2 strtBlock, const int2 goalBlock, float goalRadius, int pathType, const bool synced) const
 {
-	return pathCache[synced]->GetCachedPath(strtBlock, goalBlock, goalRadius, pathType);
+	if (!IsWorker())
+		return pathCache[synced]->GetCachedPath(strtBlock, goalBlock, goalRadius, pathType);
+
+	// workers see the shared cache as it was when they started plus their own additions
+	for (const CPathCache::CacheItem& ci: pendingCacheItems[synced]) {
+		if (ci.strtBlock != strtBlock || ci.goalBlock != goalBlock)
+			continue;
+		if (ci.goalRadius != goalRadius || ci.pathType != pathType)
+			continue;
+
+		return ci;
+	}
+
+	return pathCache[synced]->FindCachedPath(strtBlock, goalBlock, goalRadius, pathType);
 }
 
 void CPathEstimator::AddCache(const IPath::Path* path, const IPath::SearchResult result, const int2 strtBlock, const int2 goalBlock, float goalRadius, int pathType, const bool synced)
 {
-	pathCache[synced]->AddPath(path, result, strtBlock, goalBlock, goalRadius, pathType);
+	if (!IsWorker()) {
+		pathCache[synced]->AddPath(path, result, strtBlock, goalBlock, goalRadius, pathType);
+		return;
+	}
+
+	pendingCacheItems[synced].push_back(CPathCache::CacheItem{result, *path, strtBlock, goalBlock, goalRadius, pathType});
+}
+
+void CPathEstimator::SwapPendingCacheItems(std::vector<CPathCache::CacheItem> items[2])
+{
+	assert(IsWorker());
+
+	for (unsigned int n = 0; n < 2; n++) {
+		items[n].clear();
+		items[n].swap(pendingCacheItems[n]);
+	}
+}
+
+void CPathEstimator::AddCacheItems(const std::vector<CPathCache::CacheItem> items[2])
+{
+	assert(!IsWorker());
+
+	for (unsigned int n = 0; n < 2; n++) {
+		for (const CPathCache::CacheItem& ci: items[n]) {
+			pathCache[n]->AddPath(&ci.path, ci.result, ci.strtBlock, ci.goalBlock, ci.goalRadius, ci.pathType);
+		}
+	}
 }
 
 
@@ -609,6 +975,72 @@ IPath::SearchResult CPathEstimator::DoBlockSearch(
 }
 
 
+void CPathEstimator::BuildFlowField(const MoveDef& moveDef, const CPathFinderDef& peDef, CPathFlowField& flowField) const
+{
+	// edges cost the same as TestBlock charges a search for them
+	struct FlowFieldGraph {
+		int2 GetNumBlocks() const { return pe->nbrOfBlocks; }
+
+		float GetEdgeCost(const int2 blockPos, const unsigned int pathDir) const {
+			const int2 nbrBlockPos = blockPos + PE_DIRECTION_VECTORS[pathDir];
+			const int2 nbrBlockSquare = pe->GetBlockOffset(pathType, nbrBlockPos);
+
+			const unsigned int vertexCostIdx =
+				pe->BlockPosToIdx(blockPos) * PATH_DIRECTION_VERTICES +
+				GetBlockVertexOffset(pathDir, pe->nbrOfBlocks.x);
+
+			const float vertexCost = masterPE->vertexCosts[pathType][vertexCostIdx];
+			const float extraCost = masterPE->blockStates.GetNodeExtraCost(nbrBlockSquare.x, nbrBlockSquare.y, synced);
+
+			return (vertexCost + extraCost);
+		}
+
+		const CPathEstimator* pe;
+		const CPathEstimator* masterPE;
+
+		unsigned int pathType;
+		bool synced;
+	};
+
+	const FlowFieldGraph graph = {this, GetMaster(), moveDef.pathType, peDef.synced};
+	const int2 goalBlockPos = {int(peDef.goalSquareX / BLOCK_SIZE), int(peDef.goalSquareZ / BLOCK_SIZE)};
+
+	std::vector<int2> goalBlocks;
+
+	for (int z = 0; z < nbrOfBlocks.y; z++) {
+		for (int x = 0; x < nbrOfBlocks.x; x++) {
+			const int2 blockPos = {x, z};
+			const int2 blockSquare = GetBlockOffset(moveDef.pathType, blockPos);
+
+			if (blockPos != goalBlockPos && !peDef.IsGoal(blockSquare.x, blockSquare.y))
+				continue;
+
+			goalBlocks.push_back(blockPos);
+		}
+	}
+
+	flowField.Build(graph, goalBlocks);
+}
+
+bool CPathEstimator::FlowFieldChanged(const CPathFlowField& flowField, unsigned int pathType) const
+{
+	for (const SingleBlock& sb: consumedBlocks) {
+		if (sb.moveDef->pathType != pathType)
+			continue;
+
+		// the block's vertices connect it to its eight neighbors
+		for (int z = std::max(sb.blockPos.y - 1, 0); z <= std::min(sb.blockPos.y + 1, nbrOfBlocks.y - 1); z++) {
+			for (int x = std::max(sb.blockPos.x - 1, 0); x <= std::min(sb.blockPos.x + 1, nbrOfBlocks.x - 1); x++) {
+				if (flowField.IsReachable({x, z}))
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
 /**
  * Performs the actual search.
  */
@@ -618,7 +1050,9 @@ IPath::SearchResult CPathEstimator::DoSearch(const MoveDef& moveDef, const CPath
 
 	// get the goal square offset
 	const int2 goalSqrOffset = peDef.GoalSquareOffset(BLOCK_SIZE);
-	const float maxSpeedMod = maxSpeedMods[moveDef.pathType];
+	const float maxSpeedMod = GetMaster()->maxSpeedMods[moveDef.pathType];
+
+	const std::vector<short2>& nodeOffsets = masterInstance->blockStates.peNodeOffsets[moveDef.pathType];
 
 	while (!openBlocks.empty() && (openBlockBuffer.GetSize() < maxBlocksToBeSearched)) {
 		// get the open block with lowest cost
@@ -630,7 +1064,7 @@ IPath::SearchResult CPathEstimator::DoSearch(const MoveDef& moveDef, const CPath
 			continue;
 
 		// no, check if the goal is already reached
-		const int2 bSquare = blockStates.peNodeOffsets[moveDef.pathType][ob->nodeNum];
+		const int2 bSquare = nodeOffsets[ob->nodeNum];
 		const int2 gSquare = ob->nodePos * BLOCK_SIZE + goalSqrOffset;
 
 		bool runBlkSearch = false;
@@ -722,21 +1156,21 @@ bool CPathEstimator::TestBlock(
 	if (blockStates.nodeMask[testBlockIdx] & (PATHOPT_BLOCKED | PATHOPT_CLOSED))
 		return false;
 
-	const unsigned int vertexBaseIdx = moveDef.pathType * nbrOfBlocks.x * nbrOfBlocks.y * PATH_DIRECTION_VERTICES;
+	const CPathEstimator* masterPE = GetMaster();
+
 	const unsigned int vertexCostIdx =
-		vertexBaseIdx +
 		openBlockIdx * PATH_DIRECTION_VERTICES +
 		GetBlockVertexOffset(pathDir, nbrOfBlocks.x);
 
-	assert(testBlockIdx < blockStates.peNodeOffsets[moveDef.pathType].size());
-	assert(vertexCostIdx < vertexCosts.size());
+	assert(testBlockIdx < masterPE->blockStates.peNodeOffsets[moveDef.pathType].size());
+	assert(vertexCostIdx < masterPE->vertexCosts[moveDef.pathType].size());
 
 	// best accessible heightmap-coordinate within tested block
 	// [DBG] const int2 openBlockSquare = blockStates.peNodeOffsets[moveDef.pathType][openBlockIdx];
-	const int2 testBlockSquare = blockStates.peNodeOffsets[moveDef.pathType][testBlockIdx];
+	const int2 testBlockSquare = masterPE->blockStates.peNodeOffsets[moveDef.pathType][testBlockIdx];
 
 	// transition-cost from parent to tested child
-	float testVertexCost = vertexCosts[vertexCostIdx];
+	float testVertexCost = masterPE->vertexCosts[moveDef.pathType][vertexCostIdx];
 
 
 	// inf-cost means we can not get from the parent VERTEX to the child
@@ -820,7 +1254,7 @@ bool CPathEstimator::TestBlock(
 	// maximum modifier value
 	//
 	// const float  flowCost = (peDef.testMobile) ? (PathFlowMap::GetInstance())->GetFlowCost(testBlockSquare.x, testBlockSquare.y, moveDef, PathDir2PathOpt(pathDir)) : 0.0f;
-	const float extraCost = blockStates.GetNodeExtraCost(testBlockSquare.x, testBlockSquare.y, peDef.synced);
+	const float extraCost = masterPE->blockStates.GetNodeExtraCost(testBlockSquare.x, testBlockSquare.y, peDef.synced);
 	const float  nodeCost = testVertexCost + extraCost;
 
 	const float gCost = parentOpenBlock->gCost + nodeCost;
@@ -903,7 +1337,7 @@ void CPathEstimator::FinishSearch(const MoveDef& moveDef, const CPathFinderDef&
 
 		while (true) {
 			// use offset defined by the block
-			const int2 square = blockStates.peNodeOffsets[moveDef.pathType][blockIdx];
+			const int2 square = masterInstance->blockStates.peNodeOffsets[moveDef.pathType][blockIdx];
 
 			// foundPath.squares.push_back(square);
 			foundPath.path.emplace_back(square.x * SQUARE_SIZE, CMoveMath::yLevel(moveDef, square.x, square.y), square.y * SQUARE_SIZE);
@@ -926,10 +1360,91 @@ void CPathEstimator::FinishSearch(const MoveDef& moveDef, const CPathFinderDef&
 }
 
 
+#ifndef UNIT_TEST
 /**
  * Try to read offset and vertices data from file, return false on failure
  */
 bool CPathEstimator::ReadFile(const std::string& baseFileName, const std::string& mapName)
+{
+	if (ReadMappedFile(baseFileName, mapName))
+		return true;
+
+	// zip-files written by older versions are still accepted (and converted)
+	if (!ReadZipFile(baseFileName, mapName))
+		return false;
+
+	WriteFile(baseFileName, mapName);
+	ReadMappedFile(baseFileName, mapName);
+	return true;
+}
+
+bool CPathEstimator::ReadMappedFile(const std::string& baseFileName, const std::string& mapName)
+{
+	const std::string hashHexString = IntToString(fileHashCode, "%x");
+	const std::string cacheFileName = GetPathCacheDir() + mapName + "." + baseFileName + "-" + hashHexString + ".pcache";
+
+	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
+
+	if (!FileSystem::FileExists(cacheFileName))
+		return false;
+
+	if (!cacheFile.Open(dataDirsAccess.LocateFile(cacheFileName)))
+		return false;
+
+	const unsigned int numPathTypes = moveDefHandler.GetNumMoveDefs();
+	const size_t tableSize = sizeof(PECacheFileHeader) + numPathTypes * sizeof(PECacheFileSection);
+	const size_t sectionSize = blockStates.GetSize() * (sizeof(short2) + PATH_DIRECTION_VERTICES * sizeof(float));
+
+	const PECacheFileHeader* header = reinterpret_cast<const PECacheFileHeader*>(cacheFile.GetData());
+	const PECacheFileSection* sections = reinterpret_cast<const PECacheFileSection*>(header + 1);
+
+	const auto IsValidFile = [&]() {
+		if (cacheFile.GetSize() < tableSize)
+			return false;
+
+		if (std::memcmp(header->magic, PECACHE_FILE_MAGIC, sizeof(header->magic)) != 0)
+			return false;
+		if (header->version != PECACHE_FILE_VERSION || header->hashCode != fileHashCode)
+			return false;
+		if (header->blockSize != BLOCK_SIZE || header->numBlocks != blockStates.GetSize() || header->numPathTypes != numPathTypes)
+			return false;
+
+		for (unsigned int pathType = 0; pathType < numPathTypes; pathType++) {
+			if (sections[pathType].dataPos < tableSize || (sections[pathType].dataPos + sectionSize) > cacheFile.GetSize())
+				return false;
+		}
+
+		// the checksum and digest are taken from the header as-is, but
+		// neither it nor the section-entries can have been damaged
+		return (CalcTableHash(*header, sections) == header->tableHash);
+	};
+
+	if (!IsValidFile()) {
+		LOG_L(L_WARNING, "[PathEstimator::%s] invalid header in \"%s\"", __func__, cacheFileName.c_str());
+
+		cacheFile.Close();
+		FileSystem::Remove(cacheFileName);
+		return false;
+	}
+
+	// the sections are not read here, LoadPathType verifies each one's hash
+	// when copying it out on first use (path-types never used are never read)
+	for (unsigned int pathType = 0; pathType < numPathTypes; pathType++) {
+		std::vector<short2>().swap(blockStates.peNodeOffsets[pathType]);
+		std::vector<float>().swap(vertexCosts[pathType]);
+	}
+
+	std::fill(loadedPathTypes.begin(), loadedPathTypes.end(), 0);
+	std::memcpy(pathDigest.data(), header->pathDigest, pathDigest.size());
+
+	pathChecksum = header->pathChecksum;
+	cacheFilePath = cacheFileName;
+
+	NetLogChecksum(__func__);
+	return true;
+}
+
+bool CPathEstimator::ReadZipFile(const std::string& baseFileName, const std::string& mapName)
 {
 	const std::string hashHexString = IntToString(fileHashCode, "%x");
 	const std::string cacheFileName = GetPathCacheDir() + mapName + "." + baseFileName + "-" + hashHexString + ".zip";
@@ -987,16 +1502,102 @@ bool CPathEstimator::ReadFile(const std::string& baseFileName, const std::string
 	}
 
 	// read vertex-cost data
-	if (buffer.size() < (pos + vertexCosts.size() * sizeof(float))) {
+	const unsigned int costsSize = blockStates.GetSize() * PATH_DIRECTION_VERTICES * sizeof(float);
+
+	if (buffer.size() < (pos + costsSize * moveDefHandler.GetNumMoveDefs())) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	std::memcpy(&vertexCosts[0], &buffer[pos], vertexCosts.size() * sizeof(float));
+	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
+		std::memcpy(&vertexCosts[pathType][0], &buffer[pos], costsSize);
+		pos += costsSize;
+	}
+
+	pathChecksum = CalcChecksum();
 	return true;
 }
 
 
+bool CPathEstimator::LoadPathType(unsigned int pathType, bool synced)
+{
+	const bool copyData = (loadedPathTypes[pathType] == 0);
+	const bool syncData = (synced && syncedPathTypes[pathType] == 0);
+
+	if (!copyData && !syncData)
+		return true;
+
+	bool intactData = true;
+
+	if (copyData) {
+		const PECacheFileHeader* header = reinterpret_cast<const PECacheFileHeader*>(cacheFile.GetData());
+		const PECacheFileSection& section = reinterpret_cast<const PECacheFileSection*>(header + 1)[pathType];
+
+		const size_t offsetsSize = blockStates.GetSize() * sizeof(short2);
+		const size_t costsSize = blockStates.GetSize() * PATH_DIRECTION_VERTICES * sizeof(float);
+
+		const std::uint8_t* offsetsData = cacheFile.GetData() + section.dataPos;
+		const std::uint8_t*   costsData = offsetsData + offsetsSize;
+
+		blockStates.peNodeOffsets[pathType].resize(blockStates.GetSize());
+		vertexCosts[pathType].resize(blockStates.GetSize() * PATH_DIRECTION_VERTICES);
+
+		if (HsiehHash(costsData, costsSize, HsiehHash(offsetsData, offsetsSize, 0)) == section.dataHash) {
+			std::memcpy(blockStates.peNodeOffsets[pathType].data(), offsetsData, offsetsSize);
+			std::memcpy(vertexCosts[pathType].data(), costsData, costsSize);
+		} else {
+			// the section is corrupt (or the file was changed since it was
+			// opened); recalculated data need not match that of other clients,
+			// which have to learn about it through our checksum
+			LOG_L(L_ERROR, "[PathEstimator::%s] corrupt data for path-type %u in \"%s\"", __func__, pathType, cacheFilePath.c_str());
+			FileSystem::Remove(cacheFilePath);
+
+			const MoveDef* md = moveDefHandler.GetMoveDefByPathType(pathType);
+
+			for (unsigned int blockIdx = 0; blockIdx < blockStates.GetSize(); blockIdx++) {
+				const int2 blockPos = BlockIdxToPos(blockIdx);
+
+				blockStates.peNodeOffsets[pathType][blockIdx] = FindBlockPosOffset(*md, blockPos.x, blockPos.y);
+			}
+			for (unsigned int blockIdx = 0; blockIdx < blockStates.GetSize(); blockIdx++) {
+				CalcVertexPathCosts(*md, BlockIdxToPos(blockIdx));
+			}
+
+			pathChecksum = HsiehHash(vertexCosts[pathType].data(), costsSize, HsiehHash(blockStates.peNodeOffsets[pathType].data(), offsetsSize, pathChecksum));
+			intactData = false;
+		}
+
+		loadedPathTypes[pathType] = 1;
+
+		if (std::find(loadedPathTypes.begin(), loadedPathTypes.end(), 0) == loadedPathTypes.end())
+			cacheFile.Close();
+	}
+
+	syncedPathTypes[pathType] |= synced;
+
+	// the data still equals the cache-file's where Update has changed blocks
+	// since; those are queued again once the path-type becomes synced (which
+	// happens in the same frame on every client) and recalculated by Update
+	// within its usual budget, blocks on requested paths first
+	if (syncData)
+		QueueChangedBlocks();
+
+	return intactData;
+}
+
+void CPathEstimator::QueueChangedBlocks()
+{
+	// new offsets first, every vertex touching a changed block depends on them
+	for (unsigned int blockIdx = 0; blockIdx < blockStates.GetSize(); blockIdx++) {
+		if (changedBlocks[blockIdx] != 0)
+			QueueBlockUpdate(BlockIdxToPos(blockIdx), BLOCK_UPDATE_OFFSET);
+	}
+	for (unsigned int blockIdx = 0; blockIdx < blockStates.GetSize(); blockIdx++) {
+		if (changedBlocks[blockIdx] != 0)
+			QueueBlockVertexUpdates(BlockIdxToPos(blockIdx));
+	}
+}
+
 /**
  * Try to write offset and vertex data to file.
  */
@@ -1007,89 +1608,155 @@ void CPathEstimator::WriteFile(const std::string& baseFileName, const std::strin
 		return;
 
 	const std::string hashHexString = IntToString(fileHashCode, "%x");
-	const std::string cacheFileName = GetPathCacheDir() + mapName + "." + baseFileName + "-" + hashHexString + ".zip";
+	const std::string cacheFileName = GetPathCacheDir() + mapName + "." + baseFileName + "-" + hashHexString + ".pcache";
 
 	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
-	// open file for writing in a suitable location
-	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
+	// written under a temporary name and renamed into place when complete;
+	// other processes (or our own cacheFile) may still have the old file
+	// mapped, truncating it would pull the data out from under them
+	const std::string filePath = dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE);
+	const std::string tempPath = filePath + ".tmp";
+
+	std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
 
-	if (file == nullptr)
+	if (!file.is_open())
 		return;
 
-	zipOpenNewFileInZip(file, "pathinfo", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_COMPRESSION);
+	const unsigned int numPathTypes = moveDefHandler.GetNumMoveDefs();
+	const size_t pageSize = MappedFile::GetPageSize();
+	const size_t offsetsSize = blockStates.GetSize() * sizeof(short2);
+	const size_t costsSize = blockStates.GetSize() * PATH_DIRECTION_VERTICES * sizeof(float);
 
-	// write hash-code (NOTE: this also affects the CRC!)
-	zipWriteInFileInZip(file, (const void*) &fileHashCode, 4);
+	PECacheFileHeader header;
+	std::vector<PECacheFileSection> sections(numPathTypes);
 
-	// write center-offsets
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		zipWriteInFileInZip(file, (const void*) &blockStates.peNodeOffsets[pathType][0], blockStates.peNodeOffsets[pathType].size() * sizeof(short2));
+	// the magic is written last, so a partially written file is never accepted
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.pathDigest, pathDigest.data(), sizeof(header.pathDigest));
+
+	header.version = PECACHE_FILE_VERSION;
+	header.hashCode = fileHashCode;
+	header.blockSize = BLOCK_SIZE;
+	header.numBlocks = blockStates.GetSize();
+	header.numPathTypes = numPathTypes;
+	header.pathChecksum = pathChecksum;
+
+	size_t filePos = sizeof(header) + numPathTypes * sizeof(PECacheFileSection);
+
+	for (unsigned int pathType = 0; pathType < numPathTypes; pathType++) {
+		const std::uint8_t* offsetsData = reinterpret_cast<const std::uint8_t*>(blockStates.peNodeOffsets[pathType].data());
+		const std::uint8_t*   costsData = reinterpret_cast<const std::uint8_t*>(vertexCosts[pathType].data());
+
+		filePos = ((filePos + pageSize - 1) / pageSize) * pageSize;
+
+		sections[pathType].dataPos = filePos;
+		sections[pathType].dataHash = HsiehHash(costsData, costsSize, HsiehHash(offsetsData, offsetsSize, 0));
+		sections[pathType].padding = 0;
+
+		filePos += (offsetsSize + costsSize);
 	}
 
-	// write vertex-costs
-	zipWriteInFileInZip(file, vertexCosts.data(), vertexCosts.size() * sizeof(float));
+	header.tableHash = CalcTableHash(header, sections.data());
 
-	zipCloseFileInZip(file);
-	zipClose(file, nullptr);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(PECacheFileSection));
 
+	filePos = sizeof(header) + numPathTypes * sizeof(PECacheFileSection);
 
-	// get the CRC over the written path data
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
+	const std::vector<char> padding(pageSize, 0);
 
-	if (upfile == nullptr || !upfile->IsOpen()) {
-		FileSystem::Remove(cacheFileName);
+	for (unsigned int pathType = 0; pathType < numPathTypes; pathType++) {
+		file.write(padding.data(), sections[pathType].dataPos - filePos);
+		file.write(reinterpret_cast<const char*>(blockStates.peNodeOffsets[pathType].data()), offsetsSize);
+		file.write(reinterpret_cast<const char*>(vertexCosts[pathType].data()), costsSize);
+
+		filePos = sections[pathType].dataPos + offsetsSize + costsSize;
+	}
+
+	file.seekp(0);
+	file.write(PECACHE_FILE_MAGIC, sizeof(header.magic));
+	file.close();
+
+	if (!file.good()) {
+		std::remove(tempPath.c_str());
 		return;
 	}
 
-	assert(upfile->FindFile("pathinfo") < upfile->NumFiles());
-	// pointless; gets reassigned the output of CalcChecksum and CRC is not otherwise used
-	// pathChecksum = upfile->GetCrc32(upfile->FindFile("pathinfo"));
+	if (std::rename(tempPath.c_str(), filePath.c_str()) == 0)
+		return;
+
+	// rename does not replace existing files on all platforms
+	std::remove(filePath.c_str());
+
+	if (std::rename(tempPath.c_str(), filePath.c_str()) == 0)
+		return;
+
+	LOG_L(L_WARNING, "[PathEstimator::%s] could not replace \"%s\"", __func__, filePath.c_str());
+	std::remove(tempPath.c_str());
 }
 
 
-std::uint32_t CPathEstimator::CalcChecksum() const
+std::uint32_t CPathEstimator::CalcChecksum()
 {
-	std::uint32_t cs = 0;
-	std::uint64_t nb = 0;
+	std::vector<const void*> offsetsData(blockStates.peNodeOffsets.size());
+	std::vector<const void*> costsData(vertexCosts.size());
 
-	#if (ENABLE_NETLOG_CHECKSUM == 1)
-	std::array<char, 128 + sha512::SHA_LEN * 2 + 1> msgBuffer;
+	for (size_t pathType = 0; pathType < offsetsData.size(); pathType++) {
+		offsetsData[pathType] = blockStates.peNodeOffsets[pathType].data();
+		costsData[pathType] = vertexCosts[pathType].data();
+	}
 
-	sha512::hex_digest hexChars;
-	sha512::raw_digest shaBytes;
-	sha512::msg_vector rawBytes;
-	#endif
+	const std::uint32_t cs = CalcChecksum(offsetsData, costsData);
 
-	for (const auto& pathTypeOffsets: blockStates.peNodeOffsets) {
-		nb = pathTypeOffsets.size() * sizeof(short2);
-		cs = HsiehHash(pathTypeOffsets.data(), nb, cs);
+	NetLogChecksum(__func__);
+	return cs;
+}
 
-		#if (ENABLE_NETLOG_CHECKSUM == 1)
-		rawBytes.resize(rawBytes.size() + nb, 0);
-		std::memcpy(&rawBytes[rawBytes.size() - nb], pathTypeOffsets.data(), nb);
-		#endif
-	}
+std::uint32_t CPathEstimator::CalcChecksum(const std::vector<const void*>& offsetsData, const std::vector<const void*>& costsData)
+{
+	const size_t offsetsSize = blockStates.GetSize() * sizeof(short2);
+	const size_t costsSize = blockStates.GetSize() * PATH_DIRECTION_VERTICES * sizeof(float);
 
-	nb = vertexCosts.size() * sizeof(float);
-	cs = HsiehHash(vertexCosts.data(), nb, cs);
+	std::uint32_t cs = 0;
 
-	#if (ENABLE_NETLOG_CHECKSUM == 1)
-	{
-		rawBytes.resize(rawBytes.size() + nb);
+	// hash(offsets|costs); the costs of all path-types are hashed in one go
+	sha512::msg_vector rawBytes((offsetsSize + costsSize) * offsetsData.size(), 0);
+
+	std::uint8_t* offsetBytes = rawBytes.data();
+	std::uint8_t*   costBytes = rawBytes.data() + offsetsSize * offsetsData.size();
 
-		std::memcpy(&rawBytes[rawBytes.size() - nb], vertexCosts.data(), nb);
-		sha512::calc_digest(rawBytes, shaBytes); // hash(offsets|costs)
-		sha512::dump_digest(shaBytes, hexChars); // hexify(hash)
+	for (size_t pathType = 0; pathType < offsetsData.size(); pathType++) {
+		cs = HsiehHash(offsetsData[pathType], offsetsSize, cs);
 
-		SNPRINTF(msgBuffer.data(), msgBuffer.size(), "[PE::%s][BLK_SIZE=%d][SHA_DATA=%s]", __func__, BLOCK_SIZE, hexChars.data());
-		CLIENT_NETLOG(gu->myPlayerNum, LOG_LEVEL_INFO, msgBuffer.data());
+		std::memcpy(offsetBytes + pathType * offsetsSize, offsetsData[pathType], offsetsSize);
+		std::memcpy(  costBytes + pathType *   costsSize,   costsData[pathType],   costsSize);
 	}
+
+	cs = HsiehHash(costBytes, costsSize * costsData.size(), cs);
+
+	#if (ENABLE_NETLOG_CHECKSUM == 1)
+	sha512::calc_digest(rawBytes, pathDigest);
+	#else
+	pathDigest.fill(0);
 	#endif
 
 	return cs;
 }
 
+void CPathEstimator::NetLogChecksum(const char* caller) const
+{
+	#if (ENABLE_NETLOG_CHECKSUM == 1)
+	std::array<char, 128 + sha512::SHA_LEN * 2 + 1> msgBuffer;
+	sha512::hex_digest hexChars;
+
+	sha512::dump_digest(pathDigest, hexChars); // hexify(hash)
+
+	SNPRINTF(msgBuffer.data(), msgBuffer.size(), "[PE::%s][BLK_SIZE=%d][SHA_DATA=%s]", caller, BLOCK_SIZE, hexChars.data());
+	CLIENT_NETLOG(gu->myPlayerNum, LOG_LEVEL_INFO, msgBuffer.data());
+	#endif
+}
+
 
 /**
  * Returns a hash-code identifying the dataset of this estimator.
@@ -1112,3 +1779,5 @@ std::uint32_t CPathEstimator::CalcHash(const char* caller) const
 
 	return peHashCode;
 }
+#endif // UNIT_TEST
+
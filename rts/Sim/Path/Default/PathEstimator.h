@@ -14,6 +14,8 @@
 #include "PathConstants.h"
 #include "PathDataTypes.h"
 #include "System/float3.h"
+#include "System/Platform/MappedFile.h"
+#include "System/Sync/SHA512.hpp"
 #include "System/Threading/SpringThreading.h"
 
 
@@ -21,6 +23,7 @@ struct MoveDef;
 class CPathFinder;
 class CPathEstimatorDef;
 class CPathFinderDef;
+class CPathFlowField;
 class CPathCache;
 class CSolidObject;
 
@@ -41,6 +44,14 @@ public:
 	 *   Ex. PE-name "pe" + Mapname "Desert" => "Desert.pe"
 	 */
 	void Init(IPathFinder*, unsigned int BSIZE, const std::string& cacheFileName, const std::string& mapFileName);
+	/**
+	 * Sets this instance up as a search-worker of <master>, sharing all of
+	 * its precalculated data and (read-only) path-caches; cache additions
+	 * are kept pending until the owner hands them to AddCacheItems.
+	 * @param pathFinder
+	 *   The worker's own parent instance (used by DoBlockSearch).
+	 */
+	void InitWorker(const CPathEstimator* master, IPathFinder* pathFinder);
 	void Kill();
 
 
@@ -52,13 +63,57 @@ public:
 	 */
 	void MapChanged(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2);
 
+	/**
+	 * Marks the block containing <pos> as lying on an active path, such that
+	 * the next Update consumes it ahead of all other queued blocks.
+	 */
+	void MarkDemandedBlock(const float3& pos);
+
 	/**
 	 * called every frame
+	 * <budgetScale> scales the maximum number of blocks updated per frame
 	 */
-	void Update();
+	void Update(float budgetScale = 1.0f);
 
 	IPathFinder* GetParent() override { return parentPathFinder; }
 
+	/**
+	 * Copies the data of <pathType> out of the cache-file if that has not
+	 * happened yet. The first synced call also makes Update keep the data
+	 * current from then on; since every client makes that call in the same
+	 * frame, the recalculation of blocks changed before it stays in sync.
+	 * Returns false if the cache-file section was corrupt and the data had
+	 * to be recalculated, after which our checksum no longer matches.
+	 */
+	bool LoadPathType(unsigned int pathType, bool synced);
+
+	bool IsPathTypeLoaded(unsigned int pathType) const { return (loadedPathTypes[pathType] != 0); }
+	bool IsPathTypeSynced(unsigned int pathType) const { return (syncedPathTypes[pathType] != 0); }
+
+	/// (search-workers) moves the cache additions of all searches since the last call into <items>
+	void SwapPendingCacheItems(std::vector<CPathCache::CacheItem> items[2]);
+	/// adds the items of a search-worker's SwapPendingCacheItems to our caches
+	void AddCacheItems(const std::vector<CPathCache::CacheItem> items[2]);
+
+	/**
+	 * Builds <flowField> toward the goal region of <peDef> over our vertex
+	 * costs (plus the synced extra costs) for <moveDef>'s path-type. Goal
+	 * blocks are those whose offset lies within the goal radius, and the
+	 * block containing the goal square.
+	 */
+	void BuildFlowField(const MoveDef& moveDef, const CPathFinderDef& peDef, CPathFlowField& flowField) const;
+	/**
+	 * Returns true if the last Update recalculated a block of <pathType>
+	 * that is reachable in <flowField> or borders one that is, in which
+	 * case the field has to be rebuilt.
+	 */
+	bool FlowFieldChanged(const CPathFlowField& flowField, unsigned int pathType) const;
+
+	/// heightmap-coordinate units of <pathType> pass through in block <blockPos>
+	int2 GetBlockOffset(unsigned int pathType, const int2 blockPos) const {
+		return masterInstance->blockStates.peNodeOffsets[pathType][BlockPosToIdx(blockPos)];
+	}
+
 	/**
 	 * Returns a checksum that can be used to check if every player has the same
 	 * path data.
@@ -112,26 +167,50 @@ private:
 	void CalcVertexPathCosts(const MoveDef&, int2, unsigned int threadNum = 0);
 	void CalcVertexPathCost(const MoveDef&, int2, unsigned int pathDir, unsigned int threadNum = 0);
 
+	void QueueBlockUpdate(int2 blockPos, std::uint8_t updateMask);
+	void QueueBlockVertexUpdates(int2 blockPos);
+	void ConsumeBlockUpdate(int2 blockPos);
+
+	/// re-queues all blocks Update recalculated so far, for a path-type that just became synced
+	void QueueChangedBlocks();
+
 	bool ReadFile(const std::string& baseFileName, const std::string& mapName);
+	bool ReadMappedFile(const std::string& baseFileName, const std::string& mapName);
+	bool ReadZipFile(const std::string& baseFileName, const std::string& mapName);
 	void WriteFile(const std::string& baseFileName, const std::string& mapName);
 
-	std::uint32_t CalcChecksum() const;
+	std::uint32_t CalcChecksum();
+	std::uint32_t CalcChecksum(const std::vector<const void*>& offsetsData, const std::vector<const void*>& costsData);
+	void NetLogChecksum(const char* caller) const;
 	std::uint32_t CalcHash(const char* caller) const;
 
+	const CPathEstimator* GetMaster() const { return (static_cast<const CPathEstimator*>(masterInstance)); }
+	bool IsWorker() const { return (masterInstance != this); }
+
 private:
 	friend class CPathManager;
 	friend class CDefaultPathDrawer;
 
+	// bits [0, PATH_DIRECTION_VERTICES) of a block's update-mask flag its vertices
+	static constexpr std::uint8_t BLOCK_UPDATE_OFFSET = (1 << PATH_DIRECTION_VERTICES);
+	static constexpr std::uint8_t BLOCK_UPDATE_ALL = (BLOCK_UPDATE_OFFSET << 1) - 1;
+
 	unsigned int BLOCKS_TO_UPDATE = 0;
 
 	unsigned int nextOffsetMessageIdx = 0;
 	unsigned int nextCostMessageIdx = 0;
 
 	int blockUpdatePenalty = 0;
+	// squares around a changed area whose speedmods or blocking can change with it
+	int changedSquaresMargin = 1;
+	unsigned int numDemandedBlocks = 0;
 
 	std::uint32_t pathChecksum = 0;
 	std::uint32_t fileHashCode = 0;
 
+	// SHA512 over the precached offsets and costs (see CalcChecksum)
+	sha512::raw_digest pathDigest;
+
 	std::atomic<std::int64_t> offsetBlockNum = {0};
 	std::atomic<std::int64_t> costBlockNum = {0};
 
@@ -139,13 +218,33 @@ private:
 	CPathEstimator* nextPathEstimator; // next lower-resolution estimator
 	CPathCache* pathCache[2]; // [0] = !synced, [1] = synced
 
+	// search-workers only; [0] = !synced, [1] = synced
+	std::vector<CPathCache::CacheItem> pendingCacheItems[2];
+
+	// uncompressed cache-file, kept mapped until every path-type's data has been copied out
+	MappedFile cacheFile;
+	std::string cacheFilePath;
+	/// per path-type, zero while its data is only in cacheFile
+	std::vector<std::uint8_t> loadedPathTypes;
+	/// per path-type, non-zero once a synced request used it; only these are recalculated by Update
+	std::vector<std::uint8_t> syncedPathTypes;
+	/// per block, non-zero once Update recalculated it; path-types synced later still hold older data here
+	std::vector<std::uint8_t> changedBlocks;
+
 	std::vector<IPathFinder*> pathFinders; // InitEstimator helpers
 	std::vector<spring::thread> threads;
 
 	std::vector<float> maxSpeedMods;
-	std::vector<float> vertexCosts;
+	/// vertexCosts[pathType][blockIdx * PATH_DIRECTION_VERTICES + pathDir], empty while not loaded
+	std::vector< std::vector<float> > vertexCosts;
 	/// blocks that may need an update due to map changes
 	std::deque<int2> updatedBlocks;
+	/// per block, which of its vertices and whether its offset need to be recalculated
+	std::vector<std::uint8_t> blockUpdateMasks;
+	/// per block, non-zero if it lies on an active (synced) path; reset by Update
+	std::vector<std::uint8_t> demandedBlocks;
+	/// per block, non-zero if Update recalculated it; cached paths crossing such blocks are dropped
+	std::vector<std::uint8_t> recalcedBlocks;
 
 	struct SOffsetBlock {
 		float cost;
@@ -155,7 +254,9 @@ private:
 	struct SingleBlock {
 		int2 blockPos;
 		const MoveDef* moveDef;
-		SingleBlock(const int2& pos, const MoveDef* md) : blockPos(pos), moveDef(md) {}
+		std::uint8_t updateMask;
+		bool offsetChanged;
+		SingleBlock(const int2& pos, const MoveDef* md, std::uint8_t mask) : blockPos(pos), moveDef(md), updateMask(mask), offsetChanged(false) {}
 	};
 
 	std::vector<SingleBlock> consumedBlocks;
@@ -8,6 +8,7 @@
 #include "PathFinderDef.h"
 #include "PathFlowMap.hpp"
 #include "PathHeatMap.hpp"
+#include "PathJumpPoints.h"
 #include "PathLog.h"
 #include "PathMemPool.h"
 #include "Map/Ground.h"
@@ -73,6 +74,117 @@ static constexpr float3 PF_DIRECTION_VECTORS_3D[] = {
 };
 
 
+static constexpr float JUMP_SPEEDMOD_UNKNOWN = -2.0f;
+
+struct CPathFinder::JumpGrid {
+	float GetUniformSpeedMod(const int2 square) const {
+		if (static_cast<unsigned int>(square.x) >= pf->nbrOfBlocks.x || static_cast<unsigned int>(square.y) >= pf->nbrOfBlocks.y)
+			return -1.0f;
+
+		// runs and probes overlap, evaluate each square only once per search
+		const unsigned int sqrIdx = pf->BlockPosToIdx(square);
+
+		if (pf->jumpSpeedMods[sqrIdx] == JUMP_SPEEDMOD_UNKNOWN) {
+			pf->jumpSpeedMods[sqrIdx] = CalcUniformSpeedMod(square, sqrIdx);
+			pf->jumpSpeedModSquares.push_back(sqrIdx);
+		}
+
+		return pf->jumpSpeedMods[sqrIdx];
+	}
+
+	float CalcUniformSpeedMod(const int2 square, const unsigned int sqrIdx) const {
+		if ((pf->blockStates.nodeMask[sqrIdx] & PATHOPT_BLOCKED) != 0)
+			return -1.0f;
+
+		// directional speedmods only differ on sloped squares; checked before the
+		// (far more expensive) footprint test, sloped squares are never skipped
+		if (!pfDef.dirIndependent) {
+			const float3& sqrNormal = readMap->GetCenterNormals2DSynced()[square.x + square.y * mapDims.mapx];
+
+			if (sqrNormal.x != 0.0f || sqrNormal.z != 0.0f)
+				return 0.0f;
+		}
+
+		const CMoveMath::BlockType blockMask = pf->blockCheckFunc(moveDef, square.x, square.y, owner);
+
+		if ((blockMask & CMoveMath::BLOCK_STRUCTURE) != 0)
+			return -1.0f;
+
+		// anything TestBlock adds to (or multiplies into) the cost of the square
+		if (!pfDef.WithinConstraints(square.x, square.y))
+			return 0.0f;
+		if (pfDef.testMobile && moveDef.avoidMobilesOnPath && (blockMask & squareMobileBlockBits) != 0)
+			return 0.0f;
+		if (pfDef.testMobile && (PathHeatMap::GetInstance())->GetHeatCost(square.x, square.y, moveDef, ((owner != nullptr)? owner->id: -1U)) != 0.0f)
+			return 0.0f;
+		if (pf->masterInstance->blockStates.GetNodeExtraCost(square.x, square.y, pfDef.synced) != 0.0f)
+			return 0.0f;
+
+		if (pfDef.dirIndependent)
+			return (pf->GetPosSpeedMod(moveDef, square));
+
+		return (CMoveMath::GetPosSpeedMod(moveDef, square.x, square.y, PF_DIRECTION_VECTORS_3D[PATHOPT_LEFT]));
+	}
+
+	float GetNodeCost(const unsigned int pathOptDir, const float speedMod) const {
+		// same as TestBlock's nodeCost without heat and extra costs
+		return (PF_DIRECTION_COSTS[pathOptDir] / speedMod);
+	}
+
+	bool IsJumpTarget(const int2 square) const { return (pfDef.IsGoal(square.x, square.y)); }
+
+	// two bits (known, result) per straight direction
+	static unsigned int GetProbeShift(const unsigned int pathOptDir) {
+		return (((pathOptDir & (PATHOPT_LEFT | PATHOPT_RIGHT)) != 0)? (pathOptDir >> 1): (2 + (pathOptDir >> 3))) * 2;
+	}
+
+	int GetProbeResult(const int2 square, const unsigned int pathOptDir) const {
+		const unsigned int probeBits = pf->jumpProbeResults[pf->BlockPosToIdx(square)] >> GetProbeShift(pathOptDir);
+		return (((probeBits & 1) != 0)? ((probeBits >> 1) & 1): -1);
+	}
+
+	void SetProbeResult(const int2 square, const unsigned int pathOptDir, const bool result) {
+		const unsigned int sqrIdx = pf->BlockPosToIdx(square);
+
+		// only squares with known speedmods are reset for the next search
+		assert(pf->jumpSpeedMods[sqrIdx] != JUMP_SPEEDMOD_UNKNOWN);
+		pf->jumpProbeResults[sqrIdx] |= ((1 | (result << 1)) << GetProbeShift(pathOptDir));
+	}
+
+	void TestIntermediate(const int2 square, const unsigned int pathOptDir, const float gCost) {
+		if (pfDef.exactPath)
+			return;
+
+		// same as TestBlock, skipped squares can also be the closest to the goal
+		const float hCost = pfDef.Heuristic(square.x, square.y, pf->BLOCK_SIZE);
+
+		if (hCost >= pf->mGoalHeuristic)
+			return;
+
+		const unsigned int sqrIdx = pf->BlockPosToIdx(square);
+
+		pf->mGoalBlockIdx = sqrIdx;
+		pf->mGoalHeuristic = hCost;
+
+		pf->blockStates.fCost[sqrIdx] = gCost + hCost;
+		pf->blockStates.gCost[sqrIdx] = gCost;
+		pf->blockStates.nodeMask[sqrIdx] &= ~PATHOPT_CARDINALS;
+		pf->blockStates.nodeMask[sqrIdx] |= pathOptDir;
+
+		pf->jumpParents[sqrIdx] = parentIdx;
+		pf->dirtyBlocks.push_back(sqrIdx);
+	}
+
+	CPathFinder* pf;
+
+	const MoveDef& moveDef;
+	const CPathFinderDef& pfDef;
+	const CSolidObject* owner;
+
+	unsigned int parentIdx;
+};
+
+
 void CPathFinder::InitStatic() {
 	static_assert(PF_DIRECTION_COSTS[PATHOPT_LEFT                ] ==        1.0f, "");
 	static_assert(PF_DIRECTION_COSTS[PATHOPT_RIGHT               ] ==        1.0f, "");
@@ -122,6 +234,32 @@ void CPathFinder::Init(bool threadSafe)
 }
 
 
+void CPathFinder::SetSpeedModWindow(const MoveDef& moveDef, const SRectangle& rect)
+{
+	speedModWindow = rect;
+	speedModWindow.ClampIn(SRectangle(0, 0, mapDims.hmapx, mapDims.hmapy));
+	speedModWindowValues.resize(std::max(speedModWindow.GetArea(), 0));
+	speedModWindowPathType = moveDef.pathType;
+
+	for (int z = speedModWindow.z1; z < speedModWindow.z2; z++) {
+		CMoveMath::GetPosSpeedModRow(moveDef, speedModWindow.x1, z, speedModWindow.GetWidth(), &speedModWindowValues[(z - speedModWindow.z1) * speedModWindow.GetWidth()]);
+	}
+}
+
+float CPathFinder::GetPosSpeedMod(const MoveDef& moveDef, const int2 square) const
+{
+	const unsigned int wx = (square.x >> 1) - speedModWindow.x1;
+	const unsigned int wz = (square.y >> 1) - speedModWindow.z1;
+
+	if (moveDef.pathType != speedModWindowPathType)
+		return (CMoveMath::GetPosSpeedMod(moveDef, square.x, square.y));
+	if (wx >= static_cast<unsigned int>(speedModWindow.GetWidth()) || wz >= static_cast<unsigned int>(speedModWindow.GetHeight()))
+		return (CMoveMath::GetPosSpeedMod(moveDef, square.x, square.y));
+
+	return speedModWindowValues[wz * speedModWindow.GetWidth() + wx];
+}
+
+
 IPath::SearchResult CPathFinder::DoRawSearch(
 	const MoveDef& moveDef,
 	const CPathFinderDef& pfDef,
@@ -201,6 +339,26 @@ IPath::SearchResult CPathFinder::DoSearch(
 ) {
 	bool foundGoal = false;
 
+	// only for searches that need a path (PE vertex costs must not depend on it),
+	// and only if no square can be crossed faster than at speedmod 1; otherwise
+	// the heuristic is not consistent, the plain search is not optimal either and
+	// the order in which squares are expanded (which jumps change) decides costs
+	const bool jumpPointSearch = (modInfo.jumpPointPathSearch && pfDef.needPath && CMoveMath::GetMaxSpeedMod(moveDef) <= 1.0f);
+
+	jumpParents.clear();
+
+	if (jumpPointSearch) {
+		jumpSpeedMods.resize(nbrOfBlocks.x * nbrOfBlocks.y, JUMP_SPEEDMOD_UNKNOWN);
+		jumpProbeResults.resize(nbrOfBlocks.x * nbrOfBlocks.y, 0);
+
+		for (const unsigned int sqrIdx: jumpSpeedModSquares) {
+			jumpSpeedMods[sqrIdx] = JUMP_SPEEDMOD_UNKNOWN;
+			jumpProbeResults[sqrIdx] = 0;
+		}
+
+		jumpSpeedModSquares.clear();
+	}
+
 	while (!openBlocks.empty() && (openBlockBuffer.GetSize() < maxBlocksToBeSearched)) {
 		// get the open square with lowest expected path-cost
 		const PathNode* openSquare = openBlocks.top();
@@ -224,9 +382,15 @@ IPath::SearchResult CPathFinder::DoSearch(
 			continue;
 		}
 
+		if (jumpPointSearch && TestJumpPoints(moveDef, pfDef, openSquare, owner))
+			continue;
+
 		TestNeighborSquares(moveDef, pfDef, openSquare, owner);
 	}
 
+	if (!jumpParents.empty())
+		UnrollJumpPoints();
+
 	if (foundGoal)
 		return IPath::Ok;
 
@@ -296,7 +460,7 @@ void CPathFinder::TestNeighborSquares(
 			//
 			// only close node if search is directionally independent, since it
 			// might still be entered from another (better) direction otherwise
-			if ((sqState.speedMod = CMoveMath::GetPosSpeedMod(moveDef, ngbSquareCoors.x, ngbSquareCoors.y)) == 0.0f) {
+			if ((sqState.speedMod = GetPosSpeedMod(moveDef, ngbSquareCoors)) == 0.0f) {
 				blockStates.nodeMask[ngbSquareIdx] |= PATHOPT_CLOSED;
 				dirtyBlocks.push_back(ngbSquareIdx);
 			}
@@ -408,21 +572,29 @@ bool CPathFinder::TestBlock(
 
 	const float heatCost  = (pfDef.testMobile) ? (PathHeatMap::GetInstance())->GetHeatCost(square.x, square.y, moveDef, ((owner != NULL)? owner->id: -1U)) : 0.0f;
 	//const float flowCost  = (pfDef.testMobile) ? (PathFlowMap::GetInstance())->GetFlowCost(square.x, square.y, moveDef, pathOptDir) : 0.0f;
-	const float extraCost = blockStates.GetNodeExtraCost(square.x, square.y, pfDef.synced);
+	const float extraCost = masterInstance->blockStates.GetNodeExtraCost(square.x, square.y, pfDef.synced);
 
 	const float dirMoveCost = (1.0f + heatCost) * PF_DIRECTION_COSTS[pathOptDir];
 	const float nodeCost = (dirMoveCost / speedMod) + extraCost;
 
-	const float gCost = parentSquare->gCost + nodeCost;                  // g
+	OpenSquare(pfDef, square, sqrIdx, pathOptDir, parentSquare->gCost + nodeCost);
+	return true;
+}
+
+bool CPathFinder::OpenSquare(
+	const CPathFinderDef& pfDef,
+	const int2 square,
+	const unsigned int sqrIdx,
+	const unsigned int pathOptDir,
+	const float gCost
+) {
 	const float hCost = pfDef.Heuristic(square.x, square.y, BLOCK_SIZE); // h
 	const float fCost = gCost + hCost;                                   // f
 
 	if (blockStates.nodeMask[sqrIdx] & PATHOPT_OPEN) {
 		// already in the open set, look for a cost-improvement
 		if (blockStates.fCost[sqrIdx] <= fCost)
-			return true;
-
-		blockStates.nodeMask[sqrIdx] &= ~PATHOPT_CARDINALS;
+			return false;
 	}
 
 	// if heuristic says this node is closer to goal than previous h-estimate, keep it
@@ -447,13 +619,120 @@ bool CPathFinder::TestBlock(
 
 	blockStates.fCost[sqrIdx] = os->fCost;
 	blockStates.gCost[sqrIdx] = os->gCost;
+	// squares skipped by a jump may already have a direction
+	blockStates.nodeMask[sqrIdx] &= ~PATHOPT_CARDINALS;
 	blockStates.nodeMask[sqrIdx] |= (PATHOPT_OPEN | pathOptDir);
 
+	if (!jumpParents.empty())
+		jumpParents.erase(sqrIdx);
+
 	dirtyBlocks.push_back(sqrIdx);
 	return true;
 }
 
 
+bool CPathFinder::TestJumpPoints(
+	const MoveDef& moveDef,
+	const CPathFinderDef& pfDef,
+	const PathNode* square,
+	const CSolidObject* owner
+) {
+	const unsigned int parentDir = blockStates.nodeMask[square->nodeNum] & PATHOPT_CARDINALS;
+
+	// the start square has no direction to prune by
+	if (parentDir == 0)
+		return false;
+
+	JumpGrid grid = {this, moveDef, pfDef, owner, static_cast<unsigned int>(square->nodeNum)};
+
+	const float speedMod = grid.GetUniformSpeedMod(square->nodePos);
+
+	if (speedMod <= 0.0f || !PathJumpPoints::IsUniformArea(grid, square->nodePos, speedMod))
+		return false;
+
+	unsigned int jumpDirs[PathJumpPoints::MAX_NATURAL_DIRS];
+
+	for (unsigned int n = 0, numDirs = PathJumpPoints::GetNaturalDirs(parentDir, jumpDirs); n < numDirs; n++) {
+		const unsigned int pathOptDir = jumpDirs[n];
+
+		float gCost = square->gCost;
+		int2 jumpSquare;
+
+		if (!PathJumpPoints::Jump(grid, square->nodePos, pathOptDir, speedMod, gCost, jumpSquare))
+			continue;
+
+		const unsigned int sqrIdx = BlockPosToIdx(jumpSquare);
+
+		testedBlocks++;
+
+		if ((blockStates.nodeMask[sqrIdx] & (PATHOPT_CLOSED | PATHOPT_BLOCKED)) != 0)
+			continue;
+		if (!OpenSquare(pfDef, jumpSquare, sqrIdx, pathOptDir, gCost))
+			continue;
+
+		if (jumpSquare != (square->nodePos + PF_DIRECTION_VECTORS_2D[pathOptDir]))
+			jumpParents[sqrIdx] = square->nodeNum;
+	}
+
+	// mark this square as closed
+	blockStates.nodeMask[square->nodeNum] |= PATHOPT_CLOSED;
+	dirtyBlocks.push_back(square->nodeNum);
+	return true;
+}
+
+void CPathFinder::UnrollJumpPoints()
+{
+	unsigned int blockIdx = mGoalBlockIdx;
+
+	// collect all jumps first; if the path crosses itself, directions
+	// written for jumps closer to the start have to win at crossings
+	jumpChain.clear();
+
+	while (blockIdx != mStartBlockIdx) {
+		const unsigned int pathOptDir = blockStates.nodeMask[blockIdx] & PATHOPT_CARDINALS;
+		const auto iter = jumpParents.find(blockIdx);
+
+		assert(pathOptDir != 0);
+		jumpChain.emplace_back(blockIdx, pathOptDir);
+
+		if (iter != jumpParents.end()) {
+			blockIdx = iter->second;
+		} else {
+			blockIdx = BlockPosToIdx(BlockIdxToPos(blockIdx) - PF_DIRECTION_VECTORS_2D[pathOptDir]);
+		}
+	}
+
+	for (size_t n = 0; n < jumpChain.size(); n++) {
+		const unsigned int jumpIdx = jumpChain[n].first;
+		const unsigned int pathOptDir = jumpChain[n].second;
+		const unsigned int parentIdx = (n + 1 < jumpChain.size())? jumpChain[n + 1].first: mStartBlockIdx;
+
+		const int2 dirVec = PF_DIRECTION_VECTORS_2D[pathOptDir];
+		const int2 jumpSquare = BlockIdxToPos(jumpIdx);
+		const int2 parentSquare = BlockIdxToPos(parentIdx);
+
+		const int numSteps = std::max(std::abs(jumpSquare.x - parentSquare.x), std::abs(jumpSquare.y - parentSquare.y)) / PATH_NODE_SPACING;
+
+		const float jumpFCost = blockStates.fCost[jumpIdx];
+		const float parentFCost = blockStates.fCost[parentIdx];
+
+		blockStates.nodeMask[jumpIdx] &= ~PATHOPT_CARDINALS;
+		blockStates.nodeMask[jumpIdx] |= pathOptDir;
+
+		// SmoothMidWaypoint compares f-costs along the path, interpolate them
+		for (int k = numSteps - 1; k > 0; k--) {
+			const unsigned int sqrIdx = BlockPosToIdx(parentSquare + dirVec * k);
+
+			blockStates.fCost[sqrIdx] = mix(parentFCost, jumpFCost, k / float(numSteps));
+			blockStates.nodeMask[sqrIdx] &= ~PATHOPT_CARDINALS;
+			blockStates.nodeMask[sqrIdx] |= pathOptDir;
+
+			dirtyBlocks.push_back(sqrIdx);
+		}
+	}
+}
+
+
 void CPathFinder::FinishSearch(const MoveDef& moveDef, const CPathFinderDef& pfDef, IPath::Path& foundPath) const
 {
 	if (pfDef.needPath) {
@@ -12,6 +12,8 @@
 #include "PathDataTypes.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Objects/SolidObject.h"
+#include "System/Rectangle.h"
+#include "System/UnorderedMap.hpp"
 
 struct MoveDef;
 class CPathFinderDef;
@@ -28,6 +30,15 @@ public:
 
 	typedef CMoveMath::BlockType (*BlockCheckFunc)(const MoveDef&, int, int, const CSolidObject*);
 
+	/**
+	 * Lets direction-independent searches for <moveDef> read the positional
+	 * speedmods of squares in <rect> (half-resolution) from a table filled a
+	 * row at a time, instead of calling GetPosSpeedMod for each square. Only
+	 * worth it when many searches cover the same area (PE vertex costs).
+	 */
+	void SetSpeedModWindow(const MoveDef& moveDef, const SRectangle& rect);
+	void ClearSpeedModWindow() { speedModWindowPathType = -1; }
+
 protected:
 	/// Performs the actual search.
 	IPath::SearchResult DoRawSearch(const MoveDef& moveDef, const CPathFinderDef& pfDef, const CSolidObject* owner);
@@ -76,6 +87,10 @@ protected:
 	) { }
 
 private:
+	struct JumpGrid;
+
+	float GetPosSpeedMod(const MoveDef& moveDef, const int2 square) const;
+
 	void TestNeighborSquares(
 		const MoveDef& moveDef,
 		const CPathFinderDef& pfDef,
@@ -83,6 +98,36 @@ private:
 		const CSolidObject* owner
 	);
 
+	/**
+	 * Expands a square only along its natural directions, jumping over
+	 * uniform terrain (see PathJumpPoints.h). Returns false if it has to
+	 * be expanded in full by TestNeighborSquares instead.
+	 */
+	bool TestJumpPoints(
+		const MoveDef& moveDef,
+		const CPathFinderDef& pfDef,
+		const PathNode* parentSquare,
+		const CSolidObject* owner
+	);
+
+	/**
+	 * Adds a square reached with cost <gCost> to the queue of open
+	 * squares, unless it is already open with a lower cost.
+	 */
+	bool OpenSquare(
+		const CPathFinderDef& pfDef,
+		const int2 square,
+		const unsigned int sqrIdx,
+		const unsigned int pathOptDir,
+		const float gCost
+	);
+
+	/**
+	 * Gives the squares skipped by jumps on the way to the goal their
+	 * directions, such that FinishSearch can backtrack over them.
+	 */
+	void UnrollJumpPoints();
+
 	/**
 	 * Adjusts the found path to cut corners where possible.
 	 */
@@ -103,6 +148,21 @@ private:
 
 	BlockCheckFunc blockCheckFunc;
 	CPathCache::CacheItem dummyCacheItem;
+
+	// squares reached by a jump of more than one step, and where it started
+	spring::unordered_map<unsigned int, unsigned int> jumpParents;
+	// <square, direction> of each jump (or step) on the way to the goal
+	std::vector< std::pair<unsigned int, unsigned int> > jumpChain;
+
+	// JumpGrid::GetUniformSpeedMod and GetProbeResult results of the current search, and where they were set
+	std::vector<float> jumpSpeedMods;
+	std::vector<uint8_t> jumpProbeResults;
+	std::vector<unsigned int> jumpSpeedModSquares;
+
+	// see SetSpeedModWindow
+	std::vector<float> speedModWindowValues;
+	SRectangle speedModWindow;
+	int speedModWindowPathType = -1;
 };
 
 #endif // PATH_FINDER_H
@@ -0,0 +1,123 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_FLOW_FIELD_H
+#define PATH_FLOW_FIELD_H
+
+#include <cinttypes>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "System/type2.h"
+#include "PathConstants.h"
+
+/**
+ * Block-level flow-field toward a goal region, followed by all units of a
+ * group move (modrule system.flowFieldGroupSize) instead of each of them
+ * searching and holding its own path.
+ *
+ * Holds, for every block of an estimator's grid, the cost of the cheapest
+ * path from that block to any of the goal blocks and the direction of its
+ * first step. The field is built by a single Dijkstra expansion outward from
+ * the goal blocks; estimator vertex costs are the same in both directions, so
+ * following the directions from any block gives a path as cheap as the best
+ * one a block-level search from there would find. Ties are broken by block
+ * index, so the field only depends on its inputs.
+ *
+ * <Graph> provides
+ *   int2 GetNumBlocks() const;
+ *   float GetEdgeCost(int2 block, unsigned int pathDir) const; cost of stepping from <block> to
+ *     its neighbor along PE_DIRECTION_VECTORS[pathDir], PATHCOST_INFINITY if there is no such edge
+ */
+class CPathFlowField {
+public:
+	enum {
+		GOAL_DIRECTION = PATH_DIRECTIONS,
+		NULL_DIRECTION = PATH_DIRECTIONS + 1,
+	};
+
+	template<typename Graph>
+	void Build(const Graph& graph, const std::vector<int2>& goalBlocks) {
+		typedef std::pair<float, unsigned int> OpenBlock;
+
+		std::priority_queue<OpenBlock, std::vector<OpenBlock>, std::greater<OpenBlock> > openBlocks;
+
+		numBlocks = graph.GetNumBlocks();
+
+		costs.clear();
+		costs.resize(numBlocks.x * numBlocks.y, PATHCOST_INFINITY);
+		directions.clear();
+		directions.resize(numBlocks.x * numBlocks.y, NULL_DIRECTION);
+
+		for (const int2 goalBlock: goalBlocks) {
+			const unsigned int blockIdx = BlockPosToIdx(goalBlock);
+
+			if (costs[blockIdx] == 0.0f)
+				continue;
+
+			costs[blockIdx] = 0.0f;
+			directions[blockIdx] = GOAL_DIRECTION;
+			openBlocks.emplace(0.0f, blockIdx);
+		}
+
+		while (!openBlocks.empty()) {
+			const OpenBlock ob = openBlocks.top();
+			openBlocks.pop();
+
+			// stale entry, block was reached more cheaply after this was queued
+			if (ob.first > costs[ob.second])
+				continue;
+
+			const int2 blockPos = BlockIdxToPos(ob.second);
+
+			for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+				const int2 nbrBlockPos = blockPos + PE_DIRECTION_VECTORS[pathDir];
+
+				if (static_cast<unsigned int>(nbrBlockPos.x) >= static_cast<unsigned int>(numBlocks.x))
+					continue;
+				if (static_cast<unsigned int>(nbrBlockPos.y) >= static_cast<unsigned int>(numBlocks.y))
+					continue;
+
+				// neighbor steps back along the opposite direction to reach us
+				const unsigned int nbrPathDir = (pathDir + (PATH_DIRECTIONS >> 1)) % PATH_DIRECTIONS;
+				const unsigned int nbrBlockIdx = BlockPosToIdx(nbrBlockPos);
+
+				const float edgeCost = graph.GetEdgeCost(nbrBlockPos, nbrPathDir);
+				const float nbrCost = ob.first + edgeCost;
+
+				if (edgeCost >= PATHCOST_INFINITY)
+					continue;
+				if (nbrCost >= costs[nbrBlockIdx])
+					continue;
+
+				costs[nbrBlockIdx] = nbrCost;
+				directions[nbrBlockIdx] = nbrPathDir;
+				openBlocks.emplace(nbrCost, nbrBlockIdx);
+			}
+		}
+	}
+
+	int2 GetNumBlocks() const { return numBlocks; }
+	int2 GetNextBlock(const int2 blockPos) const { return (blockPos + PE_DIRECTION_VECTORS[directions[BlockPosToIdx(blockPos)]]); }
+
+	float GetCost(const int2 blockPos) const { return costs[BlockPosToIdx(blockPos)]; }
+
+	bool IsGoal(const int2 blockPos) const { return (directions[BlockPosToIdx(blockPos)] == GOAL_DIRECTION); }
+	bool IsReachable(const int2 blockPos) const { return (directions[BlockPosToIdx(blockPos)] != NULL_DIRECTION); }
+
+	size_t GetMemFootPrint() const { return (costs.size() * sizeof(float) + directions.size() * sizeof(std::uint8_t)); }
+
+private:
+	int2 BlockIdxToPos(const unsigned int idx) const { return int2(idx % numBlocks.x, idx / numBlocks.x); }
+	unsigned int BlockPosToIdx(const int2 pos) const { return (pos.y * numBlocks.x + pos.x); }
+
+private:
+	int2 numBlocks;
+
+	std::vector<float> costs;
+	/// per block, the PATHDIR_* of its first step toward the goal (or one of the *_DIRECTION values)
+	std::vector<std::uint8_t> directions;
+};
+
+#endif // PATH_FLOW_FIELD_H
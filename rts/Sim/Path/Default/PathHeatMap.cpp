@@ -2,11 +2,15 @@
 
 #include "PathHeatMap.hpp"
 #include "PathConstants.h"
-#include "PathManager.h"
+#include "Map/ReadMap.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/Objects/SolidObject.h"
 
+#ifndef UNIT_TEST
+	#include "PathManager.h"
+#endif
+
 // not extern'ed, so static
 static PathHeatMap gPathHeatMap;
 
@@ -44,6 +48,7 @@ unsigned int PathHeatMap::GetHeatMapIndex(unsigned int hmx, unsigned int hmz) co
 	return (hmz * xsize + hmx);
 }
 
+#ifndef UNIT_TEST
 void PathHeatMap::AddHeat(const CSolidObject* owner, const CPathManager* pm, unsigned int pathID) {
 	if (pathID == 0)
 		return;
@@ -85,6 +90,7 @@ void PathHeatMap::AddHeat(const CSolidObject* owner, const CPathManager* pm, uns
 		UpdateHeatValue(sqr.x, sqr.y, (i--) * value, owner->id);
 	}
 }
+#endif
 
 void PathHeatMap::UpdateHeatValue(unsigned int x, unsigned int y, unsigned int value, unsigned int ownerID) {
 	const unsigned int idx = GetHeatMapIndex(x, y);
@@ -0,0 +1,202 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_JUMP_POINTS_H
+#define PATH_JUMP_POINTS_H
+
+#include "System/type2.h"
+#include "PathConstants.h"
+
+/**
+ * Jump-point pruning for CPathFinder's max-res searches (modrule
+ * system.jumpPointPathSearch).
+ *
+ * A square is "uniform" if entering it costs the same from every direction
+ * and nothing but its speedmod contributes to that cost (no structures, no
+ * mobile units or heat to avoid, no extra costs, flat terrain). Inside an
+ * area where a node and its eight lattice neighbors are all uniform with
+ * the same speedmod, every path has an equal-cost counterpart that moves
+ * straight before moving diagonally, so a node reached along direction d
+ * only has to be expanded along d (and d's two components if diagonal),
+ * and runs of such nodes can be skipped entirely. A run stops at the first
+ * node next to a non-uniform square (which is expanded in full, exactly as
+ * a plain search would) unless only a wall lies ahead, and at goal squares;
+ * a diagonal run also stops where one of its straight components would stop.
+ *
+ * Pruning is only sound if the search is optimal to begin with, i.e. its
+ * heuristic is consistent, which CPathFinder's octile heuristic is as long
+ * as no speedmod exceeds 1; CPathFinder::DoSearch does not prune otherwise.
+ * Then a pruned search never returns a path cheaper than the cheapest one
+ * over the same costs. It need not return the same path (or cost) as a
+ * plain search though: a plain search refuses diagonal steps past closed
+ * squares (see CPathFinder::TestNeighborSquares), so what it returns depends
+ * on the order in which squares were closed and may be more expensive; the
+ * pruned search expands fewer squares in full and so is steered off the
+ * cheapest path less often (on open terrain not at all).
+ *
+ * <Grid> provides
+ *   float GetUniformSpeedMod(int2 square) const; speedmod of a uniform square, 0 if
+ *     not uniform, negative if the square can not be entered at all
+ *   float GetNodeCost(unsigned int pathOptDir, float speedMod) const; cost of entering a uniform square
+ *   bool IsJumpTarget(int2 square) const; squares every run must stop at (goals)
+ *   int GetProbeResult(int2 square, unsigned int pathOptDir) const; result of an earlier
+ *     Probe from <square> along straight direction <pathOptDir>, negative if there was none
+ *   void SetProbeResult(int2 square, unsigned int pathOptDir, bool result);
+ *   void TestIntermediate(int2 square, unsigned int pathOptDir, float gCost); squares a run skips
+ */
+
+namespace PathJumpPoints {
+	static constexpr unsigned int PATHOPT_AXIS_X = (PATHOPT_LEFT | PATHOPT_RIGHT);
+	static constexpr unsigned int PATHOPT_AXIS_Z = (PATHOPT_UP | PATHOPT_DOWN);
+	static constexpr unsigned int MAX_NATURAL_DIRS = 3;
+
+	inline bool IsDiagonal(unsigned int pathOptDir) {
+		return ((pathOptDir & PATHOPT_AXIS_X) != 0 && (pathOptDir & PATHOPT_AXIS_Z) != 0);
+	}
+
+	/// writes the directions a node entered along <pathOptDir> is expanded in to <dirs>, returns their number
+	inline unsigned int GetNaturalDirs(unsigned int pathOptDir, unsigned int* dirs) {
+		dirs[0] = pathOptDir;
+
+		if (!IsDiagonal(pathOptDir))
+			return 1;
+
+		dirs[1] = pathOptDir & PATHOPT_AXIS_X;
+		dirs[2] = pathOptDir & PATHOPT_AXIS_Z;
+		return MAX_NATURAL_DIRS;
+	}
+
+
+	/// true if <square> and its eight lattice neighbors are uniform with speedmod <speedMod>
+	template<typename Grid>
+	inline bool IsUniformArea(const Grid& grid, const int2 square, const float speedMod) {
+		for (int z = -1; z <= 1; z++) {
+			for (int x = -1; x <= 1; x++) {
+				if (grid.GetUniformSpeedMod(square + int2(x, z) * PATH_NODE_SPACING) != speedMod)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Returns true if a straight run from <square> (whose neighborhood must be
+	 * uniform with <speedMod>) along <pathOptDir> would reach a jump point and
+	 * false if it would end at a wall, without reporting any squares. Diagonal
+	 * runs probe a whole row or column at each step and neighboring runs probe
+	 * the same ones, so results are remembered for every square passed.
+	 */
+	template<typename Grid>
+	inline bool Probe(Grid& grid, int2 square, const unsigned int pathOptDir, const float speedMod) {
+		const int2 dirVec = PF_DIRECTION_VECTORS_2D[pathOptDir];
+		const int2 sideVec = {dirVec.y, dirVec.x};
+		const int2 startSquare = square;
+
+		int result = grid.GetProbeResult(square, pathOptDir);
+		int numSteps = 0;
+
+		while (result < 0) {
+			square += dirVec;
+			numSteps += 1;
+
+			if (grid.IsJumpTarget(square)) {
+				result = 1;
+				break;
+			}
+
+			// a run from here takes the same squares as the rest of this one
+			if ((result = grid.GetProbeResult(square, pathOptDir)) >= 0)
+				break;
+
+			const int2 nextSquare = square + dirVec;
+
+			const float nextSpeedMods[] = {
+				grid.GetUniformSpeedMod(nextSquare - sideVec),
+				grid.GetUniformSpeedMod(nextSquare          ),
+				grid.GetUniformSpeedMod(nextSquare + sideVec),
+			};
+
+			if (nextSpeedMods[0] != speedMod || nextSpeedMods[1] != speedMod || nextSpeedMods[2] != speedMod) {
+				result = (nextSpeedMods[0] >= 0.0f || nextSpeedMods[1] >= 0.0f || nextSpeedMods[2] >= 0.0f);
+				break;
+			}
+		}
+
+		// the square the run stopped at has no result of its own
+		for (int n = 0; n < numSteps; n++) {
+			grid.SetProbeResult(startSquare + dirVec * n, pathOptDir, result != 0);
+		}
+
+		return (result != 0);
+	}
+
+	/**
+	 * Runs from <square> (whose neighborhood must be uniform with <speedMod>)
+	 * along <pathOptDir>, adding the cost of each step to <gCost> and passing
+	 * each skipped square to the grid. Returns true and the square at which the
+	 * run stopped in <jumpSquare> if it reached a jump point, false if it ended
+	 * at a wall.
+	 */
+	template<typename Grid>
+	inline bool Jump(
+		Grid& grid,
+		int2 square,
+		const unsigned int pathOptDir,
+		const float speedMod,
+		float& gCost,
+		int2& jumpSquare
+	) {
+		const int2 dirVec = PF_DIRECTION_VECTORS_2D[pathOptDir];
+		// for straight runs, the lattice neighbors on either side of each square
+		const int2 sideVec = {dirVec.y, dirVec.x};
+
+		const bool diagonal = IsDiagonal(pathOptDir);
+		const float nodeCost = grid.GetNodeCost(pathOptDir, speedMod);
+
+		// runs end at the map border at the latest, where squares are not uniform
+		while (true) {
+			// the square entered is always inside the (uniform) neighborhood of the last one
+			square += dirVec;
+			gCost += nodeCost;
+
+			if (grid.IsJumpTarget(square)) {
+				jumpSquare = square;
+				return true;
+			}
+
+			if (diagonal) {
+				if (!IsUniformArea(grid, square, speedMod)) {
+					jumpSquare = square;
+					return true;
+				}
+
+				if (Probe(grid, square, pathOptDir & PATHOPT_AXIS_X, speedMod) || Probe(grid, square, pathOptDir & PATHOPT_AXIS_Z, speedMod)) {
+					jumpSquare = square;
+					return true;
+				}
+			} else {
+				// two of the three rows (or columns) of the next neighborhood are shared with this one
+				const int2 nextSquare = square + dirVec;
+
+				const float nextSpeedMods[] = {
+					grid.GetUniformSpeedMod(nextSquare - sideVec),
+					grid.GetUniformSpeedMod(nextSquare          ),
+					grid.GetUniformSpeedMod(nextSquare + sideVec),
+				};
+
+				if (nextSpeedMods[0] != speedMod || nextSpeedMods[1] != speedMod || nextSpeedMods[2] != speedMod) {
+					// runs into a wall are dead ends, whatever lies beside them is reached by other runs
+					if (nextSpeedMods[0] < 0.0f && nextSpeedMods[1] < 0.0f && nextSpeedMods[2] < 0.0f)
+						return false;
+
+					jumpSquare = square;
+					return true;
+				}
+			}
+
+			grid.TestIntermediate(square, pathOptDir, gCost);
+		}
+	}
+}
+
+#endif // PATH_JUMP_POINTS_H
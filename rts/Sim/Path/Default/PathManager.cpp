@@ -8,19 +8,44 @@
 #include "PathHeatMap.hpp"
 #include "PathLog.h"
 #include "PathMemPool.h"
+#include "Game/GlobalUnsynced.h"
 #include "Map/MapInfo.h"
+#include "Map/ReadMap.h"
+#include "Net/Protocol/NetProtocol.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Objects/SolidObject.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/TimeProfiler.h"
 
+#include <algorithm>
+#include <atomic>
+
 
 static CPathFinder    gMaxResPF;
 static CPathEstimator gMedResPE;
 static CPathEstimator gLowResPE;
 
 
+// block of <pe> containing <pos>, clamped to the map
+static int2 GetBlockPos(const CPathEstimator* pe, const float3& pos) {
+	const int2 numBlocks = pe->GetNumBlocks();
+	const int2 blockPos = {int(pos.x / pe->BLOCK_PIXEL_SIZE), int(pos.z / pe->BLOCK_PIXEL_SIZE)};
+
+	return {Clamp(blockPos.x, 0, numBlocks.x - 1), Clamp(blockPos.y, 0, numBlocks.y - 1)};
+}
+
+
+// NOTE: this distance can be far smaller than the actual path length!
+// NOTE: take height difference into consideration for "special" cases
+// (unit at top of cliff, goal at bottom or vv.)
+static float GetHeurGoalDist2D(const CPathFinderDef& pfDef, const float3& startPos, const float3& goalPos) {
+	return (pfDef.Heuristic(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE, 1) + math::fabs(goalPos.y - startPos.y) / SQUARE_SIZE);
+}
+
+
 CPathManager::CPathManager()
 : maxResPF(nullptr)
 , medResPE(nullptr)
@@ -28,6 +53,11 @@ CPathManager::CPathManager()
 , pathFlowMap(nullptr)
 , pathHeatMap(nullptr)
 , nextPathID(0)
+, nextFlowFieldID(0)
+, numFlowFields(0)
+, numFlowPaths(0)
+, numFlowFieldRebuilds(0)
+, numSyncedRequests(0)
 {
 	IPathFinder::InitStatic();
 	CPathFinder::InitStatic();
@@ -44,6 +74,11 @@ CPathManager::CPathManager()
 
 CPathManager::~CPathManager()
 {
+	if (modInfo.flowFieldGroupSize > 0)
+		LOG("[PathManager::%s] %u flow-fields built (%u rebuilt) for %u path-requests", __func__, numFlowFields, numFlowFieldRebuilds, numFlowPaths);
+
+	KillSearchWorkers();
+
 	lowResPE->Kill();
 	medResPE->Kill();
 	maxResPF->Kill();
@@ -70,6 +105,9 @@ std::int64_t CPathManager::Finalize() {
 		medResPE->Init(maxResPF, MEDRES_PE_BLOCKSIZE, "pe",  mapInfo->map.name);
 		lowResPE->Init(medResPE, LOWRES_PE_BLOCKSIZE, "pe2", mapInfo->map.name);
 
+		if (modInfo.parallelPathRequests)
+			InitSearchWorkers();
+
 		// make cached path data checksum part of synced state s.t. when
 		// any client has a corrupted or incorrect cache it desyncs from
 		// the start, not minutes later
@@ -80,6 +118,46 @@ std::int64_t CPathManager::Finalize() {
 	return (dt.toMilliSecsi());
 }
 
+void CPathManager::InitSearchWorkers()
+{
+	// keep the total memory-footprint of the worker instances within
+	// the same bounds as the PE cache-generator threads at load-time
+	const size_t minMemFootPrint = sizeof(CPathFinder) + sizeof(CPathEstimator) * 2 + maxResPF->GetMemFootPrint();
+	const size_t maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint") * size_t(1024 * 1024);
+	const size_t numWorkers = Clamp(maxMemFootPrint / minMemFootPrint, size_t(1), size_t(ThreadPool::GetNumThreads()));
+
+	searchWorkers.resize(numWorkers);
+
+	for (SearchInstances& si: searchWorkers) {
+		// workers run on the ThreadPool, so their PF must be thread-safe
+		si.maxResPF = pfMemPool.alloc<CPathFinder>(true);
+		si.medResPE = peMemPool.alloc<CPathEstimator>();
+		si.lowResPE = peMemPool.alloc<CPathEstimator>();
+
+		si.maxResPF->masterInstance = maxResPF;
+		si.medResPE->InitWorker(medResPE, si.maxResPF);
+		si.lowResPE->InitWorker(lowResPE, si.medResPE);
+	}
+
+	LOG("[PathManager::%s] %u search-workers (%u MB)", __func__, unsigned(numWorkers), unsigned((minMemFootPrint * numWorkers) / (1024 * 1024)));
+}
+
+void CPathManager::KillSearchWorkers()
+{
+	for (SearchInstances& si: searchWorkers) {
+		si.lowResPE->Kill();
+		si.medResPE->Kill();
+		si.maxResPF->Kill();
+
+		peMemPool.free(si.lowResPE);
+		peMemPool.free(si.medResPE);
+		pfMemPool.free(si.maxResPF);
+	}
+
+	searchWorkers.clear();
+	queuedPaths.clear();
+}
+
 
 void CPathManager::FinalizePath(MultiPath* path, const float3 startPos, const float3 goalPos, const bool cantGetCloser)
 {
@@ -123,15 +201,13 @@ IPath::SearchResult CPathManager::ArrangePath(
 	const MoveDef* moveDef,
 	const float3& startPos,
 	const float3& goalPos,
-	CSolidObject* caller
+	CSolidObject* caller,
+	const SearchInstances& si
 ) const {
 	CPathFinderDef* pfDef = &newPath->peDef;
 
 	// choose the PF or the PE depending on the projected 2D goal-distance
-	// NOTE: this distance can be far smaller than the actual path length!
-	// NOTE: take height difference into consideration for "special" cases
-	// (unit at top of cliff, goal at bottom or vv.)
-	const float heurGoalDist2D = pfDef->Heuristic(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE, 1) + math::fabs(goalPos.y - startPos.y) / SQUARE_SIZE;
+	const float heurGoalDist2D = GetHeurGoalDist2D(*pfDef, startPos, goalPos);
 	const float searchDistances[] = {std::numeric_limits<float>::max(), MEDRES_SEARCH_DISTANCE, MAXRES_SEARCH_DISTANCE};
 
 	// MAX_SEARCHED_NODES_PF is 65536, MAXRES_SEARCH_DISTANCE is 50 squares
@@ -147,7 +223,7 @@ IPath::SearchResult CPathManager::ArrangePath(
 	constexpr bool useConstraints[] = {false, false, false};
 	constexpr bool allowRawSearch[] = {false, false, false};
 
-	IPathFinder* pathFinders[] = {lowResPE, medResPE, maxResPF};
+	IPathFinder* pathFinders[] = {si.lowResPE, si.medResPE, si.maxResPF};
 	IPath::Path* pathObjects[] = {&newPath->lowResPath, &newPath->medResPath, &newPath->maxResPath};
 
 	IPath::SearchResult bestResult = IPath::Error;
@@ -361,40 +437,43 @@ unsigned int CPathManager::RequestPath(
 	goalRadius = std::max<float>(goalRadius, PATH_NODE_SPACING * SQUARE_SIZE); //FIXME do on a per PE & PF level?
 	assert(moveDef == moveDefHandler.GetMoveDefByPathType(moveDef->pathType));
 
+	// estimator data is copied out of the cache-files on first use and
+	// kept current from the first synced use on; if it had to be rebuilt
+	// the other clients are told through a new checksum
+	const bool medResIntact = medResPE->LoadPathType(moveDef->pathType, synced);
+	const bool lowResIntact = lowResPE->LoadPathType(moveDef->pathType, synced);
+
+	if (!medResIntact || !lowResIntact)
+		clientNet->Send(CBaseNetProtocol::Get().SendPathCheckSum(gu->myPlayerNum, GetPathCheckSum()));
+
 	MultiPath newPath = MultiPath(moveDef, startPos, goalPos, goalRadius);
 	newPath.finalGoal = goalPos;
 	newPath.caller = caller;
 	newPath.peDef.synced = synced;
 
+	numSyncedRequests += synced;
+
+	// synced requests made on behalf of an object are resolved in batch
+	// by the next Update (Lua and AI callers need the result right away),
+	// either by the search-workers or because they may join a flow-field
+	// group; requests too short to ever get a field are not held back
+	const bool batchSearch = !searchWorkers.empty();
+	const bool flowFieldGroup = (modInfo.flowFieldGroupSize > 0 && GetFlowFieldKey(newPath) != 0);
+
+	if (caller != nullptr && synced && (batchSearch || flowFieldGroup))
+		return (Queue(newPath));
+
 	if (caller != nullptr)
 		caller->UnBlock();
 
-	const IPath::SearchResult result = ArrangePath(&newPath, moveDef, startPos, goalPos, caller);
-
 	unsigned int pathID = 0;
 
-	if (result != IPath::Error) {
-		if (newPath.maxResPath.path.empty()) {
-			if (result != IPath::CantGetCloser) {
-				LowRes2MedRes(newPath, startPos, caller, synced);
-				MedRes2MaxRes(newPath, startPos, caller, synced);
-			} else {
-				// add one dummy waypoint so that the calling MoveType
-				// does not consider this request a failure, which can
-				// happen when startPos is very close to goalPos
-				//
-				// otherwise, code relying on MoveType::progressState
-				// (eg. BuilderCAI::MoveInBuildRange) would misbehave
-				// (eg. reject build orders)
-				newPath.maxResPath.path.push_back(startPos);
-				newPath.maxResPath.squares.push_back(int2(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE));
-			}
-		}
+	const std::uint64_t sharedSearchKey = GetSharedSearchKey(newPath);
+
+	SharedSearch* sharedSearch = (sharedSearchKey != 0)? &sharedSearches[sharedSearchKey]: nullptr;
 
-		FinalizePath(&newPath, startPos, goalPos, result == IPath::CantGetCloser);
-		newPath.searchResult = result;
+	if (SearchPath(newPath, GetMainInstances(), sharedSearch) != IPath::Error)
 		pathID = Store(newPath);
-	}
 
 	if (caller != nullptr)
 		caller->Block();
@@ -402,9 +481,385 @@ unsigned int CPathManager::RequestPath(
 	return pathID;
 }
 
+IPath::SearchResult CPathManager::SearchPath(MultiPath& newPath, const SearchInstances& si, SharedSearch* sharedSearch) const
+{
+	const float3 startPos = newPath.start;
+	const float3 goalPos = newPath.finalGoal;
+
+	const bool synced = newPath.peDef.synced;
+
+	IPath::SearchResult result = IPath::Error;
+
+	// the goal-radius decides where each search may stop, so results
+	// are only passed on between requests that agree on it exactly
+	if (sharedSearch != nullptr && sharedSearch->valid && sharedSearch->sqGoalRadius != newPath.peDef.sqGoalRadius)
+		sharedSearch = nullptr;
+
+	if (sharedSearch != nullptr && sharedSearch->valid) {
+		// same block-level search as an earlier request, only the
+		// max-res head of the path (refined below) is our own
+		newPath.lowResPath = sharedSearch->lowResPath;
+		newPath.medResPath = sharedSearch->medResPath;
+
+		sharedSearch->numShared += 1;
+		result = sharedSearch->result;
+	} else {
+		result = ArrangePath(&newPath, newPath.moveDef, startPos, goalPos, newPath.caller, si);
+
+		// only block-level results are worth sharing; a max-res result
+		// (or none at all) means every other request has to search too
+		if (sharedSearch != nullptr && (result == IPath::Ok || result == IPath::GoalOutOfRange) && newPath.maxResPath.path.empty()) {
+			sharedSearch->valid = true;
+			sharedSearch->sqGoalRadius = newPath.peDef.sqGoalRadius;
+			sharedSearch->result = result;
+			sharedSearch->lowResPath = newPath.lowResPath;
+			sharedSearch->medResPath = newPath.medResPath;
+		}
+	}
+
+	if (result == IPath::Error)
+		return result;
+
+	if (newPath.maxResPath.path.empty()) {
+		if (result != IPath::CantGetCloser) {
+			LowRes2MedRes(newPath, startPos, newPath.caller, synced, si);
+			MedRes2MaxRes(newPath, startPos, newPath.caller, synced, si);
+		} else {
+			// add one dummy waypoint so that the calling MoveType
+			// does not consider this request a failure, which can
+			// happen when startPos is very close to goalPos
+			//
+			// otherwise, code relying on MoveType::progressState
+			// (eg. BuilderCAI::MoveInBuildRange) would misbehave
+			// (eg. reject build orders)
+			newPath.maxResPath.path.push_back(startPos);
+			newPath.maxResPath.squares.push_back(int2(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE));
+		}
+	}
+
+	FinalizePath(&newPath, startPos, goalPos, result == IPath::CantGetCloser);
+	newPath.searchResult = result;
+	return result;
+}
+
+/*
+Requests in the same frame with equal keys start and end in the same low- or
+med-res blocks, so (if their goal-radii are equal as well, see SearchPath) they
+would run the same block-level search and can share the first one's result;
+zero if ArrangePath would try a max-res search.
+*/
+std::uint64_t CPathManager::GetSharedSearchKey(const MultiPath& path) const
+{
+	if (!modInfo.sharedPathRequests)
+		return 0;
+
+	const float heurGoalDist2D = GetHeurGoalDist2D(path.peDef, path.start, path.finalGoal);
+
+	if (heurGoalDist2D <= (MAXRES_SEARCH_DISTANCE * std::max(1.0f, modInfo.pfRawDistMult)))
+		return 0;
+
+	// same blocks at the lower resolution also means same blocks at the higher
+	const std::uint64_t lowResSearch = (heurGoalDist2D > MEDRES_SEARCH_DISTANCE);
+	const std::uint64_t blockSize = lowResSearch? LOWRES_PE_BLOCKSIZE: MEDRES_PE_BLOCKSIZE;
+
+	const std::uint64_t strtBlockX = std::uint64_t(path.start.x / SQUARE_SIZE) / blockSize;
+	const std::uint64_t strtBlockZ = std::uint64_t(path.start.z / SQUARE_SIZE) / blockSize;
+	const std::uint64_t goalBlockX = path.peDef.goalSquareX / blockSize;
+	const std::uint64_t goalBlockZ = path.peDef.goalSquareZ / blockSize;
+
+	// at most 0xFFFF / MEDRES_PE_BLOCKSIZE blocks per axis, 12 bits each
+	static_assert((0xFFFF / MEDRES_PE_BLOCKSIZE) < (1 << 12), "");
+	assert(path.moveDef->pathType < (1 << 9));
+
+	std::uint64_t key = 1;
+
+	key |= (lowResSearch << 1);
+	key |= (std::uint64_t(path.peDef.synced) << 2);
+	key |= (std::uint64_t(path.moveDef->pathType) << 3);
+	key |= (strtBlockX << 12);
+	key |= (strtBlockZ << 24);
+	key |= (goalBlockX << 36);
+	key |= (goalBlockZ << 48);
+	return key;
+}
+
+void CPathManager::CountSharedSearch(std::uint64_t key, const SharedSearch& sharedSearch)
+{
+	const bool lowResSearch = ((key >> 1) & 1);
+	const bool synced = ((key >> 2) & 1);
+
+	CPathEstimator* pe = lowResSearch? lowResPE: medResPE;
+	CPathCache* pc = pe->pathCache[synced];
+
+	pc->AddSharedHits(sharedSearch.numShared);
+}
+
+
+/*
+Queued requests with equal keys are made with the same MoveDef toward the same
+goal (and goal-radius), so these can follow one flow-field; zero if ArrangePath
+would try a max-res search, which the (block-level) field can not replace.
+*/
+std::uint64_t CPathManager::GetFlowFieldKey(const MultiPath& path) const
+{
+	if (path.peDef.startInGoalRadius)
+		return 0;
+
+	const float heurGoalDist2D = GetHeurGoalDist2D(path.peDef, path.start, path.finalGoal);
+
+	if (heurGoalDist2D <= (MAXRES_SEARCH_DISTANCE * std::max(1.0f, modInfo.pfRawDistMult)))
+		return 0;
+
+	// at most 0xFFFF squares per axis, 16 bits each; radius in whole elmos
+	const std::uint64_t goalRadius = std::min(std::uint64_t(math::sqrt(path.peDef.sqGoalRadius)), std::uint64_t((1 << 22) - 1));
+
+	assert(path.moveDef->pathType < (1 << 9));
+
+	std::uint64_t key = 1;
+
+	key |= (std::uint64_t(path.moveDef->pathType) << 1);
+	key |= (std::uint64_t(path.peDef.goalSquareX) << 10);
+	key |= (std::uint64_t(path.peDef.goalSquareZ) << 26);
+	key |= (goalRadius << 42);
+	return key;
+}
+
+void CPathManager::AssignFlowFields()
+{
+	SCOPED_TIMER("Sim::Path::FlowFields");
+
+	struct FlowGroup {
+		std::uint64_t key;
+		std::vector<unsigned int> queueIndices;
+	};
+
+	std::vector<FlowGroup> flowGroups;
+	spring::unordered_map<std::uint64_t, unsigned int> flowGroupIndices;
+
+	for (unsigned int n = 0; n < queuedPaths.size(); n++) {
+		const std::uint64_t key = GetFlowFieldKey(queuedPaths[n].multiPath);
+
+		if (key == 0)
+			continue;
+
+		const auto iter = flowGroupIndices.find(key);
+
+		if (iter != flowGroupIndices.end()) {
+			flowGroups[iter->second].queueIndices.push_back(n);
+			continue;
+		}
+
+		flowGroupIndices[key] = flowGroups.size();
+
+		flowGroups.emplace_back();
+		flowGroups.back().key = key;
+		flowGroups.back().queueIndices.push_back(n);
+	}
+
+	// groups are ordered by their first member, so field IDs match on every client
+	for (const FlowGroup& fg: flowGroups) {
+		if (fg.queueIndices.size() < size_t(modInfo.flowFieldGroupSize))
+			continue;
+
+		const MultiPath& leader = queuedPaths[fg.queueIndices[0]].multiPath;
+
+		FlowField& flowField = flowFields[++nextFlowFieldID];
+
+		flowField.moveDef = leader.moveDef;
+		flowField.peDef = leader.peDef;
+
+		medResPE->BuildFlowField(*flowField.moveDef, flowField.peDef, flowField.field);
+
+		for (const unsigned int queueIdx: fg.queueIndices) {
+			MultiPath& multiPath = queuedPaths[queueIdx].multiPath;
+
+			// members the field does not lead anywhere search on their own
+			if (!flowField.field.IsReachable(GetBlockPos(medResPE, multiPath.start)))
+				continue;
+
+			multiPath.flowFieldID = nextFlowFieldID;
+			multiPath.searchResult = IPath::Ok;
+
+			flowField.numPaths += 1;
+		}
+
+		numFlowFields += 1;
+		numFlowPaths += flowField.numPaths;
+
+		if (flowField.numPaths > 0)
+			continue;
+
+		flowFields.erase(nextFlowFieldID);
+	}
+}
+
+void CPathManager::ReleaseFlowField(unsigned int flowFieldID)
+{
+	if (flowFieldID == 0)
+		return;
+
+	const auto iter = flowFields.find(flowFieldID);
+
+	assert(iter != flowFields.end());
+	assert(iter->second.numPaths > 0);
+
+	if ((iter->second.numPaths -= 1) > 0)
+		return;
+
+	flowFields.erase(iter);
+}
+
+void CPathManager::UpdateFlowFields()
+{
+	if (flowFields.empty())
+		return;
+
+	bool rebuild = false;
+
+	for (auto& pair: flowFields) {
+		FlowField& flowField = pair.second;
+
+		flowField.rebuild |= medResPE->FlowFieldChanged(flowField.field, flowField.moveDef->pathType);
+		rebuild |= flowField.rebuild;
+	}
+
+	if (!rebuild)
+		return;
+
+	SCOPED_TIMER("Sim::Path::FlowFields");
+
+	// members keep their max-res waypoints and take
+	// new med-res ones from the rebuilt field after
+	for (auto& pair: pathMap) {
+		MultiPath& multiPath = pair.second;
+
+		if (multiPath.flowFieldID == 0)
+			continue;
+		if (!flowFields.find(multiPath.flowFieldID)->second.rebuild)
+			continue;
+
+		multiPath.medResPath.path.clear();
+	}
+
+	for (auto& pair: flowFields) {
+		FlowField& flowField = pair.second;
+
+		if (!flowField.rebuild)
+			continue;
+
+		medResPE->BuildFlowField(*flowField.moveDef, flowField.peDef, flowField.field);
+
+		flowField.rebuild = false;
+		numFlowFieldRebuilds += 1;
+	}
+}
+
+
+void CPathManager::ExecuteQueuedSearches()
+{
+	if (queuedPaths.empty())
+		return;
+
+	// groups heading for the same goal follow one flow-field instead of searching
+	if (modInfo.flowFieldGroupSize > 0)
+		AssignFlowFields();
+
+	SCOPED_TIMER("Sim::Path::QueuedSearches");
+
+	struct SearchGroup {
+		std::uint64_t key;
+		std::vector<unsigned int> queueIndices;
+		SharedSearch sharedSearch;
+	};
+
+	std::vector<SearchGroup> searchGroups;
+	spring::unordered_map<std::uint64_t, unsigned int> searchGroupIndices;
+
+	searchGroups.reserve(queuedPaths.size());
+
+	// requests with equal keys form one group (ordered by their first member)
+	// whose members are resolved in sequence by the same worker, so the first
+	// shareable result in a group is the same on every client
+	for (unsigned int n = 0; n < queuedPaths.size(); n++) {
+		if (queuedPaths[n].multiPath.flowFieldID != 0)
+			continue;
+
+		const std::uint64_t key = GetSharedSearchKey(queuedPaths[n].multiPath);
+
+		if (key != 0) {
+			const auto iter = searchGroupIndices.find(key);
+
+			if (iter != searchGroupIndices.end()) {
+				searchGroups[iter->second].queueIndices.push_back(n);
+				continue;
+			}
+
+			searchGroupIndices[key] = searchGroups.size();
+		}
+
+		searchGroups.emplace_back();
+		searchGroups.back().key = key;
+		searchGroups.back().queueIndices.push_back(n);
+	}
+
+	// without workers (queueing only for the sake of flow-fields) the
+	// main instances resolve everything, adding to the caches directly
+	if (searchWorkers.empty()) {
+		for (SearchGroup& sg: searchGroups) {
+			for (const unsigned int queueIdx: sg.queueIndices) {
+				SearchPath(queuedPaths[queueIdx].multiPath, GetMainInstances(), (sg.key != 0)? &sg.sharedSearch: nullptr);
+			}
+		}
+	}
+
+	// nothing else touches the shared PE data or caches while the workers
+	// run; which worker resolves a group does not affect its result, so
+	// groups are simply handed out in order to whichever becomes idle
+	std::atomic<unsigned int> nextSearchGroup = {0};
+
+	for_mt(0, int(std::min(searchGroups.size(), searchWorkers.size())), [&](const int workerNum) {
+		const SearchInstances& si = searchWorkers[workerNum];
+
+		for (unsigned int n = nextSearchGroup++; n < searchGroups.size(); n = nextSearchGroup++) {
+			SearchGroup& sg = searchGroups[n];
+
+			for (const unsigned int queueIdx: sg.queueIndices) {
+				QueuedPath& qp = queuedPaths[queueIdx];
+
+				// no need to UnBlock the caller, block-checks always ignore it
+				SearchPath(qp.multiPath, si, (sg.key != 0)? &sg.sharedSearch: nullptr);
+
+				si.medResPE->SwapPendingCacheItems(qp.cacheItems[0]);
+				si.lowResPE->SwapPendingCacheItems(qp.cacheItems[1]);
+			}
+		}
+	});
+
+	for (const SearchGroup& sg: searchGroups) {
+		if (sg.key == 0)
+			continue;
+
+		CountSharedSearch(sg.key, sg.sharedSearch);
+	}
+
+	// publish in request-ID order s.t. the caches evolve identically everywhere
+	for (QueuedPath& qp: queuedPaths) {
+		medResPE->AddCacheItems(qp.cacheItems[0]);
+		lowResPE->AddCacheItems(qp.cacheItems[1]);
+
+		// failed requests leave a dangling ID, NextWayPoint will report it
+		if (qp.multiPath.searchResult == IPath::Error)
+			continue;
+
+		pathMap[qp.pathID] = std::move(qp.multiPath);
+	}
+
+	queuedPaths.clear();
+}
+
 
 // converts part of a med-res path into a max-res path
-void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced) const
+void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced, const SearchInstances& si) const
 {
 	assert(IsFinalized());
 
@@ -437,7 +892,7 @@ void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, c
 	// Perform the search.
 	// If this is the final improvement of the path, then use the original goal.
 	const auto& pfd = (medResPath.path.empty() && lowResPath.path.empty()) ? multiPath.peDef : rangedGoalDef;
-	const IPath::SearchResult result = maxResPF->GetPath(*multiPath.moveDef, pfd, owner, startPos, maxResPath, MAX_SEARCHED_NODES_ON_REFINE);
+	const IPath::SearchResult result = si.maxResPF->GetPath(*multiPath.moveDef, pfd, owner, startPos, maxResPath, MAX_SEARCHED_NODES_ON_REFINE);
 
 	// If no refined path could be found, set goal as desired goal.
 	if (result == IPath::CantGetCloser || result == IPath::Error) {
@@ -445,8 +900,40 @@ void CPathManager::MedRes2MaxRes(MultiPath& multiPath, const float3& startPos, c
 	}
 }
 
+// converts the rest of a flow-field path into a med-res path
+void CPathManager::FlowField2MedRes(MultiPath& multiPath, const float3& startPos) const
+{
+	assert(IsFinalized());
+
+	const CPathFlowField& field = flowFields.find(multiPath.flowFieldID)->second.field;
+	const int2 numBlocks = field.GetNumBlocks();
+
+	IPath::Path& medResPath = multiPath.medResPath;
+	IPath::path_list_type& points = medResPath.path;
+
+	int2 blockPos = GetBlockPos(medResPE, startPos);
+
+	points.clear();
+
+	// every step down the field lowers the remaining cost, so this ends at the goal
+	for (int n = numBlocks.x * numBlocks.y; n > 0; n--) {
+		points.push_back(GetFlowTarget(multiPath, field, blockPos));
+
+		if (points.back() == multiPath.finalGoal)
+			break;
+
+		blockPos = field.GetNextBlock(blockPos);
+	}
+
+	// waypoints are stored goal-first; MedRes2MaxRes drops the start
+	std::reverse(points.begin(), points.end());
+	points.push_back(startPos);
+
+	medResPath.pathGoal = multiPath.finalGoal;
+}
+
 // converts part of a low-res path into a med-res path
-void CPathManager::LowRes2MedRes(MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced) const
+void CPathManager::LowRes2MedRes(MultiPath& multiPath, const float3& startPos, const CSolidObject* owner, bool synced, const SearchInstances& si) const
 {
 	assert(IsFinalized());
 
@@ -476,7 +963,7 @@ void CPathManager::LowRes2MedRes(MultiPath& multiPath, const float3& startPos, c
 	// Perform the search.
 	// If there is no low-res path left, use original goal.
 	const auto& pfd = (lowResPath.path.empty()) ? multiPath.peDef : rangedGoalDef;
-	const IPath::SearchResult result = medResPE->GetPath(*multiPath.moveDef, pfd, owner, startPos, medResPath, MAX_SEARCHED_NODES_ON_REFINE);
+	const IPath::SearchResult result = si.medResPE->GetPath(*multiPath.moveDef, pfd, owner, startPos, medResPath, MAX_SEARCHED_NODES_ON_REFINE);
 
 	// If no refined path could be found, set goal as desired goal.
 	if (result == IPath::CantGetCloser || result == IPath::Error) {
@@ -511,8 +998,19 @@ float3 CPathManager::NextWayPoint(
 	// find corresponding multipath entry
 	MultiPath* multiPath = GetMultiPath(pathID);
 
-	if (multiPath == nullptr)
-		return noPathPoint;
+	if (multiPath == nullptr) {
+		const auto qi = FindQueuedPath(pathID);
+
+		// dangling ID after a failed (queued) request or regular deletion
+		if (qi == queuedPaths.end())
+			return noPathPoint;
+
+		// request has not been resolved yet; just set the owner off toward
+		// its goal (keeping the point close enough that NextWayPoint will be
+		// called again soon) with y=-1 to mark this as a temporary waypoint
+		const float3 goalDir = (qi->multiPath.finalGoal - callerPos).SafeNormalize2D() * SQUARE_SIZE;
+		return float3(callerPos.x + goalDir.x, -1.0f, callerPos.z + goalDir.z);
+	}
 
 	if (numRetries > MAX_PATH_REFINEMENT_DEPTH)
 		return (multiPath->finalGoal);
@@ -538,10 +1036,15 @@ float3 CPathManager::NextWayPoint(
 		if (multiPath->caller != nullptr)
 			multiPath->caller->UnBlock();
 
-		if (extendMedResPath)
-			LowRes2MedRes(*multiPath, callerPos, owner, synced);
+		if (extendMedResPath) {
+			if (multiPath->flowFieldID != 0) {
+				FlowField2MedRes(*multiPath, callerPos);
+			} else {
+				LowRes2MedRes(*multiPath, callerPos, owner, synced, GetMainInstances());
+			}
+		}
 
-		MedRes2MaxRes(*multiPath, callerPos, owner, synced);
+		MedRes2MaxRes(*multiPath, callerPos, owner, synced, GetMainInstances());
 
 		if (multiPath->caller != nullptr)
 			multiPath->caller->Block();
@@ -583,10 +1086,66 @@ float3 CPathManager::NextWayPoint(
 	} while ((callerPos.SqDistance2D(waypoint) < Square(radius)) && (waypoint != maxResPath.pathGoal));
 
 	// y=0 indicates this is not a temporary waypoint
-	// (the default PFS does not queue path-requests)
+	// (those are only handed out while a request is queued)
 	return (waypoint * XZVector);
 }
 
+float3 CPathManager::GetFlowTarget(const MultiPath& path, const CPathFlowField& field, const int2 blockPos) const
+{
+	if (field.IsGoal(blockPos) || !field.IsReachable(blockPos))
+		return path.finalGoal;
+
+	const int2 nextBlockPos = field.GetNextBlock(blockPos);
+
+	// head straight for the goal once it is one step away
+	if (field.IsGoal(nextBlockPos))
+		return path.finalGoal;
+
+	return (SquareToFloat3(medResPE->GetBlockOffset(path.moveDef->pathType, nextBlockPos)));
+}
+
+float3 CPathManager::GetFlowDir(unsigned int pathID, const float3& pos) const
+{
+	const MultiPath* multiPath = GetMultiPathConst(pathID);
+
+	if (multiPath == nullptr || multiPath->flowFieldID == 0)
+		return ZeroVector;
+
+	const CPathFlowField& field = flowFields.find(multiPath->flowFieldID)->second.field;
+	const int2 numBlocks = field.GetNumBlocks();
+
+	// inside a goal-block the waypoint already is the goal itself
+	if (field.IsGoal(GetBlockPos(medResPE, pos)))
+		return ZeroVector;
+
+	// blend the directions toward the targets of the four blocks whose centers surround <pos>
+	const float bx = pos.x / medResPE->BLOCK_PIXEL_SIZE - 0.5f;
+	const float bz = pos.z / medResPE->BLOCK_PIXEL_SIZE - 0.5f;
+
+	const int2 minBlockPos = {int(math::floor(bx)), int(math::floor(bz))};
+
+	const float fx = bx - minBlockPos.x;
+	const float fz = bz - minBlockPos.y;
+
+	float3 flowDir;
+
+	for (int z = 0; z <= 1; z++) {
+		for (int x = 0; x <= 1; x++) {
+			const int2 blockPos = {Clamp(minBlockPos.x + x, 0, numBlocks.x - 1), Clamp(minBlockPos.y + z, 0, numBlocks.y - 1)};
+
+			if (!field.IsReachable(blockPos))
+				continue;
+
+			const float3 targetDir = ((GetFlowTarget(*multiPath, field, blockPos) - pos) * XZVector).SafeNormalize2D();
+			const float weight = ((x == 0)? (1.0f - fx): fx) * ((z == 0)? (1.0f - fz): fz);
+
+			flowDir += (targetDir * weight);
+		}
+	}
+
+	return (flowDir.SafeNormalize2D());
+}
+
 
 // Tells estimators about changes in or on the map.
 void CPathManager::TerrainChange(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2, unsigned int /*type*/) {
@@ -612,8 +1171,54 @@ void CPathManager::Update()
 	pathFlowMap->Update();
 	pathHeatMap->Update();
 
-	medResPE->Update();
-	lowResPE->Update();
+	// requests only share searches within the same frame
+	for (const auto& pair: sharedSearches) {
+		CountSharedSearch(pair.first, pair.second);
+	}
+
+	sharedSearches.clear();
+
+	float budgetScale = 1.0f;
+
+	// dirty blocks on active paths are updated first, and more of them
+	// while few units need new paths (up to twice as many if none do)
+	if (modInfo.prioritizedPathUpdates) {
+		MarkDemandedBlocks();
+
+		budgetScale += (1.0f / (1.0f + numSyncedRequests * 0.125f));
+	}
+
+	numSyncedRequests = 0;
+
+	medResPE->Update(budgetScale);
+	lowResPE->Update(budgetScale);
+
+	// before the queued requests can be assigned to any of them
+	UpdateFlowFields();
+
+	// resolve last frame's requests against the updated estimator data
+	ExecuteQueuedSearches();
+}
+
+void CPathManager::MarkDemandedBlocks()
+{
+	if (medResPE->updatedBlocks.empty() && lowResPE->updatedBlocks.empty())
+		return;
+
+	// unsynced paths must not influence the (synced) estimator data
+	for (const auto& pair: pathMap) {
+		const MultiPath& multiPath = pair.second;
+
+		if (!multiPath.peDef.synced)
+			continue;
+
+		for (const IPath::Path* path: {&multiPath.maxResPath, &multiPath.medResPath, &multiPath.lowResPath}) {
+			for (const float3& pos: path->path) {
+				medResPE->MarkDemandedBlock(pos);
+				lowResPE->MarkDemandedBlock(pos);
+			}
+		}
+	}
 }
 
 // used to deposit heat on the heat-map as a unit moves along its path
@@ -731,6 +1336,16 @@ bool CPathManager::SetNodeExtraCost(unsigned int x, unsigned int z, float cost,
 	maxResBuf.SetNodeExtraCost(x, z, cost, synced);
 	medResBuf.SetNodeExtraCost(x, z, cost, synced);
 	lowResBuf.SetNodeExtraCost(x, z, cost, synced);
+
+	// cached paths were found with the old costs
+	medResPE->pathCache[synced]->Invalidate();
+	lowResPE->pathCache[synced]->Invalidate();
+
+	// flow-fields are built with the synced costs
+	for (auto& pair: flowFields) {
+		pair.second.rebuild |= synced;
+	}
+
 	return true;
 }
 
@@ -749,6 +1364,15 @@ bool CPathManager::SetNodeExtraCosts(const float* costs, unsigned int sizex, uns
 	maxResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
 	medResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
 	lowResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
+
+	medResPE->pathCache[synced]->Invalidate();
+	lowResPE->pathCache[synced]->Invalidate();
+
+	// flow-fields are built with the synced costs
+	for (auto& pair: flowFields) {
+		pair.second.rebuild |= synced;
+	}
+
 	return true;
 }
 
@@ -784,3 +1408,24 @@ int2 CPathManager::GetNumQueuedUpdates() const {
 	return data;
 }
 
+PathCacheStats CPathManager::GetPathCacheStats(bool synced) const {
+	PathCacheStats stats;
+
+	if (!IsFinalized())
+		return stats;
+
+	for (const CPathEstimator* pe: {medResPE, lowResPE}) {
+		const CPathCache* pc = pe->pathCache[synced];
+
+		stats.numHits += pc->GetNumCacheHits();
+		stats.numMisses += pc->GetNumCacheMisses();
+		stats.numSharedHits += pc->GetNumSharedHits();
+		stats.numEvictions += pc->GetNumEvictions();
+		stats.numInvalidations += pc->GetNumInvalidations();
+		stats.size += pc->GetSize();
+		stats.capacity += pc->GetCapacity();
+	}
+
+	return stats;
+}
+
@@ -3,11 +3,15 @@
 #ifndef PATHMANAGER_H
 #define PATHMANAGER_H
 
+#include <algorithm>
 #include <cinttypes>
+#include <vector>
 
 #include "Sim/Path/IPathManager.h"
 #include "IPath.h"
+#include "PathCache.h"
 #include "PathFinderDef.h"
+#include "PathFlowField.h"
 #include "System/UnorderedMap.hpp"
 
 class CSolidObject;
@@ -36,10 +40,18 @@ public:
 
 		const auto pi = pathMap.find(pathID);
 
-		if (pi == pathMap.end())
+		if (pi != pathMap.end()) {
+			ReleaseFlowField(pi->second.flowFieldID);
+			pathMap.erase(pi);
+			return;
+		}
+
+		const auto qi = FindQueuedPath(pathID);
+
+		if (qi == queuedPaths.end())
 			return;
 
-		pathMap.erase(pi);
+		queuedPaths.erase(qi);
 	}
 
 
@@ -52,6 +64,8 @@ public:
 		bool synced
 	) override;
 
+	float3 GetFlowDir(unsigned int pathID, const float3& pos) const override;
+
 	unsigned int RequestPath(
 		CSolidObject* caller,
 		const MoveDef* moveDef,
@@ -90,6 +104,7 @@ public:
 	const float* GetNodeExtraCosts(bool) const override;
 
 	int2 GetNumQueuedUpdates() const override;
+	PathCacheStats GetPathCacheStats(bool synced) const override;
 
 private:
 	struct MultiPath {
@@ -120,8 +135,11 @@ private:
 			moveDef = mp.moveDef;
 			caller  = mp.caller;
 
+			flowFieldID = mp.flowFieldID;
+
 			mp.moveDef = nullptr;
 			mp.caller  = nullptr;
+			mp.flowFieldID = 0;
 			return *this;
 		}
 
@@ -142,6 +160,58 @@ private:
 
 		// additional information
 		CSolidObject* caller;
+
+		// non-zero if this path follows a shared flow-field, which then
+		// takes the place of its low-res path (see FlowField2MedRes)
+		unsigned int flowFieldID = 0;
+	};
+
+	// a request deferred to the next Update (see ExecuteQueuedSearches)
+	struct QueuedPath {
+		unsigned int pathID = 0;
+
+		MultiPath multiPath;
+
+		// cache additions made while resolving, [0] = med-res PE, [1] = low-res PE
+		std::vector<CPathCache::CacheItem> cacheItems[2][2];
+	};
+
+	// block-level result of the first request (in a frame) with a given
+	// GetSharedSearchKey, reused by all subsequent requests with that key
+	// and the same goal-radius
+	struct SharedSearch {
+		bool valid = false;
+
+		unsigned int numShared = 0;
+
+		float sqGoalRadius = 0.0f;
+
+		IPath::SearchResult result = IPath::Error;
+		IPath::Path lowResPath;
+		IPath::Path medResPath;
+	};
+
+	// flow-field followed by a group of queued requests with the same
+	// GetFlowFieldKey, released when the last of their paths is deleted
+	// and rebuilt (by UpdateFlowFields) when the estimator changes under it
+	struct FlowField {
+		unsigned int numPaths = 0;
+
+		bool rebuild = false;
+
+		// definition of the request that built the field
+		const MoveDef* moveDef = nullptr;
+		CCircularSearchConstraint peDef;
+
+		CPathFlowField field;
+	};
+
+	// one set of instances to search with; the main set handles all immediate
+	// requests, each search-worker has its own set for ExecuteQueuedSearches
+	struct SearchInstances {
+		CPathFinder* maxResPF;
+		CPathEstimator* medResPE;
+		CPathEstimator* lowResPE;
 	};
 
 private:
@@ -150,9 +220,22 @@ private:
 		const MoveDef* moveDef,
 		const float3& startPos,
 		const float3& goalPos,
-		CSolidObject* caller
+		CSolidObject* caller,
+		const SearchInstances& si
 	) const;
 
+	IPath::SearchResult SearchPath(MultiPath& newPath, const SearchInstances& si, SharedSearch* sharedSearch) const;
+
+	std::uint64_t GetSharedSearchKey(const MultiPath& path) const;
+	void CountSharedSearch(std::uint64_t key, const SharedSearch& sharedSearch);
+
+	std::uint64_t GetFlowFieldKey(const MultiPath& path) const;
+	void AssignFlowFields();
+	void ReleaseFlowField(unsigned int flowFieldID);
+	void UpdateFlowFields();
+
+	float3 GetFlowTarget(const MultiPath& path, const CPathFlowField& field, int2 blockPos) const;
+
 	MultiPath* GetMultiPath(int pathID) { return (const_cast<MultiPath*>(GetMultiPathConst(pathID))); }
 
 	const MultiPath* GetMultiPathConst(int pathID) const {
@@ -167,14 +250,41 @@ private:
 		return nextPathID;
 	}
 
+	unsigned int Queue(MultiPath& path) {
+		queuedPaths.emplace_back();
+		queuedPaths.back().pathID = ++nextPathID;
+		queuedPaths.back().multiPath = std::move(path);
+		return nextPathID;
+	}
+
+	// queuedPaths is sorted by ID since IDs only ever increase
+	std::vector<QueuedPath>::iterator FindQueuedPath(unsigned int pathID) {
+		const auto pred = [](const QueuedPath& qp, unsigned int id) { return (qp.pathID < id); };
+		const auto iter = std::lower_bound(queuedPaths.begin(), queuedPaths.end(), pathID, pred);
+
+		if (iter == queuedPaths.end() || iter->pathID != pathID)
+			return queuedPaths.end();
+
+		return iter;
+	}
+
+	void InitSearchWorkers();
+	void KillSearchWorkers();
+	void ExecuteQueuedSearches();
+
+	void MarkDemandedBlocks();
+
 
 	static void FinalizePath(MultiPath* path, const float3 startPos, const float3 goalPos, const bool cantGetCloser);
 
-	void LowRes2MedRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
-	void MedRes2MaxRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
+	void FlowField2MedRes(MultiPath& path, const float3& startPos) const;
+	void LowRes2MedRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced, const SearchInstances& si) const;
+	void MedRes2MaxRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced, const SearchInstances& si) const;
 
 	bool IsFinalized() const { return (maxResPF != nullptr); }
 
+	SearchInstances GetMainInstances() const { return {maxResPF, medResPE, lowResPE}; }
+
 private:
 	CPathFinder* maxResPF;
 	CPathEstimator* medResPE;
@@ -185,7 +295,24 @@ private:
 
 	spring::unordered_map<unsigned int, MultiPath> pathMap;
 
+	// only used if modInfo.sharedPathRequests is enabled; cleared every Update
+	spring::unordered_map<std::uint64_t, SharedSearch> sharedSearches;
+
+	// only used if modInfo.flowFieldGroupSize is positive
+	spring::unordered_map<unsigned int, FlowField> flowFields;
+
+	// only used if modInfo.parallelPathRequests is enabled (or flowFieldGroupSize is positive)
+	std::vector<QueuedPath> queuedPaths;
+	std::vector<SearchInstances> searchWorkers;
+
 	unsigned int nextPathID;
+	unsigned int nextFlowFieldID;
+	// flow-fields built (and rebuilt) and requests resolved by them, reported by the dtor
+	unsigned int numFlowFields;
+	unsigned int numFlowPaths;
+	unsigned int numFlowFieldRebuilds;
+	// synced requests since the last Update
+	unsigned int numSyncedRequests;
 };
 
 #endif
@@ -13,6 +13,18 @@
 struct MoveDef;
 class CSolidObject;
 
+/// path-cache counters, summed over all caches of a path manager
+struct PathCacheStats {
+	std::uint32_t numHits = 0;
+	std::uint32_t numMisses = 0;
+	std::uint32_t numSharedHits = 0;
+	std::uint32_t numEvictions = 0;
+	std::uint32_t numInvalidations = 0;
+
+	std::uint32_t size = 0;
+	std::uint32_t capacity = 0;
+};
+
 class IPathManager {
 public:
 	static IPathManager* GetInstance(int type);
@@ -80,6 +92,16 @@ public:
 	}
 
 
+	/**
+	 * Returns the direction (in the XZ-plane) in which a unit at <pos>
+	 * should head to follow path <pathID>, for paths that are part of a
+	 * flow-field shared by a group of units (so the direction varies
+	 * smoothly between blocks), or ZeroVector for all other paths. Unlike
+	 * waypoints it does not account for obstacles inside blocks.
+	 */
+	virtual float3 GetFlowDir(unsigned int pathID, const float3& pos) const { return ZeroVector; }
+
+
 	/**
 	 * Returns all waypoints of a path. Different segments of a path might
 	 * have different resolutions, or each segment might be represented at
@@ -169,6 +191,8 @@ public:
 	virtual const float* GetNodeExtraCosts(bool synced) const { return nullptr; }
 
 	virtual int2 GetNumQueuedUpdates() const { return (int2(0, 0)); }
+	/// stats of the caches used by synced (or unsynced) path-requests
+	virtual PathCacheStats GetPathCacheStats(bool synced) const { return PathCacheStats(); }
 };
 
 extern IPathManager* pathManager;
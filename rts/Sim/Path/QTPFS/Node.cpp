@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 
@@ -501,6 +502,50 @@ void QTPFS::QTNode::Tesselate(NodeLayer& nl, const SRectangle& r) {
 	}
 }
 
+// re-tesselates a de-serialized tree after the squares inside <rects>
+// were updated (see PathManager::ReadNodeLayer); whether a node splits
+// only depends on its own squares, so re-deciding every node that has
+// one of <rects> in its area yields the same tree as Tesselate would
+// when building it from scratch
+void QTPFS::QTNode::ReTesselate(NodeLayer& nl, const std::vector<SRectangle>& rects) {
+	const auto IsExteriorRect = [&](const SRectangle& r) { return (GetRectangleRelation(r) == REL_RECT_EXTERIOR_NODE); };
+
+	if (std::all_of(rects.begin(), rects.end(), IsExteriorRect))
+		return;
+
+	unsigned int numNewBinSquares = 0;
+	unsigned int numDifBinSquares = 0;
+	unsigned int numClosedSquares = 0;
+
+	bool wantSplit = false;
+	bool needSplit = false;
+
+	UpdateMoveCost(nl, SRectangle(xmin(), zmin(), xmax(), zmax()), numNewBinSquares, numDifBinSquares, numClosedSquares, wantSplit, needSplit);
+
+	if (!((wantSplit && CanSplit(false)) || (needSplit && CanSplit(true)))) {
+		Merge(nl);
+		nl.RegisterNode(this);
+		return;
+	}
+
+	if (IsLeaf()) {
+		Split(nl, true);
+
+		for (unsigned int i = 0; i < children.size(); i++) {
+			QTNode* cn = children[i];
+
+			cn->Tesselate(nl, SRectangle(cn->xmin(), cn->zmin(), cn->xmax(), cn->zmax()));
+			assert(cn->GetMoveCost() != -1.0f);
+		}
+
+		return;
+	}
+
+	for (unsigned int i = 0; i < children.size(); i++) {
+		children[i]->ReTesselate(nl, rects);
+	}
+}
+
 bool QTPFS::QTNode::UpdateMoveCost(
 	const NodeLayer& nl,
 	const SRectangle& r,
@@ -129,6 +129,7 @@ namespace QTPFS {
 		void Delete();
 		void PreTesselate(NodeLayer& nl, const SRectangle& r, SRectangle& ur);
 		void Tesselate(NodeLayer& nl, const SRectangle& r);
+		void ReTesselate(NodeLayer& nl, const std::vector<SRectangle>& rects);
 		void Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsigned int* streamSize, bool readMode);
 
 		bool IsLeaf() const;
@@ -86,6 +86,7 @@ namespace QTPFS {
 //		bool full() const { return (size() >= capacity()); }
 		size_t size() const { return (cur_idx); }
 		size_t capacity() const { return (max_idx + 1); }
+		bool allocated() const { return (!nodes.empty()); }
 
 		void clear() {
 			nodes.clear();
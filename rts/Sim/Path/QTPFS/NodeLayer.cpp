@@ -24,6 +24,8 @@ QTPFS::NodeLayer::NodeLayer()
 	, updateCounter(0)
 	, xsize(0)
 	, zsize(0)
+	, xtiles(0)
+	, ztiles(0)
 	, maxRelSpeedMod(0.0f)
 	, avgRelSpeedMod(0.0f)
 {
@@ -52,6 +54,8 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 
 	xsize = mapDims.mapx;
 	zsize = mapDims.mapy;
+	xtiles = (xsize + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE;
+	ztiles = (zsize + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE;
 
 	nodeGrid.resize(xsize * zsize, NULL);
 
@@ -59,6 +63,8 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 	oldSpeedMods.resize(xsize * zsize,  0);
 	oldSpeedBins.resize(xsize * zsize, -1);
 	curSpeedBins.resize(xsize * zsize, -1);
+
+	tileMaxRelSpeedMods.resize(xtiles * ztiles, 0.0f);
 }
 
 void QTPFS::NodeLayer::Clear() {
@@ -69,6 +75,8 @@ void QTPFS::NodeLayer::Clear() {
 	oldSpeedBins.clear();
 	curSpeedBins.clear();
 
+	tileMaxRelSpeedMods.clear();
+
 	#ifdef QTPFS_STAGGERED_LAYER_UPDATES
 	layerUpdates.clear();
 	#endif
@@ -93,8 +101,8 @@ void QTPFS::NodeLayer::QueueUpdate(const SRectangle& r, const MoveDef* md) {
 		for (unsigned int hmx = r.x1; hmx < r.x2; hmx++) {
 			const unsigned int recIdx = (hmz - r.z1) * r.GetWidth() + (hmx - r.x1);
 
-			const unsigned int chmx = Clamp(int(hmx), md->xsizeh, r.x2 - md->xsizeh - 1);
-			const unsigned int chmz = Clamp(int(hmz), md->zsizeh, r.z2 - md->zsizeh - 1);
+			const unsigned int chmx = Clamp(int(hmx), md->xsizeh, mapDims.mapx - md->xsizeh - 1);
+			const unsigned int chmz = Clamp(int(hmz), md->zsizeh, mapDims.mapy - md->zsizeh - 1);
 
 			layerUpdate->speedMods[recIdx] = CMoveMath::GetPosSpeedMod(*md, hmx, hmz);
 			layerUpdate->blockBits[recIdx] = CMoveMath::IsBlockedNoSpeedModCheck(*md, chmx, chmz, NULL);
@@ -136,15 +144,29 @@ bool QTPFS::NodeLayer::Update(
 		avgRelSpeedMod = 0.0f;
 	}
 
+	// restart the maximum of every tile <r> fully covers
+	for (unsigned int tz = (r.z1 + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE; tz < ztiles; tz++) {
+		if (std::min((tz + 1) * QTPFS_SNAPSHOT_TILE_SIZE, zsize) > r.z2)
+			break;
+
+		for (unsigned int tx = (r.x1 + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE; tx < xtiles; tx++) {
+			if (std::min((tx + 1) * QTPFS_SNAPSHOT_TILE_SIZE, xsize) > r.x2)
+				break;
+
+			tileMaxRelSpeedMods[tz * xtiles + tx] = 0.0f;
+		}
+	}
+
 	// divide speed-modifiers into bins
 	for (unsigned int hmz = r.z1; hmz < r.z2; hmz++) {
 		for (unsigned int hmx = r.x1; hmx < r.x2; hmx++) {
 			const unsigned int sqrIdx = hmz * xsize + hmx;
 			const unsigned int recIdx = (hmz - r.z1) * r.GetWidth() + (hmx - r.x1);
+			const unsigned int tileIdx = (hmz / QTPFS_SNAPSHOT_TILE_SIZE) * xtiles + (hmx / QTPFS_SNAPSHOT_TILE_SIZE);
 
 			// don't tesselate map edges when footprint extends across them in IsBlocked*
-			const unsigned int chmx = Clamp(int(hmx), md->xsizeh, r.x2 - md->xsizeh - 1);
-			const unsigned int chmz = Clamp(int(hmz), md->zsizeh, r.z2 - md->zsizeh - 1);
+			const unsigned int chmx = Clamp(int(hmx), md->xsizeh, mapDims.mapx - md->xsizeh - 1);
+			const unsigned int chmz = Clamp(int(hmz), md->zsizeh, mapDims.mapy - md->zsizeh - 1);
 
 			const float minSpeedMod = (luSpeedMods == NULL)? CMoveMath::GetPosSpeedMod(*md, hmx, hmz): (*luSpeedMods)[recIdx];
 			const   int maxBlockBit = (luBlockBits == NULL)? CMoveMath::IsBlockedNoSpeedModCheck(*md, chmx, chmz, NULL): (*luBlockBits)[recIdx];
@@ -182,6 +204,9 @@ bool QTPFS::NodeLayer::Update(
 			oldSpeedBins[sqrIdx] = curSpeedModBin;
 			curSpeedBins[sqrIdx] = newSpeedModBin;
 
+			if (newRelSpeedMod > 0.0f)
+				tileMaxRelSpeedMods[tileIdx] = std::max(tileMaxRelSpeedMods[tileIdx], newRelSpeedMod);
+
 			if (globalUpdate && newRelSpeedMod > 0.0f) {
 				// only count open squares toward the maximum and average
 				maxRelSpeedMod  = std::max(maxRelSpeedMod, newRelSpeedMod);
@@ -208,6 +233,43 @@ bool QTPFS::NodeLayer::Update(
 
 
 
+void QTPFS::NodeLayer::UpdateMaxRelSpeedMod() {
+	// max is exact, so this equals what a global update would produce
+	maxRelSpeedMod = 0.0f;
+
+	for (const float tileMaxRelSpeedMod: tileMaxRelSpeedMods) {
+		maxRelSpeedMod = std::max(maxRelSpeedMod, tileMaxRelSpeedMod);
+	}
+}
+
+void QTPFS::NodeLayer::Serialize(std::fstream& fStream, unsigned int* streamSize, bool readMode) {
+	// the old speed{Mods, Bins} are only compared against during
+	// re-tesselation and can stay at their initial values; nodes
+	// are registered by QTNode::Serialize
+	(*streamSize) += (curSpeedMods.size() * sizeof(SpeedModType));
+	(*streamSize) += (curSpeedBins.size() * sizeof(SpeedBinType));
+	(*streamSize) += (tileMaxRelSpeedMods.size() * sizeof(float));
+	(*streamSize) += (2 * sizeof(float));
+
+	if (readMode) {
+		fStream.read(reinterpret_cast<char*>(&curSpeedMods[0]), curSpeedMods.size() * sizeof(SpeedModType));
+		fStream.read(reinterpret_cast<char*>(&curSpeedBins[0]), curSpeedBins.size() * sizeof(SpeedBinType));
+		fStream.read(reinterpret_cast<char*>(&tileMaxRelSpeedMods[0]), tileMaxRelSpeedMods.size() * sizeof(float));
+
+		fStream.read(reinterpret_cast<char*>(&maxRelSpeedMod), sizeof(float));
+		fStream.read(reinterpret_cast<char*>(&avgRelSpeedMod), sizeof(float));
+	} else {
+		fStream.write(reinterpret_cast<const char*>(&curSpeedMods[0]), curSpeedMods.size() * sizeof(SpeedModType));
+		fStream.write(reinterpret_cast<const char*>(&curSpeedBins[0]), curSpeedBins.size() * sizeof(SpeedBinType));
+		fStream.write(reinterpret_cast<const char*>(&tileMaxRelSpeedMods[0]), tileMaxRelSpeedMods.size() * sizeof(float));
+
+		fStream.write(reinterpret_cast<const char*>(&maxRelSpeedMod), sizeof(float));
+		fStream.write(reinterpret_cast<const char*>(&avgRelSpeedMod), sizeof(float));
+	}
+}
+
+
+
 QTPFS::NodeLayer::SpeedBinType QTPFS::NodeLayer::GetSpeedModBin(float absSpeedMod, float relSpeedMod) const {
 	// NOTE:
 	//     bins N and N+1 are reserved for modifiers <= min and >= max
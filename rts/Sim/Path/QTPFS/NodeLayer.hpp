@@ -6,6 +6,7 @@
 #include <limits>
 #include <vector>
 #include <deque> // for QTPFS_STAGGERED_LAYER_UPDATES
+#include <fstream>
 #include <cinttypes>
 
 #include "System/Rectangle.h"
@@ -57,6 +58,8 @@ namespace QTPFS {
 			const std::vector<  int>* luBlockBits = NULL
 		);
 
+		void Serialize(std::fstream& fStream, unsigned int* streamSize, bool readMode);
+
 		void ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, unsigned int currMagicNum);
 		void ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsigned int currMagicNum);
 
@@ -80,6 +83,10 @@ namespace QTPFS {
 		float GetMaxRelSpeedMod() const { return maxRelSpeedMod; }
 		float GetAvgRelSpeedMod() const { return avgRelSpeedMod; }
 
+		// recalculates the maximum from the per-tile maxima (which partial
+		// updates keep current for every snapshot-tile they fully cover)
+		void UpdateMaxRelSpeedMod();
+
 		SpeedBinType GetSpeedModBin(float absSpeedMod, float relSpeedMod) const;
 
 		std::uint64_t GetMemFootPrint() const {
@@ -88,6 +95,7 @@ namespace QTPFS {
 			memFootPrint += (oldSpeedMods.size() * sizeof(SpeedModType));
 			memFootPrint += (curSpeedBins.size() * sizeof(SpeedBinType));
 			memFootPrint += (oldSpeedBins.size() * sizeof(SpeedBinType));
+			memFootPrint += (tileMaxRelSpeedMods.size() * sizeof(float));
 			memFootPrint += (nodeGrid.size() * sizeof(INode*));
 			return memFootPrint;
 		}
@@ -100,6 +108,9 @@ namespace QTPFS {
 		std::vector<SpeedBinType> curSpeedBins;
 		std::vector<SpeedBinType> oldSpeedBins;
 
+		// maximum relative speedmod of the open squares in each snapshot-tile
+		std::vector<float> tileMaxRelSpeedMods;
+
 		#ifdef QTPFS_STAGGERED_LAYER_UPDATES
 		std::deque<LayerUpdate> layerUpdates;
 		#endif
@@ -118,6 +129,8 @@ namespace QTPFS {
 
 		unsigned int xsize;
 		unsigned int zsize;
+		unsigned int xtiles;
+		unsigned int ztiles;
 
 		float maxRelSpeedMod;
 		float avgRelSpeedMod;
@@ -12,12 +12,10 @@
 // #define QTPFS_DEBUG_NODE_HEAP
 #define QTPFS_CORNER_CONNECTED_NODES
 // #define QTPFS_SLOW_ACCURATE_TESSELATION
-// #define QTPFS_OPENMP_ENABLED
 // #define QTPFS_ORTHOPROJECTED_EDGE_TRANSITIONS
 #define QTPFS_STAGGERED_LAYER_UPDATES
 //
 // #define QTPFS_VIRTUAL_NODE_FUNCTIONS
-// #define QTPFS_ENABLE_THREADED_UPDATE
 // #define QTPFS_AMORTIZED_NODE_NEIGHBOR_CACHE_UPDATES
 #define QTPFS_ENABLE_MICRO_OPTIMIZATION_HACKS
 // #define QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
@@ -27,8 +25,12 @@
 #define QTPFS_MAX_NETPOINTS_PER_NODE_EDGE 3
 #define QTPFS_NETPOINT_EDGE_SPACING_SCALE (1.0f / (QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + 1))
 
-#define QTPFS_CACHE_VERSION 15
+#define QTPFS_CACHE_VERSION 16
 #define QTPFS_CACHE_XACCESS
+// size (in heightmap squares) of the regions whose terrain and blocking
+// state is hashed when writing a node-layer snapshot; regions that hash
+// differently on load are the only ones re-tesselated
+#define QTPFS_SNAPSHOT_TILE_SIZE 64
 
 #define QTPFS_POSITIVE_INFINITY (std::numeric_limits<float>::infinity())
 #define QTPFS_CLOSED_NODE_COST (1 << 24)
@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cinttypes>
+#include <fstream>
 #include <functional>
 
 #include "System/Threading/ThreadPool.h"
@@ -12,16 +13,17 @@
 #include "Game/GameSetup.h"
 #include "Game/LoadScreen.h"
 #include "Map/MapInfo.h"
+#include "Map/ReadMap.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/GroundBlockingObjectMap.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Objects/SolidObject.h"
-#include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/ArchiveScanner.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
-#include "System/Platform/Threading.h"
+#include "System/Sync/HsiehHash.h"
 #include "System/Threading/SpringThreading.h"
 #include "System/Rectangle.h"
 #include "System/TimeProfiler.h"
@@ -82,12 +84,6 @@ namespace QTPFS {
 	static PMLoadScreen pmLoadScreen;
 	static spring::thread pmLoadThread;
 
-	static size_t GetNumThreads() {
-		const size_t numThreads = std::max(0, configHandler->GetInt("PathingThreadCount"));
-		const size_t numCores = Threading::GetLogicalCpuCores();
-		return ((numThreads == 0)? numCores: numThreads);
-	}
-
 	unsigned int PathManager::LAYERS_PER_UPDATE;
 	unsigned int PathManager::MAX_TEAM_SEARCHES;
 }
@@ -119,26 +115,15 @@ QTPFS::PathManager::~PathManager() {
 	nodeLayers.clear();
 	pathCaches.clear();
 	pathSearches.clear();
+	searchBatches.clear();
 	pathTypes.clear();
 	pathTraces.clear();
 
 	numCurrExecutedSearches.clear();
 	numPrevExecutedSearches.clear();
+	searchStateOffsets.clear();
 
 	PathSearch::FreeGlobalQueue();
-
-	#ifdef QTPFS_ENABLE_THREADED_UPDATE
-	// at this point the thread is waiting, so notify it
-	// nodeLayers has been cleared already, guaranteeing
-	// that no "final" iteration shall execute
-	condThreadUpdate->notify_one();
-	updateThread->join();
-
-	delete updateThread;
-	delete mutexThreadUpdate;
-	delete condThreadUpdate;
-	delete condThreadUpdated;
-	#endif
 }
 
 std::int64_t QTPFS::PathManager::Finalize() {
@@ -148,13 +133,6 @@ std::int64_t QTPFS::PathManager::Finalize() {
 		pmLoadThread = spring::thread(std::bind(&PathManager::Load, this));
 		pmLoadScreen.Loop();
 		pmLoadThread.join();
-
-		#ifdef QTPFS_ENABLE_THREADED_UPDATE
-		mutexThreadUpdate = new spring::mutex();
-		condThreadUpdate = new spring::condition_variable();
-		condThreadUpdated = new spring::condition_variable();
-		updateThread = new spring::thread(std::bind(&PathManager::ThreadUpdate, this));
-		#endif
 	}
 
 	const spring_time t1 = spring_gettime();
@@ -171,8 +149,6 @@ void QTPFS::PathManager::InitStatic() {
 void QTPFS::PathManager::Load() {
 	pmLoadScreen.SetLoading(true);
 
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
@@ -181,11 +157,16 @@ void QTPFS::PathManager::Load() {
 	nodeLayers.resize(moveDefHandler.GetNumMoveDefs());
 	pathCaches.resize(moveDefHandler.GetNumMoveDefs());
 	pathSearches.resize(moveDefHandler.GetNumMoveDefs());
+	searchBatches.resize(moveDefHandler.GetNumMoveDefs());
+	numDirtyTiles.resize(moveDefHandler.GetNumMoveDefs(), -1);
 
 	// add one extra element for object-less requests
 	numCurrExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
 	numPrevExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
 
+	// NOTE: offsets *must* start at a non-zero value
+	searchStateOffsets.resize(moveDefHandler.GetNumMoveDefs(), NODE_STATE_OFFSET);
+
 	{
 		const sha512::raw_digest& mapCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(gameSetup->mapName);
 		const sha512::raw_digest& modCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(gameSetup->modName);
@@ -195,14 +176,19 @@ void QTPFS::PathManager::Load() {
 		sha512::dump_digest(mapCheckSum, mapCheckSumHex);
 		sha512::dump_digest(modCheckSum, modCheckSumHex);
 
-		const std::string& cacheDirName = GetCacheDirName({mapCheckSumHex.data()}, {modCheckSumHex.data()});
+		cacheDirName = GetCacheDirName({mapCheckSumHex.data()}, {modCheckSumHex.data()});
 
 		{
 			layersInited = false;
 			haveCacheDir = FileSystem::DirExists(cacheDirName);
 
+			if (!haveCacheDir) {
+				FileSystem::CreateDirectory(cacheDirName);
+				assert(FileSystem::DirExists(cacheDirName));
+			}
+
+			InitTileCheckSums();
 			InitNodeLayersThreaded(MAP_RECTANGLE);
-			Serialize(cacheDirName);
 
 			layersInited = true;
 		}
@@ -221,8 +207,8 @@ void QTPFS::PathManager::Load() {
 
 		for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
 			#ifndef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-			if (haveCacheDir) {
-				// if cache-dir exists, must set node relations after de-serializing its trees
+			if (numDirtyTiles[layerNum] >= 0) {
+				// if read from a snapshot, must set node relations after de-serializing its tree
 				nodeLayers[layerNum].ExecNodeNeighborCacheUpdates(MAP_RECTANGLE, numTerrainChanges);
 			}
 			#endif
@@ -236,6 +222,21 @@ void QTPFS::PathManager::Load() {
 		PathSearch::InitGlobalQueue(maxNumLeafNodes);
 	}
 
+	{
+		unsigned int numReadLayers = 0;
+		unsigned int numReadTiles = 0;
+
+		for (const int n: numDirtyTiles) {
+			numReadLayers += (n >= 0);
+			numReadTiles += std::max(n, 0);
+		}
+
+		char loadMsg[512] = {'\0'};
+		const char* fmtString = "[PathManager::%s] read %u of %u node-layers from snapshots (%u of %u tiles re-tesselated)";
+
+		sprintf(loadMsg, fmtString, __func__, numReadLayers, nodeLayers.size(), numReadTiles, numReadLayers * static_cast<unsigned int>(tileCheckSums.size()));
+		pmLoadScreen.AddLoadMessage(loadMsg);
+	}
 	{
 		const std::string sumStr = "pfs-checksum: " + IntToString(pfsCheckSum, "%08x") + ", ";
 		const std::string memStr = "mem-footprint: " + IntToString(GetMemFootPrint()) + "MB";
@@ -258,110 +259,47 @@ std::uint64_t QTPFS::PathManager::GetMemFootPrint() const {
 
 
 
-void QTPFS::PathManager::SpawnSpringThreads(MemberFunc f, const SRectangle& r) {
-	static std::vector<spring::thread*> threads(std::min(GetNumThreads(), nodeLayers.size()), NULL);
-
-	for (unsigned int threadNum = 0; threadNum < threads.size(); threadNum++) {
-		threads[threadNum] = new spring::thread(std::bind(f, this, threadNum, threads.size(), r));
-	}
-
-	for (unsigned int threadNum = 0; threadNum < threads.size(); threadNum++) {
-		threads[threadNum]->join(); delete threads[threadNum];
-	}
-}
-
-
-
 void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 	streflop::streflop_init<streflop::Simple>();
 
 	char loadMsg[512] = {'\0'};
 	const char* fmtString = "[PathManager::%s] using %u threads for %u node-layers (%s)";
 
-	#ifdef QTPFS_OPENMP_ENABLED
-	{
-		sprintf(loadMsg, fmtString, __func__, ThreadPool::GetNumThreads(), nodeLayers.size(), (haveCacheDir? "cached": "uncached"));
-		pmLoadScreen.AddLoadMessage(loadMsg);
+	sprintf(loadMsg, fmtString, __func__, ThreadPool::GetNumThreads(), nodeLayers.size(), (haveCacheDir? "cached": "uncached"));
+	pmLoadScreen.AddLoadMessage(loadMsg);
 
+	for_mt(0, nodeLayers.size(), [&](const int layerNum) {
 		#ifndef NDEBUG
+		char layerMsg[512] = {'\0'};
 		const char* preFmtStr = "  initializing node-layer %u (thread %u)";
 		const char* pstFmtStr = "  initialized node-layer %u (%u MB, %u leafs, ratio %f)";
+
+		sprintf(layerMsg, preFmtStr, layerNum, ThreadPool::GetThreadNum());
+		pmLoadScreen.AddLoadMessage(layerMsg);
 		#endif
 
-		for_mt(0, nodeLayers.size(), [&,loadMsg](const int layerNum){
-			#ifndef NDEBUG
-			sprintf(loadMsg, preFmtStr, layerNum, ThreadPool::GetThreadNum());
-			pmLoadScreen.AddLoadMessage(loadMsg);
-			#endif
+		// construct each tree from scratch IFF it has no (readable)
+		// snapshot; otherwise only the tiles whose terrain changed
+		// since the snapshot was written are rebuilt, and the result
+		// is the same either way so players can not desync over it
+		InitNodeLayer(layerNum, rect);
 
-			// construct each tree from scratch IFF no cache-dir exists
-			// (if it does, we only need to initialize speed{Mods, Bins}
-			// since Serialize will fill in the branches)
-			// NOTE:
-			//     silently assumes trees either ALL exist or ALL do not
-			//     (if >= 1 are missing for some player in MP, we desync)
-			InitNodeLayer(layerNum, rect);
+		if (!haveCacheDir || !ReadNodeLayer(layerNum))
 			UpdateNodeLayer(layerNum, rect);
+		if (!haveCacheDir)
+			WriteNodeLayer(layerNum);
 
-			const QTNode* tree = nodeTrees[layerNum];
-			const NodeLayer& layer = nodeLayers[layerNum];
-			const unsigned int mem = (tree->GetMemFootPrint() + layer.GetMemFootPrint()) / (1024 * 1024);
-
-			#ifndef NDEBUG
-			sprintf(loadMsg, pstFmtStr, layerNum, mem, layer.GetNumLeafNodes(), layer.GetNodeRatio());
-			pmLoadScreen.AddLoadMessage(loadMsg);
-			#endif
-		});
-	}
-	#else
-	{
-		sprintf(loadMsg, fmtString, __func__, GetNumThreads(), nodeLayers.size(), (haveCacheDir? "cached": "uncached"));
-		pmLoadScreen.AddLoadMessage(loadMsg);
-
-		SpawnSpringThreads(&PathManager::InitNodeLayersThread, rect);
-	}
-	#endif
-
-	streflop::streflop_init<streflop::Simple>();
-}
-
-__FORCE_ALIGN_STACK__
-void QTPFS::PathManager::InitNodeLayersThread(
-	unsigned int threadNum,
-	unsigned int numThreads,
-	const SRectangle& rect
-) {
-	const unsigned int layersPerThread = (nodeLayers.size() / numThreads);
-	const unsigned int numExcessLayers = (threadNum == (numThreads - 1))?
-		(nodeLayers.size() % numThreads): 0;
-
-	const unsigned int minLayer = threadNum * layersPerThread;
-	const unsigned int maxLayer = minLayer + layersPerThread + numExcessLayers;
-
-	#ifndef NDEBUG
-	char loadMsg[512] = {'\0'};
-	const char* preFmtStr = "  initializing node-layer %u (thread %u)";
-	const char* pstFmtStr = "  initialized node-layer %u (%u MB, %u leafs, ratio %f)";
-	#endif
-
-	for (unsigned int layerNum = minLayer; layerNum < maxLayer; layerNum++) {
 		#ifndef NDEBUG
-		sprintf(loadMsg, preFmtStr, layerNum, threadNum);
-		pmLoadScreen.AddLoadMessage(loadMsg);
-		#endif
-
-		InitNodeLayer(layerNum, rect);
-		UpdateNodeLayer(layerNum, rect);
-
 		const QTNode* tree = nodeTrees[layerNum];
 		const NodeLayer& layer = nodeLayers[layerNum];
 		const unsigned int mem = (tree->GetMemFootPrint() + layer.GetMemFootPrint()) / (1024 * 1024);
 
-		#ifndef NDEBUG
-		sprintf(loadMsg, pstFmtStr, layerNum, mem, layer.GetNumLeafNodes(), layer.GetNodeRatio());
-		pmLoadScreen.AddLoadMessage(loadMsg);
+		sprintf(layerMsg, pstFmtStr, layerNum, mem, layer.GetNumLeafNodes(), layer.GetNodeRatio());
+		pmLoadScreen.AddLoadMessage(layerMsg);
 		#endif
-	}
+	});
+
+	streflop::streflop_init<streflop::Simple>();
 }
 
 void QTPFS::PathManager::InitNodeLayer(unsigned int layerNum, const SRectangle& r) {
@@ -376,39 +314,13 @@ void QTPFS::PathManager::InitNodeLayer(unsigned int layerNum, const SRectangle&
 void QTPFS::PathManager::UpdateNodeLayersThreaded(const SRectangle& rect) {
 	streflop::streflop_init<streflop::Simple>();
 
-	#ifdef QTPFS_OPENMP_ENABLED
-	{
-		for_mt(0, nodeLayers.size(), [&,rect](const int layerNum) {
-			UpdateNodeLayer(layerNum, rect);
-		});
-	}
-	#else
-	{
-		SpawnSpringThreads(&PathManager::UpdateNodeLayersThread, rect);
-	}
-	#endif
+	for_mt(0, nodeLayers.size(), [&](const int layerNum) {
+		UpdateNodeLayer(layerNum, rect);
+	});
 
 	streflop::streflop_init<streflop::Simple>();
 }
 
-__FORCE_ALIGN_STACK__
-void QTPFS::PathManager::UpdateNodeLayersThread(
-	unsigned int threadNum,
-	unsigned int numThreads,
-	const SRectangle& rect
-) {
-	const unsigned int layersPerThread = (nodeLayers.size() / numThreads);
-	const unsigned int numExcessLayers = (threadNum == (numThreads - 1))?
-		(nodeLayers.size() % numThreads): 0;
-
-	const unsigned int minLayer = threadNum * layersPerThread;
-	const unsigned int maxLayer = minLayer + layersPerThread + numExcessLayers;
-
-	for (unsigned int layerNum = minLayer; layerNum < maxLayer; layerNum++) {
-		UpdateNodeLayer(layerNum, rect);
-	}
-}
-
 // called in the non-staggered (#ifndef QTPFS_STAGGERED_LAYER_UPDATES)
 // layer update scheme and during initialization; see ::TerrainChange
 void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle& r) {
@@ -439,10 +351,7 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 	ur.x2 = mr.x2;
 	ur.z2 = mr.z2;
 
-	const bool wantTesselation = (layersInited || !haveCacheDir);
-	const bool needTesselation = nodeLayers[layerNum].Update(mr, md);
-
-	if (needTesselation && wantTesselation) {
+	if (nodeLayers[layerNum].Update(mr, md)) {
 		nodeTrees[layerNum]->PreTesselate(nodeLayers[layerNum], mr, ur);
 		pathCaches[layerNum].MarkDeadPaths(mr);
 
@@ -532,87 +441,209 @@ std::string QTPFS::PathManager::GetCacheDirName(const std::string& mapCheckSumHe
 	return dir;
 }
 
-void QTPFS::PathManager::Serialize(const std::string& cacheFileDir) {
-	std::vector<std::string> fileNames(nodeTrees.size(), "");
-	std::vector<std::fstream*> fileStreams(nodeTrees.size(), NULL);
-	std::vector<unsigned int> fileSizes(nodeTrees.size(), 0);
+std::string QTPFS::PathManager::GetCacheFileName(unsigned int layerNum) const {
+	const MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
+	return (cacheDirName + "tree" + IntToString(layerNum, "%02x") + "-" + md->name);
+}
 
-	if (!haveCacheDir) {
-		FileSystem::CreateDirectory(cacheFileDir);
-		assert(FileSystem::DirExists(cacheFileDir));
-	}
+void QTPFS::PathManager::InitTileCheckSums() {
+	const float* cornerHeightMap = readMap->GetCornerHeightMapSynced();
+	const unsigned char* typeMap = readMap->GetTypeMapSynced();
 
-	#ifndef NDEBUG
-	char loadMsg[512] = {'\0'};
-	const char* fmtString = "[PathManager::%s] serializing node-tree %u (%s)";
-	#endif
+	const unsigned int xtiles = (mapDims.mapx + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE;
+	const unsigned int ztiles = (mapDims.mapy + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE;
 
-	// TODO: compress the tree cache-files?
-	for (unsigned int i = 0; i < nodeTrees.size(); i++) {
-		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
-
-		fileNames[i] = cacheFileDir + "tree" + IntToString(i, "%02x") + "-" + md->name;
-		fileStreams[i] = new std::fstream();
-
-		if (haveCacheDir) {
-			#ifdef QTPFS_CACHE_XACCESS
-			{
-				// FIXME: lock fileNames[i] instead of doing this
-				// fstreams can not be easily locked however, see
-				// http://stackoverflow.com/questions/839856/
-				while (!FileSystem::FileExists(fileNames[i] + "-tmp")) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
-				}
-				while (FileSystem::GetFileSize(fileNames[i] + "-tmp") != sizeof(unsigned int)) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
-				}
+	tileCheckSums.clear();
+	tileCheckSums.resize(xtiles * ztiles, 0);
 
-				fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::in | std::ios::binary);
-				fileStreams[i]->read(reinterpret_cast<char*>(&fileSizes[i]), sizeof(unsigned int));
-				fileStreams[i]->close();
+	for (unsigned int tz = 0; tz < ztiles; tz++) {
+		for (unsigned int tx = 0; tx < xtiles; tx++) {
+			const int x1 = tx * QTPFS_SNAPSHOT_TILE_SIZE, x2 = std::min(x1 + QTPFS_SNAPSHOT_TILE_SIZE, mapDims.mapx);
+			const int z1 = tz * QTPFS_SNAPSHOT_TILE_SIZE, z2 = std::min(z1 + QTPFS_SNAPSHOT_TILE_SIZE, mapDims.mapy);
 
-				while (!FileSystem::FileExists(fileNames[i])) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
-				}
-				while (FileSystem::GetFileSize(fileNames[i]) != fileSizes[i]) {
-					spring::this_thread::sleep_for(std::chrono::milliseconds(100));
+			std::uint32_t checkSum = 0;
+
+			// corner heights (including those on the far edges), which the
+			// mip-heights and slopes used by GetPosSpeedMod are derived from
+			for (int z = z1; z <= z2; z++) {
+				checkSum = HsiehHash(&cornerHeightMap[z * mapDims.mapxp1 + x1], (x2 - x1 + 1) * sizeof(float), checkSum);
+			}
+			// terrain types (half resolution)
+			for (int z = (z1 >> 1); z < (z2 >> 1); z++) {
+				checkSum = HsiehHash(&typeMap[z * mapDims.hmapx + (x1 >> 1)], (x2 >> 1) - (x1 >> 1), checkSum);
+			}
+			// blocking objects and the state ObjectBlockType looks at
+			for (int z = z1; z < z2; z++) {
+				for (int x = x1; x < x2; x++) {
+					const unsigned int sqrIdx = z * mapDims.mapx + x;
+					const BlockingMapCell& cell = groundBlockingObjectMap.GetCellUnsafeConst(sqrIdx);
+
+					if (cell.empty())
+						continue;
+
+					checkSum = HsiehHash(&sqrIdx, sizeof(sqrIdx), checkSum);
+
+					for (const CSolidObject* obj: cell) {
+						const int objID = obj->GetBlockingMapID();
+						const unsigned int objState = (obj->collidableState << 2) | (obj->crushable << 1) | (obj->immobile << 0);
+
+						checkSum = HsiehHash(&objID, sizeof(objID), checkSum);
+						checkSum = HsiehHash(&objState, sizeof(objState), checkSum);
+						checkSum = HsiehHash(&obj->crushResistance, sizeof(obj->crushResistance), checkSum);
+					}
 				}
 			}
-			#else
-			assert(FileSystem::FileExists(fileNames[i]));
-			#endif
 
-			// read fileNames[i] into nodeTrees[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::in | std::ios::binary);
-			assert(fileStreams[i]->good());
-			assert(nodeTrees[i]->IsLeaf());
-		} else {
-			// write nodeTrees[i] into fileNames[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::out | std::ios::binary);
+			tileCheckSums[tz * xtiles + tx] = checkSum;
 		}
+	}
+}
 
-		#ifndef NDEBUG
-		sprintf(loadMsg, fmtString, __func__, i, md->name.c_str());
-		pmLoadScreen.AddLoadMessage(loadMsg);
-		#endif
+// a snapshot holds the tile checksums at the time it was written,
+// followed by the layer's speed{Mods, Bins} and its tree; on load
+// the tiles whose checksum differs (and those near enough to them
+// to be affected via slopes or footprints) are updated as if by a
+// terrain change, after which the tree is made to match what full
+// construction would produce over the current terrain
+bool QTPFS::PathManager::ReadNodeLayer(unsigned int layerNum) {
+	const MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
+	const std::string& fileName = GetCacheFileName(layerNum);
 
-		nodeTrees[i]->Serialize(*fileStreams[i], nodeLayers[i], &fileSizes[i], haveCacheDir);
+	NodeLayer& nodeLayer = nodeLayers[layerNum];
+	QTNode* nodeTree = nodeTrees[layerNum];
 
-		fileStreams[i]->flush();
-		fileStreams[i]->close();
+	unsigned int fileSize = 0;
 
-		#ifdef QTPFS_CACHE_XACCESS
-		if (!haveCacheDir) {
-			// signal any other (concurrently loading) Spring processes; needed for validation-tests
-			fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::out | std::ios::binary);
-			fileStreams[i]->write(reinterpret_cast<const char*>(&fileSizes[i]), sizeof(unsigned int));
-			fileStreams[i]->flush();
-			fileStreams[i]->close();
+	#ifdef QTPFS_CACHE_XACCESS
+	{
+		// FIXME: lock fileName instead of doing this
+		// fstreams can not be easily locked however, see
+		// http://stackoverflow.com/questions/839856/
+		while (!FileSystem::FileExists(fileName + "-tmp")) {
+			spring::this_thread::sleep_for(std::chrono::milliseconds(100));
 		}
-		#endif
+		while (FileSystem::GetFileSize(fileName + "-tmp") != sizeof(unsigned int)) {
+			spring::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+
+		std::fstream sizeStream((fileName + "-tmp").c_str(), std::ios::in | std::ios::binary);
+		sizeStream.read(reinterpret_cast<char*>(&fileSize), sizeof(unsigned int));
+		sizeStream.close();
 
-		delete fileStreams[i];
+		while (!FileSystem::FileExists(fileName)) {
+			spring::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+		while (FileSystem::GetFileSize(fileName) != fileSize) {
+			spring::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
 	}
+	#else
+	if (!FileSystem::FileExists(fileName))
+		return false;
+	#endif
+
+	std::fstream fileStream(fileName.c_str(), std::ios::in | std::ios::binary);
+
+	unsigned int tileSize = 0;
+	unsigned int numTiles = 0;
+
+	fileStream.read(reinterpret_cast<char*>(&tileSize), sizeof(unsigned int));
+	fileStream.read(reinterpret_cast<char*>(&numTiles), sizeof(unsigned int));
+
+	if (!fileStream.good() || tileSize != QTPFS_SNAPSHOT_TILE_SIZE || numTiles != tileCheckSums.size())
+		return false;
+
+	std::vector<std::uint32_t> snapshotCheckSums(numTiles, 0);
+
+	assert(nodeTree->IsLeaf());
+
+	fileStream.read(reinterpret_cast<char*>(&snapshotCheckSums[0]), numTiles * sizeof(std::uint32_t));
+	nodeLayer.Serialize(fileStream, &fileSize, true);
+	nodeTree->Serialize(fileStream, nodeLayer, &fileSize, true);
+
+	if (!fileStream.good()) {
+		// truncated, discard whatever was read
+		nodeTree->Delete();
+		nodeLayer.Clear();
+
+		InitNodeLayer(layerNum, MAP_RECTANGLE);
+		return false;
+	}
+
+	const int xtiles = (mapDims.mapx + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE;
+	const int ztiles = (mapDims.mapy + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE;
+	// a changed square can alter the speedmods of squares up to two away
+	// (slopes are averaged over neighbors) and blocking state of those in
+	// a footprint's reach
+	const int margin = (std::max(md->xsizeh, md->zsizeh) + 2 + QTPFS_SNAPSHOT_TILE_SIZE - 1) / QTPFS_SNAPSHOT_TILE_SIZE;
+
+	std::vector<unsigned char> dirtyTiles(numTiles, 0);
+	std::vector<SRectangle> dirtyRects;
+
+	for (int tz = 0; tz < ztiles; tz++) {
+		for (int tx = 0; tx < xtiles; tx++) {
+			if (snapshotCheckSums[tz * xtiles + tx] == tileCheckSums[tz * xtiles + tx])
+				continue;
+
+			for (int z = std::max(tz - margin, 0); z <= std::min(tz + margin, ztiles - 1); z++) {
+				for (int x = std::max(tx - margin, 0); x <= std::min(tx + margin, xtiles - 1); x++) {
+					dirtyTiles[z * xtiles + x] = 1;
+				}
+			}
+		}
+	}
+
+	for (int tz = 0; tz < ztiles; tz++) {
+		for (int tx = 0; tx < xtiles; tx++) {
+			if (dirtyTiles[tz * xtiles + tx] == 0)
+				continue;
+
+			const int x1 = tx * QTPFS_SNAPSHOT_TILE_SIZE, x2 = std::min(x1 + QTPFS_SNAPSHOT_TILE_SIZE, mapDims.mapx);
+			const int z1 = tz * QTPFS_SNAPSHOT_TILE_SIZE, z2 = std::min(z1 + QTPFS_SNAPSHOT_TILE_SIZE, mapDims.mapy);
+
+			dirtyRects.emplace_back(x1, z1, x2, z2);
+			nodeLayer.Update(dirtyRects.back(), md);
+		}
+	}
+
+	if (!dirtyRects.empty()) {
+		// the average is not used for pathing and stays at its snapshot value
+		nodeLayer.UpdateMaxRelSpeedMod();
+		nodeTree->ReTesselate(nodeLayer, dirtyRects);
+	}
+
+	numDirtyTiles[layerNum] = dirtyRects.size();
+	return true;
+}
+
+void QTPFS::PathManager::WriteNodeLayer(unsigned int layerNum) {
+	const std::string& fileName = GetCacheFileName(layerNum);
+
+	const unsigned int tileSize = QTPFS_SNAPSHOT_TILE_SIZE;
+	const unsigned int numTiles = tileCheckSums.size();
+
+	unsigned int fileSize = (2 * sizeof(unsigned int)) + (numTiles * sizeof(std::uint32_t));
+
+	// TODO: compress the snapshot files?
+	std::fstream fileStream(fileName.c_str(), std::ios::out | std::ios::binary);
+
+	fileStream.write(reinterpret_cast<const char*>(&tileSize), sizeof(unsigned int));
+	fileStream.write(reinterpret_cast<const char*>(&numTiles), sizeof(unsigned int));
+	fileStream.write(reinterpret_cast<const char*>(&tileCheckSums[0]), numTiles * sizeof(std::uint32_t));
+
+	nodeLayers[layerNum].Serialize(fileStream, &fileSize, false);
+	nodeTrees[layerNum]->Serialize(fileStream, nodeLayers[layerNum], &fileSize, false);
+
+	fileStream.flush();
+	fileStream.close();
+
+	#ifdef QTPFS_CACHE_XACCESS
+	// signal any other (concurrently loading) Spring processes; needed for validation-tests
+	fileStream.open((fileName + "-tmp").c_str(), std::ios::out | std::ios::binary);
+	fileStream.write(reinterpret_cast<const char*>(&fileSize), sizeof(unsigned int));
+	fileStream.flush();
+	fileStream.close();
+	#endif
 }
 
 
@@ -650,180 +681,193 @@ void QTPFS::PathManager::TerrainChange(unsigned int x1, unsigned int z1,  unsign
 void QTPFS::PathManager::Update() {
 	SCOPED_TIMER("Sim::Path");
 
-	#ifdef QTPFS_ENABLE_THREADED_UPDATE
-	streflop::streflop_init<streflop::Simple>();
+	// NOTE:
+	//     for a mod with N move-types, any unit will be waiting
+	//     (N / LAYERS_PER_UPDATE) sim-frames before its request
+	//     executes at a minimum
+	const unsigned int layersPerUpdateTmp = LAYERS_PER_UPDATE;
+	const unsigned int numPathTypeUpdates = std::min(static_cast<unsigned int>(nodeLayers.size()), layersPerUpdateTmp);
+
+	// NOTE: thread-safe (only the sim-thread ever accesses these)
+	static unsigned int minPathTypeUpdate = 0;
+	static unsigned int maxPathTypeUpdate = numPathTypeUpdates;
+
+	#ifndef QTPFS_IGNORE_DEAD_PATHS
+	for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+		QueueDeadPathSearches(pathTypeUpdate);
+	}
+	#endif
 
-	std::lock_guard<spring::mutex> lock(*mutexThreadUpdate);
+	// NOTE:
+	//   layers share no state (node search-states live in their trees), so
+	//   each is updated and searched by its own pool-task; the updates *must*
+	//   happen between QueueDeadPathSearches and AdmitQueuedSearches because
+	//   the latter looks up the source- and target-nodes in the updated trees
+	#ifdef QTPFS_STAGGERED_LAYER_UPDATES
+	for_mt(minPathTypeUpdate, maxPathTypeUpdate, [&](const int pathTypeUpdate) {
+		ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
+	});
+	#endif
 
-	// allow ThreadUpdate to run one iteration
-	condThreadUpdate->notify_one();
+	// team search-limits span all layers, so admit sequentially
+	for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+		AdmitQueuedSearches(pathTypeUpdate);
+	}
 
-	// wait for the ThreadUpdate iteration to finish
-	condThreadUpdated->wait(lock);
+	for_mt(minPathTypeUpdate, maxPathTypeUpdate, [&](const int pathTypeUpdate) {
+		ExecuteQueuedSearches(pathTypeUpdate);
+	});
 
-	streflop::streflop_init<streflop::Simple>();
-	#else
-	ThreadUpdate();
-	#endif
-}
+	// outcomes are published in layer order, not in order of completion
+	for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+		FinishQueuedSearches(pathTypeUpdate);
+	}
 
-__FORCE_ALIGN_STACK__
-void QTPFS::PathManager::ThreadUpdate() {
-	#ifdef QTPFS_ENABLE_THREADED_UPDATE
-	while (!nodeLayers.empty()) {
-		std::lock_guard<spring::mutex> lock(*mutexThreadUpdate);
+	std::copy(numCurrExecutedSearches.begin(), numCurrExecutedSearches.end(), numPrevExecutedSearches.begin());
 
-		// wait for green light from Update
-		condThreadUpdate->wait(lock);
+	minPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
+	maxPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
+
+	if (minPathTypeUpdate >= nodeLayers.size()) {
+		minPathTypeUpdate = 0;
+		maxPathTypeUpdate = numPathTypeUpdates;
+	}
+	if (maxPathTypeUpdate >= nodeLayers.size()) {
+		maxPathTypeUpdate = nodeLayers.size();
+	}
+}
 
-		// if we were notified from the destructor, then structures
-		// are no longer valid and there is no point to finish this
-		// iteration --> break early to avoid crashing
-		if (nodeLayers.empty()) {
-			break;
-		}
-	#endif
 
-		// NOTE:
-		//     for a mod with N move-types, any unit will be waiting
-		//     (N / LAYERS_PER_UPDATE) sim-frames before its request
-		//     executes at a minimum
-		const unsigned int layersPerUpdateTmp = LAYERS_PER_UPDATE;
-		const unsigned int numPathTypeUpdates = std::min(static_cast<unsigned int>(nodeLayers.size()), layersPerUpdateTmp);
 
-		// NOTE: thread-safe (only ONE thread ever accesses these)
-		static unsigned int minPathTypeUpdate = 0;
-		static unsigned int maxPathTypeUpdate = numPathTypeUpdates;
+// moves the searches of a layer that may run this Update from its queue
+// into its batch (RequestPath and QueueDeadPathSearches fill the queues)
+void QTPFS::PathManager::AdmitQueuedSearches(unsigned int pathType) {
+	NodeLayer& nodeLayer = nodeLayers[pathType];
+	PathCache& pathCache = pathCaches[pathType];
+	SearchBatch& searchBatch = searchBatches[pathType];
 
-		sharedPaths.clear();
+	std::vector<IPathSearch*>& searches = pathSearches[pathType];
 
-		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
-			#ifndef QTPFS_IGNORE_DEAD_PATHS
-			QueueDeadPathSearches(pathTypeUpdate);
-			#endif
+	// maps "hashes" of admitted searches to the batch-index of the last one executing
+	SharedPathMap sharedPaths;
 
-			#ifdef QTPFS_STAGGERED_LAYER_UPDATES
-			// NOTE: *must* be called between QueueDeadPathSearches and ExecuteQueuedSearches
-			ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
-			#endif
+	unsigned int numQueuedSearches = 0;
 
-			ExecuteQueuedSearches(pathTypeUpdate);
-		}
+	searchBatch.Clear();
 
-		std::copy(numCurrExecutedSearches.begin(), numCurrExecutedSearches.end(), numPrevExecutedSearches.begin());
+	for (IPathSearch* search: searches) {
+		IPath* path = pathCache.GetTempPath(search->GetID());
 
-		minPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
-		maxPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
+		assert(search != nullptr);
+		assert(path != nullptr);
 
-		if (minPathTypeUpdate >= nodeLayers.size()) {
-			minPathTypeUpdate = 0;
-			maxPathTypeUpdate = numPathTypeUpdates;
-		}
-		if (maxPathTypeUpdate >= nodeLayers.size()) {
-			maxPathTypeUpdate = nodeLayers.size();
+		// temp-path might have been removed already via
+		// DeletePath before we got a chance to process it
+		if (path->GetID() == 0) {
+			delete search;
+			continue;
 		}
 
-	#ifdef QTPFS_ENABLE_THREADED_UPDATE
-		// tell Update we are finished with this iteration
-		condThreadUpdated->notify_one();
-	}
-	#endif
-}
+		assert(search->GetID() != 0);
+		assert(path->GetID() == search->GetID());
 
+		search->Initialize(&nodeLayer, &pathCache, path->GetSourcePoint(), path->GetTargetPoint(), MAP_RECTANGLE);
+		path->SetHash(search->GetHash(mapDims.mapx * mapDims.mapy, pathType));
 
+		int leaderIdx = -1;
 
-void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
-	NodeLayer& nodeLayer = nodeLayers[pathType];
-	PathCache& pathCache = pathCaches[pathType];
+		#ifdef QTPFS_SEARCH_SHARED_PATHS
+		const SharedPathMapIt sharedPathsIt = sharedPaths.find(path->GetHash());
 
-	std::vector<IPathSearch*>& searches = pathSearches[pathType];
-	std::vector<IPathSearch*>::iterator searchesIt = searches.begin();
-
-	if (!searches.empty()) {
-		// execute pending searches collected via
-		// RequestPath and QueueDeadPathSearches
-		while (searchesIt != searches.end()) {
-			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
-			}
-		}
-	}
-}
+		if (sharedPathsIt != sharedPaths.end())
+			leaderIdx = sharedPathsIt->second;
+		#endif
 
-bool QTPFS::PathManager::ExecuteSearch(
-	PathSearchVect& searches,
-	PathSearchVectIt& searchesIt,
-	NodeLayer& nodeLayer,
-	PathCache& pathCache,
-	unsigned int pathType
-) {
-	IPathSearch* search = *searchesIt;
-	IPath* path = pathCache.GetTempPath(search->GetID());
+		if (leaderIdx == -1) {
+			#ifdef QTPFS_LIMIT_TEAM_SEARCHES
+			const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
+			const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
 
-	assert(search != nullptr);
-	assert(path != nullptr);
+			if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
+				searches[numQueuedSearches++] = search;
+				continue;
+			}
 
-	const auto DeleteSearch = [](IPathSearch* s, PathSearchVect& v, PathSearchVectIt& it) {
-		// ordering of still-queued searches is not relevant
-		*it = v.back();
-		v.pop_back();
-		delete s;
-	};
+			numCurrExecutedSearches[search->GetTeam()] += 1;
+			#endif
 
-	// temp-path might have been removed already via
-	// DeletePath before we got a chance to process it
-	if (path->GetID() == 0) {
-		DeleteSearch(search, searches, searchesIt);
-		return false;
+			#ifdef QTPFS_SEARCH_SHARED_PATHS
+			sharedPaths[path->GetHash()] = searchBatch.searches.size();
+			#endif
+		}
+
+		searchBatch.searches.push_back(search);
+		searchBatch.paths.push_back(path);
+		searchBatch.leaders.push_back(leaderIdx);
+		searchBatch.results.push_back(SearchBatch::SEARCH_FAILED);
 	}
 
-	assert(search->GetID() != 0);
-	assert(path->GetID() == search->GetID());
+	// still-queued searches keep their relative order
+	searches.resize(numQueuedSearches);
+}
 
-	search->Initialize(&nodeLayer, &pathCache, path->GetSourcePoint(), path->GetTargetPoint(), MAP_RECTANGLE);
-	path->SetHash(search->GetHash(mapDims.mapx * mapDims.mapy, pathType));
+// runs on a pool-thread; touches nothing outside of this layer
+void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
+	SearchBatch& searchBatch = searchBatches[pathType];
 
-	{
-		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
+	for (unsigned int n = 0; n < searchBatch.searches.size(); n++) {
+		IPathSearch* search = searchBatch.searches[n];
+		IPath* path = searchBatch.paths[n];
 
-		if (sharedPathsIt != sharedPaths.end()) {
-			if (search->SharedFinalize(sharedPathsIt->second, path)) {
-				DeleteSearch(search, searches, searchesIt);
-				return false;
-			}
-		}
-		#endif
+		const int leaderIdx = searchBatch.leaders[n];
 
-		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
-		const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
-		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
+		if (leaderIdx != -1) {
+			// leaders always precede their followers in a batch; a follower whose
+			// leader failed or ended too far from its own target gets re-queued
+			const bool shared =
+				(searchBatch.results[leaderIdx] == SearchBatch::SEARCH_SUCCEEDED) &&
+				search->SharedFinalize(searchBatch.paths[leaderIdx], path);
 
-		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
-			++searchesIt; return false;
+			searchBatch.results[n] = shared? SearchBatch::SEARCH_SUCCEEDED: SearchBatch::SEARCH_REQUEUED;
+			continue;
 		}
 
-		numCurrExecutedSearches[search->GetTeam()] += 1;
-		#endif
-	}
+		// removes path from temp-paths, adds it to live-paths
+		if (search->Execute(searchStateOffsets[pathType], numTerrainChanges)) {
+			search->Finalize(path);
+			searchBatch.results[n] = SearchBatch::SEARCH_SUCCEEDED;
+		}
 
-	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
-		search->Finalize(path);
+		searchStateOffsets[pathType] += NODE_STATE_OFFSET;
+	}
+}
 
-		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		sharedPaths[path->GetHash()] = path;
-		#endif
+void QTPFS::PathManager::FinishQueuedSearches(unsigned int pathType) {
+	SearchBatch& searchBatch = searchBatches[pathType];
+
+	for (unsigned int n = 0; n < searchBatch.searches.size(); n++) {
+		IPathSearch* search = searchBatch.searches[n];
+
+		switch (searchBatch.results[n]) {
+			case SearchBatch::SEARCH_REQUEUED: {
+				pathSearches[pathType].push_back(search);
+				continue;
+			} break;
+			case SearchBatch::SEARCH_FAILED: {
+				DeletePath(search->GetID());
+			} break;
+			case SearchBatch::SEARCH_SUCCEEDED: {
+				#ifdef QTPFS_TRACE_PATH_SEARCHES
+				if (searchBatch.leaders[n] == -1)
+					pathTraces[search->GetID()] = search->GetExecutionTrace();
+				#endif
+			} break;
+		}
 
-		#ifdef QTPFS_TRACE_PATH_SEARCHES
-		pathTraces[path->GetID()] = search->GetExecutionTrace();
-		#endif
-	} else {
-		DeletePath(path->GetID());
+		delete search;
 	}
 
-	DeleteSearch(search, searches, searchesIt);
-	return true;
+	searchBatch.Clear();
 }
 
 void QTPFS::PathManager::QueueDeadPathSearches(unsigned int pathType) {
@@ -15,14 +15,6 @@ struct MoveDef;
 struct SRectangle;
 class CSolidObject;
 
-#ifdef QTPFS_ENABLE_THREADED_UPDATE
-namespace spring {
-	class mutex;
-	class thread;
-	class condition_variable;
-};
-#endif
-
 namespace QTPFS {
 	struct QTNode;
 	class PathManager: public IPathManager {
@@ -71,40 +63,46 @@ namespace QTPFS {
 		int2 GetNumQueuedUpdates() const override;
 
 	private:
-		void ThreadUpdate();
 		void Load();
 
 		std::uint64_t GetMemFootPrint() const;
 
-		typedef void (PathManager::*MemberFunc)(
-			unsigned int threadNum,
-			unsigned int numThreads,
-			const SRectangle& rect
-		);
 		typedef spring::unordered_map<unsigned int, unsigned int> PathTypeMap;
 		typedef spring::unordered_map<unsigned int, unsigned int>::iterator PathTypeMapIt;
 		typedef spring::unordered_map<unsigned int, PathSearchTrace::Execution*> PathTraceMap;
 		typedef spring::unordered_map<unsigned int, PathSearchTrace::Execution*>::iterator PathTraceMapIt;
-		typedef spring::unordered_map<std::uint64_t, IPath*> SharedPathMap;
-		typedef spring::unordered_map<std::uint64_t, IPath*>::iterator SharedPathMapIt;
+		typedef spring::unordered_map<std::uint64_t, unsigned int> SharedPathMap;
+		typedef spring::unordered_map<std::uint64_t, unsigned int>::iterator SharedPathMapIt;
 
 		typedef std::vector<IPathSearch*> PathSearchVect;
 		typedef std::vector<IPathSearch*>::iterator PathSearchVectIt;
 
-		void SpawnSpringThreads(MemberFunc f, const SRectangle& r);
+		// searches admitted for execution on one layer during an Update, and
+		// their outcomes; each batch is only written by the pool-thread that
+		// executes it and consumed on the sim-thread after all have finished
+		struct SearchBatch {
+			enum {
+				SEARCH_FAILED    = 0,
+				SEARCH_SUCCEEDED = 1,
+				SEARCH_REQUEUED  = 2,
+			};
+
+			void Clear() {
+				searches.clear();
+				paths.clear();
+				leaders.clear();
+				results.clear();
+			}
+
+			std::vector<IPathSearch*> searches;
+			std::vector<IPath*> paths;
+			// index of the search whose path is shared, or -1 if executed
+			std::vector<int> leaders;
+			std::vector<unsigned char> results;
+		};
 
 		void InitNodeLayersThreaded(const SRectangle& rect);
 		void UpdateNodeLayersThreaded(const SRectangle& rect);
-		void InitNodeLayersThread(
-			unsigned int threadNum,
-			unsigned int numThreads,
-			const SRectangle& rect
-		);
-		void UpdateNodeLayersThread(
-			unsigned int threadNum,
-			unsigned int numThreads,
-			const SRectangle& rect
-		);
 		void InitNodeLayer(unsigned int layerNum, const SRectangle& r);
 		void UpdateNodeLayer(unsigned int layerNum, const SRectangle& r);
 
@@ -113,7 +111,9 @@ namespace QTPFS {
 		void ExecQueuedNodeLayerUpdates(unsigned int layerNum, bool flushQueue);
 		#endif
 
+		void AdmitQueuedSearches(unsigned int pathType);
 		void ExecuteQueuedSearches(unsigned int pathType);
+		void FinishQueuedSearches(unsigned int pathType);
 		void QueueDeadPathSearches(unsigned int pathType);
 
 		unsigned int QueueSearch(
@@ -126,38 +126,42 @@ namespace QTPFS {
 			const bool synced
 		);
 
-		bool ExecuteSearch(
-			PathSearchVect& searches,
-			PathSearchVectIt& searchesIt,
-			NodeLayer& nodeLayer,
-			PathCache& pathCache,
-			unsigned int pathType
-		);
-
 		bool IsFinalized() const { return (!nodeTrees.empty()); }
 
 
 		std::string GetCacheDirName(const std::string& mapCheckSumHexStr, const std::string& modCheckSumHexStr) const;
-		void Serialize(const std::string& cacheFileDir);
+		std::string GetCacheFileName(unsigned int layerNum) const;
+
+		void InitTileCheckSums();
+		bool ReadNodeLayer(unsigned int layerNum);
+		void WriteNodeLayer(unsigned int layerNum);
 
 		std::vector<NodeLayer> nodeLayers;
 		std::vector<QTNode*> nodeTrees;
 		std::vector<PathCache> pathCaches;
 		std::vector< std::vector<IPathSearch*> > pathSearches;
+		std::vector<SearchBatch> searchBatches;
 
 		spring::unordered_map<unsigned int, unsigned int> pathTypes;
 		spring::unordered_map<unsigned int, PathSearchTrace::Execution*> pathTraces;
 
-		// maps "hashes" of executed searches to the found paths
-		spring::unordered_map<std::uint64_t, IPath*> sharedPaths;
-
 		std::vector<unsigned int> numCurrExecutedSearches;
 		std::vector<unsigned int> numPrevExecutedSearches;
 
+		// terrain and blocking state of each QTPFS_SNAPSHOT_TILE_SIZE^2
+		// region at load-time, compared against those a snapshot holds
+		std::vector<std::uint32_t> tileCheckSums;
+		// number of tiles each layer had to rebuild, -1 if it had no snapshot
+		std::vector<int> numDirtyTiles;
+
+		std::string cacheDirName;
+
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
 
-		unsigned int searchStateOffset;
+		// per layer, since searches on different layers run concurrently
+		std::vector<unsigned int> searchStateOffsets;
+
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
@@ -166,13 +170,6 @@ namespace QTPFS {
 
 		bool layersInited;
 		bool haveCacheDir;
-
-		#ifdef QTPFS_ENABLE_THREADED_UPDATE
-		spring::thread* updateThread;
-		spring::mutex* mutexThreadUpdate;
-		spring::condition_variable* condThreadUpdate;
-		spring::condition_variable* condThreadUpdated;
-		#endif
 	};
 }
 
@@ -122,6 +122,7 @@ namespace QTPFS {
 			: IPathSearch(pathSearchType)
 			, nodeLayer(NULL)
 			, pathCache(NULL)
+			, openNodes(NULL)
 			, searchExec(NULL)
 			, srcNode(NULL)
 			, tgtNode(NULL)
@@ -132,7 +133,7 @@ namespace QTPFS {
 			, haveFullPath(false)
 			, havePartPath(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
+		~PathSearch() {}
 
 		void Initialize(
 			NodeLayer* layer,
@@ -151,8 +152,8 @@ namespace QTPFS {
 
 		const std::uint64_t GetHash(std::uint64_t N, std::uint32_t k) const;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
+		static void InitGlobalQueue(unsigned int n);
+		static void FreeGlobalQueue();
 
 	private:
 		void ResetState(INode* node);
@@ -165,9 +166,15 @@ namespace QTPFS {
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
+		// global queues (one per pool thread, since searches on different layers
+		// run concurrently): each is allocated on first use and then re-used by
+		// all searches executing on that thread without clear()'s
 		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
+		static std::vector< binary_heap<INode*> > openNodeQueues;
+		static unsigned int openNodeQueueSize;
+
+		// queue of the thread executing this search
+		binary_heap<INode*>* openNodes;
 
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
@@ -0,0 +1,424 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cassert>
+
+#include "ProjectileBroadphase.h"
+
+#ifndef UNIT_TEST
+	#include "Projectile.h"
+	#include "Sim/Features/Feature.h"
+	#include "Sim/Features/FeatureHandler.h"
+	#include "Sim/Misc/CollisionVolume.h"
+	#include "Sim/Misc/GlobalSynced.h"
+	#include "Sim/Units/Unit.h"
+	#include "Sim/Units/UnitDef.h"
+	#include "Sim/Units/UnitHandler.h"
+	#include "Sim/Weapons/PlasmaRepulser.h"
+	#include "Sim/Weapons/WeaponDef.h"
+#endif
+
+
+static bool SolidEntryLess(const CProjectileBroadphase::SolidEntry& a, const CProjectileBroadphase::SolidEntry& b)
+{
+	if (a.minX != b.minX)
+		return (a.minX < b.minX);
+	if (a.type != b.type)
+		return (a.type < b.type);
+	if (a.id != b.id)
+		return (a.id < b.id);
+
+	return (a.sub < b.sub);
+}
+
+static bool ProjectileEntryLess(const CProjectileBroadphase::ProjectileEntry& a, const CProjectileBroadphase::ProjectileEntry& b)
+{
+	if (a.minX != b.minX)
+		return (a.minX < b.minX);
+
+	return (a.index < b.index);
+}
+
+template<typename A, typename B>
+static bool OverlapZ(const A& a, const B& b)
+{
+	return (a.minZ <= b.maxZ && b.minZ <= a.maxZ);
+}
+
+// removes (unordered) all active entries ending before <minX>
+template<typename T>
+static void PruneActive(std::vector<int>& active, const float minX, const std::vector<T>& entries)
+{
+	for (size_t k = 0; k < active.size(); ) {
+		if (entries[active[k]].maxX >= minX) {
+			k++;
+		} else {
+			active[k] = active.back();
+			active.pop_back();
+		}
+	}
+}
+
+
+void CProjectileBroadphase::Kill()
+{
+	solids.clear();
+	projectiles.clear();
+	pairs.clear();
+
+	activeSolids.clear();
+	activeProjectiles.clear();
+
+	numSweptProjectiles = 0;
+	pairIndex = 0;
+}
+
+
+void CProjectileBroadphase::SortSolids(size_t numTracked)
+{
+	assert(numTracked <= solids.size());
+
+	// tracked entries move only a little between frames, so this prefix is
+	// nearly sorted and insertion sort runs in close to linear time; give up
+	// once it degrades (e.g. after mass teleports) and sort it from scratch
+	const size_t maxShifts = numTracked * 8;
+
+	size_t numShifts = 0;
+
+	for (size_t i = 1; i < numTracked && numShifts <= maxShifts; i++) {
+		const SolidEntry e = solids[i];
+
+		size_t j = i;
+
+		for (; j > 0 && SolidEntryLess(e, solids[j - 1]); j--) {
+			solids[j] = solids[j - 1];
+		}
+
+		solids[j] = e;
+		numShifts += (i - j);
+	}
+
+	if (numShifts > maxShifts)
+		std::sort(solids.begin(), solids.begin() + numTracked, SolidEntryLess);
+
+	// newly appended entries are in arbitrary order
+	std::sort(solids.begin() + numTracked, solids.end(), SolidEntryLess);
+	std::inplace_merge(solids.begin(), solids.begin() + numTracked, solids.end(), SolidEntryLess);
+}
+
+
+void CProjectileBroadphase::SweepEntries()
+{
+	pairs.clear();
+	pairIndex = 0;
+
+	std::sort(projectiles.begin(), projectiles.end(), ProjectileEntryLess);
+
+	activeSolids.clear();
+	activeProjectiles.clear();
+
+	// single sweep along x; an interval becomes active at its minimum
+	// and is paired with every active interval of the other kind that
+	// has not ended yet
+	for (size_t pi = 0, si = 0, np = projectiles.size(), ns = solids.size(); pi < np || si < ns; ) {
+		if (si >= ns || (pi < np && projectiles[pi].minX <= solids[si].minX)) {
+			const ProjectileEntry& pe = projectiles[pi];
+
+			PruneActive(activeSolids, pe.minX, solids);
+
+			for (const int k: activeSolids) {
+				if (!OverlapZ(pe, solids[k]))
+					continue;
+
+				pairs.push_back({pe.index, k});
+			}
+
+			activeProjectiles.push_back(pi++);
+		} else {
+			const SolidEntry& se = solids[si];
+
+			PruneActive(activeProjectiles, se.minX, projectiles);
+
+			for (const int k: activeProjectiles) {
+				if (!OverlapZ(se, projectiles[k]))
+					continue;
+
+				pairs.push_back({projectiles[k].index, static_cast<int>(si)});
+			}
+
+			activeSolids.push_back(si++);
+		}
+	}
+
+	// group by projectile (in container order) with a counting sort, since
+	// sorting all pairs at once dominates the sweep in crowded battles
+	{
+		int numIndices = 0;
+
+		for (const ProjectileEntry& pe: projectiles) {
+			numIndices = std::max(numIndices, pe.index + 1);
+		}
+
+		pairOffsets.clear();
+		pairOffsets.resize(numIndices + 1, 0);
+		sortedPairs.resize(pairs.size());
+
+		for (const CandidatePair& cp: pairs) {
+			pairOffsets[cp.projIndex + 1] += 1;
+		}
+		for (int i = 0; i < numIndices; i++) {
+			pairOffsets[i + 1] += pairOffsets[i];
+		}
+		for (const CandidatePair& cp: pairs) {
+			sortedPairs[pairOffsets[cp.projIndex]++] = cp;
+		}
+
+		pairs.swap(sortedPairs);
+	}
+
+	// order the (few) candidates of each projectile by (type, id)
+	const auto pairLess = [&](const CandidatePair& a, const CandidatePair& b) {
+		const SolidEntry& sa = solids[a.solidIndex];
+		const SolidEntry& sb = solids[b.solidIndex];
+
+		if (sa.type != sb.type)
+			return (sa.type < sb.type);
+		if (sa.id != sb.id)
+			return (sa.id < sb.id);
+
+		return (sa.sub < sb.sub);
+	};
+
+	for (size_t i = 0, j = 0, n = pairs.size(); i < n; i = j) {
+		for (j = i + 1; j < n && pairs[j].projIndex == pairs[i].projIndex; j++);
+
+		std::sort(pairs.begin() + i, pairs.begin() + j, pairLess);
+	}
+}
+
+
+
+#ifndef UNIT_TEST
+bool CProjectileBroadphase::RefreshSolid(SolidEntry& e) const
+{
+	float3 pos;
+	float rad = 0.0f;
+
+	switch (e.type) {
+		case SOLID_TYPE_UNIT: {
+			const CUnit* u = unitHandler.GetUnit(e.id);
+
+			// units are only collidable while linked into the QuadField
+			if (u != e.object || u->quads.empty())
+				return false;
+
+			pos = u->collisionVolume.GetWorldSpacePos(u);
+			rad = u->collisionVolume.GetBoundingRadius();
+		} break;
+
+		case SOLID_TYPE_FEATURE: {
+			const CFeature* f = featureHandler.GetFeature(e.id);
+
+			if (f != e.object)
+				return false;
+
+			pos = f->collisionVolume.GetWorldSpacePos(f);
+			rad = f->collisionVolume.GetBoundingRadius();
+		} break;
+
+		case SOLID_TYPE_REPULSER: {
+			const CUnit* u = unitHandler.GetUnit(e.id);
+
+			if (u == nullptr || e.sub >= static_cast<int>(u->weapons.size()) || u->weapons[e.sub] != e.object)
+				return false;
+
+			const CPlasmaRepulser* r = static_cast<const CPlasmaRepulser*>(e.object);
+
+			if (r->GetQuads().empty())
+				return false;
+
+			pos = r->weaponMuzzlePos;
+			rad = r->collisionVolume.GetBoundingRadius();
+		} break;
+
+		default: {
+			assert(false);
+		} break;
+	}
+
+	e.minX = pos.x - rad;
+	e.maxX = pos.x + rad;
+	e.minZ = pos.z - rad;
+	e.maxZ = pos.z + rad;
+	return true;
+}
+
+void CProjectileBroadphase::AddSolid(int type, int id, int sub, void* object)
+{
+	solids.push_back({0.0f, 0.0f, 0.0f, 0.0f, type, id, sub, object});
+
+	if (RefreshSolid(solids.back()))
+		return;
+
+	solids.pop_back();
+}
+
+void CProjectileBroadphase::UpdateSolids()
+{
+	const int tempNum = gs->GetTempNum();
+
+	// refresh tracked entries and drop those whose object died or left the QuadField
+	{
+		size_t n = 0;
+
+		for (size_t i = 0; i < solids.size(); i++) {
+			SolidEntry& e = solids[i];
+
+			if (!RefreshSolid(e))
+				continue;
+
+			switch (e.type) {
+				case SOLID_TYPE_UNIT    : { static_cast<CUnit*          >(e.object)->tempNum = tempNum; } break;
+				case SOLID_TYPE_FEATURE : { static_cast<CFeature*       >(e.object)->tempNum = tempNum; } break;
+				case SOLID_TYPE_REPULSER: { static_cast<CPlasmaRepulser*>(e.object)->tempNum = tempNum; } break;
+				default: {} break;
+			}
+
+			solids[n++] = e;
+		}
+
+		solids.resize(n);
+	}
+
+	const size_t numTracked = solids.size();
+
+	// append everything not seen yet; SortSolids moves it into place
+	for (CUnit* u: unitHandler.GetActiveUnits()) {
+		if (u->tempNum != tempNum)
+			AddSolid(SOLID_TYPE_UNIT, u->id, 0, u);
+
+		if (u->unitDef->shieldWeaponDef == nullptr)
+			continue;
+
+		for (CWeapon* w: u->weapons) {
+			if (!w->weaponDef->isShield)
+				continue;
+
+			CPlasmaRepulser* r = static_cast<CPlasmaRepulser*>(w);
+
+			if (r->tempNum == tempNum)
+				continue;
+
+			AddSolid(SOLID_TYPE_REPULSER, u->id, w->weaponNum, r);
+		}
+	}
+
+	for (const int featureID: featureHandler.GetActiveFeatureIDs()) {
+		CFeature* f = featureHandler.GetFeature(featureID);
+
+		if (f->tempNum == tempNum)
+			continue;
+
+		AddSolid(SOLID_TYPE_FEATURE, featureID, 0, f);
+	}
+
+	SortSolids(numTracked);
+}
+
+
+void CProjectileBroadphase::SweepProjectiles(const std::vector<CProjectile*>& pc)
+{
+	projectiles.clear();
+
+	numSweptProjectiles = pc.size();
+
+	for (size_t i = 0; i < pc.size(); ++i) {
+		const CProjectile* p = pc[i];
+
+		if (!p->checkCol) continue;
+		if ( p->deleteMe) continue;
+
+		const float rad = p->speed.w + p->radius;
+
+		projectiles.push_back({p->pos.x - rad, p->pos.x + rad, p->pos.z - rad, p->pos.z + rad, static_cast<int>(i)});
+	}
+
+	SweepEntries();
+}
+
+
+bool CProjectileBroadphase::GetCandidates(
+	const CProjectile* p,
+	int i,
+	std::vector<CUnit*>& units,
+	std::vector<CFeature*>& features,
+	std::vector<CPlasmaRepulser*>& repulsers
+) {
+	if (i >= static_cast<int>(numSweptProjectiles))
+		return false;
+
+	while (pairIndex < pairs.size() && pairs[pairIndex].projIndex < i)
+		pairIndex++;
+
+	const float3& pos = p->pos;
+	const float radius = p->speed.w + p->radius;
+
+	for (; pairIndex < pairs.size() && pairs[pairIndex].projIndex == i; pairIndex++) {
+		const SolidEntry& e = solids[pairs[pairIndex].solidIndex];
+
+		// objects can be removed from the QuadField by earlier collisions in
+		// this pass (e.g. via Lua); such units and shields are skipped since
+		// a QuadField query would not have returned them either
+		switch (e.type) {
+			case SOLID_TYPE_UNIT: {
+				CUnit* u = static_cast<CUnit*>(e.object);
+
+				if (u->quads.empty())
+					continue;
+
+				const auto* colvol = &u->collisionVolume;
+				const float totRad = radius + colvol->GetBoundingRadius();
+
+				if (pos.SqDistance(colvol->GetWorldSpacePos(u)) >= (totRad * totRad))
+					continue;
+
+				units.push_back(u);
+			} break;
+
+			case SOLID_TYPE_FEATURE: {
+				CFeature* f = static_cast<CFeature*>(e.object);
+
+				const auto* colvol = &f->collisionVolume;
+				const float totRad = radius + colvol->GetBoundingRadius();
+
+				if (pos.SqDistance(colvol->GetWorldSpacePos(f)) >= (totRad * totRad))
+					continue;
+
+				features.push_back(f);
+			} break;
+
+			case SOLID_TYPE_REPULSER: {
+				CPlasmaRepulser* r = static_cast<CPlasmaRepulser*>(e.object);
+
+				if (r->GetQuads().empty())
+					continue;
+
+				const auto* colvol = &r->collisionVolume;
+				const float totRad = radius + colvol->GetBoundingRadius();
+
+				if (pos.SqDistance(r->weaponMuzzlePos) >= (totRad * totRad))
+					continue;
+
+				repulsers.push_back(r);
+			} break;
+
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+
+	return true;
+}
+
+#endif // UNIT_TEST
@@ -0,0 +1,124 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PROJECTILE_BROADPHASE_H
+#define PROJECTILE_BROADPHASE_H
+
+#include <vector>
+
+class CProjectile;
+class CUnit;
+class CFeature;
+class CPlasmaRepulser;
+
+/**
+ * Sweep-and-prune broadphase for projectile vs. unit/feature/shield collisions
+ * (alternative to one CQuadField::GetUnitsAndFeaturesColVol query per projectile).
+ *
+ * Solids are kept in a persistent list sorted by the minimum x-coordinate of
+ * their bounding-sphere AABB; since objects move little between frames the
+ * tracked part of this list is re-sorted incrementally (insertion sort) every
+ * frame, while newly added solids are sorted separately and merged in.
+ * Projectiles churn too much for that and are sorted from scratch per
+ * container. A single sweep over both lists then yields every (projectile,
+ * solid) pair whose x-intervals overlap; pairs whose z-intervals do not also
+ * overlap are dropped right away (otherwise each projectile would be paired
+ * with every solid in its x-band across the whole map), and the candidates for
+ * each projectile
+ * are handed to the narrowphase ordered by (type, id) so the result never
+ * depends on memory layout, insertion order or thread count.
+ */
+class CProjectileBroadphase
+{
+public:
+	enum {
+		SOLID_TYPE_REPULSER = 0,
+		SOLID_TYPE_UNIT     = 1,
+		SOLID_TYPE_FEATURE  = 2,
+	};
+
+	struct SolidEntry {
+		float minX;
+		float maxX;
+		float minZ;
+		float maxZ;
+
+		int type;
+		int id;  // unit or feature ID; owner-unit ID for repulsers
+		int sub; // weapon number for repulsers, 0 otherwise
+
+		void* object;
+	};
+
+	struct ProjectileEntry {
+		float minX;
+		float maxX;
+		float minZ;
+		float maxZ;
+
+		int index; // into the projectile container
+	};
+
+	struct CandidatePair {
+		int projIndex;
+		int solidIndex;
+	};
+
+public:
+	void Kill();
+
+	/// refreshes the bounds of all tracked solids, drops stale ones and adds new ones
+	void UpdateSolids();
+	/// collects (and orders) the candidate pairs for all collidable projectiles in <pc>
+	void SweepProjectiles(const std::vector<CProjectile*>& pc);
+
+	/**
+	 * Fills the per-type candidate lists for the projectile at <pc> index <i>,
+	 * applying the same bounding-sphere test as GetUnitsAndFeaturesColVol.
+	 * Returns false if <i> was not part of the last sweep (i.e. the projectile
+	 * was added during the current collision pass) and the caller should fall
+	 * back to a QuadField query.
+	 */
+	bool GetCandidates(
+		const CProjectile* p,
+		int i,
+		std::vector<CUnit*>& units,
+		std::vector<CFeature*>& features,
+		std::vector<CPlasmaRepulser*>& repulsers
+	);
+
+	/**
+	 * Restores the order of the solid entries after the first <numTracked>
+	 * (which were sorted before their bounds changed) got refreshed and any
+	 * number of new ones were appended.
+	 */
+	void SortSolids(size_t numTracked);
+	/// sorts the projectile entries and pairs them with all overlapping solid entries
+	void SweepEntries();
+
+	std::vector<SolidEntry>& GetSolidEntries() { return solids; }
+	std::vector<ProjectileEntry>& GetProjectileEntries() { return projectiles; }
+	const std::vector<CandidatePair>& GetCandidatePairs() const { return pairs; }
+
+	size_t GetNumSolids() const { return solids.size(); }
+	size_t GetNumCandidatePairs() const { return pairs.size(); }
+
+private:
+	bool RefreshSolid(SolidEntry& e) const;
+	void AddSolid(int type, int id, int sub, void* object);
+
+private:
+	std::vector<SolidEntry> solids;
+	std::vector<ProjectileEntry> projectiles;
+	std::vector<CandidatePair> pairs;
+	std::vector<CandidatePair> sortedPairs;
+
+	// scratch for SweepProjectiles
+	std::vector<int> activeSolids;
+	std::vector<int> activeProjectiles;
+	std::vector<int> pairOffsets;
+
+	size_t numSweptProjectiles = 0;
+	size_t pairIndex = 0;
+};
+
+#endif
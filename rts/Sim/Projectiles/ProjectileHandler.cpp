@@ -15,6 +15,7 @@
 #include "Sim/Misc/CollisionHandler.h"
 #include "Sim/Misc/CollisionVolume.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Rendering/Env/Particles/Classes/FlyingPiece.h"
@@ -55,7 +56,9 @@ CR_REG_METADATA(CProjectileHandler, (
 	CR_MEMBER_UN(lastProjectileCounts),
 
 	CR_MEMBER(freeProjectileIDs),
-	CR_MEMBER(projectileMaps)
+	CR_MEMBER(projectileMaps),
+
+	CR_IGNORED(broadphase)
 ))
 
 
@@ -157,6 +160,8 @@ void CProjectileHandler::Kill()
 	projectileMaps[ true].clear();
 	projectileMaps[false].clear();
 
+	broadphase.Kill();
+
 	CCollisionHandler::PrintStats();
 }
 
@@ -591,6 +596,9 @@ void CProjectileHandler::CheckUnitFeatureCollisions(ProjectileContainer& pc)
 	static std::vector<CFeature*> tempFeatures;
 	static std::vector<CPlasmaRepulser*> tempRepulsers;
 
+	if (modInfo.projectileSweepAndPrune)
+		broadphase.SweepProjectiles(pc);
+
 	for (size_t i = 0; i < pc.size(); ++i) {
 		CProjectile* p = pc[i];
 
@@ -601,7 +609,9 @@ void CProjectileHandler::CheckUnitFeatureCollisions(ProjectileContainer& pc)
 		const float3 ppos1 = p->pos + p->speed;
 		// const float3 ppos1 = p->pos + p->dir * (p->speed.w + p->radius);
 
-		quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
+		// projectiles created by collisions earlier in this pass are not in the sweep
+		if (!modInfo.projectileSweepAndPrune || !broadphase.GetCandidates(p, i, tempUnits, tempFeatures, tempRepulsers))
+			quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
 
 		CheckShieldCollisions(p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
 		CheckUnitCollisions(p, tempUnits, ppos0, ppos1); tempUnits.clear();
@@ -654,6 +664,10 @@ void CProjectileHandler::CheckCollisions()
 {
 	SCOPED_TIMER("Sim::Projectiles::Collisions");
 
+	// solids do not move during the collision passes
+	if (modInfo.projectileSweepAndPrune)
+		broadphase.UpdateSolids();
+
 	CheckUnitFeatureCollisions(projectileContainers[ true]); // changes simulation state
 	CheckUnitFeatureCollisions(projectileContainers[false]); // does not change simulation state
 
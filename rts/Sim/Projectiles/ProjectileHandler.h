@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "Rendering/Models/3DModel.h"
+#include "Sim/Projectiles/ProjectileBroadphase.h"
 #include "Sim/Projectiles/ProjectileFunctors.h"
 #include "System/float3.h"
 
@@ -100,6 +101,9 @@ private:
 	// [0] := ID ==> projectile* map for living unsynced projectiles
 	// [1] := ID ==> projectile* map for living   synced projectiles
 	std::vector<CProjectile*> projectileMaps[2];
+
+	// used instead of per-projectile QuadField queries if modInfo.projectileSweepAndPrune
+	CProjectileBroadphase broadphase;
 };
 
 
@@ -343,6 +343,7 @@ void CUnit::PreInit(const UnitLoadParams& params)
 	quadField.MovedUnit(this);
 
 	losStatus[allyteam] = LOS_ALL_MASK_BITS | LOS_INLOS | LOS_INRADAR | LOS_PREVLOS | LOS_CONTRADAR;
+	unitHandler.GetHotState().SetLosStatus(id, allyteam, losStatus[allyteam]);
 
 #ifdef TRACE_SYNC
 	tracefile << "[" << __FUNCTION__ << "] id: " << id << ", name: " << unitDef->name << " ";
@@ -642,6 +643,8 @@ void CUnit::ForcedMove(const float3& newPos)
 	Move(newPos - pos, true);
 	Block();
 
+	unitHandler.GetHotState().Store(this);
+
 	eventHandler.UnitMoved(this);
 	quadField.MovedUnit(this);
 }
@@ -970,21 +973,26 @@ void CUnit::SetLosStatus(int at, unsigned short newStatus)
 
 	// remove from the state after running the callins
 	losStatus[at] &= newStatus;
+
+	unitHandler.GetHotState().SetLosStatus(id, at, losStatus[at]);
 }
 
 
 unsigned short CUnit::CalcLosStatus(int at) const
 {
-	const unsigned short currStatus = losStatus[at];
+	return (CalcLosStatus(LosUnitInfo(this), losStatus[at], at));
+}
 
+unsigned short CUnit::CalcLosStatus(const LosUnitInfo& unit, unsigned short currStatus, int at)
+{
 	unsigned short newStatus = currStatus;
 	unsigned short mask = ~(currStatus >> 8);
 
-	if (losHandler->InLos(this, at)) {
+	if (losHandler->InLos(unit, at)) {
 		newStatus |= (mask & (LOS_INLOS   | LOS_INRADAR |
 		                      LOS_PREVLOS | LOS_CONTRADAR));
 	}
-	else if (losHandler->InRadar(this, at)) {
+	else if (losHandler->InRadar(unit, at)) {
 		newStatus |=  (mask & LOS_INRADAR);
 		newStatus &= ~(mask & LOS_INLOS);
 	}
@@ -1591,6 +1599,7 @@ bool CUnit::ChangeTeam(int newteam, ChangeType type)
 	neutral = false;
 
 	unitHandler.ChangeUnitTeam(this, oldteam, newteam);
+	unitHandler.GetHotState().Store(this);
 
 	for (int at = 0; at < teamHandler.ActiveAllyTeams(); ++at) {
 		if (teamHandler.Ally(at, allyteam)) {
@@ -25,6 +25,7 @@ struct SolidObjectDef;
 struct UnitDef;
 struct UnitLoadParams;
 struct SLosInstance;
+struct LosUnitInfo;
 
 
 // LOS state bits
@@ -155,6 +156,8 @@ public:
 	void SetLosStatus(int allyTeam, unsigned short newStatus);
 	void UpdateLosStatus(int allyTeam);
 	unsigned short CalcLosStatus(int allyTeam) const;
+	/// as above, for a unit whose LOS-relevant fields and status are read from elsewhere
+	static unsigned short CalcLosStatus(const LosUnitInfo& unit, unsigned short currStatus, int allyTeam);
 
 	void SlowUpdateCloak(bool);
 	bool ScriptCloak();
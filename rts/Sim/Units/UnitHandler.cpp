@@ -12,6 +12,8 @@
 
 #include "CommandAI/BuilderCAI.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/LosHandler.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Weapons/Weapon.h"
@@ -20,6 +22,7 @@
 #include "System/myMath.h"
 #include "System/TimeProfiler.h"
 #include "System/Sync/SyncTracer.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/creg/STL_Deque.h"
 #include "System/creg/STL_Set.h"
 
@@ -34,6 +37,10 @@ CR_REG_METADATA(CUnitHandler, (
 	CR_MEMBER(unitsToBeRemoved),
 
 	CR_MEMBER(builderCAIs),
+	CR_IGNORED(losStatusBuffer),
+	CR_IGNORED(losStatusChanged),
+	CR_IGNORED(weaponTargetVisitedSets),
+	CR_IGNORED(hotState),
 
 	CR_MEMBER(activeSlowUpdateUnit),
 	CR_MEMBER(activeUpdateUnit),
@@ -41,7 +48,9 @@ CR_REG_METADATA(CUnitHandler, (
 	CR_MEMBER(maxUnits),
 	CR_MEMBER(maxUnitRadius),
 
-	CR_MEMBER(inUpdateCall)
+	CR_MEMBER(inUpdateCall),
+
+	CR_POSTLOAD(PostLoad)
 ))
 
 
@@ -134,6 +143,21 @@ void CUnitHandler::Init() {
 			unitsByDefs[teamNum].resize(unitDefHandler->NumUnitDefs() + 1);
 		}
 	}
+	{
+		hotState.Init(maxUnits, teamHandler.ActiveAllyTeams());
+	}
+}
+
+void CUnitHandler::PostLoad()
+{
+	// not serialized, rebuild from the loaded units
+	hotState.Init(maxUnits, teamHandler.ActiveAllyTeams());
+
+	for (const CUnit* unit: activeUnits) {
+		hotState.InsertActiveID(hotState.GetActiveIDs().size(), unit->id);
+		hotState.Store(unit);
+		hotState.StoreLosStatus(unit);
+	}
 }
 
 
@@ -162,6 +186,8 @@ void CUnitHandler::Kill()
 	activeUnits.clear();
 	unitsToBeRemoved.clear();
 
+	hotState.Kill();
+
 	// only iterated by unsynced code, GetBuilderCAIs has no synced callers
 	builderCAIs.clear();
 }
@@ -196,6 +222,7 @@ void CUnitHandler::InsertActiveUnit(CUnit* unit)
 
 	assert(insertionPos < activeUnits.size());
 	activeUnits.insert(activeUnits.begin() + insertionPos, unit);
+	hotState.InsertActiveID(insertionPos, unit->id);
 
 	// do not (slow)update the same unit twice if the new one
 	// gets inserted behind our current iterator position and
@@ -205,9 +232,12 @@ void CUnitHandler::InsertActiveUnit(CUnit* unit)
 
 	#else
 	activeUnits.push_back(unit);
+	hotState.InsertActiveID(activeUnits.size() - 1, unit->id);
 	#endif
 
 	units[unit->id] = unit;
+	hotState.Store(unit);
+	hotState.StoreLosStatus(unit);
 }
 
 
@@ -298,6 +328,9 @@ void CUnitHandler::DeleteUnit(CUnit* delUnit)
 	if (activeSlowUpdateUnit > std::distance(activeUnits.begin(), it))
 		--activeSlowUpdateUnit;
 
+	hotState.EraseActiveID(std::distance(activeUnits.begin(), it));
+	hotState.Clear(delUnit->id);
+
 	activeUnits.erase(it);
 
 	spring::VectorErase(GetUnitsByTeamAndDef(delUnitTeam,           0), delUnit);
@@ -313,10 +346,25 @@ void CUnitHandler::DeleteUnit(CUnit* delUnit)
 }
 
 
+void CUnitHandler::PreUpdateUnitMoveTypes()
+{
+	SCOPED_TIMER("Sim::Unit::MoveType::PreUpdate");
+
+	// read-only phase; every movetype only writes into its own cache
+	// so the results do not depend on the number of worker threads,
+	// and Update revalidates them in activeUnits order afterwards
+	for_mt(0, activeUnits.size(), [&](const int i) {
+		activeUnits[i]->moveType->PreUpdate();
+	});
+}
+
 void CUnitHandler::UpdateUnitMoveTypes()
 {
 	SCOPED_TIMER("Sim::Unit::MoveType");
 
+	if (modInfo.parallelMoveTypeUpdates)
+		PreUpdateUnitMoveTypes();
+
 	for (activeUpdateUnit = 0; activeUpdateUnit < activeUnits.size(); ++activeUpdateUnit) {
 		CUnit* unit = activeUnits[activeUpdateUnit];
 		AMoveType* moveType = unit->moveType;
@@ -336,10 +384,25 @@ void CUnitHandler::UpdateUnitMoveTypes()
 	}
 }
 
+void CUnitHandler::StoreHotState()
+{
+	SCOPED_TIMER("Sim::Unit::StoreHotState");
+
+	// every unit only writes its own entries
+	for_mt(0, activeUnits.size(), [&](const int i) {
+		hotState.Store(activeUnits[i]);
+	});
+}
+
 void CUnitHandler::UpdateUnitLosStates()
 {
 	SCOPED_TIMER("Sim::Unit::UpdateLosStatus");
 
+	if (modInfo.parallelLosStatusUpdates) {
+		UpdateUnitLosStatesMT();
+		return;
+	}
+
 	for (CUnit* unit: activeUnits) {
 		for (int at = 0; at < teamHandler.ActiveAllyTeams(); ++at) {
 			unit->UpdateLosStatus(at);
@@ -347,6 +410,97 @@ void CUnitHandler::UpdateUnitLosStates()
 	}
 }
 
+void CUnitHandler::UpdateUnitLosStatesMT()
+{
+	// units are handed to workers in fixed-size shards, each of which
+	// walks one allyteam (i.e. one row of losStatusBuffer and one set
+	// of LOS-maps) at a time
+	static constexpr int NUM_SHARD_UNITS = 256;
+
+	const int numUnits = activeUnits.size();
+	const int numAllyTeams = teamHandler.ActiveAllyTeams();
+
+	losStatusBuffer.resize(numUnits * numAllyTeams);
+	losStatusChanged.resize(numUnits);
+
+	// current statuses and all fields the LOS-tests depend on are read
+	// from the (dense) hot-state rows, which StoreHotState refreshed
+	// right after the MoveType pass; units are not touched until the
+	// changes are applied
+	const std::vector<int>& activeIDs = hotState.GetActiveIDs();
+
+	assert(activeIDs.size() == activeUnits.size());
+
+	for_mt(0, numUnits, NUM_SHARD_UNITS, [&](const int shardBeg) {
+		const int shardEnd = std::min(shardBeg + NUM_SHARD_UNITS, numUnits);
+
+		std::fill(losStatusChanged.begin() + shardBeg, losStatusChanged.begin() + shardEnd, 0);
+
+		for (int at = 0; at < numAllyTeams; ++at) {
+			const unsigned short* currRow = hotState.GetLosStatusRow(at);
+			unsigned short* statusRow = &losStatusBuffer[at * numUnits];
+
+			for (int i = shardBeg; i < shardEnd; ++i) {
+				const unsigned short currStatus = currRow[activeIDs[i]];
+
+				assert(currStatus == activeUnits[i]->losStatus[at]);
+
+				// all changes masked, same as UpdateLosStatus
+				if ((currStatus & LOS_ALL_MASK_BITS) == LOS_ALL_MASK_BITS) {
+					statusRow[i] = currStatus;
+					continue;
+				}
+
+				const LosUnitInfo unitInfo(hotState, activeIDs[i]);
+
+				assert(unitInfo.pos == activeUnits[i]->pos);
+				assert(unitInfo.allyteam == activeUnits[i]->allyteam);
+
+				losStatusChanged[i] |= ((statusRow[i] = CUnit::CalcLosStatus(unitInfo, currStatus, at)) != currStatus);
+			}
+		}
+	});
+
+	// apply serially in the same (unit, allyteam) order as the MT-less
+	// path such that Unit{Entered,Left}{Los,Radar} events do not change
+	// order; units without any changed bits would be no-ops
+	for (int i = 0; i < numUnits; ++i) {
+		if (losStatusChanged[i] == 0)
+			continue;
+
+		CUnit* unit = activeUnits[i];
+
+		for (int at = 0; at < numAllyTeams; ++at) {
+			unit->SetLosStatus(at, losStatusBuffer[at * numUnits + i]);
+		}
+	}
+}
+
+
+void CUnitHandler::PreSlowUpdateUnitWeapons(size_t numUnits)
+{
+	SCOPED_TIMER("Sim::Unit::Weapon::PreSlowUpdate");
+
+	const size_t begUnit = activeSlowUpdateUnit;
+	const size_t endUnit = std::min(activeUnits.size(), begUnit + numUnits);
+
+	weaponTargetVisitedSets.resize(ThreadPool::MAX_THREADS);
+
+	// read-only phase; every weapon only writes its own candidate
+	// list, which AutoTarget revalidates during the serial pass
+	for_mt(begUnit, endUnit, [&](const int i) {
+		const CUnit* unit = activeUnits[i];
+
+		if (!unit->CanUpdateWeapons())
+			return;
+
+		QueryVisitedSet& visited = weaponTargetVisitedSets[ThreadPool::GetThreadNum()];
+
+		for (CWeapon* w: unit->weapons) {
+			w->PreSlowUpdate(visited);
+		}
+	});
+}
 
 void CUnitHandler::SlowUpdateUnits()
 {
@@ -357,6 +511,9 @@ void CUnitHandler::SlowUpdateUnits()
 	if ((gs->frameNum % UNIT_SLOWUPDATE_RATE) == 0)
 		activeSlowUpdateUnit = 0;
 
+	if (modInfo.parallelWeaponTargeting)
+		PreSlowUpdateUnitWeapons((activeUnits.size() / UNIT_SLOWUPDATE_RATE) + 1);
+
 	// stagger the SlowUpdate's
 	for (size_t n = (activeUnits.size() / UNIT_SLOWUPDATE_RATE) + 1; (activeSlowUpdateUnit < activeUnits.size() && n != 0); ++activeSlowUpdateUnit) {
 		CUnit* unit = activeUnits[activeSlowUpdateUnit];
@@ -412,10 +569,12 @@ void CUnitHandler::Update()
 	DeleteUnits();
 	UpdateUnitMoveTypes();
 	QueueDeleteUnits();
+	StoreHotState();
 	UpdateUnitLosStates();
 	SlowUpdateUnits();
 	UpdateUnits();
 	UpdateUnitWeapons();
+	StoreHotState();
 
 	inUpdateCall = false;
 }
@@ -6,7 +6,9 @@
 #include <vector>
 
 #include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/SimObjectIDPool.h"
+#include "Sim/Units/UnitHotState.h"
 #include "System/creg/STL_Map.h"
 
 struct UnitDef;
@@ -22,6 +24,7 @@ public:
 
 	void Init();
 	void Kill();
+	void PostLoad();
 
 	void DeleteScripts();
 
@@ -73,6 +76,9 @@ public:
 
 	const spring::unordered_map<unsigned int, CBuilderCAI*>& GetBuilderCAIs() const { return builderCAIs; }
 
+	const CUnitHotState& GetHotState() const { return hotState; }
+	      CUnitHotState& GetHotState()       { return hotState; }
+
 private:
 	void InsertActiveUnit(CUnit* unit);
 	bool QueueDeleteUnit(CUnit* unit);
@@ -80,8 +86,13 @@ private:
 	void DeleteUnit(CUnit* unit);
 	void DeleteUnits();
 	void SlowUpdateUnits();
+	void PreSlowUpdateUnitWeapons(size_t numUnits);
+	void PreUpdateUnitMoveTypes();
 	void UpdateUnitMoveTypes();
+	/// refreshes the mirrored fields of all active units, see CUnitHotState
+	void StoreHotState();
 	void UpdateUnitLosStates();
+	void UpdateUnitLosStatesMT();
 	void UpdateUnits();
 	void UpdateUnitWeapons();
 
@@ -96,6 +107,17 @@ private:
 
 	spring::unordered_map<unsigned int, CBuilderCAI*> builderCAIs;
 
+	///< per-frame scratch space for UpdateUnitLosStatesMT; one row
+	///< of new statuses per allyteam, indexed by activeUnits-index
+	std::vector<unsigned short> losStatusBuffer;
+	std::vector<unsigned char> losStatusChanged;
+
+	///< dense copies of per-frame unit state, indexed by unit ID
+	CUnitHotState hotState;
+
+	///< per-thread scratch space for PreSlowUpdateUnitWeapons
+	std::vector<QueryVisitedSet> weaponTargetVisitedSets;
+
 
 	size_t activeSlowUpdateUnit = 0;  ///< first unit of batch that will be SlowUpdate'd this frame
 	size_t activeUpdateUnit = 0;      ///< first unit of batch that will be SlowUpdate'd this frame
@@ -0,0 +1,177 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef UNIT_HOT_STATE_H
+#define UNIT_HOT_STATE_H
+
+#include <cassert>
+#include <vector>
+
+#include "System/float3.h"
+#include "System/float4.h"
+
+/**
+ * Dense (struct-of-arrays) copies of the CUnit fields read most often by
+ * the per-frame batch passes in CUnitHandler, indexed by unit ID.
+ *
+ * LOS-status entries always equal CUnit::losStatus since every write goes
+ * through CUnit::SetLosStatus; they are copied once when a unit is inserted
+ * (see StoreLosStatus). All other entries are refreshed by Store, which
+ * CUnitHandler calls for every active unit right after the MoveType pass
+ * (such that the LOS-status pass sees exactly the values the units have at
+ * that point) and at the end of each frame, as well as whenever a unit is
+ * teleported or changes teams. Code running in between passes that needs
+ * the live value must still read the unit.
+ *
+ * activeIDs mirrors CUnitHandler::activeUnits (same order), such that a
+ * batch can walk all units without dereferencing any unit pointers.
+ */
+class CUnitHotState {
+public:
+	/// bits of the per-unit LOS-flags, the boolean unit fields LOS-tests depend on
+	enum {
+		LOS_FLAG_CLOAKED        = (1 << 0),
+		LOS_FLAG_ALWAYS_VISIBLE = (1 << 1),
+		LOS_FLAG_AIR_LOS        = (1 << 2),
+		LOS_FLAG_STEALTH        = (1 << 3),
+		LOS_FLAG_SONAR_STEALTH  = (1 << 4),
+		LOS_FLAG_BEING_BUILT    = (1 << 5),
+	};
+
+	template<typename U> static unsigned char GetLosFlags(const U* unit) {
+		unsigned char flags = 0;
+
+		flags |= (LOS_FLAG_CLOAKED        * unit->isCloaked);
+		flags |= (LOS_FLAG_ALWAYS_VISIBLE * unit->alwaysVisible);
+		flags |= (LOS_FLAG_AIR_LOS        * unit->useAirLos);
+		flags |= (LOS_FLAG_STEALTH        * unit->stealth);
+		flags |= (LOS_FLAG_SONAR_STEALTH  * unit->sonarStealth);
+		flags |= (LOS_FLAG_BEING_BUILT    * unit->beingBuilt);
+		return flags;
+	}
+
+public:
+	void Init(unsigned int _maxUnits, unsigned int _numAllyTeams) {
+		maxUnits = _maxUnits;
+		numAllyTeams = _numAllyTeams;
+
+		pos.clear();
+		pos.resize(maxUnits, ZeroVector);
+		speed.clear();
+		speed.resize(maxUnits, float4());
+		heading.clear();
+		heading.resize(maxUnits, 0);
+		allyTeams.clear();
+		allyTeams.resize(maxUnits, -1);
+		health.clear();
+		health.resize(maxUnits, 0.0f);
+		physicalStates.clear();
+		physicalStates.resize(maxUnits, 0);
+		losFlags.clear();
+		losFlags.resize(maxUnits, 0);
+		losStatus.clear();
+		losStatus.resize(maxUnits * numAllyTeams, 0);
+
+		activeIDs.clear();
+		activeIDs.reserve(maxUnits);
+	}
+
+	void Kill() {
+		pos.clear();
+		speed.clear();
+		heading.clear();
+		allyTeams.clear();
+		health.clear();
+		physicalStates.clear();
+		losFlags.clear();
+		losStatus.clear();
+		activeIDs.clear();
+
+		maxUnits = 0;
+		numAllyTeams = 0;
+	}
+
+	/// copies all mirrored fields of <unit> except for its LOS-status
+	template<typename U> void Store(const U* unit) {
+		assert(unit->id >= 0 && static_cast<unsigned int>(unit->id) < maxUnits);
+
+		pos[unit->id] = unit->pos;
+		speed[unit->id] = unit->speed;
+		heading[unit->id] = unit->heading;
+		allyTeams[unit->id] = unit->allyteam;
+		health[unit->id] = unit->health;
+		physicalStates[unit->id] = unit->physicalState;
+		losFlags[unit->id] = GetLosFlags(unit);
+	}
+
+	/// copies the LOS-status of <unit> for all allyteams
+	template<typename U> void StoreLosStatus(const U* unit) {
+		for (unsigned int at = 0; at < numAllyTeams; ++at) {
+			SetLosStatus(unit->id, at, unit->losStatus[at]);
+		}
+	}
+
+	void SetLosStatus(unsigned int unitID, unsigned int allyTeam, unsigned short status) {
+		assert(unitID < maxUnits);
+		assert(allyTeam < numAllyTeams);
+		losStatus[allyTeam * maxUnits + unitID] = status;
+	}
+
+	void Clear(unsigned int unitID) {
+		assert(unitID < maxUnits);
+
+		pos[unitID] = ZeroVector;
+		speed[unitID] = float4();
+		heading[unitID] = 0;
+		allyTeams[unitID] = -1;
+		health[unitID] = 0.0f;
+		physicalStates[unitID] = 0;
+		losFlags[unitID] = 0;
+
+		for (unsigned int at = 0; at < numAllyTeams; ++at) {
+			SetLosStatus(unitID, at, 0);
+		}
+	}
+
+	// keep in sync with CUnitHandler::activeUnits
+	void InsertActiveID(unsigned int idx, int unitID) { activeIDs.insert(activeIDs.begin() + idx, unitID); }
+	void EraseActiveID(unsigned int idx) { activeIDs.erase(activeIDs.begin() + idx); }
+	void ClearActiveIDs() { activeIDs.clear(); }
+
+public:
+	const float3& GetPos(unsigned int unitID) const { return pos[unitID]; }
+	const float4& GetSpeed(unsigned int unitID) const { return speed[unitID]; }
+
+	short GetHeading(unsigned int unitID) const { return heading[unitID]; }
+	int GetAllyTeam(unsigned int unitID) const { return allyTeams[unitID]; }
+	float GetHealth(unsigned int unitID) const { return health[unitID]; }
+	unsigned int GetPhysicalState(unsigned int unitID) const { return physicalStates[unitID]; }
+	unsigned char GetLosFlags(unsigned int unitID) const { return losFlags[unitID]; }
+
+	unsigned short GetLosStatus(unsigned int unitID, unsigned int allyTeam) const { return losStatus[allyTeam * maxUnits + unitID]; }
+	/// statuses of all units for one allyteam, indexed by unit ID
+	const unsigned short* GetLosStatusRow(unsigned int allyTeam) const { return &losStatus[allyTeam * maxUnits]; }
+
+	const std::vector<int>& GetActiveIDs() const { return activeIDs; }
+
+	unsigned int GetMaxUnits() const { return maxUnits; }
+	unsigned int GetNumAllyTeams() const { return numAllyTeams; }
+
+private:
+	std::vector<float3> pos;
+	std::vector<float4> speed;
+	std::vector<short> heading;
+	std::vector<int> allyTeams;
+	std::vector<float> health;
+	std::vector<unsigned int> physicalStates;
+	std::vector<unsigned char> losFlags;
+
+	///< one row of maxUnits entries per allyteam
+	std::vector<unsigned short> losStatus;
+
+	std::vector<int> activeIDs;
+
+	unsigned int maxUnits = 0;
+	unsigned int numAllyTeams = 0;
+};
+
+#endif
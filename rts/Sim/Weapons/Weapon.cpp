@@ -13,6 +13,7 @@
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/InterceptHandler.h"
 #include "Sim/Misc/ModInfo.h"
+#include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/AAirMoveType.h"
 #include "Sim/Projectiles/ProjectileHandler.h"
@@ -103,6 +104,7 @@ CR_REG_METADATA(CWeapon, (
 
 	CR_MEMBER(currentTarget),
 	CR_MEMBER(currentTargetPos),
+	CR_IGNORED(targetCandidates),
 
 	CR_MEMBER(incomingProjectileIDs)
 ))
@@ -688,6 +690,60 @@ bool CWeapon::AutoTarget()
 }
 
 
+void CWeapon::PreSlowUpdate(QueryVisitedSet& visited)
+{
+	// NOTE: may run on any ThreadPool worker, only touch targetCandidates
+	targetCandidates.frame = -1;
+
+	// skip weapons that (barring Lua overrides) will not reach
+	// GenerateWeaponTargets during SlowUpdate; this only costs a
+	// fallback scan if the guess turns out wrong
+	if (weaponDef->noAutoTarget || noAutoTarget)
+		return;
+	if (weaponDef->interceptor || weaponDef->isShield)
+		return;
+	if (slavedTo != nullptr)
+		return;
+	if (owner->fireState < FIRESTATE_FIREATWILL)
+		return;
+	if (HaveTarget() && !avoidTarget && (currentTarget.isUserTarget || gs->frameNum <= (lastTargetRetry + 65)))
+		return;
+
+	CGameHelper::GatherWeaponTargetCandidates(this, visited, targetCandidates.scanQuads, targetCandidates.units);
+
+	targetCandidates.enemyAllyTeams.resize(teamHandler.ActiveAllyTeams());
+
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		targetCandidates.enemyAllyTeams[t] = !teamHandler.Ally(owner->allyteam, t);
+	}
+
+	targetCandidates.unitLinksVersion = quadField.GetUnitLinksVersion();
+	targetCandidates.allyTeam = owner->allyteam;
+	targetCandidates.frame = gs->frameNum;
+}
+
+const std::vector<CUnit*>* CWeapon::GetTargetCandidates(const std::vector<int>& scanQuads) const
+{
+	if (targetCandidates.frame != gs->frameNum)
+		return nullptr;
+	if (targetCandidates.allyTeam != owner->allyteam)
+		return nullptr;
+	if (targetCandidates.unitLinksVersion != quadField.GetUnitLinksVersion())
+		return nullptr;
+	// aimFromPos is updated by SlowUpdate after the candidates were gathered,
+	// but small changes rarely alter the set of quads within scanning range
+	if (targetCandidates.scanQuads != scanQuads)
+		return nullptr;
+
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		if (targetCandidates.enemyAllyTeams[t] == teamHandler.Ally(owner->allyteam, t))
+			return nullptr;
+	}
+
+	return &targetCandidates.units;
+}
+
+
 void CWeapon::SlowUpdate()
 {
 	errorVectorAdd = (gsRNG.NextVector() - errorVector) * (1.0f / UNIT_SLOWUPDATE_RATE);
@@ -13,6 +13,7 @@
 
 class CUnit;
 class CWeaponProjectile;
+class QueryVisitedSet;
 struct WeaponDef;
 
 
@@ -79,6 +80,10 @@ public:
 	virtual void UpdateRange(const float val) { range = val; }
 
 	bool AutoTarget();
+	/// gathers auto-target candidates ahead of SlowUpdate; read-only, may run on any ThreadPool worker
+	void PreSlowUpdate(QueryVisitedSet& visited);
+	/// returns the PreSlowUpdate candidates iff a fresh scan over <scanQuads> would visit exactly these
+	const std::vector<CUnit*>* GetTargetCandidates(const std::vector<int>& scanQuads) const;
 	void AimReady(const int value);
 	void Fire(const bool scriptCall);
 
@@ -198,6 +203,22 @@ protected:
 	SWeaponTarget currentTarget;
 	float3 currentTargetPos;
 
+	// enemy units gathered by PreSlowUpdate, only valid during the same frame
+	// and while the scan-quads, the QuadField unit links and the owner's
+	// alliances are unchanged
+	struct TargetCandidates {
+		std::vector<int> scanQuads;
+		std::vector<CUnit*> units;
+		std::vector<bool> enemyAllyTeams;
+
+		unsigned int unitLinksVersion = 0;
+
+		int allyTeam = -1;
+		int frame = -1;
+	};
+
+	TargetCandidates targetCandidates;
+
 	// projectiles that are on the way to our interception zone
 	// (eg. nuke toward a repulsor, or missile toward a shield)
 	std::vector<int> incomingProjectileIDs;
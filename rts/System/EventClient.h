@@ -47,6 +47,34 @@ enum DbgTimingInfoType {
 };
 
 
+/// UnitMoved event as buffered for UnitMovedBatch
+struct UnitMovedBatchEvent {
+	int unitID;
+	int unitDefID;
+	int unitTeam;
+	int unitAllyTeam;
+};
+
+/// UnitDamaged event as buffered for UnitDamagedBatch
+struct UnitDamagedBatchEvent {
+	int unitID;
+	int unitDefID;
+	int unitTeam;
+	int unitAllyTeam;
+
+	// all -1 if there was no attacker
+	int attackerID;
+	int attackerDefID;
+	int attackerTeam;
+
+	int weaponDefID;
+	int projectileID;
+
+	float damage;
+	bool paralyzer;
+};
+
+
 class CEventClient
 {
 	public:
@@ -169,6 +197,11 @@ class CEventClient
 		virtual void UnitMoved(const CUnit* unit) {}
 		virtual void UnitMoveFailed(const CUnit* unit) {}
 
+		// batched versions of UnitMoved and UnitDamaged, receive all events
+		// of a sim-frame at its end (units may have died in the meantime)
+		virtual void UnitMovedBatch(const std::vector<UnitMovedBatchEvent>& events) {}
+		virtual void UnitDamagedBatch(const std::vector<UnitDamagedBatchEvent>& events) {}
+
 		virtual void FeatureCreated(const CFeature* feature) {}
 		virtual void FeatureDestroyed(const CFeature* feature) {}
 		virtual void FeatureDamaged(
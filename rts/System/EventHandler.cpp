@@ -3,6 +3,7 @@
 #include "System/EventHandler.h"
 
 #include "Lua/LuaCallInCheck.h"
+#include "Sim/Units/UnitDef.h"
 #include "Lua/LuaOpenGL.h"  // FIXME -- should be moved
 
 #include "System/Config/ConfigHandler.h"
@@ -33,6 +34,13 @@ void CEventHandler::ResetState()
 {
 	mouseOwner = nullptr;
 
+	for (auto& batch: unitMovedBatch) {
+		batch.clear();
+	}
+	for (auto& batch: unitDamagedBatch) {
+		batch.clear();
+	}
+
 	eventMap.clear();
 	eventMap.reserve(64);
 	handles.clear();
@@ -484,6 +492,21 @@ void CEventHandler::GameFrame(int gameFrame)
 	ITERATE_EVENTCLIENTLIST(GameFrame, gameFrame);
 }
 
+void CEventHandler::SendEventBatches()
+{
+	// events are only buffered while some client is listening, but
+	// the list can become empty again before the batch is delivered
+	unitMovedBatch[1].clear();
+	unitMovedBatch[1].swap(unitMovedBatch[0]);
+	unitDamagedBatch[1].clear();
+	unitDamagedBatch[1].swap(unitDamagedBatch[0]);
+
+	if (!unitMovedBatch[1].empty())
+		ITERATE_EVENTCLIENTLIST(UnitMovedBatch, unitMovedBatch[1]);
+	if (!unitDamagedBatch[1].empty())
+		ITERATE_EVENTCLIENTLIST(UnitDamagedBatch, unitDamagedBatch[1]);
+}
+
 void CEventHandler::GameProgress(int gameFrame)
 {
 	ITERATE_EVENTCLIENTLIST(GameProgress, gameFrame);
@@ -525,6 +548,62 @@ void CEventHandler::PlayerRemoved(int playerID, int reason)
 /******************************************************************************/
 /******************************************************************************/
 
+void CEventHandler::UnitMoved(const CUnit* unit)
+{
+	if (!listUnitMovedBatch.empty())
+		unitMovedBatch[0].push_back({unit->id, unit->unitDef->id, unit->team, unit->allyteam});
+
+	const int unitAllyTeam = unit->allyteam;
+
+	for (size_t i = 0; i < listUnitMoved.size(); ) {
+		CEventClient* ec = listUnitMoved[i];
+
+		if (ec->CanReadAllyTeam(unitAllyTeam))
+			ec->UnitMoved(unit);
+
+		// the call-in may remove itself from the list
+		i += (i < listUnitMoved.size() && ec == listUnitMoved[i]);
+	}
+}
+
+void CEventHandler::UnitDamaged(
+	const CUnit* unit,
+	const CUnit* attacker,
+	float damage,
+	int weaponDefID,
+	int projectileID,
+	bool paralyzer)
+{
+	if (!listUnitDamagedBatch.empty()) {
+		UnitDamagedBatchEvent e = {
+			unit->id, unit->unitDef->id, unit->team, unit->allyteam,
+			-1, -1, -1,
+			weaponDefID, projectileID,
+			damage, paralyzer
+		};
+
+		if (attacker != nullptr) {
+			e.attackerID = attacker->id;
+			e.attackerDefID = attacker->unitDef->id;
+			e.attackerTeam = attacker->team;
+		}
+
+		unitDamagedBatch[0].push_back(e);
+	}
+
+	const int unitAllyTeam = unit->allyteam;
+
+	for (size_t i = 0; i < listUnitDamaged.size(); ) {
+		CEventClient* ec = listUnitDamaged[i];
+
+		if (ec->CanReadAllyTeam(unitAllyTeam))
+			ec->UnitDamaged(unit, attacker, damage, weaponDefID, projectileID, paralyzer);
+
+		// the call-in may remove itself from the list
+		i += (i < listUnitDamaged.size() && ec == listUnitDamaged[i]);
+	}
+}
+
 void CEventHandler::UnitHarvestStorageFull(const CUnit* unit)
 {
 	const int unitAllyTeam = unit->allyteam;
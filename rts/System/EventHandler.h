@@ -53,6 +53,8 @@ class CEventHandler
 		void GameOver(const std::vector<unsigned char>& winningAllyTeams);
 		void GamePaused(int playerID, bool paused);
 		void GameFrame(int gameFrame);
+		/// delivers the events buffered for the *Batch call-ins, called at the end of each sim-frame
+		void SendEventBatches();
 		void GameID(const unsigned char* gameID, unsigned int numBytes);
 
 		void TeamDied(int teamID);
@@ -330,6 +332,12 @@ class CEventHandler
 	private:
 		CEventClient* mouseOwner;
 
+		// only filled while some client wants the batched call-in; [1] is
+		// the batch being delivered, such that events raised by a client
+		// from within a *Batch call-in go into the next frame's batch
+		std::vector<UnitMovedBatchEvent> unitMovedBatch[2];
+		std::vector<UnitDamagedBatchEvent> unitDamagedBatch[2];
+
 	private:
 		EventMap eventMap;
 
@@ -417,7 +425,6 @@ UNIT_CALLIN_NO_PARAM(UnitEnteredWater)
 UNIT_CALLIN_NO_PARAM(UnitEnteredAir)
 UNIT_CALLIN_NO_PARAM(UnitLeftWater)
 UNIT_CALLIN_NO_PARAM(UnitLeftAir)
-UNIT_CALLIN_NO_PARAM(UnitMoved)
 
 #define UNIT_CALLIN_INT_PARAMS(name)                                              \
 	inline void CEventHandler:: Unit ## name (const CUnit* unit, int p1, int p2)  \
@@ -513,17 +520,6 @@ inline void CEventHandler::UnitCmdDone(const CUnit* unit,
 }
 
 
-inline void CEventHandler::UnitDamaged(
-	const CUnit* unit,
-	const CUnit* attacker,
-	float damage,
-	int weaponDefID,
-	int projectileID,
-	bool paralyzer)
-{
-	ITERATE_UNIT_ALLYTEAM_EVENTCLIENTLIST(UnitDamaged, unit, attacker, damage, weaponDefID, projectileID, paralyzer)
-}
-
 inline void CEventHandler::UnitStunned(
 	const CUnit* unit,
 	bool stunned)
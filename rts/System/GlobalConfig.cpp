@@ -48,6 +48,12 @@ CONFIG(int, LinkIncomingMaxWaitingPackets)
 	.defaultValue(512)
 	.minimumValue(0);
 
+CONFIG(int, NetworkCompressionLevel)
+	.defaultValue(0)
+	.minimumValue(0)
+	.maximumValue(9)
+	.description("zlib level (1-9) at which UDP connections compress their traffic if both sides enable it, 0 disables compression.");
+
 CONFIG(int, TeamHighlight)
 	.defaultValue(CTeamHighlight::HIGHLIGHT_PLAYERS)
 	.minimumValue(CTeamHighlight::HIGHLIGHT_FIRST)
@@ -76,6 +82,7 @@ void GlobalConfig::Init()
 	linkIncomingPeakBandwidth = configHandler->GetInt("LinkIncomingPeakBandwidth");
 	linkIncomingMaxPacketRate = configHandler->GetInt("LinkIncomingMaxPacketRate");
 	linkIncomingMaxWaitingPackets = configHandler->GetInt("LinkIncomingMaxWaitingPackets");
+	networkCompressionLevel = configHandler->GetInt("NetworkCompressionLevel");
 
 	if (linkIncomingSustainedBandwidth > 0 && linkIncomingPeakBandwidth < linkIncomingSustainedBandwidth)
 		linkIncomingPeakBandwidth = linkIncomingSustainedBandwidth;
@@ -81,6 +81,14 @@ public:
 	 */
 	int linkIncomingMaxWaitingPackets = 512;
 
+	/**
+	 * @brief networkCompressionLevel
+	 *
+	 * zlib level used to compress what UDP connections send, if the other
+	 * side has it enabled as well; 0 disables compression
+	 */
+	int networkCompressionLevel = 0;
+
 	/**
 	 * @brief useNetMessageSmoothingBuffer
 	 *
@@ -82,6 +82,11 @@ public:
 
 	val_type state() const { return val; }
 
+	template<typename S> void Serialize(S* s) {
+		s->SerializeInt(&val, sizeof(val));
+		s->SerializeInt(&seq, sizeof(seq));
+	}
+
 public:
 	static constexpr res_type min_res = std::numeric_limits<res_type>::min();
 	static constexpr res_type max_res = std::numeric_limits<res_type>::max();
@@ -114,6 +119,13 @@ public:
 	rng_val_type GetLastSeed() const { return lastSeed; }
 	rng_val_type GetGenState() const { return (gen.state()); }
 
+	// S is a creg::ISerializer, not included here to keep this header light
+	template<typename S> void Serialize(S* s) {
+		gen.Serialize(s);
+		s->SerializeInt(&initSeed, sizeof(initSeed));
+		s->SerializeInt(&lastSeed, sizeof(lastSeed));
+	}
+
 	// needed for std::{random_}shuffle
 	rng_res_type operator()(              ) { return (gen. next( )); }
 	rng_res_type operator()(rng_res_type N) { return (gen.bnext(N)); }
@@ -13,6 +13,8 @@
 #include "Game/GlobalUnsynced.h"
 #include "Game/WaitCommandsAI.h"
 #include "Game/UI/Groups/GroupHandler.h"
+#include "Lua/LuaGaia.h"
+#include "Lua/LuaRules.h"
 #include "Net/GameServer.h"
 #include "Sim/Features/FeatureHandler.h"
 #include "Sim/Units/UnitHandler.h"
@@ -43,6 +45,7 @@
 
 CCregLoadSaveHandler::CCregLoadSaveHandler()
 	: iss(nullptr)
+	, isSnapshot(false)
 {}
 
 CCregLoadSaveHandler::~CCregLoadSaveHandler()
@@ -122,14 +125,10 @@ static void ReadString(std::istream& s, std::string& str)
 
 
 
-void CCregLoadSaveHandler::SaveGame(const std::string& path)
+bool CCregLoadSaveHandler::SaveGameState(std::ostream& oss)
 {
 #ifdef USING_CREG
-	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
-
 	try {
-		std::stringstream oss;
-
 		// write our own header. SavePackage() will add its own
 		WriteString(oss, SpringVersion::GetSync());
 		WriteString(oss, gameSetup->setupText);
@@ -138,26 +137,52 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 
 		CGameStateCollector gsc = CGameStateCollector();
 
-		{
-			// save creg state
-			creg::COutputStreamSerializer os;
-			os.SavePackage(&oss, &gsc, gsc.GetClass());
-			PrintSize("Game", oss.tellp());
-
-			// save AI state
-			const int aiStart = oss.tellp();
-
-			for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
-				std::stringstream aiData;
-				eoh->Save(&aiData, ai.first);
-
-				std::streamsize aiSize = aiData.tellp();
-				os.SerializeInt(&aiSize, sizeof(aiSize));
-				if (aiSize > 0)
-					oss << aiData.rdbuf();
-			}
-			PrintSize("AIs", ((int)oss.tellp()) - aiStart);
+		// save creg state
+		creg::COutputStreamSerializer os;
+		os.SavePackage(&oss, &gsc, gsc.GetClass());
+		PrintSize("Game", oss.tellp());
+
+		// save AI state
+		const int aiStart = oss.tellp();
+
+		for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
+			std::stringstream aiData;
+			eoh->Save(&aiData, ai.first);
+
+			std::streamsize aiSize = aiData.tellp();
+			os.SerializeInt(&aiSize, sizeof(aiSize));
+			if (aiSize > 0)
+				oss << aiData.rdbuf();
 		}
+		PrintSize("AIs", ((int)oss.tellp()) - aiStart);
+		return true;
+	} catch (const content_error& ex) {
+		LOG_L(L_ERROR, "[LSH::%s] content error \"%s\"", __func__, ex.what());
+	} catch (const std::exception& ex) {
+		LOG_L(L_ERROR, "[LSH::%s] exception \"%s\"", __func__, ex.what());
+	} catch (const char*& exStr) {
+		LOG_L(L_ERROR, "[LSH::%s] cstr error \"%s\"", __func__, exStr);
+	} catch (const std::string& str) {
+		LOG_L(L_ERROR, "[LSH::%s] str error \"%s\"", __func__, str.c_str());
+	} catch (...) {
+		LOG_L(L_ERROR, "[LSH::%s] unknown error", __func__);
+	}
+#else //USING_CREG
+	LOG_L(L_ERROR, "[LSH::%s] creg is disabled", __func__);
+#endif //USING_CREG
+	return false;
+}
+
+void CCregLoadSaveHandler::SaveGame(const std::string& path)
+{
+#ifdef USING_CREG
+	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
+
+	try {
+		std::stringstream oss;
+
+		if (!SaveGameState(oss))
+			return;
 
 		{
 			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb9");
@@ -207,6 +232,23 @@ void CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 	while ((len = saveFile.Read(buf, sizeof(buf))) > 0)
 		sbuf->sputn(buf, len);
 
+	ReadGameStartInfo();
+
+	CGameSetup::LoadSavedScript(path, scriptText);
+}
+
+void CCregLoadSaveHandler::LoadGameStateInfo(const std::string& data)
+{
+	iss = new std::stringstream(data);
+
+	// the setup-script was already received from the server as GAMEDATA
+	ReadGameStartInfo();
+
+	isSnapshot = true;
+}
+
+void CCregLoadSaveHandler::ReadGameStartInfo()
+{
 	//Check for compatible save versions
 	std::string saveVersion;
 	ReadString(*iss, saveVersion);
@@ -234,14 +276,17 @@ void CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 	ReadString(*iss, scriptText);
 	ReadString(*iss, modName);
 	ReadString(*iss, mapName);
-
-	CGameSetup::LoadSavedScript(path, scriptText);
 }
 
 /// this should be called on frame 0 when the game has started
 void CCregLoadSaveHandler::LoadGame()
 {
 #ifdef USING_CREG
+	// creg saves do not contain synced Lua state, it would stay at its initial
+	// values (clients refuse to make snapshots while synced Lua is running)
+	if (isSnapshot && (luaRules != nullptr || luaGaia != nullptr))
+		throw content_error("game-state snapshots can not restore synced Lua state");
+
 	ENTER_SYNCED_CODE();
 
 	void* pGSC = nullptr;
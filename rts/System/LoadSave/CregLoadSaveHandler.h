@@ -17,8 +17,23 @@ public:
 	void LoadGameStartInfo(const std::string& path);
 	void LoadGame();
 
+	/// writes the same (uncompressed) data as SaveGame to <oss>, returns false on error
+	bool SaveGameState(std::ostream& oss);
+	/**
+	 * Like LoadGameStartInfo, but for a game-state snapshot received from the
+	 * server (written by SaveGameState on an in-sync client) when joining
+	 * mid-game; the setup-script is not reloaded.
+	 */
+	void LoadGameStateInfo(const std::string& data);
+	bool IsSnapshot() const { return isSnapshot; }
+
+protected:
+	void ReadGameStartInfo();
+
 protected:
 	std::stringstream* iss;
+
+	bool isSnapshot;
 };
 
 #endif // CREG_LOAD_SAVE_HANDLER_H
@@ -21,6 +21,8 @@ public:
 	/// load things such as map and mod, needed to fire up the engine
 	virtual void LoadGameStartInfo(const std::string& file) = 0;
 	virtual void LoadGame() = 0;
+	/// whether this was received from the server when joining mid-game
+	virtual bool IsSnapshot() const { return false; }
 
 	std::string scriptText;
 	std::string mapName;
@@ -0,0 +1,108 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <zlib.h>
+
+#include "ChunkCompression.h"
+
+namespace netcode
+{
+
+// raw deflate (no zlib header or checksum, chunks are checked already) with an 8KB window
+static constexpr int WINDOW_BITS = -13;
+static constexpr int MEM_LEVEL = 6;
+static constexpr size_t OUTPUT_STEP = 1024;
+
+
+ChunkDeflater::ChunkDeflater(int level): stream(new z_stream())
+{
+	if (deflateInit2(stream.get(), level, Z_DEFLATED, WINDOW_BITS, MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+		stream.reset();
+}
+
+ChunkDeflater::~ChunkDeflater()
+{
+	if (stream != nullptr)
+		deflateEnd(stream.get());
+}
+
+bool ChunkDeflater::Deflate(const std::uint8_t* data, unsigned length, bool flush, std::vector<std::uint8_t>& out)
+{
+	if (stream == nullptr)
+		return false;
+
+	const spring_time t0 = spring_gettime();
+	const size_t outSize = out.size();
+
+	stream->next_in = const_cast<Bytef*>(data);
+	stream->avail_in = length;
+
+	int ret = Z_OK;
+
+	do {
+		const size_t pos = out.size();
+
+		out.resize(pos + OUTPUT_STEP);
+		stream->next_out = &out[pos];
+		stream->avail_out = OUTPUT_STEP;
+
+		ret = deflate(stream.get(), flush? Z_PARTIAL_FLUSH: Z_NO_FLUSH);
+
+		out.resize(pos + OUTPUT_STEP - stream->avail_out);
+	} while (ret == Z_OK && stream->avail_out == 0);
+
+	rawBytes += length;
+	packedBytes += (out.size() - outSize);
+	time += (spring_gettime() - t0);
+
+	// Z_BUF_ERROR only means there was nothing left to do
+	return ((ret == Z_OK || ret == Z_BUF_ERROR) && stream->avail_in == 0);
+}
+
+
+
+ChunkInflater::ChunkInflater(): stream(new z_stream())
+{
+	if (inflateInit2(stream.get(), WINDOW_BITS) != Z_OK)
+		stream.reset();
+}
+
+ChunkInflater::~ChunkInflater()
+{
+	if (stream != nullptr)
+		inflateEnd(stream.get());
+}
+
+bool ChunkInflater::Inflate(const std::uint8_t* data, unsigned length, std::vector<std::uint8_t>& out)
+{
+	out.clear();
+
+	if (stream == nullptr)
+		return false;
+
+	const spring_time t0 = spring_gettime();
+
+	stream->next_in = const_cast<Bytef*>(data);
+	stream->avail_in = length;
+
+	int ret = Z_OK;
+
+	do {
+		const size_t pos = out.size();
+
+		out.resize(pos + OUTPUT_STEP);
+		stream->next_out = &out[pos];
+		stream->avail_out = OUTPUT_STEP;
+
+		ret = inflate(stream.get(), Z_NO_FLUSH);
+
+		out.resize(pos + OUTPUT_STEP - stream->avail_out);
+	} while (ret == Z_OK && (stream->avail_in > 0 || stream->avail_out == 0));
+
+	rawBytes += out.size();
+	packedBytes += length;
+	time += (spring_gettime() - t0);
+
+	return ((ret == Z_OK || ret == Z_BUF_ERROR) && stream->avail_in == 0);
+}
+
+} // namespace netcode
@@ -0,0 +1,80 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _CHUNK_COMPRESSION_H
+#define _CHUNK_COMPRESSION_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "System/Misc/NonCopyable.h"
+#include "System/Misc/SpringTime.h"
+
+struct z_stream_s;
+
+namespace netcode
+{
+
+/**
+ * @brief zlib stream over the chunk data one side of a UDPConnection sends
+ *
+ * The stream lives as long as the connection, so later chunks are encoded
+ * against everything sent before (within the window), which is what makes
+ * the small and repetitive command streams compressible at all. A raw
+ * deflate stream with a small window is used to keep per-connection memory
+ * low (about 64KB for the deflater, 8KB for the inflater).
+ */
+class ChunkDeflater : spring::noncopyable
+{
+public:
+	explicit ChunkDeflater(int level);
+	~ChunkDeflater();
+
+	/**
+	 * @brief compresses <data> and appends the output to <out>
+	 * @param flush if true, <out> receives everything needed to inflate
+	 *        all data handed in so far
+	 */
+	bool Deflate(const std::uint8_t* data, unsigned length, bool flush, std::vector<std::uint8_t>& out);
+
+	bool IsValid() const { return (stream != nullptr); }
+
+	std::uint64_t GetRawBytes() const { return rawBytes; }
+	std::uint64_t GetPackedBytes() const { return packedBytes; }
+	spring_time GetTime() const { return time; }
+
+private:
+	std::unique_ptr<z_stream_s> stream;
+
+	std::uint64_t rawBytes = 0;
+	std::uint64_t packedBytes = 0;
+	spring_time time;
+};
+
+
+class ChunkInflater : spring::noncopyable
+{
+public:
+	ChunkInflater();
+	~ChunkInflater();
+
+	/// replaces the contents of <out> by the inflated <data>, false on a corrupt stream
+	bool Inflate(const std::uint8_t* data, unsigned length, std::vector<std::uint8_t>& out);
+
+	bool IsValid() const { return (stream != nullptr); }
+
+	std::uint64_t GetRawBytes() const { return rawBytes; }
+	std::uint64_t GetPackedBytes() const { return packedBytes; }
+	spring_time GetTime() const { return time; }
+
+private:
+	std::unique_ptr<z_stream_s> stream;
+
+	std::uint64_t rawBytes = 0;
+	std::uint64_t packedBytes = 0;
+	spring_time time;
+};
+
+} // namespace netcode
+
+#endif // _CHUNK_COMPRESSION_H
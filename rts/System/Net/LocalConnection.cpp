@@ -12,7 +12,7 @@ namespace netcode {
 // static stuff
 unsigned int CLocalConnection::numInstances = 0;
 
-std::deque< std::shared_ptr<const RawPacket> > CLocalConnection::pktQueues[CLocalConnection::MAX_INSTANCES];
+CLocalConnection::PacketQueue CLocalConnection::pktQueues[CLocalConnection::MAX_INSTANCES];
 spring::mutex CLocalConnection::mutexes[CLocalConnection::MAX_INSTANCES];
 CLocalConnection* CLocalConnection::instancePtrs[MAX_INSTANCES] = {nullptr, nullptr};
 
@@ -72,7 +72,7 @@ void CLocalConnection::SendData(std::shared_ptr<const RawPacket> pkt)
 std::shared_ptr<const RawPacket> CLocalConnection::GetData()
 {
 	std::lock_guard<spring::mutex> scoped_lock(mutexes[instanceIdx]);
-	std::deque<std::shared_ptr<const RawPacket>>& pktQueue = pktQueues[instanceIdx];
+	PacketQueue& pktQueue = pktQueues[instanceIdx];
 
 	if (pktQueue.empty())
 		return {};
@@ -88,7 +88,7 @@ std::shared_ptr<const RawPacket> CLocalConnection::GetData()
 std::shared_ptr<const RawPacket> CLocalConnection::Peek(unsigned ahead) const
 {
 	std::lock_guard<spring::mutex> scoped_lock(mutexes[instanceIdx]);
-	std::deque<std::shared_ptr<const RawPacket>>& pktQueue = pktQueues[instanceIdx];
+	PacketQueue& pktQueue = pktQueues[instanceIdx];
 
 	if (ahead >= pktQueue.size())
 		return {};
@@ -99,7 +99,7 @@ std::shared_ptr<const RawPacket> CLocalConnection::Peek(unsigned ahead) const
 void CLocalConnection::DeleteBufferPacketAt(unsigned index)
 {
 	std::lock_guard<spring::mutex> scoped_lock(mutexes[instanceIdx]);
-	std::deque<std::shared_ptr<const RawPacket>>& pktQueue = pktQueues[instanceIdx];
+	PacketQueue& pktQueue = pktQueues[instanceIdx];
 
 	if (index >= pktQueue.size())
 		return;
@@ -7,6 +7,7 @@
 #include "System/Threading/SpringThreading.h"
 
 #include "Connection.h"
+#include "PacketPool.h"
 
 namespace netcode {
 
@@ -55,7 +56,9 @@ public:
 private:
 	static constexpr unsigned int MAX_INSTANCES = 2;
 
-	static std::deque< std::shared_ptr<const RawPacket> > pktQueues[MAX_INSTANCES];
+	typedef std::deque< std::shared_ptr<const RawPacket>, PacketPoolAllocator< std::shared_ptr<const RawPacket> > > PacketQueue;
+
+	static PacketQueue pktQueues[MAX_INSTANCES];
 	static spring::mutex mutexes[MAX_INSTANCES];
 	static CLocalConnection* instancePtrs[MAX_INSTANCES];
 
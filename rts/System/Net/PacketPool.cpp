@@ -0,0 +1,164 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <new>
+
+#include "PacketPool.h"
+#include "System/Threading/SpringThreading.h"
+
+namespace netcode
+{
+
+// every block starts with its size-class index, payloads stay max-aligned
+static constexpr size_t BLOCK_HEADER_SIZE = alignof(std::max_align_t);
+static constexpr std::uint32_t HEAP_CLASS_INDEX = PacketPool::NUM_SIZE_CLASSES;
+
+static_assert(BLOCK_HEADER_SIZE >= sizeof(std::uint32_t), "");
+static_assert(PacketPool::MIN_BLOCK_SIZE > BLOCK_HEADER_SIZE, "");
+static_assert((PacketPool::SLAB_SIZE % PacketPool::MAX_BLOCK_SIZE) == 0, "");
+
+struct FreeBlock {
+	FreeBlock* next;
+};
+
+struct SizeClass {
+	spring::spinlock mutex;
+
+	FreeBlock* freeList = nullptr;
+
+	// unused tail of the most recent slab
+	std::uint8_t* slabPos = nullptr;
+	std::uint8_t* slabEnd = nullptr;
+};
+
+struct PoolState {
+	SizeClass sizeClasses[PacketPool::NUM_SIZE_CLASSES];
+
+	std::atomic<std::uint64_t> numUsedBlocks = {0};
+	std::atomic<std::uint64_t> numPoolAllocs = {0};
+	std::atomic<std::uint64_t> numHeapAllocs = {0};
+	std::atomic<std::uint64_t> numSlabBytes = {0};
+};
+
+
+static PoolState& GetPoolState()
+{
+	// never destroyed: packets held by static queues (e.g. LocalConnection)
+	// are released during static destruction, after any local static would
+	// already be gone
+	static PoolState* state = new PoolState();
+	return *state;
+}
+
+static std::uint32_t GetSizeClassIndex(size_t size)
+{
+	std::uint32_t idx = 0;
+
+	for (size_t blockSize = PacketPool::MIN_BLOCK_SIZE; blockSize < size; blockSize <<= 1) {
+		idx += 1;
+	}
+
+	return idx;
+}
+
+
+void* PacketPool::Alloc(size_t size)
+{
+	PoolState& state = GetPoolState();
+
+	const size_t blockSize = size + BLOCK_HEADER_SIZE;
+	const std::uint32_t classIdx = (blockSize <= MAX_BLOCK_SIZE)? GetSizeClassIndex(blockSize): HEAP_CLASS_INDEX;
+
+	std::uint8_t* block = nullptr;
+
+	state.numUsedBlocks.fetch_add(1, std::memory_order_relaxed);
+
+	if (classIdx == HEAP_CLASS_INDEX) {
+		block = static_cast<std::uint8_t*>(::operator new(blockSize));
+		state.numHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+	} else {
+		SizeClass& sc = state.sizeClasses[classIdx];
+
+		{
+			std::lock_guard<spring::spinlock> lock(sc.mutex);
+
+			if (sc.freeList != nullptr) {
+				block = reinterpret_cast<std::uint8_t*>(sc.freeList);
+				sc.freeList = sc.freeList->next;
+			} else if (sc.slabPos != sc.slabEnd) {
+				block = sc.slabPos;
+				sc.slabPos += (MIN_BLOCK_SIZE << classIdx);
+			}
+		}
+
+		if (block != nullptr) {
+			state.numPoolAllocs.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			// carve a fresh slab outside the lock; a concurrent Alloc that also
+			// found the class empty just starts another one, nothing is lost
+			std::uint8_t* slab = static_cast<std::uint8_t*>(::operator new(SLAB_SIZE));
+
+			state.numSlabBytes.fetch_add(SLAB_SIZE, std::memory_order_relaxed);
+			state.numHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+
+			std::lock_guard<spring::spinlock> lock(sc.mutex);
+
+			// hand the rest of the previous slab to the free-list
+			for (std::uint8_t* pos = sc.slabPos; pos != sc.slabEnd; pos += (MIN_BLOCK_SIZE << classIdx)) {
+				FreeBlock* fb = reinterpret_cast<FreeBlock*>(pos);
+				fb->next = sc.freeList;
+				sc.freeList = fb;
+			}
+
+			block = slab;
+			sc.slabPos = slab + (MIN_BLOCK_SIZE << classIdx);
+			sc.slabEnd = slab + SLAB_SIZE;
+		}
+	}
+
+	*reinterpret_cast<std::uint32_t*>(block) = classIdx;
+	return (block + BLOCK_HEADER_SIZE);
+}
+
+void PacketPool::Free(void* ptr)
+{
+	if (ptr == nullptr)
+		return;
+
+	PoolState& state = GetPoolState();
+
+	std::uint8_t* block = static_cast<std::uint8_t*>(ptr) - BLOCK_HEADER_SIZE;
+	const std::uint32_t classIdx = *reinterpret_cast<const std::uint32_t*>(block);
+
+	assert(classIdx <= HEAP_CLASS_INDEX);
+	state.numUsedBlocks.fetch_sub(1, std::memory_order_relaxed);
+
+	if (classIdx == HEAP_CLASS_INDEX) {
+		::operator delete(block);
+		return;
+	}
+
+	SizeClass& sc = state.sizeClasses[classIdx];
+	FreeBlock* fb = reinterpret_cast<FreeBlock*>(block);
+
+	std::lock_guard<spring::spinlock> lock(sc.mutex);
+	fb->next = sc.freeList;
+	sc.freeList = fb;
+}
+
+
+PacketPool::Stats PacketPool::GetStats()
+{
+	const PoolState& state = GetPoolState();
+
+	return {
+		state.numUsedBlocks.load(std::memory_order_relaxed),
+		state.numPoolAllocs.load(std::memory_order_relaxed),
+		state.numHeapAllocs.load(std::memory_order_relaxed),
+		state.numSlabBytes.load(std::memory_order_relaxed),
+	};
+}
+
+} // namespace netcode
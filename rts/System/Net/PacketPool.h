@@ -0,0 +1,74 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace netcode
+{
+
+/**
+ * @brief size-classed memory pool shared by all network packets
+ *
+ * Messages are small and short-lived, but created and released at a high
+ * rate and often on different threads (e.g. server -> LocalConnection ->
+ * client), so each size class keeps its own spinlocked free-list of blocks
+ * carved out of larger slabs. Slabs are kept for the lifetime of the
+ * process; anything larger than the biggest class goes to the heap.
+ */
+class PacketPool
+{
+public:
+	struct Stats {
+		/// current number of blocks handed out, pooled and heap
+		std::uint64_t numUsedBlocks;
+		/// total number of Alloc calls served without going to the heap
+		std::uint64_t numPoolAllocs;
+		/// total number of Alloc calls that needed a new slab or a heap block
+		std::uint64_t numHeapAllocs;
+		/// bytes reserved for slabs
+		std::uint64_t numSlabBytes;
+	};
+
+	static void* Alloc(size_t size);
+	static void Free(void* ptr);
+
+	static Stats GetStats();
+
+	static constexpr size_t NUM_SIZE_CLASSES = 8;
+	static constexpr size_t MIN_BLOCK_SIZE = 32;
+	static constexpr size_t MAX_BLOCK_SIZE = MIN_BLOCK_SIZE << (NUM_SIZE_CLASSES - 1);
+	static constexpr size_t SLAB_SIZE = 64 * 1024;
+};
+
+
+/**
+ * @brief std-allocator drawing from PacketPool
+ * Used with std::allocate_shared, an object and its refcount end up in a
+ * single pooled block.
+ */
+template<typename T> struct PacketPoolAllocator {
+public:
+	typedef T value_type;
+
+	PacketPoolAllocator() = default;
+	template<typename U> PacketPoolAllocator(const PacketPoolAllocator<U>&) {}
+
+	T* allocate(size_t n) { return (static_cast<T*>(PacketPool::Alloc(n * sizeof(T)))); }
+	void deallocate(T* p, size_t n) { PacketPool::Free(p); }
+
+	template<typename U> bool operator == (const PacketPoolAllocator<U>&) const { return true; }
+	template<typename U> bool operator != (const PacketPoolAllocator<U>&) const { return false; }
+};
+
+
+template<typename T, typename... A> std::shared_ptr<T> AllocPacket(A&&... a) {
+	return (std::allocate_shared<T>(PacketPoolAllocator<T>(), std::forward<A>(a)...));
+}
+
+} // namespace netcode
+
+#endif // PACKET_POOL_H
@@ -13,7 +13,7 @@ namespace netcode
 RawPacket::RawPacket(const uint8_t* const tdata, const uint32_t newLength): length(newLength)
 {
 	if (length > 0) {
-		data = new uint8_t[length];
+		data = static_cast<uint8_t*>(PacketPool::Alloc(length));
 		memcpy(data, tdata, length);
 	} else {
 		LOG_L(L_ERROR, "[%s] tried to pack a zero-length packet", __func__);
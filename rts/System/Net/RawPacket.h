@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <utility>
 
+#include "PacketPool.h"
 #include "System/Misc/NonCopyable.h"
 
 namespace netcode
@@ -13,6 +14,7 @@ namespace netcode
 
 /**
  * @brief simple structure to hold some data
+ * Both the packet object and its data are taken from the PacketPool.
  */
 class RawPacket : public spring::noncopyable
 {
@@ -34,7 +36,7 @@ public:
 		if (length == 0)
 			return;
 
-		data = new uint8_t[length];
+		data = static_cast<uint8_t*>(PacketPool::Alloc(length));
 	}
 
 	RawPacket(RawPacket&& p) { *this = std::move(p); }
@@ -53,12 +55,15 @@ public:
 		if (length == 0)
 			return;
 
-		delete[] data;
+		PacketPool::Free(data);
 		data = nullptr;
 
 		length = 0;
 	}
 
+	static void* operator new(size_t size) { return (PacketPool::Alloc(size)); }
+	static void operator delete(void* ptr) { PacketPool::Free(ptr); }
+
 	uint8_t* data = nullptr;
 	uint32_t length = 0;
 };
@@ -0,0 +1,257 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "UDPBatchIO.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include "PacketPool.h"
+#include "RawPacket.h"
+#include "Socket.h"
+#include "UDPConnection.h"
+#include "System/Log/ILog.h"
+
+namespace netcode
+{
+
+#if UDP_BATCHED_IO
+// cleared the first time the kernel reports it lacks the call
+static std::atomic<bool> haveRecvmmsg = {true};
+static std::atomic<bool> haveSendmmsg = {true};
+#endif
+
+
+unsigned UDPRecvRing::RecvBatch(asio::ip::udp::socket& socket)
+{
+	if (slots.empty()) {
+		slots.resize(NUM_SLOTS);
+
+		#if UDP_BATCHED_IO
+		msgs.resize(NUM_SLOTS);
+		iovecs.resize(NUM_SLOTS);
+		addrs.resize(NUM_SLOTS);
+		#endif
+	}
+
+	for (Slot& slot: slots) {
+		// buffers still referenced by chunks waiting for reassembly stay with them
+		if (slot.buffer == nullptr || slot.buffer.use_count() > 1) {
+			slot.buffer = AllocPacket<RawPacket>(udpMaxPacketSize);
+		}
+	}
+
+#if UDP_BATCHED_IO
+	while (haveRecvmmsg) {
+		for (unsigned i = 0; i < NUM_SLOTS; i++) {
+			iovecs[i].iov_base = slots[i].buffer->data;
+			iovecs[i].iov_len = udpMaxPacketSize;
+
+			std::memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_name = &addrs[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		const int numRecv = recvmmsg(socket.native_handle(), msgs.data(), NUM_SLOTS, MSG_DONTWAIT, nullptr);
+
+		if (numRecv < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (errno == ENOSYS) {
+				haveRecvmmsg = false;
+				break;
+			}
+
+			asio::error_code err(errno, asio::error::get_system_category());
+			CheckErrorCode(err);
+			return 0;
+		}
+
+		unsigned numValid = 0;
+
+		for (unsigned i = 0; i < unsigned(numRecv); i++) {
+			if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+				LOG_L(L_WARNING, "[UDPRecvRing::%s] dropped datagram larger than %u bytes", __func__, udpMaxPacketSize);
+				continue;
+			}
+
+			Slot& slot = slots[i];
+			asio::ip::udp::endpoint& sender = slot.sender;
+
+			slot.length = msgs[i].msg_len;
+
+			std::memcpy(sender.data(), &addrs[i], msgs[i].msg_hdr.msg_namelen);
+			sender.resize(msgs[i].msg_hdr.msg_namelen);
+
+			if (numValid != i)
+				std::swap(slots[numValid], slot);
+
+			numValid += 1;
+		}
+
+		// only truncated datagrams, there might be more behind them
+		if (numValid == 0 && numRecv > 0)
+			continue;
+
+		return numValid;
+	}
+#endif
+
+	unsigned numValid = 0;
+
+	while (numValid < NUM_SLOTS && socket.available() > 0) {
+		Slot& slot = slots[numValid];
+		asio::error_code err;
+
+		slot.length = socket.receive_from(asio::buffer(slot.buffer->data, udpMaxPacketSize), slot.sender, 0, err);
+
+		if (CheckErrorCode(err))
+			break;
+
+		numValid += (slot.length > 0);
+	}
+
+	return numValid;
+}
+
+
+
+void UDPSendBatch::Copy(const Datagram& dgram, const void* data, size_t size)
+{
+	// extend the previous segment if it is this datagram's and in the arena
+	if (segments.size() > dgram.firstSegment && segments.back().data == nullptr) {
+		segments.back().size += size;
+	} else {
+		segments.push_back({nullptr, arena.size(), size});
+	}
+
+	arena.insert(arena.end(), static_cast<const std::uint8_t*>(data), static_cast<const std::uint8_t*>(data) + size);
+}
+
+void UDPSendBatch::Gather(const std::uint8_t* data, size_t size)
+{
+	segments.push_back({data, 0, size});
+}
+
+
+void UDPSendBatch::Add(const Packet& packet)
+{
+	Datagram dgram = {segments.size(), 0, packet.GetSize()};
+
+	// same layout as Packet::Serialize
+	Copy(dgram, &packet.lastContinuous, sizeof(packet.lastContinuous));
+	Copy(dgram, &packet.nakType, sizeof(packet.nakType));
+	Copy(dgram, &packet.checksum, sizeof(packet.checksum));
+
+	if (!packet.naks.empty())
+		Copy(dgram, packet.naks.data(), packet.naks.size());
+
+	for (const ChunkPtr& chunk: packet.chunks) {
+		Copy(dgram, &chunk->chunkNumber, sizeof(chunk->chunkNumber));
+		Copy(dgram, &chunk->chunkSize, sizeof(chunk->chunkSize));
+
+		if (chunk->chunkSize < MIN_GATHER_SIZE) {
+			Copy(dgram, chunk->GetData(), chunk->chunkSize);
+		} else {
+			Gather(chunk->GetData(), chunk->chunkSize);
+			chunks.push_back(chunk);
+		}
+	}
+
+	dgram.numSegments = segments.size() - dgram.firstSegment;
+	datagrams.push_back(dgram);
+}
+
+
+UDPSendBatch::Result UDPSendBatch::Send(asio::ip::udp::socket& socket, const asio::ip::udp::endpoint& addr, asio::error_code& err)
+{
+	Result result;
+	bool batched = false;
+
+#if UDP_BATCHED_IO
+	if ((batched = haveSendmmsg)) {
+		iovecs.clear();
+		iovecs.reserve(segments.size());
+		msgs.clear();
+		msgs.resize(datagrams.size());
+
+		for (const Segment& s: segments) {
+			iovecs.push_back({const_cast<std::uint8_t*>(GetSegmentData(s)), s.size});
+		}
+
+		for (size_t i = 0; i < datagrams.size(); i++) {
+			std::memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_name = const_cast<asio::ip::udp::endpoint::data_type*>(addr.data());
+			msgs[i].msg_hdr.msg_namelen = addr.size();
+			msgs[i].msg_hdr.msg_iov = &iovecs[datagrams[i].firstSegment];
+			msgs[i].msg_hdr.msg_iovlen = datagrams[i].numSegments;
+		}
+
+		size_t numSent = 0;
+
+		while (numSent < msgs.size()) {
+			const int ret = sendmmsg(socket.native_handle(), &msgs[numSent], msgs.size() - numSent, 0);
+
+			if (ret < 0) {
+				if (errno == EINTR)
+					continue;
+
+				if (errno == ENOSYS && numSent == 0) {
+					haveSendmmsg = false;
+					batched = false;
+					break;
+				}
+
+				err = asio::error_code(errno, asio::error::get_system_category());
+				break;
+			}
+
+			for (int i = 0; i < ret; i++) {
+				result.numBytes += msgs[numSent + i].msg_len;
+			}
+
+			result.numPackets += ret;
+			numSent += ret;
+		}
+	}
+#endif
+
+	if (!batched)
+		result = SendSerialized(socket, addr, err);
+
+	datagrams.clear();
+	segments.clear();
+	arena.clear();
+	chunks.clear();
+	return result;
+}
+
+UDPSendBatch::Result UDPSendBatch::SendSerialized(asio::ip::udp::socket& socket, const asio::ip::udp::endpoint& addr, asio::error_code& err)
+{
+	Result result;
+
+	for (const Datagram& dgram: datagrams) {
+		sendBuffer.clear();
+		sendBuffer.reserve(dgram.size);
+
+		for (size_t i = dgram.firstSegment; i < (dgram.firstSegment + dgram.numSegments); i++) {
+			const std::uint8_t* data = GetSegmentData(segments[i]);
+			sendBuffer.insert(sendBuffer.end(), data, data + segments[i].size);
+		}
+
+		socket.send_to(asio::buffer(sendBuffer), addr, 0, err);
+
+		if (err)
+			break;
+
+		result.numBytes += sendBuffer.size();
+		result.numPackets += 1;
+	}
+
+	return result;
+}
+
+} // namespace netcode
@@ -0,0 +1,161 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _UDP_BATCH_IO_H
+#define _UDP_BATCH_IO_H
+
+#include <asio/ip/udp.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if defined(__linux__)
+	#include <sys/socket.h>
+	#define UDP_BATCHED_IO 1
+#else
+	#define UDP_BATCHED_IO 0
+#endif
+
+namespace netcode
+{
+class RawPacket;
+class Chunk;
+class Packet;
+
+/// largest datagram we send or accept
+static constexpr unsigned udpMaxPacketSize = 4096;
+
+
+/**
+ * @brief Receives queued datagrams in batches, without copying them again
+ *
+ * Each slot is a pooled RawPacket the kernel writes one datagram into; chunks
+ * parsed from it keep referencing that buffer (see Packet), so a slot is
+ * only reused once nothing points into it anymore and replaced otherwise.
+ * On Linux a whole batch is fetched with one recvmmsg call, elsewhere (or if
+ * the kernel lacks it) with one receive_from per datagram.
+ */
+class UDPRecvRing
+{
+public:
+	static constexpr unsigned NUM_SLOTS = 32;
+
+	/**
+	 * @brief calls func(datagram, length, sender) for each received datagram
+	 * Stops when the socket has no more data or func returns false; datagrams
+	 * already read but not yet handed to func are kept for the next call.
+	 */
+	template<typename F> void Receive(asio::ip::udp::socket& socket, F func);
+
+private:
+	struct Slot {
+		std::shared_ptr<RawPacket> buffer;
+		asio::ip::udp::endpoint sender;
+		unsigned length = 0;
+	};
+
+	/// fills slots [0, numSlots) from the socket, returns numSlots
+	unsigned RecvBatch(asio::ip::udp::socket& socket);
+
+private:
+	std::vector<Slot> slots;
+
+#if UDP_BATCHED_IO
+	std::vector<struct mmsghdr> msgs;
+	std::vector<struct iovec> iovecs;
+	std::vector<struct sockaddr_storage> addrs;
+#endif
+
+	unsigned nextSlot = 0;
+	unsigned numSlots = 0;
+};
+
+
+/**
+ * @brief Collects the datagrams of one UDPConnection update and sends them together
+ *
+ * Datagrams are not serialized: headers and small payloads are copied into
+ * an arena, larger chunk payloads are handed to the kernel in place (via
+ * scatter-gather) and their chunks referenced until sent. On Linux all
+ * datagrams leave in a single sendmmsg call, elsewhere each is assembled
+ * and sent via asio.
+ */
+class UDPSendBatch
+{
+public:
+	struct Result {
+		unsigned numBytes = 0;
+		unsigned numPackets = 0;
+	};
+
+	/// payloads smaller than this are cheaper to copy than to gather
+	static constexpr unsigned MIN_GATHER_SIZE = 64;
+
+	bool Empty() const { return datagrams.empty(); }
+
+	void Add(const Packet& packet);
+
+	/**
+	 * @brief sends and clears all queued datagrams
+	 * Stops at the first error, which is returned in err; datagrams not sent
+	 * by then are dropped, as they would be on the wire.
+	 */
+	Result Send(asio::ip::udp::socket& socket, const asio::ip::udp::endpoint& addr, asio::error_code& err);
+
+private:
+	struct Segment {
+		/// nullptr if the bytes are at <pos> in arena
+		const std::uint8_t* data;
+		size_t pos;
+		size_t size;
+	};
+
+	struct Datagram {
+		size_t firstSegment;
+		size_t numSegments;
+		size_t size;
+	};
+
+	void Copy(const Datagram& dgram, const void* data, size_t size);
+	void Gather(const std::uint8_t* data, size_t size);
+
+	const std::uint8_t* GetSegmentData(const Segment& s) const { return ((s.data != nullptr)? s.data: &arena[s.pos]); }
+
+	Result SendSerialized(asio::ip::udp::socket& socket, const asio::ip::udp::endpoint& addr, asio::error_code& err);
+
+private:
+	std::vector<Datagram> datagrams;
+	std::vector<Segment> segments;
+	std::vector<std::uint8_t> arena;
+
+	/// keeps gathered payloads alive until sent
+	std::vector< std::shared_ptr<Chunk> > chunks;
+
+#if UDP_BATCHED_IO
+	std::vector<struct mmsghdr> msgs;
+	std::vector<struct iovec> iovecs;
+#endif
+
+	std::vector<std::uint8_t> sendBuffer;
+};
+
+
+template<typename F> void UDPRecvRing::Receive(asio::ip::udp::socket& socket, F func)
+{
+	while (true) {
+		if (nextSlot == numSlots) {
+			nextSlot = 0;
+
+			if ((numSlots = RecvBatch(socket)) == 0)
+				return;
+		}
+
+		const Slot& slot = slots[nextSlot++];
+
+		if (!func(std::shared_ptr<const RawPacket>(slot.buffer), slot.length, slot.sender))
+			return;
+	}
+}
+
+} // namespace netcode
+
+#endif // _UDP_BATCH_IO_H
@@ -25,7 +25,6 @@ CONFIG(bool, UDPConnectionLogDebugMessages).defaultValue(false);
 namespace netcode {
 using namespace asio;
 
-static constexpr unsigned udpMaxPacketSize = 4096;
 static constexpr int maxChunkSize = 254;
 static constexpr int chunksPerSec = 30;
 
@@ -97,11 +96,13 @@ public:
 		pos += sizeof(t);
 	}
 
-	void Unpack(std::vector<std::uint8_t>& t, unsigned unpackLength) {
-		std::copy(data + pos, data + pos + unpackLength, std::back_inserter(t));
-		pos += unpackLength;
+	void Skip(unsigned skipLength) {
+		pos += skipLength;
 	}
 
+	unsigned Position() const {
+		return pos;
+	}
 	unsigned Remaining() const {
 		return length - std::min(pos, length);
 	}
@@ -126,10 +127,15 @@ public:
 		*reinterpret_cast<T*>(&data[pos]) = t;
 	}
 
-	void Pack(std::vector<std::uint8_t>& _data) {
+	template<typename A>
+	void Pack(std::vector<std::uint8_t, A>& _data) {
 		std::copy(_data.begin(), _data.end(), std::back_inserter(data));
 	}
 
+	void Pack(const std::uint8_t* _data, unsigned length) {
+		data.insert(data.end(), _data, _data + length);
+	}
+
 private:
 	std::vector<std::uint8_t>& data;
 };
@@ -141,16 +147,16 @@ void Chunk::UpdateChecksum(CRC& crc) const {
 	crc << chunkNumber;
 	crc << (unsigned int)chunkSize;
 
-	if (!data.empty()) {
-		crc.Update(&data[0], data.size());
+	if (chunkSize > 0) {
+		crc.Update(GetData(), chunkSize);
 	}
 }
 
 
 
-Packet::Packet(const unsigned char* data, unsigned length)
+Packet::Packet(std::shared_ptr<const RawPacket> datagram, unsigned length)
 {
-	Unpacker buf(data, length);
+	Unpacker buf(datagram->data, length);
 	buf.Unpack(lastContinuous);
 	buf.Unpack(nakType);
 	buf.Unpack(checksum);
@@ -170,11 +176,14 @@ Packet::Packet(const unsigned char* data, unsigned length)
 	}
 
 	while (buf.Remaining() > Chunk::headerSize) {
-		ChunkPtr temp(new Chunk);
+		ChunkPtr temp = AllocPacket<Chunk>();
 		buf.Unpack(temp->chunkNumber);
 		buf.Unpack(temp->chunkSize);
 		if (buf.Remaining() >= temp->chunkSize) {
-			buf.Unpack(temp->data, temp->chunkSize);
+			// reference the payload in place
+			temp->buffer = datagram;
+			temp->offset = buf.Position();
+			buf.Skip(temp->chunkSize);
 			chunks.push_back(temp);
 		} else {
 			// defective, ignore
@@ -228,7 +237,7 @@ void Packet::Serialize(std::vector<std::uint8_t>& data)
 	for (auto ci = chunks.begin(); ci != chunks.end(); ++ci) {
 		buf.Pack((*ci)->chunkNumber);
 		buf.Pack((*ci)->chunkSize);
-		buf.Pack((*ci)->data);
+		buf.Pack((*ci)->GetData(), (*ci)->chunkSize);
 	}
 }
 
@@ -303,19 +312,31 @@ void UDPConnection::Init()
 	sentPackets = 0;
 	recvPackets = 0;
 	droppedChunks = 0;
-	mtu = globalConfig.mtu;
+	mtu = std::min(globalConfig.mtu, udpMaxPacketSize);
 	reconnectTime = globalConfig.reconnectTimeout;
 
 	muted = true;
 	closed = false;
 	resend = false;
 
+	logMessages = false;
+
 	#ifndef UNIT_TEST
 	logMessages = configHandler->GetBool("UDPConnectionLogDebugMessages");
 	#endif
 
 	netLossFactor = globalConfig.networkLossFactor;
 	lastMidChunk = -1;
+
+	compressionLevel = globalConfig.networkCompressionLevel;
+	compressionRequested = false;
+	corruptStream = false;
+
+	// sent once unmuted, ahead of anything else
+	if (compressionLevel > 0) {
+		const std::uint8_t offer[] = {NETMSG_COMPRESSION, COMPRESSION_OFFER};
+		outgoingData.push_front(AllocPacket<RawPacket>(offer, sizeof(offer)));
+	}
 #if	NETWORK_TEST
 	lossCounter = 0;
 #endif
@@ -338,9 +359,6 @@ UDPConnection::~UDPConnection()
 {
 	fragmentBuffer.Delete();
 
-	for (auto& it: waitingPackets)
-		delete it.second;
-
 	Flush(true);
 }
 
@@ -439,34 +457,15 @@ void UDPConnection::Update()
 		// duplicated code with UDPListener
 		netservice.poll();
 
-		size_t bytesAvailable = 0;
-
-		while ((bytesAvailable = mySocket->available()) > 0) {
-			recvBuffer.clear();
-			recvBuffer.resize(bytesAvailable, 0);
-
-			ip::udp::endpoint udpEndPoint;
-			ip::udp::socket::message_flags msgFlags = 0;
-			asio::error_code err;
-
-			const size_t bytesReceived = mySocket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
-
-			if (CheckErrorCode(err))
-				break;
-
-			if (bytesReceived < Packet::headerSize)
-				continue;
-
-			Packet data(&recvBuffer[0], bytesReceived);
-
-			if (IsUsingAddress(udpEndPoint))
+		recvRing.Receive(*mySocket, [&](const std::shared_ptr<const RawPacket>& datagram, unsigned length, const ip::udp::endpoint& udpEndPoint) {
+			if (length >= Packet::headerSize && IsUsingAddress(udpEndPoint)) {
+				Packet data(datagram, length);
 				ProcessRawPacket(data);
+			}
 
 			// not likely, but make sure we do not get stuck here
-			if ((spring_gettime() - curTime) > spring_msecs(10)) {
-				break;
-			}
-		}
+			return ((spring_gettime() - curTime) <= spring_msecs(10));
+		});
 	}
 
 
@@ -475,6 +474,10 @@ void UDPConnection::Update()
 
 void UDPConnection::ProcessRawPacket(Packet& incoming)
 {
+	// do not keep a connection alive that can no longer be read
+	if (corruptStream)
+		return;
+
 	#ifdef ENABLE_DEBUG_STATS
 	if (logMessages)
 		LOG_L(L_INFO, "\t[%s] checksum=(%u : %u) mtu=%u", __func__, incoming.GetChecksum(), incoming.checksum, mtu);
@@ -549,34 +552,74 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 			continue;
 		}
 
-		waitingPackets.emplace(c->chunkNumber, new RawPacket(&c->data[0], c->data.size()));
+		waitingPackets.emplace(c->chunkNumber, c);
 	}
 
 
 	// process all in-order packets that we have waiting
 	for (auto wpi = waitingPackets.find(lastInOrder + 1); wpi != waitingPackets.end(); wpi = waitingPackets.find(lastInOrder + 1)) {
-		waitBuffer.clear();
+		const ChunkPtr chunk = std::move(wpi->second);
+
+		lastInOrder++;
+		waitingPackets.erase(wpi);
+
+		// messages are parsed straight from the chunk unless it is compressed or a fragment precedes it
+		const unsigned char* msgData = chunk->GetData();
+		unsigned int msgSize = chunk->chunkSize;
+
+		if (inflater != nullptr) {
+			if (!inflater->Inflate(msgData, msgSize, inflateBuffer)) {
+				// every later chunk depends on the lost inflater state; stop
+				// sending as well such that both ends time out (CheckTimeout)
+				// and the link is dropped or reconnected with a fresh stream
+				LOG_L(L_ERROR, "Corrupted compression stream at incoming chunk %d, dropping connection to %s", chunk->chunkNumber, GetFullAddress().c_str());
+
+				corruptStream = true;
+				muted = true;
+
+				waitingPackets.clear();
+				return;
+			}
+
+			msgData = inflateBuffer.data();
+			msgSize = inflateBuffer.size();
+		}
 
 		if (fragmentBuffer.data != nullptr) {
 			// combine with fragment buffer (packet reassembly)
-			waitBuffer.resize(fragmentBuffer.length);
 			waitBuffer.assign(fragmentBuffer.data, fragmentBuffer.data + fragmentBuffer.length);
+			waitBuffer.insert(waitBuffer.end(), msgData, msgData + msgSize);
 
 			fragmentBuffer.Delete();
-		}
 
-		lastInOrder++;
-		std::copy(wpi->second->data, wpi->second->data + wpi->second->length, std::back_inserter(waitBuffer));
-		waitingPackets.erase(wpi);
+			msgData = waitBuffer.data();
+			msgSize = waitBuffer.size();
+		}
 
-		for (unsigned pos = 0; pos < waitBuffer.size(); ) {
-			const unsigned char* bufp = &waitBuffer[pos];
-			const unsigned int msgLength = waitBuffer.size() - pos;
+		for (unsigned pos = 0; pos < msgSize; ) {
+			const unsigned char* bufp = &msgData[pos];
+			const unsigned int msgLength = msgSize - pos;
 
 			const int pktLength = ProtocolDef::GetInstance()->PacketLength(bufp, msgLength);
 
 			// this returns false for zero/invalid pktLength
 			if (ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength)) {
+				// connection-level message, not handed out
+				if (*bufp == NETMSG_COMPRESSION) {
+					pos += pktLength;
+
+					if (bufp[1] == COMPRESSION_OFFER) {
+						compressionRequested = (compressionLevel > 0 && deflater == nullptr);
+						continue;
+					}
+					if (bufp[1] == COMPRESSION_START && inflater == nullptr) {
+						inflater.reset(new ChunkInflater());
+						break;
+					}
+
+					continue;
+				}
+
 				msgQueue.emplace_back(new RawPacket(bufp, pktLength));
 				std::shared_ptr<const RawPacket>& msgPacket = msgQueue.back();
 
@@ -653,6 +696,10 @@ void UDPConnection::Flush(const bool forced)
 		// someone in the game gives a large order.
 		bool partialPacket = false;
 		bool sendMore = true;
+		bool deflated = false;
+
+		if (compressionRequested)
+			StartCompression();
 
 		do {
 			sendMore  = (outgoing.GetAverage(true) <= globalConfig.linkOutgoingBandwidth);
@@ -688,10 +735,19 @@ void UDPConnection::Flush(const bool forced)
 				}
 			}
 			if ((pos > 0) && (outgoingData.empty() || (pos == maxChunkSize) || !sendMore)) {
-				CreateChunk(buffer, pos, currentPacketChunkNum++);
+				if (deflater != nullptr) {
+					deflater->Deflate(buffer, pos, false, deflateBuffer);
+					deflated = true;
+				} else {
+					CreateChunk(buffer, pos, currentPacketChunkNum++);
+				}
+
 				pos = 0;
 			}
 		} while (!outgoingData.empty() && sendMore);
+
+		if (deflated)
+			CreateDeflatedChunks();
 	}
 
 	SendIfNecessary(forced);
@@ -699,6 +755,10 @@ void UDPConnection::Flush(const bool forced)
 
 bool UDPConnection::CheckTimeout(int seconds, bool initial) const {
 
+	// without reconnects there is nothing to wait for
+	if (corruptStream && !CanReconnect())
+		return true;
+
 	int timeout;
 
 	if (seconds == 0) {
@@ -739,13 +799,23 @@ std::string UDPConnection::Statistics() const
 		"\t%u bytes recv'd in %u packets (%.3f bytes/packet)\n",
 		"\t{%.3fx, %.3fx} relative protocol overhead {up, down}\n",
 		"\t%u incoming chunks dropped, %u outgoing chunks resent\n",
+		"\t{%.3fx, %.3fx} compression ratio {up, down}, {%.3fms, %.3fms} spent {deflating, inflating}\n",
 	};
 
+	const ChunkDeflater* d = deflater.get();
+	const ChunkInflater* i = inflater.get();
+
 	std::string msg = "[UDPConnection::Statistics]\n";
 	msg += spring::format(fmts[0], dataSent, sentPackets, spring::SafeDivide(dataSent * 1.0f, sentPackets * 1.0f));
 	msg += spring::format(fmts[1], dataRecv, recvPackets, spring::SafeDivide(dataRecv * 1.0f, recvPackets * 1.0f));
 	msg += spring::format(fmts[2], spring::SafeDivide(sentOverhead * 1.0f, dataSent * 1.0f), spring::SafeDivide(recvOverhead * 1.0f, dataRecv * 1.0f));
 	msg += spring::format(fmts[3], droppedChunks, resentChunks);
+	msg += spring::format(fmts[4],
+		(d != nullptr)? spring::SafeDivide(d->GetPackedBytes() * 1.0f, d->GetRawBytes() * 1.0f): 1.0f,
+		(i != nullptr)? spring::SafeDivide(i->GetPackedBytes() * 1.0f, i->GetRawBytes() * 1.0f): 1.0f,
+		(d != nullptr)? d->GetTime().toMilliSecsf(): 0.0f,
+		(i != nullptr)? i->GetTime().toMilliSecsf(): 0.0f
+	);
 	return msg;
 }
 
@@ -764,14 +834,45 @@ void UDPConnection::SetMTU(unsigned mtu2)
 void UDPConnection::CreateChunk(const unsigned char* data, const unsigned length, const int packetNum)
 {
 	assert((length > 0) && (length < 255));
-	ChunkPtr buf(new Chunk);
+	ChunkPtr buf = AllocPacket<Chunk>();
 	buf->chunkNumber = packetNum;
 	buf->chunkSize = length;
-	std::copy(data, data+length, std::back_inserter(buf->data));
+	buf->buffer = AllocPacket<RawPacket>(data, length);
+	buf->offset = 0;
 	newChunks.push_back(buf);
 	lastChunkCreatedTime = spring_gettime();
 }
 
+void UDPConnection::StartCompression()
+{
+	// sent uncompressed in a chunk of its own, the other side
+	// starts inflating with exactly the next chunk
+	const std::uint8_t marker[] = {NETMSG_COMPRESSION, COMPRESSION_START};
+
+	compressionRequested = false;
+	deflater.reset(new ChunkDeflater(compressionLevel));
+
+	if (!deflater->IsValid()) {
+		LOG_L(L_WARNING, "[UDPConnection::%s] failed to initialize compression (level %d)", __func__, compressionLevel);
+		deflater.reset();
+		return;
+	}
+
+	CreateChunk(marker, sizeof(marker), currentPacketChunkNum++);
+}
+
+void UDPConnection::CreateDeflatedChunks()
+{
+	if (!deflater->Deflate(nullptr, 0, true, deflateBuffer))
+		LOG_L(L_ERROR, "[UDPConnection::%s] failed to compress outgoing data", __func__);
+
+	for (size_t pos = 0; pos < deflateBuffer.size(); pos += maxChunkSize) {
+		CreateChunk(&deflateBuffer[pos], std::min(deflateBuffer.size() - pos, size_t(maxChunkSize)), currentPacketChunkNum++);
+	}
+
+	deflateBuffer.clear();
+}
+
 void UDPConnection::SendIfNecessary(bool flushed)
 {
 	const spring_time curTime = spring_gettime();
@@ -957,6 +1058,8 @@ void UDPConnection::SendIfNecessary(bool flushed)
 			break;
 	}
 
+	SendQueuedPackets();
+
 	if (UseMinLossFactor())
 		return;
 
@@ -968,11 +1071,13 @@ void UDPConnection::SendIfNecessary(bool flushed)
 
 void UDPConnection::SendPacket(Packet& pkt)
 {
-	pkt.Serialize(sendBuffer);
-
-	outgoing.DataSent(sendBuffer.size());
+	outgoing.DataSent(pkt.GetSize());
 	lastPacketSendTime = spring_gettime();
 
+#if NETWORK_TEST
+	// loss and latency emulation need each datagram on its own
+	pkt.Serialize(sendBuffer);
+
 	ip::udp::socket::message_flags flags = 0;
 	asio::error_code err;
 
@@ -985,6 +1090,26 @@ void UDPConnection::SendPacket(Packet& pkt)
 
 	dataSent += sendBuffer.size();
 	sentPackets += 1;
+#else
+	// sent with the rest of this update by SendQueuedPackets
+	sendBatch.Add(pkt);
+#endif
+}
+
+void UDPConnection::SendQueuedPackets()
+{
+	if (sendBatch.Empty())
+		return;
+
+	asio::error_code err;
+
+	const UDPSendBatch::Result result = sendBatch.Send(*mySocket, addr, err);
+
+	// datagrams that left before an error still count
+	dataSent += result.numBytes;
+	sentPackets += result.numPackets;
+
+	CheckErrorCode(err);
 }
 
 void UDPConnection::AckChunks(int lastAck)
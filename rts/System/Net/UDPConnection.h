@@ -9,7 +9,10 @@
 #include <deque>
 #include <list>
 
+#include "ChunkCompression.h"
 #include "Connection.h"
+#include "PacketPool.h"
+#include "UDPBatchIO.h"
 #include "System/Misc/SpringTime.h"
 
 class CRC;
@@ -30,13 +33,16 @@ namespace netcode {
 class Chunk
 {
 public:
-	unsigned GetSize() const { return (data.size() + headerSize); }
+	unsigned GetSize() const { return (chunkSize + headerSize); }
+	const std::uint8_t* GetData() const { return (buffer->data + offset); }
 	void UpdateChecksum(CRC& crc) const;
 	static constexpr unsigned maxSize = 254;
 	static constexpr unsigned headerSize = 5;
 	std::int32_t chunkNumber;
 	std::uint8_t chunkSize;
-	std::vector<std::uint8_t> data;
+	/// payload is at buffer->data + offset; received chunks share the datagram they arrived in
+	std::shared_ptr<const RawPacket> buffer;
+	std::uint32_t offset;
 };
 typedef std::shared_ptr<Chunk> ChunkPtr;
 
@@ -44,7 +50,7 @@ class Packet
 {
 public:
 	static constexpr unsigned headerSize = 6;
-	Packet(const unsigned char* data, unsigned length);
+	Packet(std::shared_ptr<const RawPacket> datagram, unsigned length);
 	Packet(int lastContinuous, int nak);
 
 	unsigned GetSize() const;
@@ -100,6 +106,7 @@ public:
 	bool NeedsReconnect() override;
 
 	unsigned int GetPacketQueueSize() const override { return msgQueue.size(); }
+	unsigned int GetOutgoingQueueSize() const override { return (outgoingData.size() + unackedChunks.size()); }
 
 	std::string Statistics() const override;
 	std::string GetFullAddress() const override;
@@ -140,7 +147,12 @@ private:
 
 	/// add header to data and send it
 	void CreateChunk(const unsigned char* data, const unsigned length, const int packetNum);
+	/// send COMPRESSION_START and deflate everything after it
+	void StartCompression();
+	/// flush the deflater and put its output into new chunks
+	void CreateDeflatedChunks();
 	void SendIfNecessary(bool flushed);
+	void SendQueuedPackets();
 	void AckChunks(int lastAck);
 
 	void RequestResend(ChunkPtr ptr);
@@ -175,8 +187,8 @@ private:
 
 	/// outgoing stuff (pure data without header) waiting to be sent
 	std::list< std::shared_ptr<const RawPacket> > outgoingData;
-	/// packets we have received but not yet read
-	std::map<int, RawPacket*> waitingPackets;
+	/// chunks we have received but not yet read
+	std::map<int, ChunkPtr> waitingPackets;
 
 	/// Newly created and not yet sent
 	std::deque<ChunkPtr> newChunks;
@@ -189,10 +201,28 @@ private:
 	/// complete packets we received but did not yet consume
 	std::deque< std::shared_ptr<const RawPacket> > msgQueue;
 
-	std::vector<std::uint8_t> sendBuffer;
-	std::vector<std::uint8_t> recvBuffer;
+	/// datagrams of the current SendIfNecessary call
+	UDPSendBatch sendBatch;
+	/// datagrams read from a non-shared socket
+	UDPRecvRing recvRing;
+
 	std::vector<std::uint8_t> waitBuffer;
 
+	/// compresses what we send, once the other side offered to inflate it
+	std::unique_ptr<ChunkDeflater> deflater;
+	/// inflates what the other side sends, once it started compressing
+	std::unique_ptr<ChunkInflater> inflater;
+
+	std::vector<std::uint8_t> deflateBuffer;
+	std::vector<std::uint8_t> inflateBuffer;
+
+	/// zlib level, 0 if we neither offer nor accept compression
+	int compressionLevel;
+	/// other side offered, COMPRESSION_START not yet sent
+	bool compressionRequested;
+	/// a chunk failed to inflate, nothing after it can be read anymore
+	bool corruptStream;
+
 	std::vector<int> droppedPackets;
 
 	std::int32_t lastMidChunk;
@@ -200,6 +230,7 @@ private:
 #if	NETWORK_TEST
 	/// Delayed packets, for testing purposes
 	std::map< spring_time, std::vector<std::uint8_t> > delayed;
+	std::vector<std::uint8_t> sendBuffer;
 	int lossCounter;
 #endif
 
@@ -110,35 +110,21 @@ std::string UDPListener::TryBindSocket(int port, std::shared_ptr<asio::ip::udp::
 void UDPListener::Update() {
 	netservice.poll();
 
-	size_t bytesAvailable = 0;
-
-	while ((bytesAvailable = socket->available()) > 0) {
-		recvBuffer.clear();
-		recvBuffer.resize(bytesAvailable, 0);
-
-		ip::udp::endpoint udpEndPoint;
-		asio::ip::udp::socket::message_flags msgFlags = 0;
-		asio::error_code err;
-
-		const size_t bytesReceived = socket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
-
+	recvRing.Receive(*socket, [&](const std::shared_ptr<const RawPacket>& datagram, unsigned length, const ip::udp::endpoint& udpEndPoint) {
 		const auto ci = connMap.find(udpEndPoint);
 
 		// known connection but expired
 		if (ci != connMap.end() && ci->second.expired())
-			continue;
+			return true;
 
-		if (CheckErrorCode(err))
-			break;
+		if (length < Packet::headerSize)
+			return true;
 
-		if (bytesReceived < Packet::headerSize)
-			continue;
-
-		Packet data(&recvBuffer[0], bytesReceived);
+		Packet data(datagram, length);
 
 		if (ci != connMap.end()) {
 			ci->second.lock()->ProcessRawPacket(data);
-			continue;
+			return true;
 		}
 
 
@@ -151,7 +137,7 @@ void UDPListener::Update() {
 				incoming->ProcessRawPacket(data);
 			}
 
-			continue;
+			return true;
 		}
 
 
@@ -159,7 +145,7 @@ void UDPListener::Update() {
 		const std::string& senderIP = senderAddr.to_string();
 
 		if (dropMap.find(senderIP) == dropMap.end()) {
-			LOG_L(L_DEBUG, "[UDPListener::%s] dropping packet from unknown IP: [%s]:%i", __func__, senderIP.c_str(), udpEndPoint.port());
+			LOG_L(L_DEBUG, "[UDPListener::Update] dropping packet from unknown IP: [%s]:%i", senderIP.c_str(), udpEndPoint.port());
 			dropMap[senderIP] = 0;
 		} else {
 			dropMap[senderIP] += 1;
@@ -170,9 +156,11 @@ void UDPListener::Update() {
 		for (auto it = connMap.cbegin(); it != connMap.cend(); ++it) {
 			conns += spring::format(" [%s]:%i;", it->first.address().to_string().c_str(),it->first.port());
 		}
-		LOG_L(L_DEBUG, "[UDPListener::%s] open connections: %s", __func__, conns.c_str());
+		LOG_L(L_DEBUG, "[UDPListener::Update] open connections: %s", conns.c_str());
 	#endif
-	}
+
+		return true;
+	});
 
 	for (auto i = connMap.cbegin(); i != connMap.cend(); ) {
 		if (i->second.expired()) {
@@ -10,6 +10,8 @@
 #include <queue>
 #include <string>
 
+#include "UDPBatchIO.h"
+
 namespace netcode
 {
 class UDPConnection;
@@ -85,7 +87,7 @@ private:
 	/// socket being listened on
 	std::shared_ptr<asio::ip::udp::socket> socket;
 
-	std::vector<std::uint8_t> recvBuffer;
+	UDPRecvRing recvRing;
 
 	/// all connections
 	std::map< asio::ip::udp::endpoint, std::weak_ptr<UDPConnection> > connMap;
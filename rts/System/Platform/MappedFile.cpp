@@ -0,0 +1,109 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "MappedFile.h"
+#include "System/Platform/Win/win32.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE fh = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (fh == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(fh, &fileSize) || fileSize.QuadPart <= 0) {
+		CloseHandle(fh);
+		return false;
+	}
+
+	HANDLE mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mh == nullptr) {
+		CloseHandle(fh);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+
+	if (view == nullptr) {
+		CloseHandle(mh);
+		CloseHandle(fh);
+		return false;
+	}
+
+	fileHandle = fh;
+	mappingHandle = mh;
+
+	data = static_cast<const std::uint8_t*>(view);
+	size = fileSize.QuadPart;
+#else
+	const int fd = open(fileName.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// the mapping stays valid after the descriptor is closed
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return false;
+
+	data = static_cast<const std::uint8_t*>(view);
+	size = fileStat.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+#else
+	munmap(const_cast<std::uint8_t*>(data), size);
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+
+size_t MappedFile::GetPageSize()
+{
+#ifdef _WIN32
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	return sysInfo.dwPageSize;
+#else
+	return sysconf(_SC_PAGESIZE);
+#endif
+}
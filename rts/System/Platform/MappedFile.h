@@ -0,0 +1,45 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief read-only memory-mapped file
+ *
+ * Pages are only read from disk when first accessed.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	~MappedFile() { Close(); }
+
+	MappedFile& operator = (const MappedFile&) = delete;
+
+	/// maps all of <fileName>; closes any previously mapped file first
+	bool Open(const std::string& fileName);
+	void Close();
+
+	bool IsOpen() const { return (data != nullptr); }
+
+	const std::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+	static size_t GetPageSize();
+
+private:
+	const std::uint8_t* data = nullptr;
+	size_t size = 0;
+
+	#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	#endif
+};
+
+#endif // MAPPED_FILE_H
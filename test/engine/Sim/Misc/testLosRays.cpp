@@ -0,0 +1,175 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Game/GlobalUnsynced.h"
+#include "Map/ReadMap.h"
+#include "Sim/Misc/LosHandler.h"
+#include "Sim/Misc/LosMap.h"
+#include "System/type2.h"
+#include "System/Log/ILog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE LosRays
+#include <boost/test/unit_test.hpp>
+
+
+static constexpr int MAP_SQUARES = 512;
+static constexpr int MAX_RADIUS = 96;
+static constexpr int NUM_MAPS = 200;
+static constexpr int NUM_INSTANCES = 10;
+static constexpr int NUM_CASTS = 2000;
+
+
+// the engine globals LosMap.cpp refers to; UpdateLOS is only
+// called for maps that send ReadMap events, which these do not
+CReadMap* readMap = nullptr;
+MapDimensions mapDims;
+CGlobalUnsynced* gu = nullptr;
+
+void CReadMap::UpdateLOS(const SRectangle&) {}
+
+constexpr SLosInstance::RLE SLosInstance::EMPTY_RLE;
+
+
+// exposes both ways CLosMap casts an instance's rays: UnsafeLosAdd
+// (quad layout, four mirrored rays per kernel call) and SafeLosAdd
+// (one CastLos call per ray and square), which for instances that
+// do not touch the map borders stops no ray early
+class TestLosMap: public CLosMap {
+public:
+	using CLosMap::UnsafeLosAdd;
+	using CLosMap::SafeLosAdd;
+};
+
+static std::vector<float> GetHeightMap(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> randf(0.0f, 1.0f);
+	std::vector<float> heightMap(MAP_SQUARES * MAP_SQUARES);
+
+	// a few overlapping ridges plus noise, with some squares below water
+	const float fx = 0.02f + randf(rng) * 0.1f;
+	const float fy = 0.02f + randf(rng) * 0.1f;
+
+	for (int y = 0; y < MAP_SQUARES; y++) {
+		for (int x = 0; x < MAP_SQUARES; x++) {
+			const float ridges = std::sin(x * fx) * 80.0f + std::cos(y * fy) * 60.0f + std::sin((x + y) * 0.013f) * 120.0f;
+			const float noise = randf(rng) * 30.0f;
+
+			heightMap[y * MAP_SQUARES + x] = ridges + noise;
+		}
+	}
+
+	return heightMap;
+}
+
+static int CountSquares(const SLosInstance& instance)
+{
+	int numSquares = 0;
+
+	for (const SLosInstance::RLE& rle: instance.squares) {
+		numSquares += rle.length;
+	}
+
+	return numSquares;
+}
+
+static bool operator != (const SLosInstance::RLE& a, const SLosInstance::RLE& b) {
+	return (a.start != b.start || a.length != b.length);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( LosRaysEquality )
+{
+	std::mt19937 rng(4321);
+	std::uniform_int_distribution<int> randRadius(1, MAX_RADIUS);
+	std::uniform_int_distribution<int> randPos(MAX_RADIUS, MAP_SQUARES - 1 - MAX_RADIUS);
+	std::uniform_real_distribution<float> randHeight(-50.0f, 300.0f);
+
+	mapDims.mapx = MAP_SQUARES;
+	mapDims.mapy = MAP_SQUARES;
+
+	TestLosMap losMap;
+
+	int numMismatches = 0;
+	int numHidden = 0;
+
+	for (int n = 0; n < NUM_MAPS; n++) {
+		const std::vector<float> heightMap = GetHeightMap(rng);
+
+		losMap.Init(int2(MAP_SQUARES, MAP_SQUARES), int2(MAP_SQUARES, MAP_SQUARES), heightMap.data(), heightMap.data(), false);
+
+		for (int k = 0; k < NUM_INSTANCES; k++) {
+			SLosInstance quadInstance(0);
+			SLosInstance planeInstance(0);
+			SLosInstance aboveInstance(0);
+
+			quadInstance.radius = randRadius(rng);
+			quadInstance.basePos = {randPos(rng), randPos(rng)};
+			quadInstance.baseHeight = randHeight(rng);
+
+			planeInstance.radius = quadInstance.radius;
+			planeInstance.basePos = quadInstance.basePos;
+			planeInstance.baseHeight = quadInstance.baseHeight;
+
+			// from high enough above the terrain every square is visible
+			aboveInstance.radius = quadInstance.radius;
+			aboveInstance.basePos = quadInstance.basePos;
+			aboveInstance.baseHeight = 1e6f;
+
+			losMap.UnsafeLosAdd(&quadInstance);
+			losMap.SafeLosAdd(&planeInstance);
+			losMap.SafeLosAdd(&aboveInstance);
+
+			numMismatches += (quadInstance.squares.size() != planeInstance.squares.size());
+			numMismatches += !std::equal(quadInstance.squares.begin(), quadInstance.squares.end(), planeInstance.squares.begin(), [](const SLosInstance::RLE& a, const SLosInstance::RLE& b) { return !(a != b); });
+			numHidden += (CountSquares(aboveInstance) - CountSquares(planeInstance));
+		}
+	}
+
+	// make sure the terrain actually blocked some sight
+	BOOST_CHECK(numHidden > 0);
+	BOOST_CHECK_MESSAGE(numMismatches == 0, "quad-layout LOS rays differ from the scalar path");
+}
+
+
+BOOST_AUTO_TEST_CASE( LosRaysCost )
+{
+	static const int radii[] = {16, 32, 64, 96};
+
+	std::mt19937 rng(1234);
+
+	const std::vector<float> heightMap = GetHeightMap(rng);
+
+	TestLosMap losMap;
+	losMap.Init(int2(MAP_SQUARES, MAP_SQUARES), int2(MAP_SQUARES, MAP_SQUARES), heightMap.data(), heightMap.data(), false);
+
+	for (const int radius: radii) {
+		const auto TimeCasts = [&](decltype(&TestLosMap::UnsafeLosAdd) castFunc) {
+			SLosInstance instance(0);
+
+			instance.radius = radius;
+			instance.basePos = {MAP_SQUARES / 2, MAP_SQUARES / 2};
+			instance.baseHeight = 100.0f;
+
+			const auto t0 = std::chrono::high_resolution_clock::now();
+
+			for (int n = 0; n < NUM_CASTS; n++) {
+				instance.squares.clear();
+				(losMap.*castFunc)(&instance);
+			}
+
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			return (std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 0.001f / NUM_CASTS);
+		};
+
+		const float scalarTime = TimeCasts(&TestLosMap::SafeLosAdd);
+		const float vectorTime = TimeCasts(&TestLosMap::UnsafeLosAdd);
+
+		LOG("[LosRaysCost] radius=%2d scalar=%7.2fus vector=%7.2fus (%.2fx)", radius, scalarTime, vectorTime, scalarTime / std::max(vectorTime, 0.001f));
+	}
+}
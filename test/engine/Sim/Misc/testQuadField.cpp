@@ -3,6 +3,8 @@
 #include "Sim/Misc/QuadField.h"
 #include "System/float3.h"
 #include "System/myMath.h"
+#include "System/Log/ILog.h"
+#include <chrono>
 #include <stdlib.h>
 #include <time.h>
 
@@ -98,3 +100,185 @@ BOOST_AUTO_TEST_CASE( QuadField )
 
 	BOOST_CHECK_MESSAGE(!fail, "Too less quads returned!");
 }
+
+
+
+// stand-in for CUnit and CFeature; these can not be linked into
+// the test, so the object lists live here while the quad lookups
+// are done by CQuadField exactly as in Get{Units,Solids}Exact
+struct TestObject {
+	float3 pos;
+	float radius;
+	int tempNum;
+};
+
+struct TestQuadIndex {
+	void Init(int numQuads) {
+		units.clear();
+		units.resize(numQuads);
+		features.clear();
+		features.resize(numQuads);
+	}
+
+	void Add(std::vector< std::vector<TestObject*> >& quadLists, TestObject* o) {
+		QuadFieldQuery qfQuery;
+		quadField.GetQuads(qfQuery, o->pos, o->radius);
+
+		for (const int qi: *qfQuery.quads) {
+			quadLists[qi].push_back(o);
+		}
+	}
+
+	float GetLoadFactor() const {
+		CQuadField::LoadStats stats;
+
+		for (size_t qi = 0; qi < units.size(); qi++) {
+			const int n = units[qi].size() + features[qi].size();
+
+			stats.numObjectLinks += n;
+			stats.numOccupiedQuads += (n > 0);
+		}
+
+		return stats.GetLoadFactor();
+	}
+
+	std::vector< std::vector<TestObject*> > units;
+	std::vector< std::vector<TestObject*> > features;
+};
+
+static int QueryExact(const std::vector< std::vector<TestObject*> >* lists[], int numLists, const float3& pos, float radius, int tempNum)
+{
+	QuadFieldQuery qfQuery;
+	quadField.GetQuads(qfQuery, pos, radius);
+
+	int numFound = 0;
+
+	for (int l = 0; l < numLists; l++) {
+		for (const int qi: *qfQuery.quads) {
+			for (TestObject* o: (*lists[l])[qi]) {
+				if (o->tempNum == tempNum)
+					continue;
+
+				o->tempNum = tempNum;
+
+				const float totRad = radius + o->radius;
+
+				if (pos.SqDistance(o->pos) >= (totRad * totRad))
+					continue;
+
+				numFound++;
+			}
+		}
+	}
+
+	return numFound;
+}
+
+
+BOOST_AUTO_TEST_CASE( QuadFieldCalcQuadSize )
+{
+	static constexpr int BQS = CQuadField::BASE_QUAD_SIZE;
+	static constexpr int MQS = CQuadField::MIN_QUAD_SIZE;
+
+	// disabled
+	BOOST_CHECK(CQuadField::CalcQuadSize(BQS, 1000.0f, 0.0f) == BQS);
+	// shrink above threshold, but never below the minimum
+	BOOST_CHECK(CQuadField::CalcQuadSize(BQS, 40.0f, 32.0f) == (BQS >> 1));
+	BOOST_CHECK(CQuadField::CalcQuadSize(MQS, 40.0f, 32.0f) == MQS);
+	// keep size inside the hysteresis band
+	BOOST_CHECK(CQuadField::CalcQuadSize(BQS >> 1, 8.0f, 32.0f) == (BQS >> 1));
+	// grow again far below threshold, but never above the base size
+	BOOST_CHECK(CQuadField::CalcQuadSize(BQS >> 1, 2.0f, 32.0f) == BQS);
+	BOOST_CHECK(CQuadField::CalcQuadSize(BQS, 2.0f, 32.0f) == BQS);
+}
+
+
+BOOST_AUTO_TEST_CASE( QuadFieldQueryCost )
+{
+	// benchmark of the Get{Units,Solids}Exact access pattern against
+	// unit density for each quad size CQuadField::Resize can select
+	static constexpr int MAP_SQUARES = 1024;
+	static constexpr int NUM_QUERIES = 20000;
+	static constexpr int NUM_FEATURES = 2000;
+
+	static constexpr float MAP_SIZE = MAP_SQUARES * SQUARE_SIZE;
+
+	static const int unitCounts[] = {1000, 4000, 16000};
+	// typical collision-check and area-command radii
+	static const float queryRadii[] = {48.0f, 250.0f};
+	static const int quadSizes[] = {CQuadField::BASE_QUAD_SIZE, CQuadField::BASE_QUAD_SIZE / 2, CQuadField::MIN_QUAD_SIZE};
+
+	float3::maxxpos = MAP_SIZE - 1.0f;
+	float3::maxzpos = MAP_SIZE - 1.0f;
+
+	srand(1234);
+
+	std::vector<TestObject> units;
+	std::vector<TestObject> features(NUM_FEATURES);
+	std::vector<float3> queryPositions(NUM_QUERIES);
+
+	for (TestObject& f: features) {
+		f = {float3(randf() * MAP_SIZE, 0.0f, randf() * MAP_SIZE), 8.0f + randf() * 24.0f, 0};
+	}
+	// queries are made where the units are
+	for (float3& p: queryPositions) {
+		p = float3(MAP_SIZE * 0.5f, 0.0f, MAP_SIZE * 0.5f) + float3(randf() - 0.5f, 0.0f, randf() - 0.5f) * MAP_SIZE * 0.25f;
+	}
+
+	TestQuadIndex quadIndex;
+	int tempNum = 0;
+
+	for (const int numUnits: unitCounts) {
+		units.clear();
+		units.resize(numUnits);
+
+		// clustered, as in large battles
+		for (TestObject& u: units) {
+			const float3 center = float3(MAP_SIZE * 0.5f, 0.0f, MAP_SIZE * 0.5f);
+			const float3 offset = float3(randf() - 0.5f, 0.0f, randf() - 0.5f) * MAP_SIZE * 0.25f;
+
+			u = {center + offset, 8.0f + randf() * 40.0f, 0};
+		}
+
+		int numFoundRef[2][2] = {{-1, -1}, {-1, -1}};
+
+		for (const int quadSize: quadSizes) {
+			quadField.Init(int2(MAP_SQUARES, MAP_SQUARES), quadSize);
+			quadIndex.Init(quadField.GetNumQuadsX() * quadField.GetNumQuadsZ());
+
+			for (TestObject& u: units) {
+				quadIndex.Add(quadIndex.units, &u);
+			}
+			for (TestObject& f: features) {
+				quadIndex.Add(quadIndex.features, &f);
+			}
+
+			const std::vector< std::vector<TestObject*> >* lists[] = {&quadIndex.units, &quadIndex.features};
+
+			for (int r = 0; r < 2; r++) {
+				for (int solids = 0; solids < 2; solids++) {
+					const auto t0 = std::chrono::high_resolution_clock::now();
+
+					int numFound = 0;
+
+					// GetUnitsExact only checks units, GetSolidsExact units and features
+					for (const float3& pos: queryPositions) {
+						numFound += QueryExact(lists, 1 + solids, pos, queryRadii[r], ++tempNum);
+					}
+
+					const auto t1 = std::chrono::high_resolution_clock::now();
+					const float us = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 0.001f;
+
+					LOG("[%s] units=%5d quadSize=%3d loadFactor=%6.2f radius=%3.0f Get%sExact: %.3fus/query (%d found)",
+						__func__, numUnits, quadSize, quadIndex.GetLoadFactor(), queryRadii[r], (solids != 0)? "Solids": "Units", us / NUM_QUERIES, numFound);
+
+					// quad size must not change query results
+					if (numFoundRef[r][solids] < 0)
+						numFoundRef[r][solids] = numFound;
+
+					BOOST_CHECK(numFound == numFoundRef[r][solids]);
+				}
+			}
+		}
+	}
+}
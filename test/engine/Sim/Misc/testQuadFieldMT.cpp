@@ -0,0 +1,131 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Misc/QuadField.h"
+#include "System/float3.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Threading/SpringThreading.h"
+#include "System/Threading/ThreadPool.h"
+
+#include <atomic>
+#include <vector>
+#include <stdlib.h>
+
+#define BOOST_TEST_MODULE QuadFieldMT
+#include <boost/test/unit_test.hpp>
+
+
+struct do_once {
+	do_once() { Threading::DetectCores(); } // make GetMaxThreads() work
+	~do_once() { ThreadPool::SetThreadCount(0); } // cleanup after last test
+};
+
+BOOST_GLOBAL_FIXTURE(InitSpringTime);
+BOOST_GLOBAL_FIXTURE(do_once);
+
+
+static constexpr int MAP_SQUARES = 512;
+static constexpr int NUM_QUERIES = 20000;
+static constexpr int NUM_PASSES = 10;
+
+static constexpr float MAP_SIZE = MAP_SQUARES * SQUARE_SIZE;
+
+
+static inline float randf()
+{
+	return rand() / float(RAND_MAX);
+}
+
+
+struct TestQuery {
+	float3 pos;
+	float3 dir;
+	float length;
+	float radius;
+
+	// reference results, computed single-threaded
+	std::vector<int> rayQuads;
+	std::vector<int> circleQuads;
+	std::vector<int> rectQuads;
+};
+
+
+BOOST_AUTO_TEST_CASE( QuadFieldVisitedSet )
+{
+	QueryVisitedSet visited;
+	std::vector<int> objects(5000);
+
+	for (int n = 0; n < 3; n++) {
+		visited.Reset();
+
+		// forces multiple table-growths in the first round
+		for (size_t i = 0; i < objects.size(); i++) {
+			BOOST_CHECK(visited.Insert(&objects[i]));
+		}
+		for (size_t i = 0; i < objects.size(); i++) {
+			BOOST_CHECK(!visited.Insert(&objects[i]));
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( QuadFieldConcurrentQueries )
+{
+	float3::maxxpos = MAP_SIZE - 1.0f;
+	float3::maxzpos = MAP_SIZE - 1.0f;
+
+	quadField.Init(int2(MAP_SQUARES, MAP_SQUARES), CQuadField::BASE_QUAD_SIZE);
+
+	srand(1234);
+
+	std::vector<TestQuery> queries(NUM_QUERIES);
+
+	for (TestQuery& q: queries) {
+		q.pos = float3(randf() * MAP_SIZE, 0.0f, randf() * MAP_SIZE);
+		q.dir = (float3(randf() - 0.5f, 0.0f, randf() - 0.5f)).SafeNormalize();
+		q.length = randf() * MAP_SIZE * 0.5f;
+		q.radius = randf() * 500.0f;
+
+		QuadFieldQuery rayQuery;
+		QuadFieldQuery circleQuery;
+		QuadFieldQuery rectQuery;
+
+		quadField.GetQuadsOnRay(rayQuery, q.pos, q.dir, q.length);
+		quadField.GetQuads(circleQuery, q.pos, q.radius);
+		quadField.GetQuadsRectangle(rectQuery, q.pos - q.radius, q.pos + q.radius);
+
+		q.rayQuads = *rayQuery.quads;
+		q.circleQuads = *circleQuery.quads;
+		q.rectQuads = *rectQuery.quads;
+	}
+
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+	LOG("[%s] running %d queries on %d threads", __func__, NUM_QUERIES * NUM_PASSES, ThreadPool::GetNumThreads());
+
+	std::atomic<int> numMismatches(0);
+	std::atomic<int> numQueries(0);
+
+	for (int n = 0; n < NUM_PASSES; n++) {
+		for_mt(0, NUM_QUERIES, [&](const int i) {
+			const TestQuery& q = queries[i];
+
+			// hold all three vectors at once, as nested queries do
+			QuadFieldQuery rayQuery;
+			QuadFieldQuery circleQuery;
+			QuadFieldQuery rectQuery;
+
+			quadField.GetQuadsOnRay(rayQuery, q.pos, q.dir, q.length);
+			quadField.GetQuads(circleQuery, q.pos, q.radius);
+			quadField.GetQuadsRectangle(rectQuery, q.pos - q.radius, q.pos + q.radius);
+
+			numMismatches += (*rayQuery.quads != q.rayQuads);
+			numMismatches += (*circleQuery.quads != q.circleQuads);
+			numMismatches += (*rectQuery.quads != q.rectQuads);
+			numQueries += 1;
+		});
+	}
+
+	BOOST_CHECK(numQueries == (NUM_QUERIES * NUM_PASSES));
+	BOOST_CHECK_MESSAGE(numMismatches == 0, "concurrent queries returned different quads");
+}
@@ -0,0 +1,505 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Map/MapInfo.h"
+#include "Map/ReadMap.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "Sim/Path/Default/PathEstimator.h"
+#include "Sim/Path/Default/PathFinder.h"
+#include "Sim/Path/Default/PathFinderDef.h"
+#include "Sim/Path/Default/PathFlowField.h"
+#include "Sim/Path/Default/PathHeatMap.hpp"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE PathFlowField
+#include <boost/test/unit_test.hpp>
+
+
+BOOST_GLOBAL_FIXTURE(InitSpringTime);
+
+
+// a 16x16 map, the med-res estimator has 64x64 blocks
+static constexpr int MAP_SQUARES = 16 * 64;
+static constexpr int NUM_GROUPS = 6;
+static constexpr int GROUP_SIZE = 200;
+
+// terrain-types of the test map
+static constexpr uint8_t TERRAIN_OPEN = 0;
+static constexpr uint8_t TERRAIN_WALL = 1;
+static constexpr uint8_t TERRAIN_MUD  = 2;
+
+
+// the engine's map globals, see testPathSpeedModRows
+CReadMap* readMap = nullptr;
+MapDimensions mapDims;
+const CMapInfo* mapInfo = nullptr;
+
+std::vector<float> CReadMap::centerHeightMap;
+std::vector<float> CReadMap::slopeMap;
+std::vector<uint8_t> CReadMap::typeMap;
+std::vector<float3> CReadMap::centerNormals2D;
+
+CReadMap::~CReadMap() {}
+CMapInfo::CMapInfo(const std::string& mapInfoFile, const std::string& mapName) {}
+CMapInfo::~CMapInfo() {}
+
+// no objects exist in these tests, and waypoint heights do not matter
+float CMoveMath::yLevel(const MoveDef& moveDef, int xSquare, int zSquare) { return 0.0f; }
+float CMoveMath::yLevel(const MoveDef& moveDef, const float3& pos) { return 0.0f; }
+
+CMoveMath::BlockType CMoveMath::IsBlockedNoSpeedModCheck(const MoveDef& moveDef, int xSquare, int zSquare, const CSolidObject* collider) { return BLOCK_NONE; }
+CMoveMath::BlockType CMoveMath::IsBlockedNoSpeedModCheckThreadUnsafe(const MoveDef& moveDef, int xSquare, int zSquare, const CSolidObject* collider) { return BLOCK_NONE; }
+
+// the real one parses movedefs.lua
+static std::vector<MoveDef> testMoveDefs;
+
+void MoveDefHandler::Init(LuaParser* defsParser) {
+	moveDefs = testMoveDefs;
+}
+
+
+class TestReadMap: public CReadMap {
+public:
+	// rolling hills around a lake, with mud patches and rings of walls
+	// (some closed, some with a gap) that units have to path around
+	void Init(std::mt19937& rng) {
+		std::uniform_int_distribution<int> randPos(0, MAP_SQUARES / 2 - 1);
+		std::uniform_int_distribution<int> randSize(16, 96);
+
+		mapDims.mapx = MAP_SQUARES;
+		mapDims.mapy = MAP_SQUARES;
+		mapDims.Initialize();
+
+		float3::maxxpos = mapDims.mapx * SQUARE_SIZE - 1;
+		float3::maxzpos = mapDims.mapy * SQUARE_SIZE - 1;
+
+		halfResHeightMap.resize(mapDims.hmapx * mapDims.hmapy);
+		centerHeightMap.resize(mapDims.mapx * mapDims.mapy);
+		slopeMap.resize(mapDims.hmapx * mapDims.hmapy);
+		typeMap.resize(mapDims.hmapx * mapDims.hmapy, TERRAIN_OPEN);
+		centerNormals2D.resize(mapDims.mapx * mapDims.mapy);
+
+		for (int z = 0; z < mapDims.hmapy; z++) {
+			for (int x = 0; x < mapDims.hmapx; x++) {
+				const float dx = x - mapDims.hmapx * 0.7f;
+				const float dz = z - mapDims.hmapy * 0.3f;
+				const float lake = std::max(0.0f, 1.0f - std::sqrt(dx * dx + dz * dz) / 60.0f) * 120.0f;
+
+				halfResHeightMap[z * mapDims.hmapx + x] = std::sin(x * 0.031f) * 40.0f + std::cos(z * 0.043f) * 30.0f + 50.0f - lake;
+			}
+		}
+
+		for (int n = 0; n < 24; n++) {
+			FillRect(randPos(rng), randPos(rng), randSize(rng), randSize(rng), TERRAIN_MUD);
+		}
+
+		for (int n = 0; n < 12; n++) {
+			const int x1 = randPos(rng), x2 = std::min(x1 + randSize(rng), mapDims.hmapx - 1);
+			const int z1 = randPos(rng), z2 = std::min(z1 + randSize(rng), mapDims.hmapy - 1);
+
+			FillRect(x1, z1, x2 - x1 + 1, 2, TERRAIN_WALL);
+			FillRect(x1, z2 - 1, x2 - x1 + 1, 2, TERRAIN_WALL);
+			FillRect(x1, z1, 2, z2 - z1 + 1, TERRAIN_WALL);
+			FillRect(x2 - 1, z1, 2, z2 - z1 + 1, TERRAIN_WALL);
+
+			// every other ring has a way in
+			if ((n & 1) == 0)
+				FillRect((x1 + x2) / 2, z1, 4, 2, TERRAIN_OPEN);
+		}
+
+		for (int z = 0; z < mapDims.hmapy; z++) {
+			for (int x = 0; x < mapDims.hmapx; x++) {
+				const float* hm = &halfResHeightMap[0];
+
+				const float dx = hm[z * mapDims.hmapx + std::min(x + 1, mapDims.hmapx - 1)] - hm[z * mapDims.hmapx + std::max(x - 1, 0)];
+				const float dz = hm[std::min(z + 1, mapDims.hmapy - 1) * mapDims.hmapx + x] - hm[std::max(z - 1, 0) * mapDims.hmapx + x];
+				const float3 normal = float3(-dx, SQUARE_SIZE * 4.0f, -dz).Normalize();
+
+				slopeMap[z * mapDims.hmapx + x] = 1.0f - normal.y;
+
+				for (int k = 0; k < 4; k++) {
+					centerHeightMap[(z * 2 + (k >> 1)) * mapDims.mapx + x * 2 + (k & 1)] = hm[z * mapDims.hmapx + x];
+					centerNormals2D[(z * 2 + (k >> 1)) * mapDims.mapx + x * 2 + (k & 1)] = float3(normal.x, 0.0f, normal.z).SafeNormalize();
+				}
+			}
+		}
+
+		mipPointerHeightMaps.fill(nullptr);
+		mipPointerHeightMaps[1] = &halfResHeightMap[0];
+	}
+
+	// (half-resolution squares)
+	void FillRect(int x1, int z1, int sx, int sz, uint8_t type) {
+		for (int z = z1; z < std::min(z1 + sz, mapDims.hmapy); z++) {
+			for (int x = x1; x < std::min(x1 + sx, mapDims.hmapx); x++) {
+				typeMap[z * mapDims.hmapx + x] = type;
+			}
+		}
+	}
+
+	void UpdateHeightMapUnsynced(const SRectangle&) override {}
+
+	void InitGroundDrawer() override {}
+	void KillGroundDrawer() override {}
+
+	unsigned int GetShadingTexture() const override { return 0; }
+	void DrawMinimap() const override {}
+
+	int GetNumFeatures() override { return 0; }
+	int GetNumFeatureTypes() override { return 0; }
+	void GetFeatureInfo(MapFeatureInfo* f) override {}
+	const char* GetFeatureTypeName(int typeID) override { return ""; }
+
+	unsigned char* GetInfoMap(const std::string& name, MapBitmapInfo* bm) override { return nullptr; }
+	void FreeInfoMap(const std::string& name, unsigned char* data) override {}
+
+	void GridVisibility(CCamera* cam, IQuadDrawer* cb, float maxDist, int quadSize, int extraSize) override {}
+
+private:
+	std::vector<float> halfResHeightMap;
+};
+
+
+// too large for the stack
+static CPathFinder maxResPF;
+static CPathEstimator medResPE;
+static CPathEstimator lowResPE;
+
+
+// the map, MoveDefs and pathfinders set up as CPathManager::Finalize does
+struct TestWorld {
+	TestWorld(unsigned int seed): rng(seed), mapInfoInst("", "") {
+		map.Init(rng);
+
+		for (CMapInfo::TerrainType& tt: mapInfoInst.terrainTypes) {
+			tt.tankSpeed  = 1.0f;
+			tt.kbotSpeed  = 1.0f;
+			tt.hoverSpeed = 1.0f;
+			tt.shipSpeed  = 1.0f;
+		}
+
+		mapInfoInst.terrainTypes[TERRAIN_WALL].tankSpeed = 0.0f;
+		mapInfoInst.terrainTypes[TERRAIN_WALL].kbotSpeed = 0.0f;
+		mapInfoInst.terrainTypes[TERRAIN_MUD ].tankSpeed = 0.3f;
+		mapInfoInst.terrainTypes[TERRAIN_MUD ].kbotSpeed = 0.6f;
+
+		readMap = &map;
+		mapInfo = &mapInfoInst;
+
+		CMoveMath::waterDamageCost = 1.0f;
+		CMoveMath::noHoverWaterMove = false;
+
+		// a tank that can not cross the lake and a bot that can
+		testMoveDefs.clear();
+		testMoveDefs.resize(2);
+
+		for (unsigned int n = 0; n < testMoveDefs.size(); n++) {
+			MoveDef& md = testMoveDefs[n];
+
+			md.pathType = n;
+			md.speedModClass = (n == 0)? MoveDef::Tank: MoveDef::KBot;
+			md.xsize = md.zsize = 4;
+			md.xsizeh = md.zsizeh = 2;
+			md.maxSlope = 1.0f - std::cos(((n == 0)? 27.0f: 54.0f) * (3.14159265f / 180.0f));
+			md.slopeMod = 4.0f / (md.maxSlope + 0.001f);
+			md.depth = (n == 0)? 22.0f: 5000.0f;
+			md.heatMapping = false;
+		}
+
+		moveDefHandler.Init(nullptr);
+
+		PathHeatMap::GetInstance();
+
+		const auto t0 = std::chrono::high_resolution_clock::now();
+
+		maxResPF.Init(false);
+		medResPE.Init(&maxResPF, MEDRES_PE_BLOCKSIZE, "", "");
+		lowResPE.Init(&medResPE, LOWRES_PE_BLOCKSIZE, "", "");
+
+		const auto t1 = std::chrono::high_resolution_clock::now();
+
+		LOG("[TestWorld] estimators initialized in %.2fms", std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-6f);
+	}
+	~TestWorld() {
+		lowResPE.Kill();
+		medResPE.Kill();
+
+		moveDefHandler.Kill();
+
+		readMap = nullptr;
+		mapInfo = nullptr;
+	}
+
+	// a random square that is not inside a wall
+	float3 GetRandomPos() {
+		std::uniform_int_distribution<int> randSquare(0, MAP_SQUARES - 1);
+
+		while (true) {
+			const int x = randSquare(rng);
+			const int z = randSquare(rng);
+
+			if (readMap->GetTypeMapSynced()[(z >> 1) * mapDims.hmapx + (x >> 1)] != TERRAIN_WALL)
+				return (SquareToFloat3(x, z));
+		}
+	}
+
+	// a unit's request, as set up by CPathManager::RequestPath and ArrangePath
+	static CCircularSearchConstraint GetPathDef(const float3& startPos, const float3& goalPos, float goalRadius) {
+		CCircularSearchConstraint pfDef(startPos, goalPos, goalRadius, 3.0f, 2000);
+
+		pfDef.synced = true;
+		pfDef.DisableConstraint(true);
+		pfDef.AllowRawPathSearch(false);
+		return pfDef;
+	}
+
+	std::mt19937 rng;
+
+	TestReadMap map;
+	CMapInfo mapInfoInst;
+};
+
+
+static int2 GetBlockPos(const float3& pos) {
+	return {int(pos.x / medResPE.BLOCK_PIXEL_SIZE), int(pos.z / medResPE.BLOCK_PIXEL_SIZE)};
+}
+
+static float GetElapsedTime(const std::chrono::high_resolution_clock::time_point t0) {
+	const auto t1 = std::chrono::high_resolution_clock::now();
+	return (std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-6f);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( PathFlowFieldEstimator )
+{
+	TestWorld world(1234);
+
+	CPathFlowField field;
+
+	float lowResSearchTime = 0.0f;
+	float medResSearchTime = 0.0f;
+	float flowFieldTime = 0.0f;
+
+	int numStarts = 0;
+	int numReachable = 0;
+	int numMedResPaths = 0;
+	int numLowResPaths = 0;
+	int numComparedPaths = 0;
+	int numShortcutPaths = 0;
+	int numCostlierFields = 0;
+	int numFollowErrors = 0;
+
+	float medResCostSum = 0.0f;
+	float fieldCostSum = 0.0f;
+
+	for (int n = 0; n < NUM_GROUPS; n++) {
+		const MoveDef& md = *moveDefHandler.GetMoveDefByPathType(n % moveDefHandler.GetNumMoveDefs());
+		const float3 goalPos = world.GetRandomPos();
+		const float goalRadius = (n % 3) * 64.0f;
+
+		// all members share the field built for the first
+		const auto t0 = std::chrono::high_resolution_clock::now();
+
+		medResPE.BuildFlowField(md, TestWorld::GetPathDef(world.GetRandomPos(), goalPos, goalRadius), field);
+
+		flowFieldTime += GetElapsedTime(t0);
+
+		for (int k = 0; k < GROUP_SIZE; k++) {
+			const float3 startPos = world.GetRandomPos();
+			const int2 startBlock = GetBlockPos(startPos);
+
+			// what ArrangePath does for each member at this distance, and the
+			// med-res search (the field's resolution) it falls back on
+			IPath::Path lowResPath;
+			IPath::Path medResPath;
+
+			CCircularSearchConstraint lowResDef = TestWorld::GetPathDef(startPos, goalPos, goalRadius);
+			CCircularSearchConstraint medResDef = TestWorld::GetPathDef(startPos, goalPos, goalRadius);
+
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			const IPath::SearchResult lowResResult = lowResPE.GetPath(md, lowResDef, nullptr, startPos, lowResPath, MAX_SEARCHED_NODES_PE >> 3);
+			lowResSearchTime += GetElapsedTime(t1);
+
+			const auto t2 = std::chrono::high_resolution_clock::now();
+			const IPath::SearchResult medResResult = medResPE.GetPath(md, medResDef, nullptr, startPos, medResPath, MAX_SEARCHED_NODES_PE >> 3);
+			medResSearchTime += GetElapsedTime(t2);
+
+			numStarts += 1;
+			numLowResPaths += (lowResResult == IPath::Ok);
+
+			if (field.IsReachable(startBlock)) {
+				// following the field from the start has to end in the goal region
+				int2 blockPos = startBlock;
+
+				for (int steps = 0; !field.IsGoal(blockPos) && steps < (medResPE.nbrOfBlocks.x * medResPE.nbrOfBlocks.y); steps++) {
+					blockPos = field.GetNextBlock(blockPos);
+				}
+
+				numReachable += 1;
+				numFollowErrors += !field.IsGoal(blockPos);
+			}
+
+			if (medResResult != IPath::Ok)
+				continue;
+
+			numMedResPaths += 1;
+
+			// the field is optimal over the estimator's precomputed vertex costs;
+			// a search may also take its first step across an infinite-cost vertex
+			// if a max-res sub-search connects the start to the neighboring block
+			// (see CPathEstimator::TestBlock), the field can only do better from
+			// that block on
+			const int2 nextBlock = (medResPath.path.size() > 1)? GetBlockPos(medResPath.path[medResPath.path.size() - 2]): startBlock;
+			const float maxFieldCost = medResPath.pathCost * 1.001f + 0.001f;
+
+			numCostlierFields += (!field.IsReachable(nextBlock) || field.GetCost(nextBlock) > maxFieldCost);
+
+			// members starting in such blocks search on their own if the field does not reach them
+			if (!field.IsReachable(startBlock) || field.GetCost(startBlock) > maxFieldCost)
+				numShortcutPaths += 1;
+
+			if (!field.IsReachable(startBlock))
+				continue;
+
+			medResCostSum += medResPath.pathCost;
+			fieldCostSum += field.GetCost(startBlock);
+			numComparedPaths += 1;
+		}
+	}
+
+	LOG("[PathFlowFieldEstimator] %d groups of %d units, %d starts reachable, %d/%d found by med-res/low-res searches (%d with a start-block shortcut)", NUM_GROUPS, GROUP_SIZE, numReachable, numMedResPaths, numLowResPaths, numShortcutPaths);
+	LOG("[PathFlowFieldEstimator] per-unit low-res PE searches: %8.2fms", lowResSearchTime);
+	LOG("[PathFlowFieldEstimator] per-unit med-res PE searches: %8.2fms (avg. path-cost %.1f)", medResSearchTime, medResCostSum / std::max(1, numComparedPaths));
+	LOG("[PathFlowFieldEstimator] flow-fields:                  %8.2fms (avg. path-cost %.1f, %u bytes per field)", flowFieldTime, fieldCostSum / std::max(1, numComparedPaths), unsigned(field.GetMemFootPrint()));
+
+	// make sure both outcomes were exercised
+	BOOST_CHECK(numReachable > 0);
+	BOOST_CHECK(numReachable < numStarts);
+
+	BOOST_CHECK_MESSAGE(numCostlierFields == 0, "flow-field costs exceed those of estimator paths");
+	BOOST_CHECK_MESSAGE(numFollowErrors == 0, "following a flow-field does not end in its goal region");
+}
+
+
+BOOST_AUTO_TEST_CASE( PathFlowFieldInvalidation )
+{
+	TestWorld world(4321);
+
+	const MoveDef& md = *moveDefHandler.GetMoveDefByPathType(0);
+
+	CCircularSearchConstraint pfDef = TestWorld::GetPathDef(ZeroVector, ZeroVector, 0.0f);
+
+	CPathFlowField field;
+	CPathFlowField freshField;
+
+	// blocks on the way to the goal, a new building there changes the field
+	std::vector<int2> pathBlocks;
+
+	// the goal must not be walled in
+	while (pathBlocks.empty()) {
+		pfDef = TestWorld::GetPathDef(world.GetRandomPos(), world.GetRandomPos(), 0.0f);
+
+		medResPE.BuildFlowField(md, pfDef, field);
+
+		for (int z = 0; z < medResPE.nbrOfBlocks.y; z++) {
+			for (int x = 0; x < medResPE.nbrOfBlocks.x; x++) {
+				if (!field.IsReachable({x, z}) || field.IsGoal({x, z}))
+					continue;
+
+				pathBlocks.push_back({x, z});
+			}
+		}
+	}
+
+	// nothing changed, nothing to rebuild
+	for (int frame = 0; frame < 10; frame++) {
+		medResPE.Update();
+
+		BOOST_CHECK(!medResPE.FlowFieldChanged(field, md.pathType));
+	}
+
+	// wall off a reachable block, as a new building would
+	const int2 blockPos = pathBlocks[world.rng() % pathBlocks.size()];
+	const float blockCost = field.GetCost(blockPos);
+
+	const int x1 = blockPos.x * MEDRES_PE_BLOCKSIZE;
+	const int z1 = blockPos.y * MEDRES_PE_BLOCKSIZE;
+
+	world.map.FillRect(x1 >> 1, z1 >> 1, MEDRES_PE_BLOCKSIZE >> 1, MEDRES_PE_BLOCKSIZE >> 1, TERRAIN_WALL);
+	medResPE.MapChanged(x1, z1, x1 + MEDRES_PE_BLOCKSIZE - 1, z1 + MEDRES_PE_BLOCKSIZE - 1);
+
+	bool fieldChanged = false;
+
+	for (int frame = 0; frame < 100; frame++) {
+		medResPE.Update();
+
+		if (!medResPE.FlowFieldChanged(field, md.pathType))
+			continue;
+
+		// the rebuilt field matches one made from scratch afterwards
+		medResPE.BuildFlowField(md, pfDef, field);
+
+		fieldChanged = true;
+	}
+
+	medResPE.BuildFlowField(md, pfDef, freshField);
+
+	BOOST_CHECK(fieldChanged);
+	BOOST_CHECK(!field.IsReachable(blockPos) || field.GetCost(blockPos) != blockCost);
+
+	int numDifferences = 0;
+
+	for (int z = 0; z < medResPE.nbrOfBlocks.y; z++) {
+		for (int x = 0; x < medResPE.nbrOfBlocks.x; x++) {
+			numDifferences += (field.IsReachable({x, z}) != freshField.IsReachable({x, z}));
+			numDifferences += (field.IsReachable({x, z}) && field.GetCost({x, z}) != freshField.GetCost({x, z}));
+		}
+	}
+
+	BOOST_CHECK(numDifferences == 0);
+}
+
+
+BOOST_AUTO_TEST_CASE( PathFlowFieldDeterminism )
+{
+	TestWorld world(5678);
+
+	const MoveDef& md = *moveDefHandler.GetMoveDefByPathType(1);
+	const CCircularSearchConstraint pfDef = TestWorld::GetPathDef(world.GetRandomPos(), world.GetRandomPos(), 64.0f);
+
+	// unreachable or not, every block of the field only depends on the inputs
+	CPathFlowField fields[2];
+
+	for (CPathFlowField& field: fields) {
+		medResPE.BuildFlowField(md, pfDef, field);
+	}
+
+	int numDifferences = 0;
+
+	for (int z = 0; z < medResPE.nbrOfBlocks.y; z++) {
+		for (int x = 0; x < medResPE.nbrOfBlocks.x; x++) {
+			const int2 blockPos = {x, z};
+
+			if (fields[0].IsReachable(blockPos) != fields[1].IsReachable(blockPos)) {
+				numDifferences += 1;
+				continue;
+			}
+
+			if (!fields[0].IsReachable(blockPos) || fields[0].IsGoal(blockPos))
+				continue;
+
+			numDifferences += (fields[0].GetNextBlock(blockPos) != fields[1].GetNextBlock(blockPos));
+			numDifferences += (fields[0].GetCost(blockPos) != fields[1].GetCost(blockPos));
+		}
+	}
+
+	BOOST_CHECK(numDifferences == 0);
+}
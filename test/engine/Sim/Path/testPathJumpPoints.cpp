@@ -0,0 +1,607 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Map/MapInfo.h"
+#include "Map/ReadMap.h"
+#include "Sim/Misc/ModInfo.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "Sim/Path/Default/PathFinder.h"
+#include "Sim/Path/Default/PathFinderDef.h"
+#include "Sim/Path/Default/PathHeatMap.hpp"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#define BOOST_TEST_MODULE PathJumpPoints
+#include <boost/test/unit_test.hpp>
+
+
+BOOST_GLOBAL_FIXTURE(InitSpringTime);
+
+
+static constexpr int MAP_SQUARES = 512;
+static constexpr int NUM_SEARCHES = 80;
+
+// terrain-types of the test map
+static constexpr uint8_t TERRAIN_OPEN = 0;
+static constexpr uint8_t TERRAIN_WALL = 1;
+static constexpr uint8_t TERRAIN_MUD  = 2;
+static constexpr uint8_t TERRAIN_ROAD = 3;
+
+// goal radii as passed to CPathManager::RequestPath; CPathFinderDef raises
+// them to at least two squares, RequestPath to at least 16 elmos
+static constexpr float GOAL_RADII[] = {0.0f, 16.0f, 64.0f, 200.0f};
+
+
+// the engine's map globals, see testPathSpeedModRows
+CReadMap* readMap = nullptr;
+MapDimensions mapDims;
+const CMapInfo* mapInfo = nullptr;
+
+std::vector<float> CReadMap::centerHeightMap;
+std::vector<float> CReadMap::slopeMap;
+std::vector<uint8_t> CReadMap::typeMap;
+std::vector<float3> CReadMap::centerNormals2D;
+
+CReadMap::~CReadMap() {}
+CMapInfo::CMapInfo(const std::string&, const std::string&) {}
+CMapInfo::~CMapInfo() {}
+
+// waypoint heights do not matter
+float CMoveMath::yLevel(const MoveDef&, int, int) { return 0.0f; }
+float CMoveMath::yLevel(const MoveDef&, const float3&) { return 0.0f; }
+
+// squares covered by structures, tested over a unit's footprint the same
+// way the real functions test the blocking-map
+static std::vector<bool> structureSquares;
+
+// same as in MoveMath.cpp
+static constexpr int FOOTPRINT_XSTEP = 2;
+static constexpr int FOOTPRINT_ZSTEP = 2;
+
+CMoveMath::BlockType CMoveMath::IsBlockedNoSpeedModCheck(const MoveDef& moveDef, int xSquare, int zSquare, const CSolidObject*) {
+	const int xmin = std::max(xSquare - moveDef.xsizeh,                0);
+	const int zmin = std::max(zSquare - moveDef.zsizeh,                0);
+	const int xmax = std::min(xSquare + moveDef.xsizeh, mapDims.mapx - 1);
+	const int zmax = std::min(zSquare + moveDef.zsizeh, mapDims.mapy - 1);
+
+	for (int z = zmin; z <= zmax; z += FOOTPRINT_ZSTEP) {
+		for (int x = xmin; x <= xmax; x += FOOTPRINT_XSTEP) {
+			if (structureSquares[z * mapDims.mapx + x])
+				return BLOCK_STRUCTURE;
+		}
+	}
+
+	return BLOCK_NONE;
+}
+CMoveMath::BlockType CMoveMath::IsBlockedNoSpeedModCheckThreadUnsafe(const MoveDef& moveDef, int xSquare, int zSquare, const CSolidObject* collider) {
+	return (IsBlockedNoSpeedModCheck(moveDef, xSquare, zSquare, collider));
+}
+
+// the real one parses movedefs.lua
+static std::vector<MoveDef> testMoveDefs;
+
+void MoveDefHandler::Init(LuaParser*) {
+	moveDefs = testMoveDefs;
+}
+
+
+class TestReadMap: public CReadMap {
+public:
+	// flat ground, where squares are uniform and runs can skip them
+	void Init(std::mt19937& rng, bool cluttered) {
+		mapDims.mapx = MAP_SQUARES;
+		mapDims.mapy = MAP_SQUARES;
+		mapDims.Initialize();
+
+		float3::maxxpos = mapDims.mapx * SQUARE_SIZE - 1;
+		float3::maxzpos = mapDims.mapy * SQUARE_SIZE - 1;
+
+		halfResHeightMap.clear();
+		halfResHeightMap.resize(mapDims.hmapx * mapDims.hmapy, 50.0f);
+		centerHeightMap.clear();
+		centerHeightMap.resize(mapDims.mapx * mapDims.mapy);
+		slopeMap.clear();
+		slopeMap.resize(mapDims.hmapx * mapDims.hmapy);
+		typeMap.clear();
+		typeMap.resize(mapDims.hmapx * mapDims.hmapy, TERRAIN_OPEN);
+		centerNormals2D.clear();
+		centerNormals2D.resize(mapDims.mapx * mapDims.mapy);
+
+		structureSquares.clear();
+		structureSquares.resize(mapDims.mapx * mapDims.mapy, false);
+
+		if (cluttered)
+			AddFeatures(rng);
+
+		for (int z = 0; z < mapDims.hmapy; z++) {
+			for (int x = 0; x < mapDims.hmapx; x++) {
+				const float* hm = &halfResHeightMap[0];
+
+				const float dx = hm[z * mapDims.hmapx + std::min(x + 1, mapDims.hmapx - 1)] - hm[z * mapDims.hmapx + std::max(x - 1, 0)];
+				const float dz = hm[std::min(z + 1, mapDims.hmapy - 1) * mapDims.hmapx + x] - hm[std::max(z - 1, 0) * mapDims.hmapx + x];
+				const float3 normal = float3(-dx, SQUARE_SIZE * 4.0f, -dz).Normalize();
+
+				slopeMap[z * mapDims.hmapx + x] = 1.0f - normal.y;
+
+				for (int k = 0; k < 4; k++) {
+					centerHeightMap[(z * 2 + (k >> 1)) * mapDims.mapx + x * 2 + (k & 1)] = hm[z * mapDims.hmapx + x];
+					centerNormals2D[(z * 2 + (k >> 1)) * mapDims.mapx + x * 2 + (k & 1)] = float3(normal.x, 0.0f, normal.z).SafeNormalize();
+				}
+			}
+		}
+
+		mipPointerHeightMaps.fill(nullptr);
+		mipPointerHeightMaps[1] = &halfResHeightMap[0];
+	}
+
+	// hills, mud, roads, cliffs of impassable terrain and structures
+	void AddFeatures(std::mt19937& rng) {
+		std::uniform_int_distribution<int> randPos(0, MAP_SQUARES / 2 - 1);
+		std::uniform_int_distribution<int> randSize(4, 40);
+		std::uniform_real_distribution<float> randf(0.0f, 1.0f);
+
+		for (int n = 0; n < 16; n++) {
+			const float cx = randPos(rng), cz = randPos(rng);
+			const float radius = randSize(rng);
+			const float height = (randf(rng) - 0.5f) * 60.0f;
+
+			for (int z = std::max(0, int(cz - radius)); z < std::min(mapDims.hmapy, int(cz + radius) + 1); z++) {
+				for (int x = std::max(0, int(cx - radius)); x < std::min(mapDims.hmapx, int(cx + radius) + 1); x++) {
+					const float d = std::sqrt((x - cx) * (x - cx) + (z - cz) * (z - cz)) / radius;
+
+					if (d < 1.0f)
+						halfResHeightMap[z * mapDims.hmapx + x] += height * (1.0f - d * d);
+				}
+			}
+		}
+
+		for (int n = 0; n < 30; n++) {
+			FillRect(randPos(rng), randPos(rng), randSize(rng), randSize(rng), TERRAIN_MUD);
+		}
+		for (int n = 0; n < 20; n++) {
+			FillRect(randPos(rng), randPos(rng), randSize(rng), 3, TERRAIN_ROAD);
+			FillRect(randPos(rng), randPos(rng), 3, randSize(rng), TERRAIN_ROAD);
+		}
+		for (int n = 0; n < 20; n++) {
+			FillRect(randPos(rng), randPos(rng), randSize(rng), 2, TERRAIN_WALL);
+			FillRect(randPos(rng), randPos(rng), 2, randSize(rng), TERRAIN_WALL);
+		}
+
+		// structures (in full-resolution squares) of various footprints
+		for (int n = 0; n < 200; n++) {
+			const int x1 = randPos(rng) * 2, sx = randSize(rng) >> 1;
+			const int z1 = randPos(rng) * 2, sz = randSize(rng) >> 1;
+
+			for (int z = z1; z < std::min(z1 + sz, mapDims.mapy); z++) {
+				for (int x = x1; x < std::min(x1 + sx, mapDims.mapx); x++) {
+					structureSquares[z * mapDims.mapx + x] = true;
+				}
+			}
+		}
+	}
+
+	// (half-resolution squares)
+	void FillRect(int x1, int z1, int sx, int sz, uint8_t type) {
+		for (int z = z1; z < std::min(z1 + sz, mapDims.hmapy); z++) {
+			for (int x = x1; x < std::min(x1 + sx, mapDims.hmapx); x++) {
+				typeMap[z * mapDims.hmapx + x] = type;
+			}
+		}
+	}
+
+	void UpdateHeightMapUnsynced(const SRectangle&) override {}
+
+	void InitGroundDrawer() override {}
+	void KillGroundDrawer() override {}
+
+	unsigned int GetShadingTexture() const override { return 0; }
+	void DrawMinimap() const override {}
+
+	int GetNumFeatures() override { return 0; }
+	int GetNumFeatureTypes() override { return 0; }
+	void GetFeatureInfo(MapFeatureInfo*) override {}
+	const char* GetFeatureTypeName(int) override { return ""; }
+
+	unsigned char* GetInfoMap(const std::string&, MapBitmapInfo*) override { return nullptr; }
+	void FreeInfoMap(const std::string&, unsigned char*) override {}
+
+	void GridVisibility(CCamera*, IQuadDrawer*, float, int, int) override {}
+
+private:
+	std::vector<float> halfResHeightMap;
+};
+
+
+// too large for the stack
+static CPathFinder maxResPF;
+
+
+// the map, MoveDefs and max-res pathfinder set up as CPathManager::Finalize does
+struct TestWorld {
+	TestWorld(unsigned int seed, bool cluttered, float roadSpeed): rng(seed), mapInfoInst("", "") {
+		map.Init(rng, cluttered);
+
+		for (CMapInfo::TerrainType& tt: mapInfoInst.terrainTypes) {
+			tt.tankSpeed  = 1.0f;
+			tt.kbotSpeed  = 1.0f;
+			tt.hoverSpeed = 1.0f;
+			tt.shipSpeed  = 1.0f;
+		}
+
+		mapInfoInst.terrainTypes[TERRAIN_WALL].tankSpeed = 0.0f;
+		mapInfoInst.terrainTypes[TERRAIN_WALL].kbotSpeed = 0.0f;
+		mapInfoInst.terrainTypes[TERRAIN_MUD ].tankSpeed = 0.5f;
+		mapInfoInst.terrainTypes[TERRAIN_MUD ].kbotSpeed = 0.7f;
+		mapInfoInst.terrainTypes[TERRAIN_ROAD].tankSpeed = roadSpeed;
+		mapInfoInst.terrainTypes[TERRAIN_ROAD].kbotSpeed = roadSpeed;
+
+		readMap = &map;
+		mapInfo = &mapInfoInst;
+
+		CMoveMath::waterDamageCost = 1.0f;
+		CMoveMath::noHoverWaterMove = false;
+
+		// a small bot and a large tank
+		testMoveDefs.clear();
+		testMoveDefs.resize(2);
+
+		for (unsigned int n = 0; n < testMoveDefs.size(); n++) {
+			MoveDef& md = testMoveDefs[n];
+
+			md.pathType = n;
+			md.speedModClass = (n == 0)? MoveDef::KBot: MoveDef::Tank;
+			md.xsize = md.zsize = (n == 0)? 2: 6;
+			md.xsizeh = md.zsizeh = md.xsize >> 1;
+			md.maxSlope = 1.0f - std::cos(((n == 0)? 40.0f: 20.0f) * (3.14159265f / 180.0f));
+			md.slopeMod = 4.0f / (md.maxSlope + 0.001f);
+			md.depth = 5000.0f;
+			md.heatMapping = false;
+		}
+
+		moveDefHandler.Init(nullptr);
+
+		PathHeatMap::GetInstance();
+
+		maxResPF.Init(false);
+	}
+	~TestWorld() {
+		moveDefHandler.Kill();
+
+		readMap = nullptr;
+		mapInfo = nullptr;
+	}
+
+	// a random square that is not inside a wall, and where no unit overlaps a structure
+	float3 GetRandomPos() {
+		std::uniform_int_distribution<int> randSquare(0, MAP_SQUARES - 1);
+
+		while (true) {
+			const int x = randSquare(rng);
+			const int z = randSquare(rng);
+
+			if (readMap->GetTypeMapSynced()[(z >> 1) * mapDims.hmapx + (x >> 1)] == TERRAIN_WALL)
+				continue;
+			if (CMoveMath::IsBlockedNoSpeedModCheck(testMoveDefs[0], x, z, nullptr) != CMoveMath::BLOCK_NONE)
+				continue;
+			if (CMoveMath::IsBlockedNoSpeedModCheck(testMoveDefs[1], x, z, nullptr) != CMoveMath::BLOCK_NONE)
+				continue;
+
+			return (SquareToFloat3(x, z));
+		}
+	}
+
+	// a unit's request, as set up by CPathManager::RequestPath and ArrangePath
+	static CCircularSearchConstraint GetPathDef(const float3& startPos, const float3& goalPos, float goalRadius) {
+		CCircularSearchConstraint pfDef(startPos, goalPos, goalRadius, 3.0f, 2000);
+
+		pfDef.synced = true;
+		pfDef.DisableConstraint(true);
+		pfDef.AllowRawPathSearch(false);
+		return pfDef;
+	}
+
+	std::mt19937 rng;
+
+	TestReadMap map;
+	CMapInfo mapInfoInst;
+};
+
+
+
+
+static constexpr unsigned int PATH_OPT_DIRS[] = {
+	PATHOPT_LEFT, PATHOPT_RIGHT, PATHOPT_UP, PATHOPT_DOWN,
+	PATHOPT_LEFT | PATHOPT_UP, PATHOPT_RIGHT | PATHOPT_UP, PATHOPT_LEFT | PATHOPT_DOWN, PATHOPT_RIGHT | PATHOPT_DOWN,
+};
+
+
+struct SearchStats {
+	int numFound = 0;
+	int numTestedBlocks = 0;
+	float searchTime = 0.0f;
+};
+
+struct SearchResult {
+	IPath::SearchResult result;
+	IPath::Path path;
+	unsigned int testedBlocks;
+};
+
+static SearchResult Search(const MoveDef& md, const CPathFinderDef& pfDef, const float3& startPos, bool jumpPoints, SearchStats& stats) {
+	SearchResult sr;
+
+	modInfo.jumpPointPathSearch = jumpPoints;
+
+	const auto t0 = std::chrono::high_resolution_clock::now();
+	sr.result = maxResPF.GetPath(md, pfDef, nullptr, startPos, sr.path, MAX_SEARCHED_NODES_PF);
+	const auto t1 = std::chrono::high_resolution_clock::now();
+
+	sr.testedBlocks = maxResPF.testedBlocks;
+
+	stats.numFound += (sr.result == IPath::Ok);
+	stats.numTestedBlocks += sr.testedBlocks;
+	stats.searchTime += (std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-6f);
+	return sr;
+}
+
+// Dijkstra over the node lattice of CPathFinder, with the step costs of
+// TestBlock and the diagonal rule of TestNeighborSquares; unlike the latter
+// it does not treat squares that were already closed as impassable sides of
+// a diagonal step, so it finds the cheapest path over those costs. Returns
+// the lowest f-cost of any goal square, comparable to IPath::Path::pathCost
+static float FindOptimalCost(const MoveDef& md, const CPathFinderDef& pfDef, const int2 startSquare) {
+	typedef std::pair<float, int> QueueEntry;
+
+	std::vector<float> gCosts(MAP_SQUARES * MAP_SQUARES, std::numeric_limits<float>::infinity());
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> openSquares;
+
+	const auto GetSpeedMod = [&](const int2 square, const int2 dirVec) {
+		if (static_cast<unsigned int>(square.x) >= MAP_SQUARES || static_cast<unsigned int>(square.y) >= MAP_SQUARES)
+			return 0.0f;
+		if ((CMoveMath::IsBlockedNoSpeedModCheck(md, square.x, square.y, nullptr) & CMoveMath::BLOCK_STRUCTURE) != 0)
+			return 0.0f;
+
+		return (CMoveMath::GetPosSpeedMod(md, square.x, square.y, float3(dirVec.x, 0.0f, dirVec.y).SafeNormalize2D()));
+	};
+
+	float bestCost = std::numeric_limits<float>::infinity();
+
+	gCosts[startSquare.y * MAP_SQUARES + startSquare.x] = 0.0f;
+	openSquares.emplace(0.0f, startSquare.y * MAP_SQUARES + startSquare.x);
+
+	while (!openSquares.empty()) {
+		const QueueEntry entry = openSquares.top();
+		const int2 square = {entry.second % MAP_SQUARES, entry.second / MAP_SQUARES};
+
+		openSquares.pop();
+
+		if (entry.first > gCosts[entry.second])
+			continue;
+		// f-costs are at least as high as g-costs
+		if (entry.first >= bestCost)
+			break;
+
+		if (pfDef.IsGoal(square.x, square.y)) {
+			bestCost = std::min(bestCost, entry.first + pfDef.Heuristic(square.x, square.y, 1));
+			continue;
+		}
+
+		for (const unsigned int pathOptDir: PATH_OPT_DIRS) {
+			const int2 dirVec = PF_DIRECTION_VECTORS_2D[pathOptDir];
+			const int2 ngbSquare = square + dirVec;
+			const float speedMod = GetSpeedMod(ngbSquare, dirVec);
+
+			if (speedMod == 0.0f)
+				continue;
+
+			const bool diagonal = (dirVec.x != 0 && dirVec.y != 0);
+
+			if (diagonal && GetSpeedMod(square + int2(dirVec.x, 0), int2(dirVec.x, 0)) == 0.0f)
+				continue;
+			if (diagonal && GetSpeedMod(square + int2(0, dirVec.y), int2(0, dirVec.y)) == 0.0f)
+				continue;
+
+			const int ngbIdx = ngbSquare.y * MAP_SQUARES + ngbSquare.x;
+			const float gCost = entry.first + ((diagonal)? 1.41421356f: 1.0f) / speedMod;
+
+			if (gCost >= gCosts[ngbIdx])
+				continue;
+
+			gCosts[ngbIdx] = gCost;
+			openSquares.emplace(gCost, ngbIdx);
+		}
+	}
+
+	return bestCost;
+}
+
+// every square of a path has to be one step (of PATH_NODE_SPACING squares)
+// away from the next, including squares that runs skipped and that were put
+// back by UnrollJumpPoints
+static bool IsContinuous(const IPath::Path& path) {
+	for (size_t n = 1; n < path.squares.size(); n++) {
+		const int2 d = path.squares[n] - path.squares[n - 1];
+
+		if (d.x != 0 && std::abs(d.x) != PATH_NODE_SPACING)
+			return false;
+		if (d.y != 0 && std::abs(d.y) != PATH_NODE_SPACING)
+			return false;
+		if (d.x == 0 && d.y == 0)
+			return false;
+	}
+
+	return true;
+}
+
+static int CompareCosts(float cost, float refCost) {
+	const float tolerance = std::max(refCost, 1.0f) * 1e-4f;
+
+	if (cost < (refCost - tolerance))
+		return -1;
+	if (cost > (refCost + tolerance))
+		return +1;
+
+	return 0;
+}
+
+
+
+BOOST_AUTO_TEST_CASE( PathJumpPointsOptimality )
+{
+	TestWorld world(1234, true, 1.0f);
+
+	SearchStats plainStats;
+	SearchStats jumpStats;
+
+	int numCompared[std::extent<decltype(GOAL_RADII)>::value] = {0};
+	int numOptimalPlain = 0;
+	int numOptimalJump = 0;
+	int numCheaperPlain = 0;
+	int numCheaperJump = 0;
+	int numInvalidCosts = 0;
+	int numMissedPaths = 0;
+	int numBrokenPaths = 0;
+
+	for (int n = 0; n < NUM_SEARCHES; n++) {
+		const MoveDef& md = *moveDefHandler.GetMoveDefByPathType(n % moveDefHandler.GetNumMoveDefs());
+		const float3 startPos = world.GetRandomPos();
+		const float3 goalPos = world.GetRandomPos();
+
+		for (unsigned int k = 0; k < std::extent<decltype(GOAL_RADII)>::value; k++) {
+			const CCircularSearchConstraint pfDef = TestWorld::GetPathDef(startPos, goalPos, GOAL_RADII[k]);
+
+			const SearchResult plain = Search(md, pfDef, startPos, false, plainStats);
+			const SearchResult jump = Search(md, pfDef, startPos, true, jumpStats);
+
+			// pruning only ever removes nodes, it can not make goals unreachable
+			numMissedPaths += (plain.result == IPath::Ok && jump.result != IPath::Ok);
+
+			if (plain.result != IPath::Ok || jump.result != IPath::Ok)
+				continue;
+
+			const float optimalCost = FindOptimalCost(md, pfDef, int2(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE));
+
+			// neither search can beat the cheapest path over the same costs
+			numInvalidCosts += (CompareCosts(plain.path.pathCost, optimalCost) < 0);
+			numInvalidCosts += (CompareCosts(jump.path.pathCost, optimalCost) < 0);
+
+			numOptimalPlain += (CompareCosts(plain.path.pathCost, optimalCost) == 0);
+			numOptimalJump += (CompareCosts(jump.path.pathCost, optimalCost) == 0);
+			numCheaperPlain += (CompareCosts(plain.path.pathCost, jump.path.pathCost) < 0);
+			numCheaperJump += (CompareCosts(jump.path.pathCost, plain.path.pathCost) < 0);
+
+			numBrokenPaths += !IsContinuous(jump.path);
+			numCompared[k] += 1;
+		}
+	}
+
+	const int numComparedPaths = numCompared[0] + numCompared[1] + numCompared[2] + numCompared[3];
+
+	LOG("[PathJumpPointsOptimality] %d searches per radius, compared paths (radius 0/16/64/200): %d/%d/%d/%d", NUM_SEARCHES, numCompared[0], numCompared[1], numCompared[2], numCompared[3]);
+	LOG("[PathJumpPointsOptimality] plain: %8d squares tested, %8.2fms, %d paths optimal, %d cheaper", plainStats.numTestedBlocks, plainStats.searchTime, numOptimalPlain, numCheaperPlain);
+	LOG("[PathJumpPointsOptimality] jumps: %8d squares tested, %8.2fms, %d paths optimal, %d cheaper", jumpStats.numTestedBlocks, jumpStats.searchTime, numOptimalJump, numCheaperJump);
+
+	for (const int num: numCompared) {
+		BOOST_CHECK(num > 0);
+	}
+
+	BOOST_CHECK(CMoveMath::GetMaxSpeedMod(*moveDefHandler.GetMoveDefByPathType(0)) <= 1.0f);
+	BOOST_CHECK(CMoveMath::GetMaxSpeedMod(*moveDefHandler.GetMoveDefByPathType(1)) <= 1.0f);
+	BOOST_CHECK(jumpStats.numTestedBlocks < plainStats.numTestedBlocks);
+
+	BOOST_CHECK_MESSAGE(numInvalidCosts == 0, "paths are cheaper than the cheapest possible");
+	BOOST_CHECK_MESSAGE(numMissedPaths == 0, "jump-point searches miss goals that plain searches reach");
+	BOOST_CHECK_MESSAGE(numBrokenPaths == 0, "jump-point paths skip squares");
+	BOOST_CHECK(numOptimalJump >= numOptimalPlain);
+	BOOST_CHECK(numComparedPaths > 0);
+}
+
+
+BOOST_AUTO_TEST_CASE( PathJumpPointsOpenTerrain )
+{
+	// without closed squares next to the path, plain searches can not be
+	// steered off the cheapest path (see PathJumpPoints.h) and jumps must
+	// find exactly the same cost as the reference
+	TestWorld world(5678, false, 1.0f);
+
+	SearchStats plainStats;
+	SearchStats jumpStats;
+
+	int numNonOptimal = 0;
+	int numBrokenPaths = 0;
+
+	for (int n = 0; n < NUM_SEARCHES / 4; n++) {
+		const MoveDef& md = *moveDefHandler.GetMoveDefByPathType(n % moveDefHandler.GetNumMoveDefs());
+		const float3 startPos = world.GetRandomPos();
+		const float3 goalPos = world.GetRandomPos();
+
+		for (const float goalRadius: GOAL_RADII) {
+			const CCircularSearchConstraint pfDef = TestWorld::GetPathDef(startPos, goalPos, goalRadius);
+
+			const SearchResult plain = Search(md, pfDef, startPos, false, plainStats);
+			const SearchResult jump = Search(md, pfDef, startPos, true, jumpStats);
+
+			BOOST_CHECK(plain.result == IPath::Ok);
+			BOOST_CHECK(jump.result == IPath::Ok);
+
+			if (jump.result != IPath::Ok)
+				continue;
+
+			const float optimalCost = FindOptimalCost(md, pfDef, int2(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE));
+
+			numNonOptimal += (CompareCosts(jump.path.pathCost, optimalCost) != 0);
+			numBrokenPaths += !IsContinuous(jump.path);
+		}
+	}
+
+	LOG("[PathJumpPointsOpenTerrain] plain: %8d squares tested, %8.2fms", plainStats.numTestedBlocks, plainStats.searchTime);
+	LOG("[PathJumpPointsOpenTerrain] jumps: %8d squares tested, %8.2fms", jumpStats.numTestedBlocks, jumpStats.searchTime);
+
+	BOOST_CHECK(jumpStats.numTestedBlocks < plainStats.numTestedBlocks);
+	BOOST_CHECK_MESSAGE(numNonOptimal == 0, "jump-point paths are not the cheapest on open terrain");
+	BOOST_CHECK_MESSAGE(numBrokenPaths == 0, "jump-point paths skip squares");
+}
+
+
+BOOST_AUTO_TEST_CASE( PathJumpPointsFastTerrain )
+{
+	// roads faster than speedmod 1 make the heuristic inconsistent
+	TestWorld world(4321, true, 1.5f);
+
+	SearchStats plainStats;
+	SearchStats jumpStats;
+
+	int numDifferences = 0;
+
+	for (int n = 0; n < NUM_SEARCHES / 3; n++) {
+		const MoveDef& md = *moveDefHandler.GetMoveDefByPathType(n % moveDefHandler.GetNumMoveDefs());
+		const float3 startPos = world.GetRandomPos();
+		const CCircularSearchConstraint pfDef = TestWorld::GetPathDef(startPos, world.GetRandomPos(), GOAL_RADII[n % std::extent<decltype(GOAL_RADII)>::value]);
+
+		BOOST_CHECK(CMoveMath::GetMaxSpeedMod(md) > 1.0f);
+
+		const SearchResult plain = Search(md, pfDef, startPos, false, plainStats);
+		const SearchResult jump = Search(md, pfDef, startPos, true, jumpStats);
+
+		// so no squares may be pruned, the search has to stay the same
+		numDifferences += (plain.result != jump.result);
+		numDifferences += (plain.testedBlocks != jump.testedBlocks);
+		numDifferences += (plain.path.pathCost != jump.path.pathCost);
+		numDifferences += (plain.path.squares != jump.path.squares);
+	}
+
+	LOG("[PathJumpPointsFastTerrain] %d of %d paths found", jumpStats.numFound, NUM_SEARCHES / 3);
+
+	BOOST_CHECK(jumpStats.numFound > 0);
+	BOOST_CHECK_MESSAGE(numDifferences == 0, "jump-point searches were not disabled for speedmods above 1");
+}
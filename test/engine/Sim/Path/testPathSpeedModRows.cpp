@@ -0,0 +1,379 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Map/MapInfo.h"
+#include "Map/ReadMap.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "Sim/Path/Default/PathConstants.h"
+#include "System/Log/ILog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE PathSpeedModRows
+#include <boost/test/unit_test.hpp>
+
+
+// a 32x32 map (2048x2048 squares), as large as commonly played ones get
+static constexpr int MAP_SQUARES = 32 * 64;
+static constexpr int NUM_TERRAIN_TYPES = CMapInfo::NUM_TERRAIN_TYPES;
+
+
+// the engine's map globals; CMoveMath reads the synced half-resolution
+// height-, slope- and type-maps through readMap and the terrain-type
+// speeds through mapInfo, nothing else is needed for speedmods
+CReadMap* readMap = nullptr;
+MapDimensions mapDims;
+const CMapInfo* mapInfo = nullptr;
+
+std::vector<float> CReadMap::slopeMap;
+std::vector<uint8_t> CReadMap::typeMap;
+std::vector<float3> CReadMap::centerNormals2D;
+
+// the real ones load a map, resp. parse its mapinfo.lua
+CReadMap::~CReadMap() {}
+CMapInfo::CMapInfo(const std::string& mapInfoFile, const std::string& mapName) {}
+CMapInfo::~CMapInfo() {}
+
+
+class TestReadMap: public CReadMap {
+public:
+	// hills and valleys reaching well below the water-plane, with
+	// patches of other terrain-types; slopes follow from the heights
+	void Init(std::mt19937& rng) {
+		std::uniform_real_distribution<float> randf(0.0f, 1.0f);
+		std::uniform_int_distribution<int> randType(1, NUM_TERRAIN_TYPES - 1);
+
+		mapDims.mapx = MAP_SQUARES;
+		mapDims.mapy = MAP_SQUARES;
+		mapDims.Initialize();
+
+		halfResHeightMap.resize(mapDims.hmapx * mapDims.hmapy);
+		slopeMap.resize(mapDims.hmapx * mapDims.hmapy);
+		typeMap.resize(mapDims.hmapx * mapDims.hmapy, 0);
+
+		for (int z = 0; z < mapDims.hmapy; z++) {
+			for (int x = 0; x < mapDims.hmapx; x++) {
+				halfResHeightMap[z * mapDims.hmapx + x] = std::sin(x * 0.011f) * 120.0f + std::cos(z * 0.017f) * 90.0f + randf(rng) * 10.0f - 30.0f;
+			}
+		}
+
+		for (int z = 0; z < mapDims.hmapy; z++) {
+			for (int x = 0; x < mapDims.hmapx; x++) {
+				const float* hm = &halfResHeightMap[0];
+
+				const float dx = hm[z * mapDims.hmapx + std::min(x + 1, mapDims.hmapx - 1)] - hm[z * mapDims.hmapx + std::max(x - 1, 0)];
+				const float dz = hm[std::min(z + 1, mapDims.hmapy - 1) * mapDims.hmapx + x] - hm[std::max(z - 1, 0) * mapDims.hmapx + x];
+				const float3 normal = float3(-dx, SQUARE_SIZE * 4.0f, -dz).Normalize();
+
+				slopeMap[z * mapDims.hmapx + x] = 1.0f - normal.y;
+			}
+		}
+
+		for (int n = 0; n < 200; n++) {
+			const int px = rng() % mapDims.hmapx;
+			const int pz = rng() % mapDims.hmapy;
+			const int size = 4 + rng() % 60;
+			const uint8_t type = randType(rng);
+
+			for (int z = pz; z < std::min(pz + size, mapDims.hmapy); z++) {
+				std::fill(typeMap.begin() + z * mapDims.hmapx + px, typeMap.begin() + z * mapDims.hmapx + std::min(px + size, mapDims.hmapx), type);
+			}
+		}
+
+		mipPointerHeightMaps.fill(nullptr);
+		mipPointerHeightMaps[1] = &halfResHeightMap[0];
+	}
+
+	void UpdateHeightMapUnsynced(const SRectangle&) override {}
+
+	void InitGroundDrawer() override {}
+	void KillGroundDrawer() override {}
+
+	unsigned int GetShadingTexture() const override { return 0; }
+	void DrawMinimap() const override {}
+
+	int GetNumFeatures() override { return 0; }
+	int GetNumFeatureTypes() override { return 0; }
+	void GetFeatureInfo(MapFeatureInfo* f) override {}
+	const char* GetFeatureTypeName(int typeID) override { return ""; }
+
+	unsigned char* GetInfoMap(const std::string& name, MapBitmapInfo* bm) override { return nullptr; }
+	void FreeInfoMap(const std::string& name, unsigned char* data) override {}
+
+	void GridVisibility(CCamera* cam, IQuadDrawer* cb, float maxDist, int quadSize, int extraSize) override {}
+
+private:
+	std::vector<float> halfResHeightMap;
+};
+
+
+struct TestWorld {
+	TestWorld(unsigned int seed): rng(seed), mapInfoInst("", "") {
+		std::uniform_real_distribution<float> randf(0.0f, 1.0f);
+
+		map.Init(rng);
+
+		for (CMapInfo::TerrainType& tt: mapInfoInst.terrainTypes) {
+			tt.tankSpeed  = (randf(rng) < 0.1f)? 0.0f: (0.2f + randf(rng) * 1.8f);
+			tt.kbotSpeed  = (randf(rng) < 0.1f)? 0.0f: (0.2f + randf(rng) * 1.8f);
+			tt.hoverSpeed = (randf(rng) < 0.1f)? 0.0f: (0.2f + randf(rng) * 1.8f);
+			tt.shipSpeed  = (randf(rng) < 0.1f)? 0.0f: (0.2f + randf(rng) * 1.8f);
+		}
+
+		mapInfoInst.terrainTypes[0].tankSpeed  = 1.0f;
+		mapInfoInst.terrainTypes[0].kbotSpeed  = 1.0f;
+		mapInfoInst.terrainTypes[0].hoverSpeed = 1.0f;
+		mapInfoInst.terrainTypes[0].shipSpeed  = 1.0f;
+
+		readMap = &map;
+		mapInfo = &mapInfoInst;
+
+		CMoveMath::waterDamageCost = 0.8f;
+		CMoveMath::noHoverWaterMove = false;
+
+		InitMoveDefs();
+	}
+	~TestWorld() {
+		readMap = nullptr;
+		mapInfo = nullptr;
+	}
+
+	static float DegreesToMaxSlope(float degrees) {
+		return (1.0f - std::cos(std::min(degrees, 60.0f) * 1.5f * (3.14159265f / 180.0f)));
+	}
+
+	// a typical game's set: tanks, bots, amphibious, hovers and ships
+	void InitMoveDefs() {
+		struct Def { MoveDef::SpeedModClass smc; float maxSlope; float depth; float depthMod; };
+
+		const Def defs[] = {
+			{MoveDef::Tank,  18.0f,   22.0f, 0.1f},
+			{MoveDef::Tank,  18.0f,   22.0f, 0.1f},
+			{MoveDef::Tank,  22.0f,   30.0f, 0.1f},
+			{MoveDef::Tank,  22.0f, 5000.0f, 0.0f},
+			{MoveDef::KBot,  36.0f,   15.0f, 0.1f},
+			{MoveDef::KBot,  36.0f,   22.0f, 0.1f},
+			{MoveDef::KBot,  60.0f,   22.0f, 0.1f},
+			{MoveDef::KBot,  36.0f, 5000.0f, 0.0f},
+			{MoveDef::Hover, 22.0f,    0.0f, 0.0f},
+			{MoveDef::Hover, 22.0f,    0.0f, 0.0f},
+			{MoveDef::Ship,  15.0f,    8.0f, 0.0f},
+			{MoveDef::Ship,  15.0f,   15.0f, 0.0f},
+		};
+
+		moveDefs.clear();
+		moveDefs.resize(sizeof(defs) / sizeof(defs[0]));
+
+		for (unsigned int n = 0; n < moveDefs.size(); n++) {
+			MoveDef& md = moveDefs[n];
+
+			md.pathType = n;
+			md.speedModClass = defs[n].smc;
+			md.maxSlope = DegreesToMaxSlope(defs[n].maxSlope);
+			md.slopeMod = 4.0f / (md.maxSlope + 0.001f);
+			md.depth = defs[n].depth;
+			md.depthModParams[MoveDef::DEPTHMOD_LIN_COEFF] = defs[n].depthMod;
+
+			// one MoveDef with a bounded quadratic depth-mod
+			if (n == 5) {
+				md.depthModParams[MoveDef::DEPTHMOD_MIN_HEIGHT] = 4.0f;
+				md.depthModParams[MoveDef::DEPTHMOD_MAX_HEIGHT] = 18.0f;
+				md.depthModParams[MoveDef::DEPTHMOD_MAX_SCALE] = 3.0f;
+				md.depthModParams[MoveDef::DEPTHMOD_QUA_COEFF] = 0.01f;
+			}
+		}
+	}
+
+	std::mt19937 rng;
+
+	TestReadMap map;
+	CMapInfo mapInfoInst;
+
+	std::vector<MoveDef> moveDefs;
+};
+
+
+
+BOOST_AUTO_TEST_CASE( PathSpeedModRowsEquality )
+{
+	TestWorld world(1234);
+
+	std::uniform_int_distribution<int> randPos(0, mapDims.hmapx - 1);
+	std::uniform_int_distribution<int> randLen(1, 100);
+
+	int numMismatches = 0;
+	int numZeroSpeedMods = 0;
+	int numSquares = 0;
+
+	std::vector<float> rowSpeedMods;
+
+	for (int noHoverWaterMove = 0; noHoverWaterMove < 2; noHoverWaterMove++) {
+		CMoveMath::noHoverWaterMove = noHoverWaterMove;
+
+		for (const MoveDef& md: world.moveDefs) {
+			for (int k = 0; k < 4000; k++) {
+				// rows may run past the map edge, and start outside it
+				const int hz = randPos(world.rng) + ((k & 255) == 0) * mapDims.hmapy;
+				const int hx = randPos(world.rng);
+				const int len = randLen(world.rng);
+
+				rowSpeedMods.clear();
+				rowSpeedMods.resize(len, -1.0f);
+
+				CMoveMath::GetPosSpeedModRow(md, hx, hz, len, rowSpeedMods.data());
+
+				for (int i = 0; i < len; i++) {
+					// both full-resolution squares of each half-resolution one
+					for (int j = 0; j < 2; j++) {
+						const float speedMod = CMoveMath::GetPosSpeedMod(md, (hx + i) * 2 + j, hz * 2 + j);
+
+						// must be bit-wise identical, not merely close
+						numMismatches += (std::memcmp(&speedMod, &rowSpeedMods[i], sizeof(float)) != 0);
+						numZeroSpeedMods += (speedMod == 0.0f);
+						numSquares += 1;
+					}
+				}
+			}
+		}
+	}
+
+	// make sure all branches (impassable squares included) were exercised
+	BOOST_CHECK(numZeroSpeedMods > 0);
+	BOOST_CHECK(numZeroSpeedMods < numSquares);
+	BOOST_CHECK_MESSAGE(numMismatches == 0, "GetPosSpeedModRow differs from GetPosSpeedMod");
+}
+
+
+BOOST_AUTO_TEST_CASE( PathSpeedModRowsCost )
+{
+	TestWorld world(4321);
+
+	struct SOffsetBlock {
+		float cost;
+		int2 offset;
+	};
+
+	// the speedmod part of CPathEstimator's initialization, for both PEs: the
+	// map-wide maximum speedmod of every MoveDef (low-res PE only) and the
+	// offset of every block, for every MoveDef (FindBlockPosOffset); <rows>
+	// selects between the GetPosSpeedModRow version and the per-square one
+	const auto InitEstimator = [&](unsigned int BLOCK_SIZE, bool rows, std::vector<float>& maxSpeedMods, std::vector<int2>& blockOffsets) {
+		std::vector<SOffsetBlock> offsetBlocksSortedByCost;
+
+		for (unsigned int z = 0; z < BLOCK_SIZE; ++z) {
+			for (unsigned int x = 0; x < BLOCK_SIZE; ++x) {
+				const float dx = x - (float)(BLOCK_SIZE - 1) * 0.5f;
+				const float dz = z - (float)(BLOCK_SIZE - 1) * 0.5f;
+
+				offsetBlocksSortedByCost.push_back({dx * dx + dz * dz, int2(x, z)});
+			}
+		}
+
+		std::stable_sort(offsetBlocksSortedByCost.begin(), offsetBlocksSortedByCost.end(), [](const SOffsetBlock& a, const SOffsetBlock& b) {
+			return (a.cost < b.cost);
+		});
+
+		const auto t0 = std::chrono::high_resolution_clock::now();
+
+		const int2 nbrOfBlocks(mapDims.mapx / BLOCK_SIZE, mapDims.mapy / BLOCK_SIZE);
+		const unsigned int blockArea = (BLOCK_SIZE * BLOCK_SIZE) / SQUARE_SIZE;
+
+		std::vector<float> speedMods(std::max<int>(mapDims.hmapx, (LOWRES_PE_BLOCKSIZE >> 1) * (LOWRES_PE_BLOCKSIZE >> 1)));
+
+		for (const MoveDef& md: world.moveDefs) {
+			if (BLOCK_SIZE == LOWRES_PE_BLOCKSIZE) {
+				float& maxSpeedMod = maxSpeedMods[md.pathType];
+
+				if (rows) {
+					for (int y = 0; y < mapDims.hmapy; y++) {
+						CMoveMath::GetPosSpeedModRow(md, 0, y, mapDims.hmapx, speedMods.data());
+
+						for (int x = 0; x < mapDims.hmapx; x++) {
+							maxSpeedMod = std::max(maxSpeedMod, speedMods[x]);
+						}
+					}
+				} else {
+					for (int y = 0; y < mapDims.mapy; y++) {
+						for (int x = 0; x < mapDims.mapx; x++) {
+							maxSpeedMod = std::max(maxSpeedMod, CMoveMath::GetPosSpeedMod(md, x, y));
+						}
+					}
+				}
+			}
+
+			for (int blockZ = 0; blockZ < nbrOfBlocks.y; blockZ++) {
+				for (int blockX = 0; blockX < nbrOfBlocks.x; blockX++) {
+					const unsigned int lowerX = blockX * BLOCK_SIZE;
+					const unsigned int lowerZ = blockZ * BLOCK_SIZE;
+
+					int2 bestPos(lowerX + (BLOCK_SIZE >> 1), lowerZ + (BLOCK_SIZE >> 1));
+					float bestCost = std::numeric_limits<float>::max();
+
+					if (rows) {
+						for (unsigned int z = 0; z < (BLOCK_SIZE >> 1); z++) {
+							CMoveMath::GetPosSpeedModRow(md, lowerX >> 1, (lowerZ >> 1) + z, BLOCK_SIZE >> 1, &speedMods[z * (BLOCK_SIZE >> 1)]);
+						}
+					}
+
+					// no structures exist while the PEs are initialized
+					for (const SOffsetBlock& ob: offsetBlocksSortedByCost) {
+						if (ob.cost >= bestCost)
+							break;
+
+						const int2 blockPos(lowerX + ob.offset.x, lowerZ + ob.offset.y);
+						const float speedMod = rows?
+							speedMods[(ob.offset.y >> 1) * (BLOCK_SIZE >> 1) + (ob.offset.x >> 1)]:
+							CMoveMath::GetPosSpeedMod(md, blockPos.x, blockPos.y);
+						const float cost = ob.cost + (blockArea / (0.001f + speedMod));
+
+						if (cost >= bestCost)
+							continue;
+
+						bestCost = cost;
+						bestPos = blockPos;
+					}
+
+					blockOffsets.push_back(bestPos);
+				}
+			}
+		}
+
+		const auto t1 = std::chrono::high_resolution_clock::now();
+		return (std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-6f);
+	};
+
+	std::vector<float> squareMaxSpeedMods(world.moveDefs.size(), 0.001f);
+	std::vector<float> rowMaxSpeedMods(world.moveDefs.size(), 0.001f);
+
+	std::vector<int2> squareOffsets;
+	std::vector<int2> rowOffsets;
+
+	float squareTimes[2];
+	float rowTimes[2];
+
+	for (unsigned int n = 0; n < 2; n++) {
+		const unsigned int blockSize = (n == 0)? MEDRES_PE_BLOCKSIZE: LOWRES_PE_BLOCKSIZE;
+
+		squareTimes[n] = InitEstimator(blockSize, false, squareMaxSpeedMods, squareOffsets);
+		rowTimes[n] = InitEstimator(blockSize, true, rowMaxSpeedMods, rowOffsets);
+
+		LOG("[PathSpeedModRowsCost] PE blocksize %2u: per-square=%8.2fms rows=%8.2fms (%.2fx)", blockSize, squareTimes[n], rowTimes[n], squareTimes[n] / std::max(rowTimes[n], 0.001f));
+	}
+
+	LOG("[PathSpeedModRowsCost] %dx%d squares, %u MoveDefs: per-square=%8.2fms rows=%8.2fms (%.2fx)",
+		mapDims.mapx, mapDims.mapy, unsigned(world.moveDefs.size()),
+		squareTimes[0] + squareTimes[1],
+		rowTimes[0] + rowTimes[1],
+		(squareTimes[0] + squareTimes[1]) / std::max(rowTimes[0] + rowTimes[1], 0.001f)
+	);
+
+	// the PE caches depend on these, so must be identical
+	BOOST_CHECK(squareMaxSpeedMods == rowMaxSpeedMods);
+	BOOST_CHECK(squareOffsets == rowOffsets);
+}
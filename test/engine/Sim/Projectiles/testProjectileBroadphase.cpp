@@ -0,0 +1,445 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Misc/QuadField.h"
+#include "Sim/Projectiles/ProjectileBroadphase.h"
+#include "System/float3.h"
+#include "System/Log/ILog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdlib.h>
+
+#define BOOST_TEST_MODULE ProjectileBroadphase
+#include <boost/test/unit_test.hpp>
+
+
+static constexpr int MAP_SQUARES = 1024;
+static constexpr float MAP_SIZE = MAP_SQUARES * SQUARE_SIZE;
+
+
+static inline float randf()
+{
+	return rand() / float(RAND_MAX);
+}
+
+
+// stand-in for a unit, feature or shield; CUnit et al. can not be
+// instantiated here, so their bounding spheres are modelled directly
+// (with the QuadField links computed from the same sphere as in
+// CQuadField::MovedUnit)
+struct TestSolid {
+	float3 pos;
+	float radius;
+
+	int type;
+	int id;
+	int sub;
+
+	bool alive;
+};
+
+struct TestProjectile {
+	float3 pos;
+	float radius; // speed.w + radius
+};
+
+
+static bool SolidLess(const TestSolid* a, const TestSolid* b)
+{
+	if (a->type != b->type)
+		return (a->type < b->type);
+	if (a->id != b->id)
+		return (a->id < b->id);
+
+	return (a->sub < b->sub);
+}
+
+static bool EntryLess(const CProjectileBroadphase::SolidEntry& a, const CProjectileBroadphase::SolidEntry& b)
+{
+	if (a.minX != b.minX)
+		return (a.minX < b.minX);
+	if (a.type != b.type)
+		return (a.type < b.type);
+	if (a.id != b.id)
+		return (a.id < b.id);
+
+	return (a.sub < b.sub);
+}
+
+static bool InRange(const TestProjectile& p, const TestSolid& s)
+{
+	// bounding-sphere test of GetUnitsAndFeaturesColVol
+	const float totRad = p.radius + s.radius;
+	return (p.pos.SqDistance(s.pos) < (totRad * totRad));
+}
+
+// objects are either spread over the whole map or crowded into one battle area
+struct TestArea {
+	float mins;
+	float maxs;
+};
+
+static constexpr TestArea MAP_AREA = {64.0f, MAP_SIZE - 64.0f};
+static constexpr TestArea BATTLE_AREA = {3072.0f, 4096.0f};
+
+static float3 RandomPos(const TestArea& area)
+{
+	return float3(area.mins + randf() * (area.maxs - area.mins), 0.0f, area.mins + randf() * (area.maxs - area.mins));
+}
+
+
+class TestWorld {
+public:
+	void Init(int numSolids, const TestArea& _area) {
+		area = _area;
+
+		// reserve up-front, entries point into this vector
+		solids.clear();
+		solids.reserve(numSolids * 4);
+
+		for (int i = 0; i < numSolids; i++) {
+			AddRandomSolid();
+		}
+
+		quadField.Init(int2(MAP_SQUARES, MAP_SQUARES), CQuadField::BASE_QUAD_SIZE);
+		broadphase.Kill();
+	}
+
+	void AddRandomSolid() {
+		TestSolid s;
+		s.pos = RandomPos(area);
+		s.radius = 4.0f + randf() * 60.0f;
+		s.type = rand() % 3;
+		s.id = int(solids.size());
+		s.sub = (s.type == CProjectileBroadphase::SOLID_TYPE_REPULSER)? (rand() % 4): 0;
+		s.alive = true;
+
+		solids.push_back(s);
+	}
+
+	// advances all solids by one frame: most move a little, some teleport, some die, some are born
+	void Step(float moveDist, float teleportChance, float killChance, int numBorn) {
+		for (TestSolid& s: solids) {
+			if (!s.alive)
+				continue;
+
+			if (randf() < killChance) {
+				s.alive = false;
+				continue;
+			}
+
+			if (randf() < teleportChance) {
+				s.pos = RandomPos(area);
+			} else {
+				s.pos.x = std::max(area.mins, std::min(area.maxs, s.pos.x + (randf() - 0.5f) * moveDist * 2.0f));
+				s.pos.z = std::max(area.mins, std::min(area.maxs, s.pos.z + (randf() - 0.5f) * moveDist * 2.0f));
+			}
+		}
+
+		for (int i = 0; i < numBorn; i++) {
+			AddRandomSolid();
+		}
+	}
+
+	// same steps as CProjectileBroadphase::UpdateSolids, minus the handler lookups
+	void UpdateBroadphase() {
+		std::vector<CProjectileBroadphase::SolidEntry>& entries = broadphase.GetSolidEntries();
+		std::vector<bool> tracked(solids.size(), false);
+
+		size_t n = 0;
+
+		for (size_t i = 0; i < entries.size(); i++) {
+			CProjectileBroadphase::SolidEntry& e = entries[i];
+			const TestSolid* s = static_cast<const TestSolid*>(e.object);
+
+			if (!s->alive)
+				continue;
+
+			e.minX = s->pos.x - s->radius;
+			e.maxX = s->pos.x + s->radius;
+			e.minZ = s->pos.z - s->radius;
+			e.maxZ = s->pos.z + s->radius;
+			entries[n++] = e;
+
+			tracked[s - &solids[0]] = true;
+		}
+
+		entries.resize(n);
+
+		const size_t numTracked = entries.size();
+
+		for (size_t i = 0; i < solids.size(); i++) {
+			TestSolid& s = solids[i];
+
+			if (!s.alive || tracked[i])
+				continue;
+
+			entries.push_back({s.pos.x - s.radius, s.pos.x + s.radius, s.pos.z - s.radius, s.pos.z + s.radius, s.type, s.id, s.sub, &s});
+		}
+
+		broadphase.SortSolids(numTracked);
+	}
+
+	// links every live solid into the quads its bounding sphere touches
+	void UpdateQuadField() {
+		quadSolids.clear();
+		quadSolids.resize(quadField.GetNumQuadsX() * quadField.GetNumQuadsZ());
+
+		for (TestSolid& s: solids) {
+			if (!s.alive)
+				continue;
+
+			QuadFieldQuery qfQuery;
+			quadField.GetQuads(qfQuery, s.pos, s.radius);
+
+			for (const int qi: *qfQuery.quads) {
+				quadSolids[qi].push_back(&s);
+			}
+		}
+
+		visited.clear();
+		visited.resize(solids.size(), 0);
+		visitStamp = 0;
+	}
+
+	void SweepProjectiles(const std::vector<TestProjectile>& projectiles) {
+		std::vector<CProjectileBroadphase::ProjectileEntry>& entries = broadphase.GetProjectileEntries();
+
+		entries.clear();
+
+		for (size_t i = 0; i < projectiles.size(); i++) {
+			const TestProjectile& p = projectiles[i];
+			entries.push_back({p.pos.x - p.radius, p.pos.x + p.radius, p.pos.z - p.radius, p.pos.z + p.radius, static_cast<int>(i)});
+		}
+
+		broadphase.SweepEntries();
+		pairIndex = 0;
+	}
+
+	// mirrors CProjectileBroadphase::GetCandidates
+	void GetBroadphaseCandidates(const TestProjectile& p, int i, std::vector<const TestSolid*>& candidates) {
+		const std::vector<CProjectileBroadphase::CandidatePair>& pairs = broadphase.GetCandidatePairs();
+		const std::vector<CProjectileBroadphase::SolidEntry>& entries = broadphase.GetSolidEntries();
+
+		while (pairIndex < pairs.size() && pairs[pairIndex].projIndex < i)
+			pairIndex++;
+
+		for (; pairIndex < pairs.size() && pairs[pairIndex].projIndex == i; pairIndex++) {
+			const TestSolid* s = static_cast<const TestSolid*>(entries[pairs[pairIndex].solidIndex].object);
+
+			if (!InRange(p, *s))
+				continue;
+
+			candidates.push_back(s);
+		}
+	}
+
+	// mirrors CQuadField::GetUnitsAndFeaturesColVol
+	void GetQuadFieldCandidates(const TestProjectile& p, std::vector<const TestSolid*>& candidates) {
+		QuadFieldQuery qfQuery;
+		quadField.GetQuads(qfQuery, p.pos, p.radius);
+
+		visitStamp += 1;
+
+		for (const int qi: *qfQuery.quads) {
+			for (const TestSolid* s: quadSolids[qi]) {
+				const size_t k = s - &solids[0];
+
+				if (visited[k] == visitStamp)
+					continue;
+
+				visited[k] = visitStamp;
+
+				if (!InRange(p, *s))
+					continue;
+
+				candidates.push_back(s);
+			}
+		}
+	}
+
+	CProjectileBroadphase& GetBroadphase() { return broadphase; }
+
+private:
+	TestArea area;
+
+	std::vector<TestSolid> solids;
+	std::vector< std::vector<const TestSolid*> > quadSolids;
+
+	std::vector<unsigned int> visited;
+	unsigned int visitStamp = 0;
+
+	CProjectileBroadphase broadphase;
+	size_t pairIndex = 0;
+};
+
+
+static std::vector<TestProjectile> RandomProjectiles(int numProjectiles, const TestArea& area)
+{
+	std::vector<TestProjectile> projectiles(numProjectiles);
+
+	for (TestProjectile& p: projectiles) {
+		p.pos = RandomPos(area);
+		p.radius = 1.0f + randf() * 30.0f;
+	}
+
+	return projectiles;
+}
+
+
+BOOST_AUTO_TEST_CASE( ProjectileBroadphaseSortSolids )
+{
+	srand(1234);
+
+	float3::maxxpos = MAP_SIZE - 1.0f;
+	float3::maxzpos = MAP_SIZE - 1.0f;
+
+	TestWorld world;
+	world.Init(2000, MAP_AREA);
+	world.UpdateBroadphase();
+
+	const std::vector<CProjectileBroadphase::SolidEntry>& entries = world.GetBroadphase().GetSolidEntries();
+
+	for (int frame = 0; frame < 50; frame++) {
+		// every tenth frame teleports a large fraction, to hit the full-sort fallback
+		world.Step(8.0f, (frame % 10 == 9)? 0.5f: 0.001f, 0.01f, 20);
+		world.UpdateBroadphase();
+
+		std::vector<CProjectileBroadphase::SolidEntry> sorted = entries;
+		std::sort(sorted.begin(), sorted.end(), EntryLess);
+
+		BOOST_CHECK(std::is_sorted(entries.begin(), entries.end(), EntryLess));
+		BOOST_CHECK(std::equal(entries.begin(), entries.end(), sorted.begin(), [](const CProjectileBroadphase::SolidEntry& a, const CProjectileBroadphase::SolidEntry& b) {
+			return (a.object == b.object && a.minX == b.minX);
+		}));
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( ProjectileBroadphaseMatchesQuadField )
+{
+	srand(4321);
+
+	float3::maxxpos = MAP_SIZE - 1.0f;
+	float3::maxzpos = MAP_SIZE - 1.0f;
+
+	std::vector<const TestSolid*> bpCandidates;
+	std::vector<const TestSolid*> qfCandidates;
+
+	for (const TestArea& area: {MAP_AREA, BATTLE_AREA}) {
+		TestWorld world;
+		world.Init(3000, area);
+
+		int numMismatches = 0;
+		int numUnordered = 0;
+		int numCandidates = 0;
+
+		for (int frame = 0; frame < 10; frame++) {
+			world.Step(8.0f, 0.001f, 0.01f, 30);
+			world.UpdateBroadphase();
+			world.UpdateQuadField();
+
+			const std::vector<TestProjectile> projectiles = RandomProjectiles(4000, area);
+
+			world.SweepProjectiles(projectiles);
+
+			for (size_t i = 0; i < projectiles.size(); i++) {
+				bpCandidates.clear();
+				qfCandidates.clear();
+
+				world.GetBroadphaseCandidates(projectiles[i], i, bpCandidates);
+				world.GetQuadFieldCandidates(projectiles[i], qfCandidates);
+
+				// the broadphase hands out candidates in (type, id) order by itself
+				numUnordered += !std::is_sorted(bpCandidates.begin(), bpCandidates.end(), SolidLess);
+				numCandidates += bpCandidates.size();
+
+				std::sort(qfCandidates.begin(), qfCandidates.end(), SolidLess);
+				numMismatches += (bpCandidates != qfCandidates);
+			}
+		}
+
+		LOG("[ProjectileBroadphaseMatchesQuadField] area=[%.0f, %.0f]: %d candidates", area.mins, area.maxs, numCandidates);
+
+		BOOST_CHECK(numCandidates > 0);
+		BOOST_CHECK_MESSAGE(numUnordered == 0, "broadphase candidates not in (type, id) order");
+		BOOST_CHECK_MESSAGE(numMismatches == 0, "broadphase and QuadField candidate sets differ");
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( ProjectileBroadphaseCost )
+{
+	srand(5678);
+
+	float3::maxxpos = MAP_SIZE - 1.0f;
+	float3::maxzpos = MAP_SIZE - 1.0f;
+
+	// from a mid-game skirmish to a late-game 8v8; the QuadField-query side only
+	// models GetUnitsAndFeaturesColVol (no CUnit dereferences), so it is a lower
+	// bound on what the engine pays for it
+	static constexpr int NUM_SOLIDS[] = {1000, 5000};
+	static constexpr int NUM_PROJECTILES[] = {2000, 10000};
+	static constexpr int NUM_FRAMES = 10;
+
+	for (const TestArea& area: {MAP_AREA, BATTLE_AREA}) {
+		for (const int numSolids: NUM_SOLIDS) {
+			for (const int numProjectiles: NUM_PROJECTILES) {
+				TestWorld world;
+				world.Init(numSolids, area);
+				world.UpdateBroadphase();
+				world.UpdateQuadField();
+
+				std::vector<const TestSolid*> candidates;
+
+				float bpTime = 0.0f;
+				float qfTime = 0.0f;
+				size_t numPairs = 0;
+
+				for (int frame = 0; frame < NUM_FRAMES; frame++) {
+					world.Step(8.0f, 0.001f, 0.001f, numSolids / 500);
+
+					const std::vector<TestProjectile> projectiles = RandomProjectiles(numProjectiles, area);
+
+					{
+						const auto t0 = std::chrono::high_resolution_clock::now();
+
+						world.UpdateBroadphase();
+						world.SweepProjectiles(projectiles);
+
+						for (size_t i = 0; i < projectiles.size(); i++) {
+							candidates.clear();
+							world.GetBroadphaseCandidates(projectiles[i], i, candidates);
+						}
+
+						const auto t1 = std::chrono::high_resolution_clock::now();
+
+						bpTime += (std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-6f);
+						numPairs += world.GetBroadphase().GetNumCandidatePairs();
+					}
+
+					// QuadField links are maintained by the solids themselves, not part of the query cost
+					world.UpdateQuadField();
+
+					{
+						const auto t0 = std::chrono::high_resolution_clock::now();
+
+						for (size_t i = 0; i < projectiles.size(); i++) {
+							candidates.clear();
+							world.GetQuadFieldCandidates(projectiles[i], candidates);
+						}
+
+						const auto t1 = std::chrono::high_resolution_clock::now();
+
+						qfTime += (std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-6f);
+					}
+				}
+
+				LOG("[ProjectileBroadphaseCost] area=[%.0f, %.0f] solids=%5d projectiles=%5d: sweep=%7.3fms quadfield=%7.3fms per frame (%.2fx, %zu pairs per frame)",
+					area.mins, area.maxs, numSolids, numProjectiles, bpTime / NUM_FRAMES, qfTime / NUM_FRAMES, qfTime / std::max(bpTime, 0.001f), numPairs / NUM_FRAMES);
+			}
+		}
+	}
+}
@@ -0,0 +1,192 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/UnitHotState.h"
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE UnitHotState
+#include <boost/test/unit_test.hpp>
+
+
+static constexpr unsigned short TEST_LOS_INLOS = (1 << 0);
+static constexpr unsigned short TEST_LOS_MASKED = (1 << 8);
+
+
+// stand-in for CUnit with the fields CUnitHotState mirrors
+struct TestUnit {
+	int id = 0;
+
+	float3 pos;
+	float4 speed;
+
+	short heading = 0;
+	int allyteam = 0;
+	float health = 0.0f;
+	unsigned int physicalState = 0;
+
+	bool isCloaked = false;
+	bool alwaysVisible = false;
+	bool useAirLos = false;
+	bool stealth = false;
+	bool sonarStealth = false;
+	bool beingBuilt = false;
+
+	std::vector<unsigned short> losStatus;
+};
+
+
+static void CheckMirror(const CUnitHotState& hotState, const TestUnit& unit)
+{
+	BOOST_CHECK(hotState.GetPos(unit.id) == unit.pos);
+	BOOST_CHECK(hotState.GetSpeed(unit.id) == unit.speed);
+	BOOST_CHECK(hotState.GetSpeed(unit.id).w == unit.speed.w);
+	BOOST_CHECK(hotState.GetHeading(unit.id) == unit.heading);
+	BOOST_CHECK(hotState.GetAllyTeam(unit.id) == unit.allyteam);
+	BOOST_CHECK(hotState.GetHealth(unit.id) == unit.health);
+	BOOST_CHECK(hotState.GetPhysicalState(unit.id) == unit.physicalState);
+	BOOST_CHECK(hotState.GetLosFlags(unit.id) == CUnitHotState::GetLosFlags(&unit));
+
+	for (unsigned int at = 0; at < unit.losStatus.size(); ++at) {
+		BOOST_CHECK(hotState.GetLosStatus(unit.id, at) == unit.losStatus[at]);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( UnitHotStateLosRows )
+{
+	CUnitHotState hotState;
+	hotState.Init(8, 2);
+
+	hotState.SetLosStatus(3, 0, TEST_LOS_INLOS);
+	hotState.SetLosStatus(3, 1, TEST_LOS_MASKED);
+
+	BOOST_CHECK(hotState.GetLosStatus(3, 0) == TEST_LOS_INLOS);
+	BOOST_CHECK(hotState.GetLosStatusRow(0)[3] == TEST_LOS_INLOS);
+	BOOST_CHECK(hotState.GetLosStatusRow(1)[3] == TEST_LOS_MASKED);
+
+	// neighbours are untouched
+	BOOST_CHECK(hotState.GetLosStatus(2, 0) == 0);
+	BOOST_CHECK(hotState.GetLosStatus(4, 1) == 0);
+	BOOST_CHECK(hotState.GetLosStatusRow(1)[7] == 0);
+
+	hotState.Clear(3);
+
+	BOOST_CHECK(hotState.GetLosStatus(3, 0) == 0);
+	BOOST_CHECK(hotState.GetLosStatus(3, 1) == 0);
+
+	// re-initialization wipes all rows
+	hotState.SetLosStatus(7, 1, TEST_LOS_INLOS);
+	hotState.Init(8, 2);
+
+	BOOST_CHECK(hotState.GetLosStatus(7, 1) == 0);
+}
+
+
+BOOST_AUTO_TEST_CASE( UnitHotStateActiveIDs )
+{
+	CUnitHotState hotState;
+	hotState.Init(8, 1);
+
+	hotState.InsertActiveID(0, 5);
+	hotState.InsertActiveID(1, 7);
+	hotState.InsertActiveID(1, 6);
+	BOOST_CHECK((hotState.GetActiveIDs() == std::vector<int>{5, 6, 7}));
+
+	hotState.EraseActiveID(0);
+	BOOST_CHECK((hotState.GetActiveIDs() == std::vector<int>{6, 7}));
+
+	hotState.ClearActiveIDs();
+	BOOST_CHECK(hotState.GetActiveIDs().empty());
+}
+
+
+BOOST_AUTO_TEST_CASE( UnitHotStateMirrorsUnits )
+{
+	constexpr unsigned int NUM_UNITS = 64;
+	constexpr unsigned int NUM_ALLYTEAMS = 3;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> coor(-1000.0f, 1000.0f);
+	std::uniform_int_distribution<int> bits(0, 0xFFFF);
+
+	std::vector<TestUnit> units(NUM_UNITS);
+
+	CUnitHotState hotState;
+	hotState.Init(NUM_UNITS * 2, NUM_ALLYTEAMS);
+
+	// same bookkeeping as CUnitHandler::InsertActiveUnit
+	for (unsigned int i = 0; i < NUM_UNITS; ++i) {
+		TestUnit& unit = units[i];
+
+		unit.id = i * 2 + 1;
+		unit.pos = float3(coor(rng), coor(rng), coor(rng));
+		unit.allyteam = i % NUM_ALLYTEAMS;
+		unit.health = 100.0f;
+		unit.losStatus.resize(NUM_ALLYTEAMS, 0);
+
+		hotState.InsertActiveID(i, unit.id);
+		hotState.Store(&unit);
+		hotState.StoreLosStatus(&unit);
+	}
+
+	for (const TestUnit& unit: units) {
+		CheckMirror(hotState, unit);
+	}
+
+	// simulate a few frames of movement, damage, state- and team-changes,
+	// each followed by the refresh CUnitHandler::StoreHotState does
+	for (int frame = 0; frame < 16; ++frame) {
+		for (TestUnit& unit: units) {
+			const int r = bits(rng);
+
+			unit.speed = float4(float3(coor(rng), coor(rng), coor(rng)) * 0.01f, 0.0f);
+			unit.speed.w = unit.speed.Length();
+			unit.pos += unit.speed;
+			unit.heading += r;
+			unit.health -= (r & 7);
+			unit.physicalState = r & 0xFF;
+			unit.isCloaked = (r & (1 << 8)) != 0;
+			unit.alwaysVisible = (r & (1 << 9)) != 0;
+			unit.useAirLos = (r & (1 << 10)) != 0;
+			unit.stealth = (r & (1 << 11)) != 0;
+			unit.sonarStealth = (r & (1 << 12)) != 0;
+			unit.beingBuilt = (r & (1 << 13)) != 0;
+
+			if ((r & (1 << 14)) != 0)
+				unit.allyteam = (unit.allyteam + 1) % NUM_ALLYTEAMS;
+
+			// LOS-status writes go through CUnit::SetLosStatus, which updates both
+			for (unsigned int at = 0; at < NUM_ALLYTEAMS; ++at) {
+				unit.losStatus[at] = bits(rng);
+				hotState.SetLosStatus(unit.id, at, unit.losStatus[at]);
+			}
+		}
+
+		for (const TestUnit& unit: units) {
+			hotState.Store(&unit);
+		}
+
+		for (const TestUnit& unit: units) {
+			CheckMirror(hotState, unit);
+		}
+	}
+
+	// entries of IDs not in use stay cleared
+	for (unsigned int id = 0; id < NUM_UNITS * 2; id += 2) {
+		BOOST_CHECK(hotState.GetAllyTeam(id) == -1);
+		BOOST_CHECK(hotState.GetPos(id) == ZeroVector);
+		BOOST_CHECK(hotState.GetLosFlags(id) == 0);
+	}
+
+	// deleting a unit clears all of its entries (CUnitHandler::DeleteUnit)
+	hotState.EraseActiveID(0);
+	hotState.Clear(units[0].id);
+
+	BOOST_CHECK(hotState.GetActiveIDs().size() == (NUM_UNITS - 1));
+	BOOST_CHECK(hotState.GetAllyTeam(units[0].id) == -1);
+	BOOST_CHECK(hotState.GetHealth(units[0].id) == 0.0f);
+	BOOST_CHECK(hotState.GetLosStatus(units[0].id, 1) == 0);
+
+	CheckMirror(hotState, units[1]);
+}
@@ -1,10 +1,16 @@
 
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/Net/UDPConnection.h"
 #include "System/Net/UDPListener.h"
 #include "System/Log/ILog.h"
 
+#include <chrono>
+#include <cstring>
+#include <thread>
 
 #define BOOST_TEST_MODULE UDPListener
 #include <boost/test/unit_test.hpp>
+BOOST_GLOBAL_FIXTURE(InitSpringTime);
 
 class SocketTest {
 public:
@@ -87,3 +93,64 @@ BOOST_AUTO_TEST_CASE(TryBindSocket)
 	t.TestPort(-1, false);
 }
 
+
+BOOST_AUTO_TEST_CASE(LoopbackTransfer)
+{
+	// enough messages for several multi-chunk datagrams per update, some of
+	// them split across chunks; kept below the default outgoing bandwidth cap
+	static constexpr int NUM_MESSAGES = 1000;
+
+	netcode::UDPListener listener(11112, "127.0.0.1");
+	listener.SetAcceptingConnections(true);
+
+	std::shared_ptr<netcode::UDPConnection> client(new netcode::UDPConnection(0, "127.0.0.1", 11112));
+	std::shared_ptr<netcode::UDPConnection> server;
+	client->Unmute();
+
+	for (int n = 0; n < NUM_MESSAGES; n++) {
+		if ((n % 10) == 0) {
+			client->SendData(CBaseNetProtocol::Get().SendLuaMsg(0, 0, 0, std::vector<std::uint8_t>(300 + n % 200, std::uint8_t(n))));
+		} else {
+			client->SendData(CBaseNetProtocol::Get().SendKeyFrame(n));
+		}
+	}
+
+	int numReceived = 0;
+	bool inOrder = true;
+
+	for (int i = 0; i < 5000 && numReceived < NUM_MESSAGES; i++) {
+		client->Update();
+		client->Flush(true);
+		listener.Update();
+
+		while (client->GetData() != nullptr);
+
+		if (server == nullptr && listener.HasIncomingConnections()) {
+			server = listener.AcceptConnection();
+			server->Unmute();
+			// the client's later packets are only accepted once it acks something
+			server->SendData(CBaseNetProtocol::Get().SendKeyFrame(0));
+		}
+
+		if (server == nullptr)
+			continue;
+
+		for (std::shared_ptr<const netcode::RawPacket> msg; (msg = server->GetData()) != nullptr; numReceived++) {
+			if ((numReceived % 10) == 0) {
+				inOrder &= (msg->data[0] == NETMSG_LUAMSG && msg->length == (7 + 300 + numReceived % 200) && msg->data[msg->length - 1] == std::uint8_t(numReceived));
+			} else {
+				std::int32_t frameNum = -1;
+				std::memcpy(&frameNum, msg->data + 1, sizeof(frameNum));
+				inOrder &= (msg->data[0] == NETMSG_KEYFRAME && frameNum == numReceived);
+			}
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	LOG("\n%s", client->Statistics().c_str());
+
+	BOOST_CHECK(server != nullptr);
+	BOOST_CHECK(numReceived == NUM_MESSAGES);
+	BOOST_CHECK(inOrder);
+}
@@ -0,0 +1,204 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/Net/PacketPool.h"
+#include "System/Net/RawPacket.h"
+#include "System/Log/ILog.h"
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE PacketPool
+#include <boost/test/unit_test.hpp>
+
+
+static constexpr int NUM_PARTICIPANTS = 32;
+static constexpr int NUM_FRAMES = 30 * 60;
+static constexpr int NUM_COMMANDS_PER_FRAME = 200;
+
+
+// packet as every Send* builder made it before pooling: object, data and
+// shared_ptr control block are three separate heap allocations
+struct HeapPacket {
+	HeapPacket(const uint8_t* d, uint32_t l): data(new uint8_t[l]), length(l) { std::memcpy(data, d, l); }
+	~HeapPacket() { delete[] data; }
+
+	uint8_t* data;
+	uint32_t length;
+};
+
+
+// the parts of CGameServer::Broadcast that touch packets: every participant
+// queues a reference (as CConnection::SendData does) and the demo recorder
+// copies the bytes; queues are drained once per frame, as on Flush
+template<typename P> struct Broadcaster {
+	void Broadcast(std::shared_ptr<const P> packet) {
+		for (auto& q: queues) {
+			q.push_back(packet);
+		}
+
+		demoBuffer.insert(demoBuffer.end(), packet->data, packet->data + packet->length);
+		numMessages += 1;
+	}
+
+	void Flush() {
+		for (auto& q: queues) {
+			numQueued += q.size();
+			q.clear();
+		}
+
+		demoBuffer.clear();
+	}
+
+	std::deque< std::shared_ptr<const P> > queues[NUM_PARTICIPANTS];
+	std::vector<uint8_t> demoBuffer;
+
+	uint64_t numMessages = 0;
+	uint64_t numQueued = 0;
+};
+
+
+BOOST_AUTO_TEST_CASE( PacketPoolReuse )
+{
+	const netcode::PacketPool::Stats s0 = netcode::PacketPool::GetStats();
+
+	std::vector<void*> blocks;
+
+	for (size_t size = 1; size <= netcode::PacketPool::MAX_BLOCK_SIZE * 2; size += 7) {
+		blocks.push_back(netcode::PacketPool::Alloc(size));
+		std::memset(blocks.back(), 0xAB, size);
+
+		// payloads have to be usable for any type
+		BOOST_CHECK((reinterpret_cast<uintptr_t>(blocks.back()) % alignof(std::max_align_t)) == 0);
+	}
+
+	BOOST_CHECK(netcode::PacketPool::GetStats().numUsedBlocks == (s0.numUsedBlocks + blocks.size()));
+
+	for (void* p: blocks) {
+		netcode::PacketPool::Free(p);
+	}
+
+	BOOST_CHECK(netcode::PacketPool::GetStats().numUsedBlocks == s0.numUsedBlocks);
+
+	// a freed block is handed out again for the next request of its class
+	void* p0 = netcode::PacketPool::Alloc(100);
+	netcode::PacketPool::Free(p0);
+	void* p1 = netcode::PacketPool::Alloc(90);
+	netcode::PacketPool::Free(p1);
+
+	BOOST_CHECK(p0 == p1);
+
+	// packet objects, their data and shared refcounts all come from the pool
+	{
+		const uint64_t numUsed = netcode::PacketPool::GetStats().numUsedBlocks;
+		const std::shared_ptr<const netcode::RawPacket> packet = CBaseNetProtocol::Get().SendKeyFrame(1234);
+
+		BOOST_CHECK(packet->length == 5);
+		BOOST_CHECK(packet->data[0] == NETMSG_KEYFRAME);
+		BOOST_CHECK(netcode::PacketPool::GetStats().numUsedBlocks == (numUsed + 2));
+	}
+
+	BOOST_CHECK(netcode::PacketPool::GetStats().numUsedBlocks == s0.numUsedBlocks);
+}
+
+
+BOOST_AUTO_TEST_CASE( PacketPoolThreads )
+{
+	// packets made by one thread and released by another, as with the
+	// server and client ends of a LocalConnection
+	const uint64_t numUsed = netcode::PacketPool::GetStats().numUsedBlocks;
+
+	std::deque< std::shared_ptr<const netcode::RawPacket> > queue;
+	std::mutex queueMutex;
+	std::vector<std::thread> threads;
+
+	bool checksOk = true;
+
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&, t]() {
+			for (int n = 0; n < 100000; n++) {
+				std::shared_ptr<const netcode::RawPacket> packet;
+
+				if ((t & 1) == 0) {
+					packet = CBaseNetProtocol::Get().SendKeyFrame(n);
+				} else {
+					packet = CBaseNetProtocol::Get().SendLuaMsg(0, 0, 0, std::vector<uint8_t>(n & 1023, uint8_t(n)));
+				}
+
+				std::lock_guard<std::mutex> lock(queueMutex);
+
+				if (!queue.empty()) {
+					checksOk &= (queue.front()->length > 0);
+					queue.pop_front();
+				}
+
+				queue.push_back(std::move(packet));
+			}
+		});
+	}
+
+	for (std::thread& t: threads) {
+		t.join();
+	}
+
+	queue.clear();
+
+	BOOST_CHECK(checksOk);
+	BOOST_CHECK(netcode::PacketPool::GetStats().numUsedBlocks == numUsed);
+}
+
+
+BOOST_AUTO_TEST_CASE( PacketPoolBroadcastRate )
+{
+	const std::vector<float> params = {1.0f, 2.0f, 3.0f, 4.0f};
+
+	Broadcaster<netcode::RawPacket> pooled;
+	Broadcaster<HeapPacket> heaped;
+
+	// both variants copy the same bytes, only where they are allocated differs
+	const std::shared_ptr<const netcode::RawPacket> frameMsg = CBaseNetProtocol::Get().SendNewFrame();
+	const std::shared_ptr<const netcode::RawPacket> commandMsg = CBaseNetProtocol::Get().SendCommand(0, 1, 0, params);
+
+	const auto TimeBroadcasts = [&](bool pool) {
+		const auto t0 = std::chrono::high_resolution_clock::now();
+
+		for (int f = 0; f < NUM_FRAMES; f++) {
+			for (int n = 0; n <= NUM_COMMANDS_PER_FRAME; n++) {
+				const netcode::RawPacket* msg = (n < NUM_COMMANDS_PER_FRAME)? commandMsg.get(): frameMsg.get();
+
+				if (pool) {
+					pooled.Broadcast(netcode::AllocPacket<netcode::RawPacket>(msg->data, msg->length));
+				} else {
+					heaped.Broadcast(std::shared_ptr<const HeapPacket>(new HeapPacket(msg->data, msg->length)));
+				}
+			}
+
+			if (pool) {
+				pooled.Flush();
+			} else {
+				heaped.Flush();
+			}
+		}
+
+		const auto t1 = std::chrono::high_resolution_clock::now();
+		return (std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9);
+	};
+
+	const double heapTime = TimeBroadcasts(false);
+	const double poolTime = TimeBroadcasts(true);
+
+	const netcode::PacketPool::Stats stats = netcode::PacketPool::GetStats();
+
+	LOG("[PacketPoolBroadcastRate] %d participants, %d frames, %d commands per frame", NUM_PARTICIPANTS, NUM_FRAMES, NUM_COMMANDS_PER_FRAME);
+	LOG("[PacketPoolBroadcastRate] heap=%.0f msgs/sec pool=%.0f msgs/sec (%.2fx)", heaped.numMessages / heapTime, pooled.numMessages / poolTime, heapTime / poolTime);
+	LOG("[PacketPoolBroadcastRate] poolAllocs=%lu heapAllocs=%lu slabBytes=%lu", (unsigned long) stats.numPoolAllocs, (unsigned long) stats.numHeapAllocs, (unsigned long) stats.numSlabBytes);
+
+	BOOST_CHECK(pooled.numMessages == heaped.numMessages);
+	BOOST_CHECK(pooled.numQueued == heaped.numQueued);
+	BOOST_CHECK(stats.numPoolAllocs > stats.numHeapAllocs);
+}
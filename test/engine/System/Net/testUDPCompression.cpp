@@ -0,0 +1,432 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/GlobalConfig.h"
+#include "System/LoadSave/demofile.h"
+#include "System/Net/ProtocolDef.h"
+#include "System/Net/RawPacket.h"
+#include "System/Net/UDPConnection.h"
+#include "System/Net/UDPListener.h"
+#include "System/Log/ILog.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#define BOOST_TEST_MODULE UDPCompression
+#include <boost/test/unit_test.hpp>
+BOOST_GLOBAL_FIXTURE(InitSpringTime);
+
+
+typedef std::shared_ptr<const netcode::RawPacket> PacketPtr;
+typedef std::vector< std::vector<PacketPtr> > MessageStream;
+
+
+// server -> client messages of a recorded game (a .sdfz file), one entry
+// per NETMSG_NEWFRAME; messages whose length does not match what the
+// current protocol expects are left out
+static bool ReadDemoStream(const char* demoName, MessageStream& frames)
+{
+	gzFile demoFile = gzopen(demoName, "rb");
+
+	if (demoFile == nullptr)
+		return false;
+
+	DemoFileHeader fileHeader;
+	DemoStreamChunkHeader chunkHeader;
+
+	if (gzread(demoFile, &fileHeader, sizeof(fileHeader)) != sizeof(fileHeader) || std::memcmp(fileHeader.magic, DEMOFILE_MAGIC, sizeof(fileHeader.magic)) != 0) {
+		gzclose(demoFile);
+		return false;
+	}
+
+	fileHeader.swab();
+	gzseek(demoFile, fileHeader.headerSize + fileHeader.scriptSize, SEEK_SET);
+
+	std::vector<std::uint8_t> buffer;
+	frames.emplace_back();
+
+	// demoStreamSize is 0 for games that did not end cleanly, read until EOF then
+	for (int streamPos = 0; fileHeader.demoStreamSize == 0 || streamPos < fileHeader.demoStreamSize; ) {
+		if (gzread(demoFile, &chunkHeader, sizeof(chunkHeader)) != sizeof(chunkHeader))
+			break;
+
+		chunkHeader.swab();
+		buffer.resize(chunkHeader.length);
+
+		if (gzread(demoFile, buffer.data(), chunkHeader.length) != int(chunkHeader.length))
+			break;
+
+		streamPos += (sizeof(chunkHeader) + chunkHeader.length);
+
+		if (buffer.empty() || netcode::ProtocolDef::GetInstance()->PacketLength(buffer.data(), buffer.size()) != int(buffer.size()))
+			continue;
+
+		frames.back().push_back(std::make_shared<const netcode::RawPacket>(buffer.data(), buffer.size()));
+
+		if (buffer[0] == NETMSG_NEWFRAME || buffer[0] == NETMSG_KEYFRAME)
+			frames.emplace_back();
+	}
+
+	gzclose(demoFile);
+	return true;
+}
+
+// stand-in with the message mix of a small team game, used when no demo is given
+static void MakeSyntheticStream(MessageStream& frames)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(0.0f, 8192.0f);
+
+	CBaseNetProtocol& proto = CBaseNetProtocol::Get();
+
+	for (int frameNum = 0; frameNum < 30 * 60 * 2; frameNum++) {
+		frames.emplace_back();
+
+		std::vector<PacketPtr>& frame = frames.back();
+
+		for (int n = rng() % 8; n > 0; n--) {
+			const uint8_t playerNum = rng() % 8;
+
+			switch (rng() % 4) {
+				case 0: { frame.push_back(proto.SendCommand(playerNum, 10, 0, {pos(rng), 128.0f, pos(rng)})); } break;
+				case 1: { frame.push_back(proto.SendCommand(playerNum, 20, 32, {float(rng() % 4000)})); } break;
+				case 2: { frame.push_back(proto.SendSelect(playerNum, {int16_t(rng() % 4000), int16_t(rng() % 4000), int16_t(rng() % 4000)})); } break;
+				case 3: { frame.push_back(proto.SendLuaMsg(playerNum, 0, 0, std::vector<uint8_t>(16 + rng() % 64, uint8_t('a' + rng() % 4)))); } break;
+			}
+		}
+
+		if ((frameNum % 30) == 0) {
+			for (uint8_t playerNum = 0; playerNum < 8; playerNum++) {
+				frame.push_back(proto.SendPlayerInfo(playerNum, 0.1f * (rng() % 10), 30 + rng() % 50));
+			}
+		}
+
+		if ((frameNum % 16) == 0) {
+			frame.push_back(proto.SendKeyFrame(frameNum));
+		} else {
+			frame.push_back(proto.SendNewFrame());
+		}
+	}
+}
+
+
+struct ReplayResult {
+	size_t numMessages = 0;
+	size_t numBytes = 0;
+	size_t numWireBytes = 0;
+	double seconds = 0.0;
+
+	bool intact = true;
+};
+
+// sends <frames> from a server-side to a client-side connection over the
+// loopback interface, one forced flush per frame
+static ReplayResult Replay(const MessageStream& frames, int port, int compressionLevel)
+{
+	ReplayResult result;
+
+	globalConfig.networkCompressionLevel = compressionLevel;
+	globalConfig.linkOutgoingBandwidth = 0;
+
+	netcode::UDPListener listener(port, "127.0.0.1");
+	listener.SetAcceptingConnections(true);
+
+	std::shared_ptr<netcode::UDPConnection> client(new netcode::UDPConnection(0, "127.0.0.1", port));
+	std::shared_ptr<netcode::UDPConnection> server;
+
+	client->Unmute();
+	client->SendData(CBaseNetProtocol::Get().SendKeyFrame(-1));
+
+	const auto Pump = [&]() {
+		client->Update();
+		listener.Update();
+
+		if (server == nullptr && listener.HasIncomingConnections()) {
+			server = listener.AcceptConnection();
+			server->Unmute();
+		}
+	};
+
+	size_t numExpected = 0;
+	size_t frameIdx = 0;
+	size_t msgIdx = 0;
+
+	const auto Receive = [&]() {
+		for (PacketPtr msg; (msg = client->GetData()) != nullptr; ) {
+			while (frameIdx < frames.size() && msgIdx == frames[frameIdx].size()) {
+				frameIdx++;
+				msgIdx = 0;
+			}
+
+			if (frameIdx == frames.size()) {
+				result.intact = false;
+				break;
+			}
+
+			const PacketPtr& sent = frames[frameIdx][msgIdx++];
+
+			result.intact &= (msg->length == sent->length && std::memcmp(msg->data, sent->data, msg->length) == 0);
+			result.numMessages += 1;
+			result.numBytes += msg->length;
+		}
+	};
+
+	for (int i = 0; i < 1000 && server == nullptr; i++) {
+		client->Flush(true);
+		Pump();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	BOOST_REQUIRE(server != nullptr);
+
+	// the reply makes the client ack, and tells the server the client can inflate
+	server->SendData(CBaseNetProtocol::Get().SendKeyFrame(-1));
+
+	for (int i = 0; i < 100 && client->GetData() == nullptr; i++) {
+		server->Flush(true);
+		client->Flush(true);
+		Pump();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	const auto t0 = std::chrono::high_resolution_clock::now();
+
+	for (const std::vector<PacketPtr>& frame: frames) {
+		for (const PacketPtr& msg: frame) {
+			server->SendData(msg);
+		}
+
+		numExpected += frame.size();
+
+		server->Flush(true);
+		Pump();
+		Receive();
+	}
+
+	// drain, resends included
+	for (int i = 0; i < 5000 && result.numMessages < numExpected; i++) {
+		server->Flush(true);
+		client->Flush(true);
+		Pump();
+		Receive();
+
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	const auto t1 = std::chrono::high_resolution_clock::now();
+
+	result.seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() * 1e-9;
+	result.numWireBytes = client->GetDataReceived();
+	result.intact &= (result.numMessages == numExpected);
+
+	LOG("[UDPCompression] level %d, server side:\n%s", compressionLevel, server->Statistics().c_str());
+	return result;
+}
+
+
+
+BOOST_AUTO_TEST_CASE(DemoReplay)
+{
+	// point SPRING_BENCHMARK_DEMO at a recorded .sdfz to replay a real game
+	const char* demoName = std::getenv("SPRING_BENCHMARK_DEMO");
+	const int compressionLevel = (std::getenv("SPRING_BENCHMARK_LEVEL") != nullptr)? std::atoi(std::getenv("SPRING_BENCHMARK_LEVEL")): 6;
+
+	MessageStream frames;
+
+	CBaseNetProtocol::Get();
+
+	if (demoName != nullptr) {
+		BOOST_REQUIRE_MESSAGE(ReadDemoStream(demoName, frames), demoName);
+		LOG("[UDPCompression] replaying demo %s", demoName);
+	} else {
+		MakeSyntheticStream(frames);
+		LOG("[UDPCompression] replaying synthetic message stream");
+	}
+
+	const ReplayResult raw = Replay(frames, 11113, 0);
+	const ReplayResult packed = Replay(frames, 11114, compressionLevel);
+
+	LOG("[UDPCompression] %u frames, %u messages, %u bytes", unsigned(frames.size()), unsigned(raw.numMessages), unsigned(raw.numBytes));
+	LOG("[UDPCompression] uncompressed: %u bytes on the wire, %.0f msgs/sec", unsigned(raw.numWireBytes), raw.numMessages / raw.seconds);
+	LOG("[UDPCompression] level %d: %u bytes on the wire (%.3fx), %.0f msgs/sec", compressionLevel, unsigned(packed.numWireBytes), packed.numWireBytes * 1.0 / raw.numWireBytes, packed.numMessages / packed.seconds);
+
+	BOOST_CHECK(raw.intact);
+	BOOST_CHECK(packed.intact);
+	BOOST_CHECK(packed.numMessages == raw.numMessages);
+
+	// the command stream has to shrink noticeably, resends aside
+	if (demoName == nullptr)
+		BOOST_CHECK(packed.numWireBytes < (raw.numWireBytes * 3) / 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(OneSidedCompression)
+{
+	// only the client wants compression, so neither side may use it
+	MessageStream frames;
+	MakeSyntheticStream(frames);
+	frames.resize(300);
+
+	globalConfig.networkCompressionLevel = 6;
+
+	netcode::UDPListener listener(11115, "127.0.0.1");
+	listener.SetAcceptingConnections(true);
+
+	std::shared_ptr<netcode::UDPConnection> client(new netcode::UDPConnection(0, "127.0.0.1", 11115));
+	std::shared_ptr<netcode::UDPConnection> server;
+
+	client->Unmute();
+	client->SendData(CBaseNetProtocol::Get().SendKeyFrame(-1));
+
+	// connections accepted by the listener pick up the setting when created
+	globalConfig.networkCompressionLevel = 0;
+
+	size_t numSent = 0;
+	size_t numReceived = 0;
+
+	for (int i = 0; i < 5000 && (server == nullptr || numReceived < numSent); i++) {
+		client->Flush(true);
+		client->Update();
+		listener.Update();
+
+		if (server == nullptr && listener.HasIncomingConnections()) {
+			server = listener.AcceptConnection();
+			server->Unmute();
+
+			for (const std::vector<PacketPtr>& frame: frames) {
+				for (const PacketPtr& msg: frame) {
+					server->SendData(msg);
+					numSent += 1;
+				}
+			}
+		}
+
+		while (client->GetData() != nullptr) {
+			numReceived += 1;
+		}
+
+		if (server != nullptr)
+			server->Flush(true);
+
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	BOOST_REQUIRE(server != nullptr);
+	BOOST_CHECK(numReceived == numSent);
+	BOOST_CHECK(server->Statistics().find("{1.000x, 1.000x} compression ratio") != std::string::npos);
+	BOOST_CHECK(client->Statistics().find("{1.000x, 1.000x} compression ratio") != std::string::npos);
+}
+
+
+BOOST_AUTO_TEST_CASE(CorruptCompressionStream)
+{
+	// nothing after a chunk that fails to inflate can be read, the link has to go down
+	MessageStream frames;
+	MakeSyntheticStream(frames);
+	frames.resize(30);
+
+	globalConfig.networkCompressionLevel = 6;
+	globalConfig.reconnectTimeout = 0;
+
+	netcode::UDPListener listener(11116, "127.0.0.1");
+	listener.SetAcceptingConnections(true);
+
+	std::shared_ptr<netcode::UDPConnection> client(new netcode::UDPConnection(0, "127.0.0.1", 11116));
+	std::shared_ptr<netcode::UDPConnection> server;
+
+	client->Unmute();
+	client->SendData(CBaseNetProtocol::Get().SendKeyFrame(-1));
+
+	size_t numSent = 0;
+	size_t numReceived = 0;
+
+	const auto Pump = [&]() {
+		client->Flush(true);
+		client->Update();
+		listener.Update();
+
+		if (server != nullptr)
+			server->Flush(true);
+
+		while (client->GetData() != nullptr) {
+			numReceived += 1;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	};
+
+	for (int i = 0; i < 5000 && (server == nullptr || numReceived < numSent); i++) {
+		if (server == nullptr && listener.HasIncomingConnections()) {
+			server = listener.AcceptConnection();
+			server->Unmute();
+
+			for (const std::vector<PacketPtr>& frame: frames) {
+				for (const PacketPtr& msg: frame) {
+					server->SendData(msg);
+					numSent += 1;
+				}
+			}
+		}
+
+		Pump();
+	}
+
+	BOOST_REQUIRE(server != nullptr);
+
+	// the server only starts compressing once it has seen the client's offer
+	for (int i = 0; i < 5000 && client->Statistics().find(", 1.000x} compression ratio") != std::string::npos; i++) {
+		server->SendData(frames[i % frames.size()].back());
+		numSent += 1;
+
+		Pump();
+	}
+	for (int i = 0; i < 5000 && numReceived < numSent; i++) {
+		Pump();
+	}
+
+	BOOST_REQUIRE(numReceived == numSent);
+	BOOST_REQUIRE(client->Statistics().find(", 1.000x} compression ratio") == std::string::npos);
+	BOOST_CHECK(!client->CheckTimeout(0));
+
+	// garbage in place of the next chunks; all-zero bits end the current block
+	// and start a stored one whose lengths do not match, wherever they land
+	const std::vector<std::uint8_t> garbage(32, 0);
+	netcode::Packet packet(0, 0);
+
+	for (int n = 0; n < 4096; n++) {
+		netcode::ChunkPtr chunk(new netcode::Chunk());
+
+		chunk->chunkNumber = n;
+		chunk->chunkSize = garbage.size();
+		chunk->buffer = std::make_shared<const netcode::RawPacket>(garbage.data(), garbage.size());
+		chunk->offset = 0;
+
+		packet.chunks.push_back(chunk);
+	}
+
+	packet.checksum = packet.GetChecksum();
+	client->ProcessRawPacket(packet);
+
+	// without reconnects the client gives up right away
+	BOOST_CHECK(client->CheckTimeout(0));
+
+	for (const std::vector<PacketPtr>& frame: frames) {
+		for (const PacketPtr& msg: frame) {
+			server->SendData(msg);
+			numSent += 1;
+		}
+	}
+
+	for (int i = 0; i < 500; i++) {
+		Pump();
+	}
+
+	BOOST_CHECK(numReceived < numSent);
+	BOOST_CHECK(client->CheckTimeout(0));
+}
@@ -0,0 +1,53 @@
+function widget:GetInfo()
+return {
+	name    = "SyncState-Widget",
+	desc    = "Logs a per-frame digest of unit state so demo replays can be compared",
+	author  = "spring",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+local period = 30 -- log every second (ingame time)
+local maxframes = Spring.GetConfigInt("SyncStateMaxFrames", 9000) -- stop after 5 minutes (ingame time)
+local maxspeed = Spring.GetConfigInt("SyncStateMaxSpeed", 1000)
+
+local GetAllUnits = Spring.GetAllUnits
+local GetUnitPosition = Spring.GetUnitPosition
+local GetUnitVelocity = Spring.GetUnitVelocity
+local GetUnitHeading = Spring.GetUnitHeading
+
+function widget:Initialize()
+	Spring.SendCommands("setmaxspeed " .. maxspeed, "setminspeed " .. maxspeed)
+end
+
+function widget:GameFrame(n)
+	if (n % period) ~= 0 then
+		return
+	end
+
+	-- order of GetAllUnits is deterministic, so is the summation
+	local units = GetAllUnits()
+	local digest = 0
+
+	for i = 1, #units do
+		local unitID = units[i]
+		local px, py, pz = GetUnitPosition(unitID)
+		local vx, vy, vz = GetUnitVelocity(unitID)
+		local h = GetUnitHeading(unitID)
+
+		digest = digest + unitID * (px + 3 * py + 7 * pz + 11 * vx + 13 * vy + 17 * vz + 19 * h)
+	end
+
+	Spring.Echo(string.format("[syncstate] frame=%d units=%d digest=%.17g", n, #units, digest))
+
+	if n >= maxframes then
+		Spring.SendCommands("quitforce")
+	end
+end
+
+function widget:GameOver()
+	Spring.SendCommands("quitforce")
+end
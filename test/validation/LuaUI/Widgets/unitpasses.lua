@@ -0,0 +1,115 @@
+function widget:GetInfo()
+return {
+	name    = "UnitPasses-Widget",
+	desc    = "Grows the unit count to 1k/5k/10k and logs the per-frame cost of the CUnitHandler passes",
+	author  = "spring",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+local unitDefName = Spring.GetConfigString("UnitPassesUnitDef", "armpw")
+local stages = {1000, 5000, 10000}
+local settleFrames = 150 -- let units spread out and start patrolling
+local measureFrames = 300
+local batchSize = 250 -- units per /give, so they do not all spawn in one blob
+
+-- SCOPED_TIMER names used by CUnitHandler::Update
+local passes = {
+	"Sim::Unit::MoveType",
+	"Sim::Unit::UpdateLosStatus",
+	"Sim::Unit::SlowUpdate",
+	"Sim::Unit::Update",
+	"Sim::Unit::Weapon",
+}
+
+local GetAllUnits = Spring.GetAllUnits
+local GetProfilerTimeRecord = Spring.GetProfilerTimeRecord
+
+local stage = 0
+local stageFrame = 0
+local measuring = false
+local startTimes = {}
+
+local function SpawnUnits(numUnits)
+	-- each team gets half, in a grid of batches around its quarter of the map
+	for team = 0, 1 do
+		local cx = Game.mapSizeX * (0.25 + 0.5 * team)
+		local cz = Game.mapSizeZ * 0.5
+		local numBatches = math.ceil(numUnits / (2 * batchSize))
+		local side = math.ceil(math.sqrt(numBatches))
+
+		for b = 0, numBatches - 1 do
+			local x = cx + ((b % side) - side * 0.5) * (Game.mapSizeX * 0.4 / side)
+			local z = cz + (math.floor(b / side) - side * 0.5) * (Game.mapSizeZ * 0.8 / side)
+			local n = math.min(batchSize, math.ceil(numUnits / 2) - b * batchSize)
+
+			Spring.SendCommands(string.format("give %d %s %d @%d,0,%d", n, unitDefName, team, x, z))
+		end
+	end
+end
+
+local function PatrolUnits()
+	-- keep the MoveType pass busy; only own units can be ordered
+	local units = Spring.GetTeamUnits(Spring.GetMyTeamID())
+
+	for i = 1, #units do
+		local x, _, z = Spring.GetUnitPosition(units[i])
+		Spring.GiveOrderToUnit(units[i], CMD.PATROL, {x + 256, 0, z + 256}, {})
+	end
+end
+
+local function StartStage()
+	stage = stage + 1
+	stageFrame = 0
+	measuring = false
+
+	if stages[stage] == nil then
+		Spring.SendCommands("quitforce")
+		return
+	end
+
+	SpawnUnits(stages[stage] - #GetAllUnits())
+end
+
+function widget:Initialize()
+	Spring.SendCommands("cheat 1", "debug", "setmaxspeed 1000", "setminspeed 1000")
+end
+
+function widget:GameFrame(n)
+	if stage == 0 then
+		StartStage()
+		return
+	end
+
+	stageFrame = stageFrame + 1
+
+	if stageFrame == 2 then
+		PatrolUnits()
+	end
+
+	if stageFrame == settleFrames then
+		for i = 1, #passes do
+			startTimes[i] = GetProfilerTimeRecord(passes[i])
+		end
+
+		measuring = true
+	end
+
+	if measuring and stageFrame == (settleFrames + measureFrames) then
+		local numUnits = #GetAllUnits()
+
+		for i = 1, #passes do
+			local msPerFrame = (GetProfilerTimeRecord(passes[i]) - startTimes[i]) / measureFrames
+			Spring.Echo(string.format("[unitpasses] units=%d pass=%s ms/frame=%.4f", numUnits, passes[i], msPerFrame))
+		end
+
+		StartStage()
+	end
+end
+
+function widget:GameOver()
+	Spring.SendCommands("quitforce")
+end
@@ -0,0 +1,55 @@
+#!/bin/sh
+
+# replays a demo played with the default pathfinder with two engine builds,
+# each in a fresh write-dir so the path-estimators are generated from scratch
+# rather than loaded from cache; prints the PFS generation times of both and
+# fails if the resulting path checksums differ (use a large map, e.g. 32x32)
+
+set -e # abort on error
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 /path/to/old/spring-headless /path/to/new/spring-headless /path/to/demo.sdfz"
+	exit 1
+fi
+
+DEMO="$3"
+
+for SPRING in "$1" "$2";
+do
+	if [ ! -x "$SPRING" ]; then
+		echo "$SPRING isn't executable!"
+		exit 1
+	fi
+done
+
+WRITEDIR=$(mktemp -d)
+trap 'rm -rf $WRITEDIR' EXIT
+
+run=0
+
+for SPRING in "$1" "$2";
+do
+	run=$((run + 1))
+	mkdir -p $WRITEDIR/run-$run
+
+	echo "Replaying $DEMO with $SPRING"
+	set +e
+	"$SPRING" --nocolor --write-dir "$WRITEDIR/run-$run" "$DEMO" > $WRITEDIR/replay-$run.log 2>&1
+	set -e
+
+	grep -o 'finalized PFS.*' $WRITEDIR/replay-$run.log > $WRITEDIR/pfs-$run.txt || true
+
+	if [ ! -s $WRITEDIR/pfs-$run.txt ]; then
+		echo "PFS was not finalized, is the demo valid?"
+		exit 1
+	fi
+
+	cat $WRITEDIR/pfs-$run.txt
+done
+
+if [ "$(grep -o 'checksum [0-9a-f]*' $WRITEDIR/pfs-1.txt)" != "$(grep -o 'checksum [0-9a-f]*' $WRITEDIR/pfs-2.txt)" ]; then
+	echo "path-estimators generated by both builds differ"
+	exit 1
+fi
+
+exit 0
@@ -0,0 +1,49 @@
+#!/bin/sh
+
+# replays the same QTPFS demo twice in a fresh write-dir, so the first run
+# builds every node-layer from scratch (and writes snapshots of them) while
+# the second one loads those snapshots; prints the PFS load times of both
+# and fails if the resulting path checksums differ
+
+set -e # abort on error
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 /path/to/spring-headless /path/to/demo.sdfz"
+	exit 1
+fi
+
+SPRING="$1"
+DEMO="$2"
+
+if [ ! -x "$SPRING" ]; then
+	echo "Parameter 1 $SPRING isn't executable!"
+	exit 1
+fi
+
+WRITEDIR=$(mktemp -d)
+trap 'rm -rf $WRITEDIR' EXIT
+
+for run in uncached cached;
+do
+	echo "Replaying $DEMO ($run)"
+	set +e
+	"$SPRING" --nocolor --write-dir "$WRITEDIR" "$DEMO" > $WRITEDIR/replay-$run.log 2>&1
+	set -e
+
+	grep -o 'node-layers from snapshots.*' $WRITEDIR/replay-$run.log || true
+	grep -o 'finalized PFS.*' $WRITEDIR/replay-$run.log > $WRITEDIR/pfs-$run.txt || true
+
+	if [ ! -s $WRITEDIR/pfs-$run.txt ]; then
+		echo "PFS was not finalized, is the demo valid and using QTPFS?"
+		exit 1
+	fi
+
+	cat $WRITEDIR/pfs-$run.txt
+done
+
+if [ "$(grep -o 'checksum [0-9a-f]*' $WRITEDIR/pfs-uncached.txt)" != "$(grep -o 'checksum [0-9a-f]*' $WRITEDIR/pfs-cached.txt)" ]; then
+	echo "node-layers loaded from snapshots differ from those built from scratch"
+	exit 1
+fi
+
+exit 0
@@ -0,0 +1,155 @@
+#!/bin/sh
+
+# hosts the same demo twice and lets a spectator join once the host reached
+# JOINFRAME, the first time replaying the server's whole packet-cache and the
+# second time starting from a game-state snapshot (SpectatorJoinSnapshotInterval);
+# compares the unit-state digests both spectators logged after joining and
+# fails on any difference or on a desync detected by the server (needs the
+# coreutils timeout command); clients refuse to make snapshots while synced
+# Lua (LuaRules or LuaGaia) is running, so the demo's game must not have any
+
+set -e # abort on error
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 /path/to/spring-headless /path/to/demo.sdfz [JOINFRAME]"
+	exit 1
+fi
+
+SPRING="$1"
+DEMO="$2"
+JOINFRAME="${3:-1800}"
+ENDFRAME=$((JOINFRAME + 1800))
+# the host keeps running a little longer, so the spectator quits by itself
+HOSTENDFRAME=$((ENDFRAME + 300))
+PORT=8452
+MAXWAIT=600
+
+if [ ! -x "$SPRING" ]; then
+	echo "Parameter 1 $SPRING isn't executable!"
+	exit 1
+fi
+
+WIDGET=test/validation/LuaUI/Widgets/syncstate.lua
+PREPARECLIENT=test/validation/prepare-client.sh
+
+if [ ! -f $WIDGET ]; then
+	echo "$WIDGET doesn't exist, please run from the source-root directory"
+	exit 1
+fi
+
+WRITEDIR=$(mktemp -d)
+PID_HOST=
+trap 'if [ -n "$PID_HOST" ]; then kill $PID_HOST 2>/dev/null; fi; rm -rf $WRITEDIR' EXIT
+
+# last frame the syncstate widget logged in $1
+lastframe() {
+	grep -o '\[syncstate\] frame=[0-9]*' "$1" | tail -n 1 | grep -o '[0-9]*$' || echo -1
+}
+
+fail() {
+	echo "$1"
+	tail -n 30 "$2"
+	exit 1
+}
+
+for mode in replay snapshot;
+do
+	if [ $mode = replay ]; then
+		INTERVAL=0
+	else
+		# every 5 seconds (the setting is in seconds), the host uploads it without costing bandwidth
+		INTERVAL=5
+	fi
+
+	for client in host spec;
+	do
+		if [ $client = host ]; then
+			MAXFRAMES=$HOSTENDFRAME
+		else
+			MAXFRAMES=$ENDFRAME
+		fi
+
+		mkdir -p $WRITEDIR/$mode-$client/LuaUI/Widgets $WRITEDIR/$mode-$client/LuaUI/Config
+		cp $WIDGET $WRITEDIR/$mode-$client/LuaUI/Widgets/syncstate.lua
+		cp test/validation/LuaUI/Config/BA.lua $WRITEDIR/$mode-$client/LuaUI/Config/BA.lua
+		(
+			echo "AllowSpectatorJoin = 1"
+			echo "SpectatorJoinSnapshotInterval = $INTERVAL"
+			echo "LinkIncomingMaxPacketRate = 0"
+			echo "SyncStateMaxSpeed = 1"
+			echo "SyncStateMaxFrames = $MAXFRAMES"
+		) > $WRITEDIR/$mode-$client.cfg
+	done
+
+	echo "Hosting $DEMO ($mode join)"
+	"$SPRING" --nocolor --write-dir "$WRITEDIR/$mode-host" --config "$WRITEDIR/$mode-host.cfg" "$DEMO" > $WRITEDIR/$mode-host.log 2>&1 &
+	PID_HOST=$!
+
+	i=0
+	while [ $(lastframe $WRITEDIR/$mode-host.log) -lt $JOINFRAME ];
+	do
+		if ! kill -0 $PID_HOST 2>/dev/null; then
+			PID_HOST=
+			fail "host exited before reaching frame $JOINFRAME, is the demo long enough?" $WRITEDIR/$mode-host.log
+		fi
+		if [ $i -ge $MAXWAIT ]; then
+			fail "host did not reach frame $JOINFRAME within $MAXWAIT seconds" $WRITEDIR/$mode-host.log
+		fi
+		i=$((i + 1))
+		sleep 1
+	done
+
+	sh $PREPARECLIENT SpecJoinTest 127.0.0.1 $PORT > $WRITEDIR/$mode-connect.txt
+
+	echo "Joining as spectator at frame $(lastframe $WRITEDIR/$mode-host.log)"
+	set +e
+	timeout $MAXWAIT "$SPRING" --nocolor --write-dir "$WRITEDIR/$mode-spec" --config "$WRITEDIR/$mode-spec.cfg" $WRITEDIR/$mode-connect.txt > $WRITEDIR/$mode-spec.log 2>&1
+	timeout $MAXWAIT sh -c "while kill -0 $PID_HOST 2>/dev/null; do sleep 1; done"
+	kill $PID_HOST 2>/dev/null
+	wait $PID_HOST
+	PID_HOST=
+	set -e
+
+	grep -o 'Joining from snapshot.*' $WRITEDIR/$mode-host.log || true
+	grep -o '\[syncstate\].*' $WRITEDIR/$mode-spec.log > $WRITEDIR/digest-$mode.txt || true
+
+	if [ $(lastframe $WRITEDIR/$mode-spec.log) -lt $ENDFRAME ]; then
+		fail "spectator did not reach frame $ENDFRAME after a $mode join" $WRITEDIR/$mode-spec.log
+	fi
+
+	if grep -q -i 'sync error' $WRITEDIR/$mode-host.log; then
+		grep -i 'sync error' $WRITEDIR/$mode-host.log
+		echo "spectator desynced after a $mode join"
+		exit 1
+	fi
+done
+
+if grep -q 'can not make game-state snapshots' $WRITEDIR/snapshot-host.log; then
+	echo "the host refused to make snapshots, the demo's game runs synced Lua"
+	exit 1
+fi
+
+if ! grep -q 'Joining from snapshot' $WRITEDIR/snapshot-host.log; then
+	echo "spectator did not join from a snapshot, is the engine built with creg?"
+	exit 1
+fi
+
+# only compare frames both spectators logged, the snapshot joiner did not
+# simulate those before its snapshot and either one may be cut off earlier
+SNAPSHOTFRAME=$(grep -o 'Joining from snapshot of frame [0-9]*' $WRITEDIR/snapshot-host.log | grep -o '[0-9]*$')
+
+awk 'NR == FNR { seen[$2]; next } ($2 in seen)' $WRITEDIR/digest-snapshot.txt $WRITEDIR/digest-replay.txt > $WRITEDIR/common-replay.txt
+awk 'NR == FNR { seen[$2]; next } ($2 in seen)' $WRITEDIR/digest-replay.txt $WRITEDIR/digest-snapshot.txt > $WRITEDIR/common-snapshot.txt
+
+if [ ! -s $WRITEDIR/common-snapshot.txt ]; then
+	echo "no digests were logged after joining, is the demo valid?"
+	exit 1
+fi
+
+if ! diff -u $WRITEDIR/common-replay.txt $WRITEDIR/common-snapshot.txt; then
+	echo "unit state of the snapshot joiner diverged from that of the replay joiner"
+	exit 1
+fi
+
+echo "$(wc -l < $WRITEDIR/common-snapshot.txt) digests equal for replay and snapshot joins (snapshot of frame $SNAPSHOTFRAME)"
+exit 0
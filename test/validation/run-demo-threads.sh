@@ -0,0 +1,73 @@
+#!/bin/sh
+
+# replays the same demo once with a single ThreadPool worker and once with
+# NUMTHREADS workers, then compares the unit-state digests logged by the
+# syncstate widget; any difference means a multi-threaded sim phase is not
+# deterministic with respect to the thread count
+#
+# modrules are part of the game archive and can not be overridden for a
+# replay, so the demo has to be of a game that sets the modrule
+# system.parallelMoveTypeUpdates; the script fails if the log shows it off
+
+set -e # abort on error
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 /path/to/spring-headless /path/to/demo.sdfz [NUMTHREADS]"
+	exit 1
+fi
+
+SPRING="$1"
+DEMO="$2"
+NUMTHREADS="${3:-8}"
+
+if [ ! -x "$SPRING" ]; then
+	echo "Parameter 1 $SPRING isn't executable!"
+	exit 1
+fi
+
+WIDGET=test/validation/LuaUI/Widgets/syncstate.lua
+
+if [ ! -f $WIDGET ]; then
+	echo "$WIDGET doesn't exist, please run from the source-root directory"
+	exit 1
+fi
+
+WRITEDIR=$(mktemp -d)
+trap 'rm -rf $WRITEDIR' EXIT
+
+mkdir -p $WRITEDIR/LuaUI/Widgets $WRITEDIR/LuaUI/Config
+cp $WIDGET $WRITEDIR/LuaUI/Widgets/syncstate.lua
+cp test/validation/LuaUI/Config/BA.lua $WRITEDIR/LuaUI/Config/BA.lua
+
+for n in 1 $NUMTHREADS;
+do
+	(
+		echo "WorkerThreadCount = $n"
+		echo "LinkIncomingMaxPacketRate = 0"
+	) > $WRITEDIR/springsettings-$n.cfg
+
+	echo "Replaying $DEMO with WorkerThreadCount=$n"
+	set +e
+	"$SPRING" --nocolor --write-dir "$WRITEDIR" --config "$WRITEDIR/springsettings-$n.cfg" "$DEMO" > $WRITEDIR/replay-$n.log 2>&1
+	set -e
+
+	if ! grep -q 'parallelMoveTypeUpdates=1' $WRITEDIR/replay-$n.log; then
+		echo "modrule system.parallelMoveTypeUpdates is not enabled by the game of $DEMO, nothing runs in parallel"
+		exit 1
+	fi
+
+	grep -o '\[syncstate\].*' $WRITEDIR/replay-$n.log > $WRITEDIR/digest-$n.txt || true
+done
+
+if [ ! -s $WRITEDIR/digest-1.txt ]; then
+	echo "no digests were logged, is the demo valid?"
+	exit 1
+fi
+
+if ! diff -u $WRITEDIR/digest-1.txt $WRITEDIR/digest-$NUMTHREADS.txt; then
+	echo "unit state diverged between 1 and $NUMTHREADS worker threads"
+	exit 1
+fi
+
+echo "$(wc -l < $WRITEDIR/digest-1.txt) digests equal for 1 and $NUMTHREADS worker threads"
+exit 0
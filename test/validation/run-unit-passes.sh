@@ -0,0 +1,101 @@
+#!/bin/sh
+
+# starts a local two-team game, grows it to 1k, 5k and 10k units with the
+# unitpasses widget and prints the per-frame cost of each CUnitHandler pass
+# as measured by the engine's own profiler; run once per build to compare
+
+set -e # abort on error
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 /path/to/spring-headless Game Map [UnitDef]"
+	exit 1
+fi
+
+SPRING="$1"
+GAME="$2"
+MAP="$3"
+UNITDEF="${4:-armpw}"
+
+if [ ! -x "$SPRING" ]; then
+	echo "Parameter 1 $SPRING isn't executable!"
+	exit 1
+fi
+
+WIDGET=test/validation/LuaUI/Widgets/unitpasses.lua
+
+if [ ! -f $WIDGET ]; then
+	echo "$WIDGET doesn't exist, please run from the source-root directory"
+	exit 1
+fi
+
+WRITEDIR=$(mktemp -d)
+trap 'rm -rf $WRITEDIR' EXIT
+
+mkdir -p $WRITEDIR/LuaUI/Widgets
+cp $WIDGET $WRITEDIR/LuaUI/Widgets/unitpasses.lua
+
+(
+	echo "UnitPassesUnitDef = $UNITDEF"
+) > $WRITEDIR/springsettings.cfg
+
+cat > $WRITEDIR/script.txt <<EOD
+[GAME]
+{
+	IsHost=1;
+	MyPlayerName=UnitPasses;
+
+	Mapname=$MAP;
+	GameType=$GAME;
+
+	StartPosType=0;
+	[modoptions]
+	{
+		maxunits=10000;
+		deathmode=neverend;
+	}
+	[PLAYER0]
+	{
+		Name=UnitPasses;
+		Spectator=0;
+		Team=0;
+	}
+	[AI0]
+	{
+		Name=Bot;
+		ShortName=NullAI;
+		Version=0.1;
+		Team=1;
+		Host=0;
+	}
+	[TEAM0]
+	{
+		TeamLeader=0;
+		AllyTeam=0;
+	}
+	[TEAM1]
+	{
+		TeamLeader=0;
+		AllyTeam=1;
+	}
+	[ALLYTEAM0]
+	{
+		NumAllies=0;
+	}
+	[ALLYTEAM1]
+	{
+		NumAllies=0;
+	}
+}
+EOD
+
+set +e
+"$SPRING" --nocolor --write-dir "$WRITEDIR" --config "$WRITEDIR/springsettings.cfg" "$WRITEDIR/script.txt" > $WRITEDIR/unitpasses.log 2>&1
+set -e
+
+if ! grep -o '\[unitpasses\].*' $WRITEDIR/unitpasses.log; then
+	tail -n 50 $WRITEDIR/unitpasses.log
+	echo "no timings were logged"
+	exit 1
+fi
+
+exit 0